@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <libwire/tcp/listener.hpp>
+#include <libwire/tcp/socket.hpp>
+
+/**
+ * Helpers shared by all benchmarks.
+ */
+namespace bench {
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Count of I/O system calls made by calling thread since start.
+     *
+     * Always 0 if libwire built without LIBWIRE_BENCHMARK_SYSCALLS.
+     */
+    uint64_t syscalls() noexcept;
+
+    /**
+     * Whether \ref syscalls is meaningful in this build.
+     */
+    bool syscalls_counted() noexcept;
+
+    inline double seconds_since(clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * Create pair of connected TCP sockets over loopback interface.
+     *
+     * Returned tuple is {client, server}.
+     */
+    inline std::tuple<libwire::tcp::socket, libwire::tcp::socket> tcp_pair(
+        libwire::address loopback = libwire::ipv4::loopback) {
+        libwire::tcp::listener listener{loopback, 0};
+        uint16_t port = std::get<1>(listener.implementation().local_endpoint());
+
+        libwire::tcp::socket client;
+        std::thread connect_thr([&]() { client.connect(loopback, port); });
+        libwire::tcp::socket server = listener.accept();
+        connect_thr.join();
+        return {std::move(client), std::move(server)};
+    }
+
+    /**
+     * Print one result line: name, time, throughput and syscalls per
+     * operation (if measured).
+     */
+    inline void report(const char* name, double seconds, uint64_t operations, uint64_t bytes,
+                       std::optional<uint64_t> syscalls_made = {}) {
+        std::printf("  %-40s %9.3f ms %10.1f MB/s %12.0f ops/s", name, seconds * 1000,
+                    double(bytes) / seconds / (1024 * 1024), double(operations) / seconds);
+        if (syscalls_counted() && syscalls_made) {
+            std::printf(" %10.3f syscalls/op", double(*syscalls_made) / double(operations));
+        }
+        std::printf("\n");
+    }
+} // namespace bench
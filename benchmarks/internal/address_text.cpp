@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "common.hpp"
+#include "libwire/internal/address_text.hpp"
+
+#ifdef _WIN32
+#    include <ws2tcpip.h>
+#else
+#    include <arpa/inet.h>
+#endif
+
+/*
+ * Compares address parsing and formatting routines used by
+ * libwire::address against inet_pton/inet_ntop.
+ *
+ * inet_pton needs NUL-terminated input, so it's measured both on
+ * prepared C strings and with copy from std::string_view into
+ * std::string (what address constructor had to do before).
+ *
+ * Usage: address_text [addresses]
+ */
+
+using namespace libwire;
+
+static volatile uint8_t sink;
+
+template<typename Parse>
+static void run_parse(const char* name, const std::vector<std::string>& texts, Parse&& parse) {
+    size_t bytes = 0;
+    for (const auto& text : texts) bytes += text.size();
+
+    uint8_t output[16];
+    unsigned accumulator = 0;
+    auto start = bench::clock::now();
+    for (const auto& text : texts) {
+        if (!parse(std::string_view(text), output)) std::abort();
+        accumulator += output[3];
+    }
+    double seconds = bench::seconds_since(start);
+    sink = uint8_t(accumulator);
+    bench::report(name, seconds, texts.size(), bytes);
+}
+
+template<typename Format>
+static void run_format(const char* name, const std::vector<std::array<uint8_t, 16>>& addresses, Format&& format) {
+    char buffer[64];
+    size_t bytes = 0;
+    auto start = bench::clock::now();
+    for (const auto& address : addresses) bytes += format(address.data(), buffer);
+    double seconds = bench::seconds_since(start);
+    sink = uint8_t(buffer[0]);
+    bench::report(name, seconds, addresses.size(), bytes);
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> byte(0, 255), zero_word(0, 3);
+    std::vector<std::array<uint8_t, 16>> ipv4(count), ipv6(count);
+    std::vector<std::string> ipv4_texts, ipv6_texts;
+    ipv4_texts.reserve(count);
+    ipv6_texts.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < 4; ++j) ipv4[i][j] = uint8_t(byte(random));
+        for (size_t j = 0; j < 16; j += 2) {
+            bool zero = zero_word(random) == 0;
+            ipv6[i][j] = zero ? 0 : uint8_t(byte(random));
+            ipv6[i][j + 1] = zero ? 0 : uint8_t(byte(random));
+        }
+
+        char text[64];
+        ipv4_texts.emplace_back(text, internal_::format_ipv4(ipv4[i].data(), text));
+        ipv6_texts.emplace_back(text, internal_::format_ipv6(ipv6[i].data(), text));
+    }
+
+    std::printf("%zu addresses\n", count);
+
+    std::printf("IPv4 parse:\n");
+    run_parse("inet_pton", ipv4_texts, [](std::string_view text, uint8_t* output) {
+        return inet_pton(AF_INET, text.data(), output) == 1;
+    });
+    run_parse("std::string + inet_pton", ipv4_texts, [](std::string_view text, uint8_t* output) {
+        return inet_pton(AF_INET, std::string(text).c_str(), output) == 1;
+    });
+    run_parse("scalar", ipv4_texts, [](std::string_view text, uint8_t* output) {
+        return internal_::parse_ipv4_scalar(text.data(), text.size(), output);
+    });
+#ifdef LIBWIRE_X86_KERNELS
+    run_parse("sse2", ipv4_texts, [](std::string_view text, uint8_t* output) {
+        return internal_::parse_ipv4_sse2(text.data(), text.size(), output);
+    });
+#endif
+
+    std::printf("IPv6 parse:\n");
+    run_parse("inet_pton", ipv6_texts, [](std::string_view text, uint8_t* output) {
+        return inet_pton(AF_INET6, text.data(), output) == 1;
+    });
+    run_parse("std::string + inet_pton", ipv6_texts, [](std::string_view text, uint8_t* output) {
+        return inet_pton(AF_INET6, std::string(text).c_str(), output) == 1;
+    });
+    run_parse("parse_ipv6", ipv6_texts, [](std::string_view text, uint8_t* output) {
+        return internal_::parse_ipv6(text.data(), text.size(), output);
+    });
+
+    std::printf("IPv4 format:\n");
+    run_format("inet_ntop", ipv4, [](const uint8_t* input, char* output) {
+        return std::strlen(inet_ntop(AF_INET, input, output, 64));
+    });
+    run_format("format_ipv4", ipv4, [](const uint8_t* input, char* output) {
+        return size_t(internal_::format_ipv4(input, output) - output);
+    });
+
+    std::printf("IPv6 format:\n");
+    run_format("inet_ntop", ipv6, [](const uint8_t* input, char* output) {
+        return std::strlen(inet_ntop(AF_INET6, input, output, 64));
+    });
+    run_format("format_ipv6", ipv6, [](const uint8_t* input, char* output) {
+        return size_t(internal_::format_ipv6(input, output) - output);
+    });
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common.hpp"
+#include "libwire/internal/search.hpp"
+
+/*
+ * Compares delimiter search kernels used by tcp::buffered_stream::read_until
+ * against per-byte push_back loop used by tcp::socket::read_until.
+ *
+ * Every line of in-memory payload is extracted to std::string, no I/O is
+ * involved.
+ *
+ * Usage: search [payload size in MiB]
+ */
+
+using namespace libwire;
+
+using search_function = size_t (*)(const uint8_t*, size_t, const uint8_t*, size_t) noexcept;
+
+static std::vector<uint8_t> make_payload(size_t size, size_t line_length, std::string_view delimiter) {
+    std::vector<uint8_t> payload;
+    payload.reserve(size + line_length);
+    while (payload.size() < size) {
+        for (size_t i = 0; i < line_length; ++i) payload.push_back(uint8_t('a' + i % 26));
+        payload.insert(payload.end(), delimiter.begin(), delimiter.end());
+    }
+    return payload;
+}
+
+// Same logic as in socket::read_until but without recv() calls: check
+// every byte and push it to output if it's not part of delimiter.
+static size_t per_byte(const std::vector<uint8_t>& payload, std::string_view delimiter, std::string& line) {
+    size_t lines = 0;
+    line.clear();
+    for (uint8_t byte : payload) {
+        line.push_back(char(byte));
+        if (line.size() >= delimiter.size() &&
+            std::memcmp(line.data() + line.size() - delimiter.size(), delimiter.data(), delimiter.size()) == 0) {
+            line.clear();
+            ++lines;
+        }
+    }
+    return lines;
+}
+
+static size_t chunked(search_function search, const std::vector<uint8_t>& payload, std::string_view delimiter,
+                      std::string& line) {
+    size_t lines = 0;
+    const auto* needle = reinterpret_cast<const uint8_t*>(delimiter.data());
+    const uint8_t* current = payload.data();
+    const uint8_t* end = payload.data() + payload.size();
+    while (current < end) {
+        size_t position = search(current, size_t(end - current), needle, delimiter.size());
+        line.assign(reinterpret_cast<const char*>(current), position);
+        current += position + delimiter.size();
+        ++lines;
+    }
+    return lines;
+}
+
+template<typename Function>
+static void run(const char* name, const std::vector<uint8_t>& payload, Function&& function) {
+    std::string line;
+    auto start = bench::clock::now();
+    size_t lines = function(payload, line);
+    double seconds = bench::seconds_since(start);
+    bench::report(name, seconds, lines, payload.size());
+}
+
+int main(int argc, char** argv) {
+    size_t payload_size = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+
+    std::printf("Active kernel: %s\n", internal_::search_kernel());
+
+    for (std::string_view delimiter : {"\n", "\r\n", "\r\n\r\n"}) {
+        for (size_t line_length : {16, 64, 512, 4096}) {
+            auto payload = make_payload(payload_size, line_length, delimiter);
+            std::printf("delimiter size %zu, line length %zu\n", delimiter.size(), line_length);
+
+            run("per-byte loop", payload,
+                [&](const auto& payload, std::string& line) { return per_byte(payload, delimiter, line); });
+            run("scalar", payload, [&](const auto& payload, std::string& line) {
+                return chunked(internal_::search_scalar, payload, delimiter, line);
+            });
+#ifdef LIBWIRE_X86_KERNELS
+            run("sse2", payload, [&](const auto& payload, std::string& line) {
+                return chunked(internal_::search_sse2, payload, delimiter, line);
+            });
+            if (internal_::search_avx2_supported()) {
+                run("avx2", payload, [&](const auto& payload, std::string& line) {
+                    return chunked(internal_::search_avx2, payload, delimiter, line);
+                });
+            }
+#endif
+        }
+    }
+}
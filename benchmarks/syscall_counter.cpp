@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "common.hpp"
+
+#ifdef LIBWIRE_BENCHMARK_SYSCALLS
+#    include <cstdarg>
+#    include <sys/sendfile.h>
+#    include <sys/socket.h>
+#    include <fcntl.h>
+#    include <poll.h>
+#    include <unistd.h>
+#    include <sys/epoll.h>
+#endif
+
+namespace bench {
+    thread_local uint64_t syscalls_made = 0;
+
+    uint64_t syscalls() noexcept {
+        return syscalls_made;
+    }
+
+    bool syscalls_counted() noexcept {
+#ifdef LIBWIRE_BENCHMARK_SYSCALLS
+        return true;
+#else
+        return false;
+#endif
+    }
+} // namespace bench
+
+#ifdef LIBWIRE_BENCHMARK_SYSCALLS
+// Linker redirects references to X made by libwire to __wrap_X when
+// -Wl,--wrap=X is passed, original function is available as __real_X.
+// List of wrapped functions must be kept in sync with
+// LIBWIRE_BENCHMARK_WRAPPED_CALLS in CMakeLists.txt.
+extern "C" {
+ssize_t __real_recv(int, void*, size_t, int);
+ssize_t __real_send(int, const void*, size_t, int);
+ssize_t __real_recvmsg(int, msghdr*, int);
+ssize_t __real_sendmsg(int, const msghdr*, int);
+ssize_t __real_sendfile(int, int, off_t*, size_t);
+ssize_t __real_splice(int, loff_t*, int, loff_t*, size_t, unsigned int);
+ssize_t __real_pread(int, void*, size_t, off_t);
+ssize_t __real_pwrite(int, const void*, size_t, off_t);
+int __real_poll(pollfd*, nfds_t, int);
+int __real_epoll_wait(int, epoll_event*, int, int);
+int __real_epoll_ctl(int, int, int, epoll_event*);
+ssize_t __real_write(int, const void*, size_t);
+long __real_syscall(long, ...);
+int __real_accept4(int, sockaddr*, socklen_t*, int);
+ssize_t __real_recvfrom(int, void*, size_t, int, sockaddr*, socklen_t*);
+ssize_t __real_sendto(int, const void*, size_t, int, const sockaddr*, socklen_t);
+int __real_recvmmsg(int, mmsghdr*, unsigned int, int, timespec*);
+int __real_sendmmsg(int, mmsghdr*, unsigned int, int);
+
+ssize_t __wrap_recv(int fd, void* buffer, size_t length, int flags) {
+    ++bench::syscalls_made;
+    return __real_recv(fd, buffer, length, flags);
+}
+
+ssize_t __wrap_send(int fd, const void* buffer, size_t length, int flags) {
+    ++bench::syscalls_made;
+    return __real_send(fd, buffer, length, flags);
+}
+
+ssize_t __wrap_recvmsg(int fd, msghdr* message, int flags) {
+    ++bench::syscalls_made;
+    return __real_recvmsg(fd, message, flags);
+}
+
+ssize_t __wrap_sendmsg(int fd, const msghdr* message, int flags) {
+    ++bench::syscalls_made;
+    return __real_sendmsg(fd, message, flags);
+}
+
+ssize_t __wrap_sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+    ++bench::syscalls_made;
+    return __real_sendfile(out_fd, in_fd, offset, count);
+}
+
+ssize_t __wrap_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t length, unsigned int flags) {
+    ++bench::syscalls_made;
+    return __real_splice(fd_in, off_in, fd_out, off_out, length, flags);
+}
+
+ssize_t __wrap_pread(int fd, void* buffer, size_t length, off_t offset) {
+    ++bench::syscalls_made;
+    return __real_pread(fd, buffer, length, offset);
+}
+
+ssize_t __wrap_pwrite(int fd, const void* buffer, size_t length, off_t offset) {
+    ++bench::syscalls_made;
+    return __real_pwrite(fd, buffer, length, offset);
+}
+
+int __wrap_poll(pollfd* fds, nfds_t count, int timeout) {
+    ++bench::syscalls_made;
+    return __real_poll(fds, count, timeout);
+}
+
+int __wrap_epoll_wait(int epoll_fd, epoll_event* events, int max_events, int timeout) {
+    ++bench::syscalls_made;
+    return __real_epoll_wait(epoll_fd, events, max_events, timeout);
+}
+
+int __wrap_epoll_ctl(int epoll_fd, int operation, int fd, epoll_event* event) {
+    ++bench::syscalls_made;
+    return __real_epoll_ctl(epoll_fd, operation, fd, event);
+}
+
+ssize_t __wrap_write(int fd, const void* buffer, size_t length) {
+    ++bench::syscalls_made;
+    return __real_write(fd, buffer, length);
+}
+
+int __wrap_accept4(int fd, sockaddr* address, socklen_t* length, int flags) {
+    ++bench::syscalls_made;
+    return __real_accept4(fd, address, length, flags);
+}
+
+ssize_t __wrap_recvfrom(int fd, void* buffer, size_t length, int flags, sockaddr* address, socklen_t* address_length) {
+    ++bench::syscalls_made;
+    return __real_recvfrom(fd, buffer, length, flags, address, address_length);
+}
+
+ssize_t __wrap_sendto(int fd, const void* buffer, size_t length, int flags, const sockaddr* address,
+                      socklen_t address_length) {
+    ++bench::syscalls_made;
+    return __real_sendto(fd, buffer, length, flags, address, address_length);
+}
+
+int __wrap_recvmmsg(int fd, mmsghdr* messages, unsigned int count, int flags, timespec* timeout) {
+    ++bench::syscalls_made;
+    return __real_recvmmsg(fd, messages, count, flags, timeout);
+}
+
+int __wrap_sendmmsg(int fd, mmsghdr* messages, unsigned int count, int flags) {
+    ++bench::syscalls_made;
+    return __real_sendmmsg(fd, messages, count, flags);
+}
+
+// Used by libwire only for io_uring calls, which take at most 6 arguments.
+long __wrap_syscall(long number, ...) {
+    ++bench::syscalls_made;
+    va_list list;
+    va_start(list, number);
+    long arguments[6];
+    for (long& argument : arguments) argument = va_arg(list, long);
+    va_end(list);
+    return __real_syscall(number, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4],
+                          arguments[5]);
+}
+}
+#endif // ifdef LIBWIRE_BENCHMARK_SYSCALLS
@@ -0,0 +1,108 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/tcp/options.hpp>
+
+/*
+ * Burst of connections: client threads open connections as fast as
+ * they can and reset them right away (linger with zero timeout, so no
+ * TIME_WAIT sockets pile up), server thread waits for listener readiness
+ * and accepts either one connection per wakeup or whole queue using
+ * listener::accept_many.
+ *
+ * Usage: accept-many [connections] [clients] [batch size]
+ */
+
+using namespace libwire;
+using namespace std::literals;
+
+static void client_loop(uint16_t port, size_t connections) {
+    for (size_t i = 0; i < connections; ++i) {
+        tcp::socket client;
+        std::error_code ec;
+        client.connect(ipv4::loopback, port, ec);
+        if (ec) {
+            std::fprintf(stderr, "connect failed: %s\n", ec.message().c_str());
+            return;
+        }
+        client.set_option(tcp::linger, true, 0s);
+    }
+}
+
+template<typename Accept>
+static void run(const char* name, size_t connections, size_t clients_count, Accept&& accept) {
+    tcp::listener listener{ipv4::loopback, 0};
+    listener.set_option(non_blocking, true);
+    uint16_t port = std::get<1>(listener.implementation().local_endpoint());
+
+    size_t accepted = 0;
+    uint64_t wakeups = 0;
+    size_t expected = connections / clients_count * clients_count;
+
+    auto start = bench::clock::now();
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < clients_count; ++i) clients.emplace_back(client_loop, port, connections / clients_count);
+
+    uint64_t syscalls_before = bench::syscalls();
+    while (accepted < expected) {
+        pollfd descriptor{listener.native_handle(), POLLIN, 0};
+        if (poll(&descriptor, 1, 100) <= 0) continue;
+        ++wakeups;
+        accepted += accept(listener);
+    }
+    uint64_t syscalls_made = bench::syscalls() - syscalls_before;
+    double seconds = bench::seconds_since(start);
+
+    for (auto& client : clients) client.join();
+    bench::report(name, seconds, accepted, 0, syscalls_made);
+    std::printf("  %-40s %9.2f connections/wakeup\n", "", double(accepted) / double(wakeups));
+}
+
+int main(int argc, char** argv) {
+    size_t connections = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t clients_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+    size_t batch_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+
+    std::printf("%zu connections from %zu clients, batch size %zu\n", connections, clients_count, batch_size);
+
+    run("accept", connections, clients_count, [](tcp::listener& listener) -> size_t {
+        std::error_code ec;
+        tcp::socket socket = listener.accept(ec);
+        return ec ? 0 : 1;
+    });
+
+    std::vector<tcp::socket> batch;
+    batch.reserve(batch_size);
+    run("accept_many", connections, clients_count, [&](tcp::listener& listener) {
+        std::error_code ec;
+        batch.clear();
+        return listener.accept_many(batch_size, batch, ec);
+    });
+}
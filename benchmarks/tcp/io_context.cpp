@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include <libwire/io_context.hpp>
+
+/*
+ * Request-response exchange over several loopback TCP connections: each
+ * client sends fixed-size request and waits for echo of it. Server is
+ * implemented using blocking sockets (thread per connection) and using
+ * io_context with every available backend.
+ *
+ * System calls are counted only on server side and include event
+ * notification calls (epoll_wait, io_uring_enter, etc).
+ *
+ * Usage: io-context [requests per connection] [connections]
+ */
+
+using namespace libwire;
+
+static constexpr size_t message_size = 64;
+
+struct connection {
+    tcp::socket client;
+    tcp::socket server;
+};
+
+static std::vector<connection> make_connections(size_t count) {
+    std::vector<connection> connections;
+    for (size_t i = 0; i < count; ++i) {
+        auto [client, server] = bench::tcp_pair();
+        connections.push_back({std::move(client), std::move(server)});
+    }
+    return connections;
+}
+
+static void client_loop(tcp::socket& client, size_t requests) {
+    std::vector<uint8_t> request(message_size, 0xAB), response;
+    for (size_t i = 0; i < requests; ++i) {
+        client.write(request);
+        client.read(message_size, response);
+    }
+    client.shutdown(false, true);
+}
+
+template<typename Server>
+static void run(const char* name, size_t requests, size_t connections_count, Server&& server) {
+    std::vector<connection> connections = make_connections(connections_count);
+
+    auto start = bench::clock::now();
+    std::vector<std::thread> clients;
+    for (connection& conn : connections) {
+        clients.emplace_back([&conn, requests]() { client_loop(conn.client, requests); });
+    }
+    uint64_t syscalls_made = server(connections);
+    for (std::thread& client : clients) client.join();
+    double seconds = bench::seconds_since(start);
+
+    uint64_t total = requests * connections_count;
+    bench::report(name, seconds, total, total * message_size, syscalls_made);
+}
+
+static uint64_t blocking_server(std::vector<connection>& connections) {
+    std::atomic<uint64_t> syscalls_made{0};
+    std::vector<std::thread> threads;
+    for (connection& conn : connections) {
+        threads.emplace_back([&conn, &syscalls_made]() {
+            uint64_t syscalls_before = bench::syscalls();
+            std::vector<uint8_t> buffer;
+            std::error_code ec;
+            for (;;) {
+                conn.server.read(message_size, buffer, ec);
+                if (ec) break;
+                conn.server.write(buffer);
+            }
+            syscalls_made += bench::syscalls() - syscalls_before;
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return syscalls_made;
+}
+
+namespace {
+    struct echo_session {
+        echo_session(io_context& context, tcp::socket& socket) : context(context), socket(socket) {
+        }
+
+        void read() {
+            context.async_read(socket, make_view(buffer), [this](std::error_code ec, size_t) {
+                if (!ec) write();
+            });
+        }
+
+        void write() {
+            context.async_write(socket, make_view(std::as_const(buffer)), [this](std::error_code ec, size_t) {
+                if (!ec) read();
+            });
+        }
+
+        io_context& context;
+        tcp::socket& socket;
+        std::vector<uint8_t> buffer = std::vector<uint8_t>(message_size);
+    };
+} // namespace
+
+static auto async_server(io_context::backend_type backend, bool register_sockets) {
+    return [=](std::vector<connection>& connections) -> uint64_t {
+        io_context context{backend};
+        std::vector<std::unique_ptr<echo_session>> sessions;
+        for (connection& conn : connections) {
+            std::error_code ec;
+            if (register_sockets) context.register_socket(conn.server, ec);
+            if (ec) std::printf("  register_socket: %s\n", ec.message().c_str());
+            sessions.push_back(std::make_unique<echo_session>(context, conn.server));
+        }
+
+        uint64_t syscalls_before = bench::syscalls();
+        for (auto& session : sessions) session->read();
+        context.run();
+        uint64_t syscalls_made = bench::syscalls() - syscalls_before;
+
+        if (register_sockets) {
+            for (connection& conn : connections) context.unregister_socket(conn.server);
+        }
+        return syscalls_made;
+    };
+}
+
+static bool io_uring_available() {
+    io_context context{io_context::backend_type::io_uring};
+    return context.backend() == io_context::backend_type::io_uring;
+}
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+
+    std::printf("io_context: %zu connections, %zu requests of %zu bytes per connection\n", connections, requests,
+                message_size);
+    run("blocking (thread per connection)", requests, connections, blocking_server);
+    run("io_context (epoll)", requests, connections, async_server(io_context::backend_type::epoll, false));
+    if (io_uring_available()) {
+        run("io_context (io_uring)", requests, connections, async_server(io_context::backend_type::io_uring, false));
+        run("io_context (io_uring, registered files)", requests, connections,
+            async_server(io_context::backend_type::io_uring, true));
+    } else {
+        std::printf("  io_uring is not available\n");
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "common.hpp"
+#include <libwire/prefix_table.hpp>
+
+/*
+ * Cost of matching peer addresses against large allow/deny lists:
+ * linear scan over network_prefix list versus prefix_table.
+ *
+ * Prefix lengths roughly follow global routing table: mostly /24 (IPv4)
+ * and /32-/48 (IPv6). Lookup addresses are random, so most of them miss
+ * every prefix except shortest ones, and half of them are taken from
+ * inside of prefixes to exercise deep trie levels.
+ *
+ * Usage: prefix_table [prefixes] [lookups]
+ */
+
+using namespace libwire;
+
+using entry_list = std::vector<std::pair<network_prefix, uint32_t>>;
+
+static address random_address(std::mt19937& random, ip version) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    address result = version == ip::v4 ? ipv4::any : ipv6::any;
+    for (size_t i = 0; i < (version == ip::v4 ? 4u : 16u); ++i) result.parts[i] = uint8_t(byte(random));
+    return result;
+}
+
+static entry_list make_prefixes(std::mt19937& random, size_t count, ip version) {
+    std::discrete_distribution<int> ipv4_length({0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 3, 4, 15, 5, 10, 20,
+                                                 30, 40, 50, 60, 700, 5, 5, 5, 5, 5, 5, 5, 20});
+    std::uniform_int_distribution<int> ipv6_length(28, 48), host(0, 9);
+    entry_list entries;
+    entries.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        int length = version == ip::v4 ? ipv4_length(random) : host(random) == 0 ? 64 : ipv6_length(random);
+        entries.emplace_back(network_prefix(random_address(random, version), uint8_t(length)), uint32_t(i % 2));
+    }
+    return entries;
+}
+
+static std::vector<address> make_lookups(std::mt19937& random, const entry_list& entries, size_t count) {
+    std::uniform_int_distribution<size_t> index(0, entries.size() - 1);
+    std::vector<address> lookups;
+    lookups.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const network_prefix& prefix = entries[index(random)].first;
+        address random_one = random_address(random, prefix.base.version);
+        if (i % 2 == 0) {
+            lookups.push_back(random_one);
+            continue;
+        }
+        // Host inside prefix.
+        address inside = prefix.base;
+        for (size_t byte = prefix.length / 8u; byte < inside.parts.size(); ++byte) {
+            unsigned keep = byte * 8 < prefix.length ? prefix.length - byte * 8 : 0;
+            auto mask = uint8_t(0xff00u >> keep);
+            inside.parts[byte] = uint8_t((inside.parts[byte] & mask) | (random_one.parts[byte] & ~mask));
+        }
+        lookups.push_back(inside);
+    }
+    return lookups;
+}
+
+template<typename Lookup>
+static void run(const char* name, const std::vector<address>& lookups, Lookup&& lookup) {
+    uint64_t matches = 0;
+    auto start = bench::clock::now();
+    for (const address& addr : lookups) matches += lookup(addr) != prefix_table::no_match;
+    double seconds = bench::seconds_since(start);
+    bench::report(name, seconds, lookups.size(), 0);
+    std::printf("    %.1f%% matched\n", 100.0 * double(matches) / double(lookups.size()));
+}
+
+static void compare(const char* title, const entry_list& entries, const std::vector<address>& lookups,
+                    bool with_linear) {
+    std::printf("%s, %zu prefixes:\n", title, entries.size());
+
+    prefix_table table;
+    auto start = bench::clock::now();
+    table.assign(entries);
+    std::printf("  build: %.1f ms, %.1f MiB\n", bench::seconds_since(start) * 1000,
+                double(table.memory_usage()) / (1024 * 1024));
+
+    if (with_linear) {
+        // Linear scan can't handle full lookup list in reasonable time.
+        std::vector<address> few(lookups.begin(), lookups.begin() + ptrdiff_t(std::min<size_t>(lookups.size(), 2000)));
+        run("linear scan", few, [&](const address& addr) {
+            uint32_t result = prefix_table::no_match;
+            int best = -1;
+            for (const auto& [prefix, value] : entries) {
+                if (int(prefix.length) > best && prefix.contains(addr)) {
+                    best = prefix.length;
+                    result = value;
+                }
+            }
+            return result;
+        });
+    }
+    run("prefix_table", lookups, [&](const address& addr) { return table.lookup(addr); });
+}
+
+int main(int argc, char** argv) {
+    size_t prefixes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t lookup_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+    std::mt19937 random(42);
+    entry_list small_ipv4 = make_prefixes(random, 10000, ip::v4);
+    entry_list ipv4 = make_prefixes(random, prefixes, ip::v4);
+    entry_list ipv6 = make_prefixes(random, prefixes, ip::v6);
+
+    compare("IPv4", small_ipv4, make_lookups(random, small_ipv4, lookup_count), true);
+    compare("IPv4", ipv4, make_lookups(random, ipv4, lookup_count), false);
+    compare("IPv6", ipv6, make_lookups(random, ipv6, lookup_count), false);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "common.hpp"
+#include <libwire/tcp/buffered_stream.hpp>
+
+/*
+ * Compares line-by-line reading using tcp::socket::read_until (one recv()
+ * per byte) and tcp::buffered_stream::read_until (one recv() per buffer).
+ *
+ * Usage: read-until [lines] [line length]
+ */
+
+using namespace libwire;
+
+static std::string make_payload(size_t lines, size_t line_length) {
+    std::string line(line_length - 1, 'x');
+    line.push_back('\n');
+
+    std::string payload;
+    payload.reserve(lines * line_length);
+    for (size_t i = 0; i < lines; ++i) payload += line;
+    return payload;
+}
+
+template<typename Reader>
+static void run(const char* name, const std::string& payload, size_t lines, Reader&& reader) {
+    auto [client, server] = bench::tcp_pair();
+    std::thread writer([&, &client = client]() { client.write(payload); });
+
+    std::string line;
+    uint64_t syscalls_before = bench::syscalls();
+    auto start = bench::clock::now();
+    reader(server, lines, line);
+    double seconds = bench::seconds_since(start);
+    uint64_t syscalls_made = bench::syscalls() - syscalls_before;
+
+    writer.join();
+    bench::report(name, seconds, lines, payload.size(), syscalls_made);
+}
+
+int main(int argc, char** argv) {
+    size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t line_length = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    std::string payload = make_payload(lines, line_length);
+
+    std::printf("read_until: %zu lines, %zu bytes per line\n", lines, line_length);
+
+    run("tcp::socket::read_until", payload, lines, [](tcp::socket& sock, size_t lines, std::string& line) {
+        for (size_t i = 0; i < lines; ++i) sock.read_until('\n', line);
+    });
+
+    for (size_t buffer_size : {size_t(512), tcp::buffered_stream::default_buffer_size, size_t(65536)}) {
+        std::string name = "tcp::buffered_stream::read_until/" + std::to_string(buffer_size);
+        run(name.c_str(), payload, lines, [=](tcp::socket& sock, size_t lines, std::string& line) {
+            tcp::buffered_stream stream{std::move(sock), buffer_size};
+            for (size_t i = 0; i < lines; ++i) stream.read_until('\n', line);
+        });
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "common.hpp"
+
+/*
+ * Compares transferring file over TCP connection using user-space buffer
+ * (pread + write, read + pwrite) and tcp::socket::send_file /
+ * receive_to_file.
+ *
+ * Usage: send-file [file size in MiB] [repeats]
+ */
+
+using namespace libwire;
+
+static constexpr size_t chunk_size = 64 * 1024;
+
+template<typename Sender, typename Receiver>
+static void run(const char* name, size_t file_size, size_t repeats, bool measure_sender, Sender&& sender,
+                Receiver&& receiver) {
+    auto [client, server] = bench::tcp_pair();
+
+    uint64_t syscalls_made = 0;
+    double seconds = 0;
+    std::thread other([&, &client = client, &server = server]() {
+        for (size_t i = 0; i < repeats; ++i) {
+            if (measure_sender) receiver(server);
+            else sender(client);
+        }
+    });
+
+    uint64_t syscalls_before = bench::syscalls();
+    auto start = bench::clock::now();
+    for (size_t i = 0; i < repeats; ++i) {
+        if (measure_sender) sender(client);
+        else receiver(server);
+    }
+    seconds = bench::seconds_since(start);
+    syscalls_made = bench::syscalls() - syscalls_before;
+    other.join();
+
+    bench::report(name, seconds, repeats, file_size * repeats, syscalls_made);
+}
+
+int main(int argc, char** argv) {
+    size_t file_size = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+    size_t repeats = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+
+    FILE* source = std::tmpfile();
+    FILE* destination = std::tmpfile();
+    std::vector<uint8_t> contents(file_size, 0xAB);
+    std::fwrite(contents.data(), 1, contents.size(), source);
+    std::fflush(source);
+    int source_fd = fileno(source), destination_fd = fileno(destination);
+
+    std::printf("send_file: %zu MiB file, %zu repeats (syscalls counted per file)\n", file_size / (1024 * 1024),
+                repeats);
+
+    auto copy_send = [&](tcp::socket& sock) {
+        std::vector<uint8_t> chunk(chunk_size);
+        for (size_t offset = 0; offset < file_size; offset += chunk_size) {
+            chunk.resize(size_t(pread(source_fd, chunk.data(), chunk_size, off_t(offset))));
+            sock.write(chunk);
+        }
+    };
+    auto zero_copy_send = [&](tcp::socket& sock) { sock.send_file(source_fd, 0, file_size); };
+
+    auto copy_receive = [&](tcp::socket& sock) {
+        std::vector<uint8_t> chunk;
+        for (size_t offset = 0; offset < file_size; offset += chunk.size()) {
+            sock.read_some(std::min(chunk_size, file_size - offset), chunk);
+            pwrite(destination_fd, chunk.data(), chunk.size(), off_t(offset));
+        }
+    };
+    auto zero_copy_receive = [&](tcp::socket& sock) { sock.receive_to_file(destination_fd, 0, file_size); };
+
+    run("pread + tcp::socket::write", file_size, repeats, true, copy_send, copy_receive);
+    run("tcp::socket::send_file", file_size, repeats, true, zero_copy_send, copy_receive);
+    run("tcp::socket::read_some + pwrite", file_size, repeats, false, copy_send, copy_receive);
+    run("tcp::socket::receive_to_file", file_size, repeats, false, copy_send, zero_copy_receive);
+
+    std::fclose(source);
+    std::fclose(destination);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/tcp/options.hpp>
+#include <libwire/tcp/sharded_listener.hpp>
+
+/*
+ * Connection rate: client threads connect and immediately reset
+ * connections (linger with zero timeout, so no TIME_WAIT sockets pile
+ * up), server threads accept and close them.
+ *
+ * Server threads either share single listener or each of them owns
+ * shard of sharded_listener (with CPU steering if it's available).
+ *
+ * Usage: sharded-listener [connections per client] [clients] [server threads]
+ */
+
+using namespace libwire;
+using namespace std::literals;
+
+static void client_loop(uint16_t port, size_t connections) {
+    for (size_t i = 0; i < connections; ++i) {
+        tcp::socket client;
+        std::error_code ec;
+        client.connect(ipv4::loopback, port, ec);
+        if (ec) {
+            std::fprintf(stderr, "connect failed: %s\n", ec.message().c_str());
+            return;
+        }
+        client.set_option(tcp::linger, true, 0s);
+    }
+}
+
+// Accepts until all expected connections are accepted by any thread,
+// accept timeout lets thread notice that.
+static void accept_loop(tcp::listener& listener, std::atomic<size_t>& accepted, size_t expected) {
+    while (accepted < expected) {
+        std::error_code ec;
+        tcp::socket socket = listener.accept(ec);
+        if (!ec) ++accepted;
+    }
+}
+
+template<typename Server>
+static void run(const char* name, uint16_t port, size_t connections, size_t clients_count, Server&& server) {
+    std::atomic<size_t> accepted{0};
+    size_t expected = connections * clients_count;
+
+    auto start = bench::clock::now();
+    std::vector<std::thread> threads = server(accepted, expected);
+    for (size_t i = 0; i < clients_count; ++i) threads.emplace_back(client_loop, port, connections);
+    for (auto& thread : threads) thread.join();
+    bench::report(name, bench::seconds_since(start), accepted, 0);
+}
+
+int main(int argc, char** argv) {
+    size_t connections = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    size_t clients_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+    size_t threads_count =
+        argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::max(2u, std::thread::hardware_concurrency());
+
+    std::printf("%zu clients, %zu connections each, %zu server threads\n", clients_count, connections, threads_count);
+
+    {
+        tcp::listener listener{ipv4::loopback, 0};
+        listener.set_option(receive_timeout, 100ms);
+        uint16_t port = std::get<1>(listener.implementation().local_endpoint());
+        run("single listener", port, connections, clients_count, [&](auto& accepted, size_t expected) {
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < threads_count; ++i) {
+                threads.emplace_back([&, expected] { accept_loop(listener, accepted, expected); });
+            }
+            return threads;
+        });
+    }
+
+    for (bool steering : {false, true}) {
+        tcp::sharded_listener listener{ipv4::loopback, 0, threads_count};
+        for (size_t i = 0; i < listener.size(); ++i) listener.shard(i).set_option(receive_timeout, 100ms);
+        if (steering) {
+            std::error_code ec;
+            listener.steer_by_cpu(ec);
+            if (ec) {
+                std::printf("  CPU steering is not available: %s\n", ec.message().c_str());
+                break;
+            }
+        }
+
+        run(steering ? "sharded listener, CPU steering" : "sharded listener", listener.port(), connections,
+            clients_count, [&](auto& accepted, size_t expected) {
+                std::vector<std::thread> threads;
+                for (size_t i = 0; i < threads_count; ++i) {
+                    threads.emplace_back([&, i, expected] {
+                        if (steering) {
+                            std::error_code ec;
+                            listener.pin_current_thread(i, ec);
+                        }
+                        accept_loop(listener.shard(i), accepted, expected);
+                    });
+                }
+                return threads;
+            });
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include "common.hpp"
+#include <libwire/options.hpp>
+
+/*
+ * Compares usual writes and zero-copy writes (MSG_ZEROCOPY) of messages
+ * with different sizes over loopback TCP connection.
+ *
+ * Note that kernel copies data anyway when it's delivered to local socket,
+ * so zero-copy writes switch to usual writes after first completion here.
+ * "zero-copy" column shows how many writes were really submitted as zero-copy.
+ *
+ * Usage: zero-copy [MiB per message size]
+ */
+
+using namespace libwire;
+
+static constexpr size_t buffers_in_flight = 8;
+
+static void drain(tcp::socket& server, size_t total) {
+    std::vector<uint8_t> buffer;
+    for (size_t received = 0; received < total; received += buffer.size()) {
+        server.read_some(std::min(total - received, size_t(256 * 1024)), buffer);
+    }
+}
+
+template<typename Writer>
+static void run(const char* name, size_t message_size, size_t messages, bool zero_copy_enabled, Writer&& writer) {
+    auto [client, server] = bench::tcp_pair();
+    if (zero_copy_enabled) client.set_option(zero_copy, true);
+
+    std::thread reader([&, &server = server]() { drain(server, message_size * messages); });
+
+    uint64_t syscalls_before = bench::syscalls();
+    auto start = bench::clock::now();
+    size_t zero_copy_writes = writer(client, message_size, messages);
+    double seconds = bench::seconds_since(start);
+    uint64_t syscalls_made = bench::syscalls() - syscalls_before;
+    reader.join();
+
+    std::string full_name = std::string(name) + "/" + std::to_string(message_size);
+    bench::report(full_name.c_str(), seconds, messages, message_size * messages, syscalls_made);
+    if (zero_copy_enabled) std::printf("  %-40s %zu of %zu writes\n", "  zero-copy", zero_copy_writes, messages);
+}
+
+static size_t copy_writer(tcp::socket& client, size_t message_size, size_t messages) {
+    std::vector<uint8_t> buffer(message_size, 0xAB);
+    for (size_t i = 0; i < messages; ++i) client.write(buffer);
+    return 0;
+}
+
+static size_t zero_copy_writer(tcp::socket& client, size_t message_size, size_t messages) {
+    struct slot {
+        std::vector<uint8_t> data;
+        std::optional<uint32_t> id;
+    };
+    std::vector<slot> slots(buffers_in_flight, slot{std::vector<uint8_t>(message_size, 0xAB), {}});
+
+    uint32_t completed_end = 0;
+    auto on_completion = [&](const zero_copy_completion& completion) {
+        completed_end = std::max(completed_end, completion.last + 1);
+    };
+    auto wait_for = [&](uint32_t id) {
+        while (id >= completed_end) {
+            pollfd fd{client.native_handle(), 0, 0};
+            poll(&fd, 1, 1000);
+            client.poll_zero_copy_completions(on_completion);
+        }
+    };
+
+    size_t zero_copy_writes = 0;
+    for (size_t i = 0; i < messages; ++i) {
+        slot& current = slots[i % slots.size()];
+        if (current.id) wait_for(*current.id);
+        client.write_zero_copy(make_view(current.data), current.id);
+        if (current.id) ++zero_copy_writes;
+    }
+    for (slot& current : slots) {
+        if (current.id) wait_for(*current.id);
+    }
+    return zero_copy_writes;
+}
+
+int main(int argc, char** argv) {
+    size_t total = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+
+    std::printf("zero_copy: %zu MiB per message size\n", total / (1024 * 1024));
+    for (size_t message_size : {4096, 16384, 65536, 262144, 1048576}) {
+        size_t messages = total / message_size;
+        run("tcp::socket::write", message_size, messages, false, copy_writer);
+        run("tcp::socket::write_zero_copy", message_size, messages, true, zero_copy_writer);
+    }
+}
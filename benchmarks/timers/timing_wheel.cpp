@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+#include "common.hpp"
+#include "libwire/timing_wheel.hpp"
+
+/*
+ * Simulates per-connection deadlines: all timers are armed, then
+ * rescheduled (activity on connection), half of them canceled (connection
+ * closed) and the rest expired while time advances in 1 ms steps.
+ *
+ * Timing wheel is compared against ordered multimap, which is what
+ * event loops without wheel usually use.
+ *
+ * Usage: timing_wheel [count of timers]
+ */
+
+using namespace libwire;
+using namespace std::literals;
+
+namespace {
+    constexpr auto max_timeout = 60s;
+    constexpr auto step = 1ms;
+
+    struct multimap_timers {
+        struct timer {
+            std::multimap<bench::clock::time_point, timer*>::iterator position;
+            bool armed = false;
+            size_t fired = 0;
+        };
+
+        void schedule(timer& timer, bench::clock::time_point expiry) {
+            if (timer.armed) timers.erase(timer.position);
+            timer.position = timers.emplace(expiry, &timer);
+            timer.armed = true;
+        }
+
+        void cancel(timer& timer) {
+            if (!timer.armed) return;
+            timers.erase(timer.position);
+            timer.armed = false;
+        }
+
+        size_t advance(bench::clock::time_point now) {
+            size_t expired = 0;
+            while (!timers.empty() && timers.begin()->first <= now) {
+                timer* current = timers.begin()->second;
+                timers.erase(timers.begin());
+                current->armed = false;
+                ++current->fired;
+                ++expired;
+            }
+            return expired;
+        }
+
+        std::multimap<bench::clock::time_point, timer*> timers;
+    };
+
+    struct wheel_timers {
+        struct timer {
+            timing_wheel::timer entry{[this] { ++fired; }};
+            size_t fired = 0;
+        };
+
+        explicit wheel_timers(bench::clock::time_point start) : wheel(1ms, start) {
+        }
+
+        void schedule(timer& timer, bench::clock::time_point expiry) {
+            wheel.schedule(timer.entry, expiry);
+        }
+
+        void cancel(timer& timer) {
+            timer.entry.cancel();
+        }
+
+        size_t advance(bench::clock::time_point now) {
+            return wheel.advance(now);
+        }
+
+        timing_wheel wheel;
+    };
+
+    template<typename Timers>
+    void run(const char* name, Timers& timers, const std::vector<bench::clock::duration>& timeouts,
+             bench::clock::time_point start) {
+        std::vector<typename Timers::timer> entries(timeouts.size());
+        std::printf("%s\n", name);
+
+        auto began = bench::clock::now();
+        for (size_t i = 0; i < entries.size(); ++i) timers.schedule(entries[i], start + timeouts[i]);
+        bench::report("schedule", bench::seconds_since(began), entries.size(), 0);
+
+        // Activity shifts deadline by few milliseconds, typical for idle timeouts.
+        began = bench::clock::now();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            timers.schedule(entries[i], start + timeouts[i] + std::chrono::milliseconds(i % 16));
+        }
+        bench::report("reschedule", bench::seconds_since(began), entries.size(), 0);
+
+        began = bench::clock::now();
+        for (size_t i = 0; i < entries.size(); i += 2) timers.cancel(entries[i]);
+        bench::report("cancel", bench::seconds_since(began), entries.size() / 2, 0);
+
+        began = bench::clock::now();
+        size_t expired = 0;
+        for (auto now = start; now <= start + max_timeout + 16ms; now += step) expired += timers.advance(now);
+        bench::report("advance and expire", bench::seconds_since(began), expired, 0);
+
+        if (expired != entries.size() / 2) std::printf("  unexpected count of expired timers: %zu\n", expired);
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<int64_t> timeout(1, std::chrono::milliseconds(max_timeout).count());
+    std::vector<bench::clock::duration> timeouts(count);
+    for (auto& value : timeouts) value = std::chrono::milliseconds(timeout(random));
+
+    std::printf("%zu timers, up to %lld s timeouts\n", count, static_cast<long long>(max_timeout.count()));
+
+    auto start = bench::clock::now();
+    {
+        wheel_timers timers{start};
+        run("timing_wheel", timers, timeouts, start);
+    }
+    {
+        multimap_timers timers;
+        run("std::multimap", timers, timeouts, start);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/udp.hpp>
+
+/*
+ * Datagram rate over loopback: sender thread writes datagrams as fast
+ * as it can, receiver reads them until sender is done and socket stays
+ * empty for a moment. Both sides move datagrams one by one (read/write)
+ * or in batches of given size (read_batch/write_batch).
+ *
+ * Loopback drops datagrams if receiver falls behind, so rate of
+ * received datagrams is reported.
+ *
+ * Usage: batch [datagrams] [datagram size]
+ */
+
+using namespace libwire;
+using namespace std::literals;
+
+struct result {
+    size_t received = 0;
+    double seconds = 0;
+    uint64_t syscalls = 0;
+};
+
+template<typename Send, typename Receive>
+static result run(Send&& send, Receive&& receive) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    receiver.set_option(receive_buffer_size, 4 * 1024 * 1024);
+    receiver.set_option(receive_timeout, 100ms);
+    sender.associate(ipv4::loopback, std::get<1>(receiver.local_endpoint()));
+
+    result result;
+    auto start = bench::clock::now();
+    std::thread sender_thread([&] { send(sender); });
+
+    uint64_t syscalls_before = bench::syscalls();
+    for (;;) {
+        std::error_code ec;
+        size_t received = receive(receiver, ec);
+        if (ec) break;
+        result.received += received;
+        result.seconds = bench::seconds_since(start);
+    }
+    result.syscalls = bench::syscalls() - syscalls_before;
+    sender_thread.join();
+    return result;
+}
+
+int main(int argc, char** argv) {
+    size_t datagrams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t datagram_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+
+    std::printf("%zu datagrams, %zu bytes each\n", datagrams, datagram_size);
+
+    std::vector<uint8_t> datagram(datagram_size, 0xAF);
+
+    result single = run(
+        [&](udp::socket& sender) {
+            std::error_code ec;
+            for (size_t i = 0; i < datagrams; ++i) sender.write(datagram, ec);
+        },
+        [&, buffer = std::vector<uint8_t>()](udp::socket& receiver, std::error_code& ec) mutable -> size_t {
+            receiver.read(datagram_size, buffer, ec);
+            return ec ? 0 : 1;
+        });
+    bench::report("read/write", single.seconds, single.received, single.received * datagram_size,
+                  single.syscalls);
+
+    for (size_t batch_size : {1, 4, 16, 64, 256}) {
+        result batched = run(
+            [&](udp::socket& sender) {
+                udp::datagram_batch batch(batch_size, datagram_size);
+                while (batch.push(memory_view(datagram.data(), datagram.size()))) {
+                }
+                std::error_code ec;
+                for (size_t sent = 0; sent < datagrams; sent += batch_size) sender.write_batch(batch, ec);
+            },
+            [&, batch = udp::datagram_batch(batch_size, datagram_size)](udp::socket& receiver,
+                                                                         std::error_code& ec) mutable {
+                return receiver.read_batch(batch, ec);
+            });
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "read_batch/write_batch, batch %zu", batch_size);
+        bench::report(name, batched.seconds, batched.received, batched.received * datagram_size, batched.syscalls);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/udp.hpp>
+
+/*
+ * Cost of addressing each datagram on unconnected socket: tuple of
+ * address and port converted to sockaddr on every write (and back on
+ * every read) versus endpoint that keeps native form.
+ *
+ * Datagrams are sent in rounds small enough to fit into socket
+ * receive buffer, both writes and reads are timed.
+ *
+ * Usage: endpoint [datagrams] [datagram size]
+ */
+
+using namespace libwire;
+
+template<typename Write, typename Read>
+static void run(const char* name, size_t datagrams, size_t datagram_size, Write&& write, Read&& read) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    receiver.set_option(receive_buffer_size, 4 * 1024 * 1024);
+    sender.bind(ipv4::loopback, 0);
+
+    std::tuple<address, uint16_t> destination = receiver.local_endpoint();
+    constexpr size_t round = 1000;
+    std::vector<uint8_t> datagram(datagram_size, 0xAF), memory(datagram_size);
+    double seconds = 0;
+    auto start = bench::clock::now();
+    for (size_t done = 0; done < datagrams; done += round) {
+        for (size_t i = 0; i < round; ++i) write(sender, datagram, destination);
+        for (size_t i = 0; i < round; ++i) read(receiver, memory_view(memory.data(), memory.size()));
+    }
+    seconds += bench::seconds_since(start);
+    bench::report(name, seconds, datagrams, datagrams * datagram_size);
+}
+
+int main(int argc, char** argv) {
+    size_t datagrams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t datagram_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+
+    std::printf("%zu datagrams, %zu bytes each\n", datagrams, datagram_size);
+
+    run(
+        "tuple write + read", datagrams, datagram_size,
+        [](udp::socket& sender, const std::vector<uint8_t>& datagram, const std::tuple<address, uint16_t>& to) {
+            sender.write(datagram, to);
+        },
+        [](udp::socket& receiver, memory_view<uint8_t> memory) { receiver.read(memory); });
+
+    endpoint target, source;
+    run(
+        "endpoint write_to + read_from", datagrams, datagram_size,
+        [&](udp::socket& sender, const std::vector<uint8_t>& datagram, const std::tuple<address, uint16_t>& to) {
+            if (target.empty()) target = to;
+            sender.write_to(memory_view(datagram.data(), datagram.size()), target);
+        },
+        [&](udp::socket& receiver, memory_view<uint8_t> memory) { receiver.read_from(memory, source); });
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "common.hpp"
+#include <libwire/endpoint_map.hpp>
+
+/*
+ * Per-peer state lookup by source endpoint, as done when many peers are
+ * served using single UDP socket: table is filled with peers, then
+ * looked up in random order (datagram arrival), looked up with unknown
+ * peers (new peer or spoofed traffic) and churned (peers leave and
+ * new ones arrive).
+ *
+ * endpoint_map is compared against std::unordered_map with endpoint_hash
+ * and with hash combining address bytes one at a time (how
+ * std::hash<address> used to work).
+ *
+ * Usage: endpoint_map [peers] [lookups]
+ */
+
+using namespace libwire;
+
+namespace {
+    using endpoint_key = std::tuple<address, uint16_t>;
+
+    struct bytewise_hash {
+        size_t operator()(const endpoint_key& key) const noexcept {
+            auto result = size_t(std::get<0>(key).version);
+            for (uint8_t part : std::get<0>(key).parts) {
+                result ^= part + 0x9e3779b9u + (result << 6u) + (result >> 2u);
+            }
+            return result ^ (std::get<1>(key) + 0x9e3779b9u + (result << 6u) + (result >> 2u));
+        }
+    };
+
+    struct peer_state {
+        uint64_t datagrams = 0;
+        uint64_t bytes = 0;
+    };
+
+    template<typename Hash>
+    struct unordered_map_adapter {
+        std::unordered_map<endpoint_key, peer_state, Hash> map;
+
+        void reserve(size_t count) {
+            map.reserve(count);
+        }
+
+        peer_state& insert(const endpoint_key& key) {
+            return map[key];
+        }
+
+        peer_state* find(const endpoint_key& key) {
+            auto it = map.find(key);
+            return it == map.end() ? nullptr : &it->second;
+        }
+
+        void erase(const endpoint_key& key) {
+            map.erase(key);
+        }
+    };
+
+    struct endpoint_map_adapter {
+        endpoint_map<peer_state> map;
+
+        void reserve(size_t count) {
+            map.reserve(count);
+        }
+
+        peer_state& insert(const endpoint_key& key) {
+            return map[key];
+        }
+
+        peer_state* find(const endpoint_key& key) {
+            return map.find(key);
+        }
+
+        void erase(const endpoint_key& key) {
+            map.erase(key);
+        }
+    };
+
+    std::vector<endpoint_key> make_peers(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<endpoint_key> peers;
+        peers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t host = rng();
+            // Mix of IPv4 and IPv6 peers with ephemeral ports.
+            if (i % 4 == 0) {
+                uint32_t low = rng();
+                peers.emplace_back(address{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, uint8_t(host >> 24u), uint8_t(host >> 16u),
+                                           uint8_t(host >> 8u), uint8_t(host), uint8_t(low >> 24u),
+                                           uint8_t(low >> 16u), uint8_t(low >> 8u), uint8_t(low)},
+                                   uint16_t(32768 + rng() % 28000));
+            } else {
+                peers.emplace_back(address{uint8_t(host >> 24u), uint8_t(host >> 16u), uint8_t(host >> 8u),
+                                           uint8_t(host)},
+                                   uint16_t(32768 + rng() % 28000));
+            }
+        }
+        return peers;
+    }
+
+    template<typename Map>
+    void run(const char* name, const std::vector<endpoint_key>& peers, const std::vector<endpoint_key>& unknown,
+             size_t lookups) {
+        std::printf(" %s\n", name);
+        Map map;
+        std::mt19937 rng(1);
+
+        auto start = bench::clock::now();
+        map.reserve(peers.size());
+        for (const endpoint_key& peer : peers) map.insert(peer);
+        bench::report("insert", bench::seconds_since(start), peers.size(), 0);
+
+        std::vector<uint32_t> order(lookups);
+        for (uint32_t& index : order) index = uint32_t(rng() % peers.size());
+
+        start = bench::clock::now();
+        for (uint32_t index : order) {
+            peer_state* state = map.find(peers[index]);
+            ++state->datagrams;
+            state->bytes += 64;
+        }
+        bench::report("lookup, known peer", bench::seconds_since(start), lookups, 0);
+
+        size_t found = 0;
+        start = bench::clock::now();
+        for (size_t i = 0; i < lookups; ++i) found += map.find(unknown[i % unknown.size()]) != nullptr;
+        bench::report("lookup, unknown peer", bench::seconds_since(start), lookups, 0);
+
+        // Every peer is replaced by unknown one, then unknown ones leave.
+        size_t churn = std::min(peers.size(), unknown.size());
+        start = bench::clock::now();
+        for (size_t i = 0; i < churn; ++i) {
+            map.erase(peers[i]);
+            map.insert(unknown[i]);
+        }
+        for (size_t i = 0; i < churn; ++i) {
+            map.erase(unknown[i]);
+            map.insert(peers[i]);
+        }
+        bench::report("churn (erase + insert)", bench::seconds_since(start), churn * 2, 0);
+
+        if (found != 0) std::printf("  (unexpected: %zu unknown peers found)\n", found);
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t peers_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+    auto peers = make_peers(peers_count, 42);
+    auto unknown = make_peers(peers_count, 43);
+    std::printf("%zu peers, %zu lookups, %zu bytes per endpoint_map slot\n", peers_count, lookups,
+                sizeof(endpoint_key) + sizeof(peer_state) + 1);
+
+    run<unordered_map_adapter<bytewise_hash>>("std::unordered_map, byte-wise hash", peers, unknown, lookups);
+    run<unordered_map_adapter<endpoint_hash>>("std::unordered_map, endpoint_hash", peers, unknown, lookups);
+    run<endpoint_map_adapter>("endpoint_map", peers, unknown, lookups);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/udp.hpp>
+
+/*
+ * Datagram rate over loopback with and without UDP offloads: sender
+ * writes datagrams one by one or as 64 KiB buffers split by kernel
+ * (write_segmented, GSO), receiver reads them one by one or lets kernel
+ * coalesce them (read_coalesced with receive_offload, GRO).
+ *
+ * Loopback drops datagrams if receiver falls behind, so rate of
+ * received datagrams is reported, syscalls are counted for receiver.
+ *
+ * Usage: offload [datagrams] [datagram size]
+ */
+
+using namespace libwire;
+using namespace std::literals;
+
+template<typename Send, typename Receive>
+static void run(const char* name, size_t datagram_size, bool gro, Send&& send, Receive&& receive) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    receiver.set_option(receive_buffer_size, 4 * 1024 * 1024);
+    receiver.set_option(receive_timeout, 100ms);
+    if (gro) {
+        receiver.set_option(udp::receive_offload, true);
+        if (!receiver.option(udp::receive_offload)) std::printf("  receive offload is not supported\n");
+    }
+    sender.associate(ipv4::loopback, std::get<1>(receiver.local_endpoint()));
+
+    size_t received = 0;
+    double seconds = 0;
+    auto start = bench::clock::now();
+    std::thread sender_thread([&] { send(sender); });
+
+    uint64_t syscalls_before = bench::syscalls();
+    for (;;) {
+        std::error_code ec;
+        size_t count = receive(receiver, ec);
+        if (ec) break;
+        received += count;
+        seconds = bench::seconds_since(start);
+    }
+    uint64_t syscalls_made = bench::syscalls() - syscalls_before;
+    sender_thread.join();
+
+    bench::report(name, seconds, received, received * datagram_size, syscalls_made);
+}
+
+int main(int argc, char** argv) {
+    size_t datagrams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t datagram_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1200;
+
+    std::printf("%zu datagrams, %zu bytes each\n", datagrams, datagram_size);
+
+    size_t per_buffer = 64 * 1024 / datagram_size;
+    std::vector<uint8_t> buffer(per_buffer * datagram_size, 0xAF);
+    std::vector<uint8_t> input(64 * 1024);
+    memory_view<uint8_t> input_view(input.data(), input.size());
+
+    auto write_each = [&](udp::socket& sender) {
+        std::error_code ec;
+        memory_view<const uint8_t> datagram(buffer.data(), datagram_size);
+        for (size_t i = 0; i < datagrams; ++i) sender.write(datagram, ec);
+    };
+    auto write_segmented = [&](udp::socket& sender) {
+        std::error_code ec;
+        for (size_t sent = 0; sent < datagrams; sent += per_buffer) {
+            sender.write_segmented(memory_view(buffer.data(), buffer.size()), datagram_size, ec);
+        }
+    };
+    auto read_each = [&](udp::socket& receiver, std::error_code& ec) -> size_t {
+        receiver.read_coalesced(input_view, ec);
+        return ec ? 0 : 1;
+    };
+    auto read_coalesced = [&](udp::socket& receiver, std::error_code& ec) -> size_t {
+        udp::coalesced_datagrams received = receiver.read_coalesced(input_view, ec);
+        return ec ? 0 : received.count();
+    };
+
+    run("write/read", datagram_size, false, write_each, read_each);
+    run("write_segmented/read (GSO)", datagram_size, false, write_segmented, read_each);
+    run("write_segmented/read_coalesced (GSO+GRO)", datagram_size, true, write_segmented, read_coalesced);
+}
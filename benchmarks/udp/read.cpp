@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/udp.hpp>
+
+/*
+ * Cost of receiving small datagrams into buffer sized for largest
+ * possible datagram: std::vector is zero-filled on every read,
+ * byte_buffer and memory_view are not.
+ *
+ * Datagrams are queued in rounds small enough to fit into socket
+ * receive buffer, only reads are timed.
+ *
+ * Usage: read [datagrams] [datagram size] [max size]
+ */
+
+using namespace libwire;
+
+template<typename Read>
+static void run(const char* name, size_t datagrams, size_t datagram_size, Read&& read) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    receiver.set_option(receive_buffer_size, 4 * 1024 * 1024);
+    sender.associate(ipv4::loopback, std::get<1>(receiver.local_endpoint()));
+
+    constexpr size_t round = 1000;
+    std::vector<uint8_t> datagram(datagram_size, 0xAF);
+    double seconds = 0;
+    for (size_t done = 0; done < datagrams; done += round) {
+        for (size_t i = 0; i < round; ++i) sender.write(datagram);
+
+        auto start = bench::clock::now();
+        for (size_t i = 0; i < round; ++i) read(receiver);
+        seconds += bench::seconds_since(start);
+    }
+    bench::report(name, seconds, datagrams, datagrams * datagram_size);
+}
+
+int main(int argc, char** argv) {
+    size_t datagrams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t datagram_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    size_t max_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64 * 1024;
+
+    std::printf("%zu datagrams, %zu bytes each, read with max size %zu\n", datagrams, datagram_size, max_size);
+
+    std::vector<uint8_t> vector;
+    run("read into std::vector", datagrams, datagram_size, [&](udp::socket& receiver) {
+        receiver.read(max_size, vector);
+    });
+
+    byte_buffer buffer;
+    run("read into byte_buffer", datagrams, datagram_size, [&](udp::socket& receiver) {
+        receiver.read(max_size, buffer);
+    });
+
+    std::vector<uint8_t> memory(max_size);
+    run("read into memory_view", datagrams, datagram_size, [&](udp::socket& receiver) {
+        receiver.read(memory_view(memory.data(), memory.size()));
+    });
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include "common.hpp"
+#include <libwire/dns/cache.hpp>
+
+/*
+ * Lookup throughput of dns::resolver depending on count of lookups in
+ * flight. Server on loopback answers every query with one A record
+ * after fixed delay, which models round trip to recursive resolver.
+ * Blocking resolver (getaddrinfo) behaves like window of 1 per thread.
+ * Windows are kept below what default socket buffers hold as burst.
+ * Last run repeats small set of names through dns::cache.
+ *
+ * Usage: resolver [lookups] [server delay, us]
+ */
+
+using namespace libwire;
+
+namespace {
+    class responder {
+    public:
+        explicit responder(std::chrono::microseconds delay) : delay_(delay) {
+            socket_.bind(ipv4::loopback, 0);
+            thread_ = std::thread([this] { run(); });
+        }
+
+        ~responder() {
+            stop_ = true;
+            thread_.join();
+        }
+
+        endpoint local_endpoint() {
+            return socket_.local_endpoint();
+        }
+
+    private:
+        struct pending {
+            bench::clock::time_point due;
+            std::vector<uint8_t> reply;
+            endpoint peer;
+        };
+
+        void run() {
+            std::deque<pending> queue;
+            std::vector<uint8_t> buffer(512);
+            while (!stop_) {
+                int timeout_ms = 10;
+                if (!queue.empty()) {
+                    auto left = std::chrono::ceil<std::chrono::milliseconds>(queue.front().due - bench::clock::now());
+                    timeout_ms = int(std::max<int64_t>(left.count(), 0));
+                }
+                // Drain everything readable, otherwise burst of queries
+                // overflows socket receive buffer.
+                pollfd descriptor{socket_.native_handle(), POLLIN, 0};
+                while (::poll(&descriptor, 1, timeout_ms) > 0) {
+                    std::error_code ec;
+                    endpoint peer;
+                    size_t size = socket_.read_from(memory_view(buffer.data(), buffer.size()), peer, ec);
+                    if (!ec) queue.push_back({bench::clock::now() + delay_, reply(buffer.data(), size), peer});
+                    timeout_ms = 0;
+                }
+                while (!queue.empty() && queue.front().due <= bench::clock::now()) {
+                    socket_.write_to(make_view(queue.front().reply), queue.front().peer);
+                    queue.pop_front();
+                }
+            }
+        }
+
+        // Question copied from query, one A record pointing to it.
+        static std::vector<uint8_t> reply(const uint8_t* query, size_t size) {
+            size_t offset = 12;
+            while (offset < size && query[offset] != 0) offset += query[offset] + 1u;
+            std::vector<uint8_t> message(query, query + std::min(offset + 5, size));
+            message[2] = 0x81;
+            message[3] = 0x80;
+            message[7] = 1;  // ANCOUNT
+            message[11] = 0; // ARCOUNT, OPT is not echoed
+            const uint8_t answer[] = {0xc0, 12, 0, 1, 0, 1, 0, 0, 1, 0x2c, 0, 4, 127, 0, 0, 1};
+            message.insert(message.end(), std::begin(answer), std::end(answer));
+            return message;
+        }
+
+        udp::socket socket_{ip::v4};
+        std::chrono::microseconds delay_;
+        std::atomic<bool> stop_{false};
+        std::thread thread_;
+    };
+
+    void run(const char* name, responder& server, size_t lookups, size_t window) {
+        io_context context;
+        dns::resolver::config settings;
+        settings.nameservers = {server.local_endpoint()};
+        dns::resolver resolver{context, settings};
+
+        size_t started = 0, failed = 0;
+        std::function<void()> start_next = [&] {
+            std::string host = "host-" + std::to_string(started++) + ".bench";
+            resolver.async_resolve(ip::v4, host, [&](std::error_code ec, const dns::answer&) {
+                if (ec) ++failed;
+                if (started < lookups) start_next();
+            });
+        };
+
+        auto start = bench::clock::now();
+        while (started < std::min(window, lookups)) start_next();
+        context.run();
+        bench::report(name, bench::seconds_since(start), lookups, 0);
+        if (failed != 0) std::printf("    %zu lookups failed\n", failed);
+    }
+
+    void run_cached(const char* name, responder& server, size_t lookups, size_t window, size_t names) {
+        io_context context;
+        dns::resolver::config settings;
+        settings.nameservers = {server.local_endpoint()};
+        dns::resolver resolver{context, settings};
+        dns::cache cache{resolver};
+
+        size_t started = 0, failed = 0;
+        std::function<void()> start_next = [&] {
+            std::string host = "host-" + std::to_string(started++ % names) + ".bench";
+            cache.async_resolve(ip::v4, host, [&](std::error_code ec, const dns::answer&) {
+                if (ec) ++failed;
+                if (started < lookups) start_next();
+            });
+        };
+
+        auto start = bench::clock::now();
+        while (started < std::min(window, lookups)) start_next();
+        context.run();
+        bench::report(name, bench::seconds_since(start), lookups, 0);
+        if (failed != 0) std::printf("    %zu lookups failed\n", failed);
+
+        dns::cache::statistics stats = cache.stats();
+        std::printf("    %llu hits, %llu misses\n", static_cast<unsigned long long>(stats.hits),
+                    static_cast<unsigned long long>(stats.misses));
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t lookups = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::chrono::microseconds delay(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000);
+
+    std::printf("%zu lookups, server delay %lld us\n", lookups, static_cast<long long>(delay.count()));
+    responder server(delay);
+    for (size_t window : {1, 16, 64, 128}) {
+        std::string name = std::to_string(window) + " in flight";
+        run(name.c_str(), server, lookups, window);
+    }
+    run_cached("16 in flight, 64 names, cached", server, lookups * 10, 16, 64);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "common.hpp"
+#include <libwire/options.hpp>
+#include <libwire/udp.hpp>
+
+/*
+ * Many peers talking to one server endpoint: single socket with lookup
+ * of peer state by source endpoint in user space versus connected
+ * session socket per peer created by udp::listener and polled using
+ * epoll, peer state is found by epoll event data.
+ *
+ * Every peer sends one datagram per pass, datagrams are sent in windows
+ * small enough to fit into socket receive buffer, only server side is
+ * timed. Session creation is reported separately.
+ *
+ * Each peer needs two descriptors (client and session), so number of
+ * peers is limited by RLIMIT_NOFILE.
+ *
+ * Usage: sessions [peers] [passes]
+ */
+
+using namespace libwire;
+
+namespace {
+    constexpr size_t window = 100;
+    constexpr size_t datagram_size = 64;
+
+    struct endpoint_hash {
+        size_t operator()(const std::tuple<address, uint16_t>& endpoint) const noexcept {
+            return std::hash<address>{}(std::get<0>(endpoint)) ^ (size_t(std::get<1>(endpoint)) << 1);
+        }
+    };
+
+    struct peer_state {
+        uint64_t received = 0;
+    };
+
+    size_t raise_descriptor_limit() {
+        rlimit limit{};
+        getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        return limit.rlim_cur;
+    }
+
+    std::vector<udp::socket> make_clients(size_t peers) {
+        std::vector<udp::socket> clients;
+        clients.reserve(peers);
+        for (size_t i = 0; i < peers; ++i) {
+            clients.emplace_back(ip::v4);
+            clients.back().bind(ipv4::loopback, 0);
+        }
+        return clients;
+    }
+
+    /**
+     * Send one datagram from every client to destination, calling
+     * receive after each window.
+     */
+    template<typename Receive>
+    double run_passes(std::vector<udp::socket>& clients, std::tuple<address, uint16_t> destination, size_t passes,
+                      Receive&& receive) {
+        std::vector<uint8_t> datagram(datagram_size, 0xAF);
+        double seconds = 0;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            for (size_t first = 0; first < clients.size(); first += window) {
+                size_t last = std::min(first + window, clients.size());
+                for (size_t i = first; i < last; ++i) clients[i].write(datagram, destination);
+
+                auto start = bench::clock::now();
+                receive(last - first);
+                seconds += bench::seconds_since(start);
+            }
+        }
+        return seconds;
+    }
+
+    void single_socket(std::vector<udp::socket>& clients, size_t passes) {
+        udp::socket server(ip::v4);
+        server.bind(ipv4::loopback, 0);
+        server.set_option(receive_timeout, std::chrono::seconds(5));
+
+        std::unordered_map<std::tuple<address, uint16_t>, peer_state, endpoint_hash> peers;
+        peers.reserve(clients.size());
+        for (auto& client : clients) peers.emplace(client.local_endpoint(), peer_state{});
+
+        std::vector<uint8_t> buffer(2048);
+        uint64_t lost = 0;
+        double seconds = run_passes(clients, server.local_endpoint(), passes, [&](size_t expected) {
+            for (size_t i = 0; i < expected; ++i) {
+                std::error_code ec;
+                auto [size, source] = server.read(memory_view(buffer.data(), buffer.size()), ec);
+                if (ec) {
+                    ++lost;
+                    continue;
+                }
+                auto peer = peers.find(source);
+                if (peer != peers.end()) ++peer->second.received;
+            }
+        });
+        uint64_t datagrams = clients.size() * passes;
+        bench::report("single socket, user-space demux", seconds, datagrams, datagrams * datagram_size);
+        if (lost != 0) std::printf("  (%llu datagrams lost)\n", (unsigned long long)lost);
+    }
+
+    void listener_sessions(std::vector<udp::socket>& clients, size_t passes) {
+        udp::listener listener(ipv4::loopback, 0);
+        listener.set_option(receive_timeout, std::chrono::seconds(5));
+
+        std::vector<udp::socket> sessions;
+        std::vector<peer_state> peers(clients.size());
+        sessions.reserve(clients.size());
+
+        std::vector<uint8_t> buffer(2048), datagram(datagram_size, 0xAF);
+        auto start = bench::clock::now();
+        for (auto& client : clients) {
+            client.write(datagram, listener.local_endpoint());
+            size_t size;
+            sessions.push_back(listener.accept(memory_view(buffer.data(), buffer.size()), size));
+        }
+        double accept_seconds = bench::seconds_since(start);
+        bench::report("listener, session creation", accept_seconds, clients.size(), clients.size() * datagram_size);
+
+        int epoll = epoll_create1(EPOLL_CLOEXEC);
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            sessions[i].set_option(non_blocking, true);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, sessions[i].native_handle(), &event);
+        }
+
+        std::vector<epoll_event> events(window);
+        double seconds = run_passes(clients, listener.local_endpoint(), passes, [&](size_t expected) {
+            size_t received = 0;
+            while (received < expected) {
+                int ready = epoll_wait(epoll, events.data(), int(events.size()), 5000);
+                if (ready <= 0) break;
+                for (int i = 0; i < ready; ++i) {
+                    // Level-triggered: if more is queued, session will be reported
+                    // again, so there is no extra read to get try_again.
+                    size_t index = events[i].data.u64;
+                    std::error_code ec;
+                    sessions[index].read(memory_view(buffer.data(), buffer.size()), ec);
+                    if (ec) continue;
+                    ++peers[index].received;
+                    ++received;
+                }
+            }
+        });
+        close(epoll);
+
+        uint64_t datagrams = clients.size() * passes;
+        bench::report("listener sessions, epoll", seconds, datagrams, datagrams * datagram_size);
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t peers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t passes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    size_t limit = raise_descriptor_limit();
+    size_t max_peers = limit > 64 ? (limit - 64) / 2 : 0;
+    if (peers > max_peers) {
+        std::printf("RLIMIT_NOFILE is %zu, using %zu peers instead of %zu\n", limit, max_peers, peers);
+        peers = max_peers;
+    }
+    std::printf("%zu peers, %zu datagrams of %zu bytes from each\n", peers, passes, datagram_size);
+
+    {
+        auto clients = make_clients(peers);
+        single_socket(clients, passes);
+    }
+    {
+        auto clients = make_clients(peers);
+        listener_sessions(clients, passes);
+    }
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <libwire/io_context.hpp>
+
+/**
+ * \example async_echo_server.cpp
+ *
+ * Same as echo_server.cpp but serves all connections at once using
+ * \ref libwire::io_context running on all available threads.
+ *
+ * Every connection is represented by session object which lives as long as
+ * there are pending operations for it: each handler holds shared_ptr to it.
+ */
+
+using namespace libwire;
+
+struct session : std::enable_shared_from_this<session> {
+    session(io_context& context, tcp::socket socket) : context(context), socket(std::move(socket)) {
+    }
+
+    void read() {
+        auto self = shared_from_this();
+        context.async_read_until(socket, '\n', line, [self](std::error_code ec, size_t) {
+            if (ec) return;
+            self->line.push_back('\n');
+            self->context.async_write(self->socket, make_view(std::as_const(self->line)),
+                                      [self](std::error_code ec, size_t) {
+                                          if (!ec) self->read();
+                                      });
+        });
+    }
+
+    io_context& context;
+    tcp::socket socket;
+    std::string line;
+};
+
+static void accept(io_context& context, tcp::listener& listener) {
+    context.async_accept(listener, [&](std::error_code ec, tcp::socket socket) {
+        if (!ec) std::make_shared<session>(context, std::move(socket))->read();
+        accept(context, listener);
+    });
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: async-echo-server <port>\n";
+        return 1;
+    }
+
+    uint16_t port = std::stoi(argv[1]);
+
+    io_context context;
+    tcp::listener listener;
+    listener.listen(ipv4::any, port);
+    accept(context, listener);
+
+    std::cout << "Listening on port " << port << ".\n";
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::thread::hardware_concurrency(); ++i) {
+        threads.emplace_back([&] { context.run(); });
+    }
+    context.run();
+    for (auto& thread : threads) thread.join();
+}
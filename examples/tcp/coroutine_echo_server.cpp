@@ -0,0 +1,55 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <libwire/coroutine.hpp>
+
+/**
+ * \example coroutine_echo_server.cpp
+ *
+ * Same as async_echo_server.cpp but written using coroutines, each
+ * connection is served by its own coroutine. Requires C++20.
+ */
+
+using namespace libwire;
+
+static coro::task<> session(io_context& context, tcp::socket socket) {
+    std::string line;
+    for (;;) {
+        auto [ec, size] = co_await coro::read_until(context, socket, '\n', line);
+        if (ec) co_return;
+        line.push_back('\n');
+        auto written = co_await coro::write(context, socket, make_view(std::as_const(line)));
+        if (written.ec) co_return;
+    }
+}
+
+static coro::task<> accept_loop(io_context& context, tcp::listener& listener) {
+    for (;;) {
+        auto [ec, socket] = co_await coro::accept(context, listener);
+        if (!ec) coro::spawn(context, session(context, std::move(socket)));
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: coroutine-echo-server <port>\n";
+        return 1;
+    }
+
+    uint16_t port = std::stoi(argv[1]);
+
+    io_context context;
+    tcp::listener listener;
+    listener.listen(ipv4::any, port);
+    coro::spawn(context, accept_loop(context, listener));
+
+    std::cout << "Listening on port " << port << ".\n";
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::thread::hardware_concurrency(); ++i) {
+        threads.emplace_back([&] { context.run(); });
+    }
+    context.run();
+    for (auto& thread : threads) thread.join();
+}
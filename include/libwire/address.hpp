@@ -24,10 +24,13 @@
 
 #include <cstdint>
 #include <array>
+#include <charconv>
 #include <string_view>
 #include <string>
+#include <tuple>
 #include <libwire/protocols.hpp>
 #include <libwire/memory_view.hpp>
+#include <libwire/internal/address_text.hpp>
 
 /**
  * \file address.hpp
@@ -57,7 +60,8 @@ namespace libwire {
      * expect.
      *
      * If you have some hardcoded address then it's better to specify it
-     * using initializer list e.g. {127, 0, 0, 1}. This will avoid runtime
+     * using literal e.g. "127.0.0.1"_ipv4 (see \ref literals) or
+     * initializer list e.g. {127, 0, 0, 1}. This will avoid runtime
      * overhead of string parsing.
      */
     struct address {
@@ -71,17 +75,21 @@ namespace libwire {
          * Construct IPv4 address from 4 bytes in network byte order (big endian).
          * Thus 127.0.0.1 => {127, 0, 0, 1}
          */
-        address(uint8_t, uint8_t, uint8_t, uint8_t) noexcept;
+        constexpr address(uint8_t o1, uint8_t o2, uint8_t o3, uint8_t o4) noexcept
+            : version(ip::v4), parts{o1, o2, o3, o4} {
+        }
 
         /**
          * Construct IPv6 address from 16 bytes in network byte order (big endian).
          * Thus ::1 => {0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,1}
          *
-         * \todo Sadly, there is no good way to short-cut it, if you can come up with
-         * a solution without templates hell - PR's are welcome!
+         * "::1"_ipv6 literal is usually more readable.
          */
-        address(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t,
-                uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) noexcept;
+        constexpr address(uint8_t o1, uint8_t o2, uint8_t o3, uint8_t o4, uint8_t o5, uint8_t o6, uint8_t o7,
+                          uint8_t o8, uint8_t o9, uint8_t o10, uint8_t o11, uint8_t o12, uint8_t o13, uint8_t o14,
+                          uint8_t o15, uint8_t o16) noexcept
+            : version(ip::v6), parts{o1, o2, o3, o4, o5, o6, o7, o8, o9, o10, o11, o12, o13, o14, o15, o16} {
+        }
 
         /**
          * Parse IP address from string. supports both IPv4 and IPv6,
@@ -101,6 +109,9 @@ namespace libwire {
          * Parse IP address from string. supports both IPv4 and IPv6,
          * use version member variable to determine address version.
          *
+         * Only characters inside view are read, string doesn't have to be
+         * NUL-terminated. Nothing is allocated.
+         *
          * Sets success to true if supplied address is valid, false
          * otherwise. Value of address is undefined if success is
          * false.
@@ -117,28 +128,108 @@ namespace libwire {
          */
         std::string to_string() const noexcept;
 
-        bool operator==(const address&) const noexcept;
-        bool operator!=(const address&) const noexcept;
+        /**
+         * Maximum length of text written by to_chars().
+         */
+        static constexpr size_t max_text_size = 45;
+
+        /**
+         * Write same text as to_string() gives into [first, last) without
+         * allocating. No terminating NUL is written.
+         *
+         * Returns pointer past written text, or last and
+         * std::errc::value_too_large if text doesn't fit. Buffer of
+         * max_text_size characters is always enough.
+         */
+        std::to_chars_result to_chars(char* first, char* last) const noexcept;
+
+        constexpr bool operator==(const address& o) const noexcept {
+            if (version != o.version) return false;
+            for (size_t i = 0; i < parts.size(); ++i) {
+                if (parts[i] != o.parts[i]) return false;
+            }
+            return true;
+        }
+
+        constexpr bool operator!=(const address& o) const noexcept {
+            return !(*this == o);
+        }
 
         ip version;
         std::array<uint8_t, 16> parts;
     };
 
+    namespace internal_ {
+        /**
+         * Called by literal operators on invalid text. Not constexpr, so
+         * in constant expression this is a compile error.
+         */
+        [[noreturn]] void invalid_address_literal();
+    } // namespace internal_
+
+    /**
+     * User-defined literals for addresses and endpoints.
+     *
+     * Text is parsed at compile time when literal is used in constant
+     * expression (e.g. to initialize constexpr variable), then invalid
+     * text is a compile error. In other contexts invalid text throws
+     * std::invalid_argument (or aborts if exceptions are disabled).
+     * \code
+     * constexpr address gateway = "10.0.0.1"_ipv4;
+     * constexpr std::tuple<address, uint16_t> dns = "[2001:4860:4860::8888]:53"_ep;
+     * \endcode
+     */
+    inline namespace literals {
+        /**
+         * IPv4 address in dotted-quad form, "10.0.0.1"_ipv4.
+         */
+        constexpr address operator""_ipv4(const char* text, size_t size) {
+            address result{0, 0, 0, 0};
+            if (!internal_::parse_ipv4_scalar(text, size, result.parts.data())) internal_::invalid_address_literal();
+            return result;
+        }
+
+        /**
+         * IPv6 address, "fe80::1"_ipv6.
+         */
+        constexpr address operator""_ipv6(const char* text, size_t size) {
+            address result{0, 0, 0, 0};
+            result.version = ip::v6;
+            if (!internal_::parse_ipv6(text, size, result.parts.data())) internal_::invalid_address_literal();
+            return result;
+        }
+
+        /**
+         * Address and port, "127.0.0.1:8080"_ep or "[::1]:8080"_ep.
+         *
+         * Result is implicitly convertible to \ref endpoint.
+         */
+        constexpr std::tuple<address, uint16_t> operator""_ep(const char* text, size_t size) {
+            address result{0, 0, 0, 0};
+            bool ipv6 = false;
+            uint16_t port = 0;
+            if (!internal_::parse_endpoint(text, size, result.parts.data(), ipv6, port)) {
+                internal_::invalid_address_literal();
+            }
+            if (ipv6) result.version = ip::v6;
+            return {result, port};
+        }
+    } // namespace literals
+
     /**
      * Namespace with few IPv4 address constants.
      */
     namespace ipv4 {
-        inline address any = {0, 0, 0, 0}, broadcast = {255, 255, 255, 255}, loopback = {127, 0, 0, 1};
+        inline constexpr address any = "0.0.0.0"_ipv4, broadcast = "255.255.255.255"_ipv4,
+                                 loopback = "127.0.0.1"_ipv4;
     } // namespace ipv4
 
     /**
      * Namespace with few IPv6 address constants.
      */
     namespace ipv6 {
-        inline address any = {0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
-                       broadcast = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-                                    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
-                       loopback = {0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x1};
+        inline constexpr address any = "::"_ipv6, broadcast = "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"_ipv6,
+                                 loopback = "::1"_ipv6;
     } // namespace ipv6
 } // namespace libwire
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace libwire {
+    /**
+     * Allocator adaptor which default-initializes elements instead of
+     * value-initializing them.
+     *
+     * Growing container of trivial type (e.g. using resize()) with this
+     * allocator leaves new elements uninitialized instead of zero-filling
+     * memory which is going to be overwritten by read anyway.
+     */
+    template<typename T, typename Allocator = std::allocator<T>>
+    class default_init_allocator : public Allocator {
+        using traits = std::allocator_traits<Allocator>;
+
+    public:
+        template<typename U>
+        struct rebind {
+            using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+        };
+
+        using Allocator::Allocator;
+
+        template<typename U>
+        void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+            ::new (static_cast<void*>(ptr)) U;
+        }
+
+        template<typename U, typename... Args>
+        void construct(U* ptr, Args&&... args) {
+            traits::construct(static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+        }
+    };
+
+    /**
+     * Byte container which is not zero-filled on resize.
+     *
+     * Prefer it over std::vector<uint8_t> for read functions which
+     * resize buffer to maximum size before receiving data
+     * (udp::socket::read, tcp::socket::read, etc).
+     *
+     * **Example**
+     * \code
+     * libwire::byte_buffer buffer;
+     * socket.read(64 * 1024, buffer); // No 64 KiB memset before every read.
+     * \endcode
+     */
+    using byte_buffer = std::vector<uint8_t, default_init_allocator<uint8_t>>;
+} // namespace libwire
@@ -0,0 +1,499 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#    error "libwire/coroutine.hpp requires C++20 coroutines support."
+#endif
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <libwire/io_context.hpp>
+
+/**
+ * \file coroutine.hpp
+ *
+ * This file defines awaitable wrappers for io_context operations.
+ * Unlike the rest of library it requires C++20.
+ */
+
+namespace libwire::coro {
+    /**
+     * Result of awaited operation: error code and value.
+     *
+     * Value is set even if error occurred, e.g. count of bytes
+     * transferred before error.
+     */
+    template<typename T>
+    struct result {
+        std::error_code ec;
+        T value{};
+
+        explicit operator bool() const noexcept {
+            return !ec;
+        }
+
+#ifdef __cpp_exceptions
+        /**
+         * Return value or throw std::system_error if error occurred.
+         */
+        T value_or_throw() && {
+            if (ec) throw std::system_error(ec);
+            return std::move(value);
+        }
+#endif
+    };
+
+    template<typename T = void>
+    class task;
+} // namespace libwire::coro
+
+namespace libwire::internal_ {
+    /**
+     * List node of coroutine started by coro::spawn.
+     */
+    struct spawned_coroutine : spawned_frame {
+        std::coroutine_handle<> handle;
+    };
+
+    struct task_promise_base {
+        /*
+         * Frames are allocated from pool of io_context passed as first
+         * argument or, if there is no such argument, from pool of
+         * io_context executing run() in current thread.
+         */
+        static void* operator new(size_t size) {
+            return frame_pool::allocate(current_frame_pool(), size);
+        }
+
+        template<typename... Args>
+        static void* operator new(size_t size, io_context& context, Args&...) {
+            return frame_pool::allocate(&coroutine_access::pool(context), size);
+        }
+
+        static void operator delete(void* pointer) noexcept {
+            frame_pool::deallocate(pointer);
+        }
+
+        template<typename... Args>
+        static void operator delete(void* pointer, io_context&, Args&...) noexcept {
+            frame_pool::deallocate(pointer);
+        }
+
+        struct final_awaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                task_promise_base& promise = handle.promise();
+                if (promise.continuation) return promise.continuation;
+                if (promise.owner != nullptr) promise.finish_spawned();
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {
+            }
+        };
+
+        std::suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+
+        final_awaiter final_suspend() const noexcept {
+            return {};
+        }
+
+        void unhandled_exception() noexcept {
+#ifdef __cpp_exceptions
+            exception = std::current_exception();
+#else
+            std::terminate();
+#endif
+        }
+
+        void rethrow_if_failed() {
+#ifdef __cpp_exceptions
+            if (exception) std::rethrow_exception(exception);
+#endif
+        }
+
+        /**
+         * Unlink finished spawned coroutine from owner and destroy it.
+         * Exception escaped coroutine is rethrown from owner's run().
+         */
+        void finish_spawned() noexcept {
+            io_context& context = *owner;
+            coroutine_access::detach(context, &node);
+#ifdef __cpp_exceptions
+            std::exception_ptr escaped = std::move(exception);
+            node.handle.destroy();
+            if (escaped) context.post([escaped] { std::rethrow_exception(escaped); });
+#else
+            node.handle.destroy();
+#endif
+        }
+
+        /// Coroutine awaiting this one.
+        std::coroutine_handle<> continuation;
+
+        /// Set for coroutines started by coro::spawn.
+        io_context* owner = nullptr;
+        spawned_coroutine node;
+
+#ifdef __cpp_exceptions
+        std::exception_ptr exception;
+#endif
+    };
+
+    template<typename T>
+    struct task_promise final : task_promise_base {
+        coro::task<T> get_return_object() noexcept;
+
+        template<typename Value>
+        void return_value(Value&& returned) {
+            value.emplace(std::forward<Value>(returned));
+        }
+
+        T take() {
+            rethrow_if_failed();
+            return std::move(*value);
+        }
+
+        std::optional<T> value;
+    };
+
+    template<>
+    struct task_promise<void> final : task_promise_base {
+        coro::task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept {
+        }
+
+        void take() {
+            rethrow_if_failed();
+        }
+    };
+
+    /**
+     * Awaitable starting io_context operation when coroutine is suspended
+     * and resuming it from completion handler.
+     *
+     * Value is void for operations reporting only error code, then
+     * awaiting returns std::error_code instead of coro::result.
+     */
+    template<typename Value, typename Initiation>
+    class io_awaitable {
+    public:
+        explicit io_awaitable(Initiation initiation) : initiation_(std::move(initiation)) {
+        }
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            // Coroutine may be resumed by other thread before initiation
+            // returns, so don't touch frame after starting operation.
+            Initiation initiation = std::move(initiation_);
+            initiation([this, handle](std::error_code ec, auto&&... values) {
+                store(ec, std::forward<decltype(values)>(values)...);
+                handle.resume();
+            });
+        }
+
+        auto await_resume() {
+            if constexpr (std::is_void_v<Value>) {
+                return ec_;
+            } else {
+                return coro::result<Value>{ec_, std::move(*value_)};
+            }
+        }
+
+    private:
+        struct no_value {};
+
+        template<typename... Values>
+        void store(std::error_code ec, Values&&... values) {
+            ec_ = ec;
+            if constexpr (sizeof...(Values) != 0) value_.emplace(std::forward<Values>(values)...);
+        }
+
+        Initiation initiation_;
+        std::error_code ec_;
+        std::optional<std::conditional_t<std::is_void_v<Value>, no_value, Value>> value_;
+    };
+
+    template<typename Value, typename Initiation>
+    io_awaitable<Value, Initiation> make_io_awaitable(Initiation initiation) {
+        return io_awaitable<Value, Initiation>(std::move(initiation));
+    }
+} // namespace libwire::internal_
+
+namespace libwire::coro {
+    /**
+     * Lazily started coroutine returning T.
+     *
+     * Coroutine starts when task is awaited, awaiting coroutine is
+     * resumed when it returns. Exceptions escaped coroutine are
+     * rethrown by co_await. Top-level task is started using \ref spawn.
+     *
+     * Quick usage example:
+     * \code
+     * coro::task<> session(io_context& context, tcp::socket socket) {
+     *     std::vector<uint8_t> buffer(64);
+     *     for (;;) {
+     *         auto [ec, read] = co_await coro::read_some(context, socket, make_view(buffer));
+     *         if (ec) co_return;
+     *         co_await coro::write(context, socket, make_view(buffer.data(), read));
+     *     }
+     * }
+     *
+     * coro::task<> server(io_context& context, tcp::listener& listener) {
+     *     for (;;) {
+     *         auto [ec, socket] = co_await coro::accept(context, listener);
+     *         if (!ec) coro::spawn(context, session(context, std::move(socket)));
+     *     }
+     * }
+     * \endcode
+     *
+     * Frames of coroutines which take io_context reference as first
+     * argument are allocated from memory pool of that io_context, frames
+     * of other coroutines created by thread executing run() are allocated
+     * from pool of io_context being run. Such coroutines should finish
+     * before io_context is destroyed.
+     */
+    template<typename T>
+    class [[nodiscard]] task {
+    public:
+        using promise_type = internal_::task_promise<T>;
+
+        task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {
+        }
+
+        task& operator=(task&& other) noexcept {
+            if (this != &other) {
+                if (handle_) handle_.destroy();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+
+        task(const task&) = delete;
+        task& operator=(const task&) = delete;
+
+        ~task() {
+            if (handle_) handle_.destroy();
+        }
+
+        auto operator co_await() const noexcept {
+            struct awaiter {
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume() {
+                    return handle.promise().take();
+                }
+
+                std::coroutine_handle<promise_type> handle;
+            };
+            return awaiter{handle_};
+        }
+
+    private:
+        friend promise_type;
+        friend void spawn(io_context& context, task<void> coroutine);
+
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {
+        }
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    /**
+     * Start coroutine from run() of context without waiting for it.
+     *
+     * Coroutine is destroyed once it returns, if it's still suspended
+     * when context is destroyed, it's destroyed together with context.
+     * Exception escaped coroutine is propagated from run().
+     */
+    inline void spawn(io_context& context, task<void> coroutine) {
+        std::coroutine_handle<internal_::task_promise<void>> handle = std::exchange(coroutine.handle_, {});
+        internal_::task_promise<void>& promise = handle.promise();
+        promise.owner = &context;
+        promise.node.handle = handle;
+        promise.node.destroy = [](internal_::spawned_frame* frame) noexcept {
+            static_cast<internal_::spawned_coroutine*>(frame)->handle.destroy();
+        };
+        internal_::coroutine_access::attach(context, &promise.node);
+        context.post([handle] { handle.resume(); });
+    }
+
+    /**
+     * Accept connection from listener queue, see \ref io_context::async_accept.
+     */
+    inline auto accept(io_context& context, tcp::listener& listener) {
+        return internal_::make_io_awaitable<tcp::socket>(
+            [&context, &listener](auto handler) { context.async_accept(listener, std::move(handler)); });
+    }
+
+    /**
+     * Connect socket to remote endpoint, see \ref io_context::async_connect.
+     * Awaiting returns std::error_code.
+     */
+    inline auto connect(io_context& context, tcp::socket& socket, address target, uint16_t port) {
+        return internal_::make_io_awaitable<void>([&context, &socket, target, port](auto handler) {
+            context.async_connect(socket, target, port, std::move(handler));
+        });
+    }
+
+    /**
+     * Same as above, but fails with error::timeout if connection is not
+     * established in specified time.
+     */
+    inline auto connect(io_context& context, tcp::socket& socket, address target, uint16_t port,
+                        std::chrono::milliseconds timeout) {
+        return internal_::make_io_awaitable<void>([&context, &socket, target, port, timeout](auto handler) {
+            context.async_connect(socket, target, port, timeout, std::move(handler));
+        });
+    }
+
+    /**
+     * Read exactly buffer.size() bytes, see \ref io_context::async_read.
+     * Value is count of bytes read.
+     */
+    inline auto read(io_context& context, tcp::socket& socket, memory_view<uint8_t> buffer) {
+        return internal_::make_io_awaitable<size_t>(
+            [&context, &socket, buffer](auto handler) { context.async_read(socket, buffer, std::move(handler)); });
+    }
+
+    /**
+     * Same as above, but fails with error::timeout if buffer is not
+     * filled in specified time.
+     */
+    inline auto read(io_context& context, tcp::socket& socket, memory_view<uint8_t> buffer,
+                     std::chrono::milliseconds timeout) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, buffer, timeout](auto handler) {
+            context.async_read(socket, buffer, timeout, std::move(handler));
+        });
+    }
+
+    /**
+     * Read at most buffer.size() bytes, see \ref io_context::async_read_some.
+     * Value is count of bytes read.
+     */
+    inline auto read_some(io_context& context, tcp::socket& socket, memory_view<uint8_t> buffer) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, buffer](auto handler) {
+            context.async_read_some(socket, buffer, std::move(handler));
+        });
+    }
+
+    /**
+     * Same as above, but fails with error::timeout if no data received
+     * in specified time.
+     */
+    inline auto read_some(io_context& context, tcp::socket& socket, memory_view<uint8_t> buffer,
+                          std::chrono::milliseconds timeout) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, buffer, timeout](auto handler) {
+            context.async_read_some(socket, buffer, timeout, std::move(handler));
+        });
+    }
+
+    /**
+     * Read until delimiter, see \ref io_context::async_read_until.
+     * Value is size of buffer.
+     */
+    template<typename Buffer>
+    auto read_until(io_context& context, tcp::socket& socket, uint8_t delimiter, Buffer& buffer,
+                    size_t max_size = 0) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, delimiter, &buffer, max_size](auto handler) {
+            context.async_read_until(socket, delimiter, buffer, std::move(handler), max_size);
+        });
+    }
+
+    /**
+     * Write whole buffer, see \ref io_context::async_write.
+     * Value is count of bytes written.
+     */
+    inline auto write(io_context& context, tcp::socket& socket, memory_view<const uint8_t> buffer) {
+        return internal_::make_io_awaitable<size_t>(
+            [&context, &socket, buffer](auto handler) { context.async_write(socket, buffer, std::move(handler)); });
+    }
+
+    /**
+     * Same as above, but fails with error::timeout if buffer is not
+     * written in specified time.
+     */
+    inline auto write(io_context& context, tcp::socket& socket, memory_view<const uint8_t> buffer,
+                      std::chrono::milliseconds timeout) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, buffer, timeout](auto handler) {
+            context.async_write(socket, buffer, timeout, std::move(handler));
+        });
+    }
+
+    /**
+     * Receive one datagram, see \ref io_context::async_receive_from.
+     * Value is tuple of datagram size and source endpoint.
+     */
+    inline auto receive_from(io_context& context, udp::socket& socket, memory_view<uint8_t> buffer) {
+        return internal_::make_io_awaitable<std::tuple<size_t, std::tuple<address, uint16_t>>>(
+            [&context, &socket, buffer](auto handler) {
+                context.async_receive_from(socket, buffer, std::move(handler));
+            });
+    }
+
+    /**
+     * Send datagram, see \ref io_context::async_send_to.
+     * Value is count of bytes sent.
+     */
+    inline auto send_to(io_context& context, udp::socket& socket, memory_view<const uint8_t> buffer,
+                        std::tuple<address, uint16_t> destination) {
+        return internal_::make_io_awaitable<size_t>([&context, &socket, buffer, destination](auto handler) {
+            context.async_send_to(socket, buffer, destination, std::move(handler));
+        });
+    }
+} // namespace libwire::coro
+
+namespace libwire::internal_ {
+    template<typename T>
+    coro::task<T> task_promise<T>::get_return_object() noexcept {
+        return coro::task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+    }
+
+    inline coro::task<void> task_promise<void>::get_return_object() noexcept {
+        return coro::task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+    }
+} // namespace libwire::internal_
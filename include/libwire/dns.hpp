@@ -49,6 +49,9 @@ namespace libwire::dns {
      *
      * \note Numeric IP addresses is accepted too and will be just copied
      * to output.
+     *
+     * \note Calling thread is blocked until system resolver answers, which
+     * may take seconds. See \ref resolver for asynchronous lookups.
      */
     std::vector<address> resolve(ip protocol, const std::string_view& domain, std::error_code& ec) noexcept;
 
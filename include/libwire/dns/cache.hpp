@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <libwire/dns/resolver.hpp>
+
+/**
+ * \file dns/cache.hpp
+ *
+ * This file defines dns::cache type, TTL-aware cache of lookup results
+ * in front of dns::resolver.
+ */
+
+namespace libwire::dns {
+    /**
+     * Cache of \ref resolver answers, kept for TTL reported by servers.
+     *
+     * Failed lookups (error::host_not_found, error::no_address) are
+     * cached too, for negative caching TTL from server's SOA record.
+     * Transient errors (timeouts, server failures) are never cached.
+     * Both TTLs are limited by configuration.
+     *
+     * Entry which is still requested near end of its lifetime is
+     * refreshed in background: lookups continue to get cached answer
+     * while new query is in flight, so popular names never expire.
+     * Concurrent lookups of missing name wait for single query.
+     *
+     * Entries are split between shards by hash of name, each shard has
+     * own lock, so lookups of different names from many threads rarely
+     * contend. Hit costs one lock of shard and copy of address list.
+     *
+     * Quick usage example:
+     * \code
+     * io_context context;
+     * dns::resolver resolver{context};
+     * dns::cache cache{resolver};
+     *
+     * dns::answer result;
+     * std::error_code ec;
+     * if (!cache.try_resolve(ip::v4, "example.com", result, ec)) {
+     *     cache.async_resolve(ip::v4, "example.com", [](std::error_code ec, dns::answer result) {
+     *         // ...
+     *     });
+     * }
+     * \endcode
+     *
+     * Resolver must outlive cache. Cache must not be destroyed while
+     * lookups or refreshes are in flight.
+     *
+     * Available on the same platforms as \ref resolver.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: safe
+     */
+    class cache {
+    public:
+        struct config {
+            /// Upper bound for TTL of successful answers.
+            std::chrono::seconds max_ttl = std::chrono::hours(1);
+
+            /**
+             * Upper bound for TTL of failed lookups, zero disables
+             * negative caching.
+             */
+            std::chrono::seconds max_negative_ttl = std::chrono::minutes(5);
+
+            /**
+             * Part of entry lifetime after which lookup of it starts
+             * refresh, 1 or more disables refresh-ahead.
+             */
+            double refresh_after = 0.75;
+
+            /**
+             * Entry is refreshed only if it was hit at least this many
+             * times since it was stored, rarely used names just expire.
+             */
+            unsigned refresh_hits = 2;
+
+            /**
+             * Max count of entries, split evenly between shards. When
+             * shard is full, expired entries are dropped or, if there
+             * are none, entry which would expire first.
+             */
+            size_t capacity = 4096;
+
+            /// Count of independently locked parts of cache.
+            size_t shards = 16;
+        };
+
+        struct statistics {
+            /// Lookups answered from cache, including cached failures.
+            uint64_t hits = 0;
+
+            /// Lookups which had to wait for resolver.
+            uint64_t misses = 0;
+
+            /// Queries sent to refresh entries before expiration.
+            uint64_t refreshes = 0;
+        };
+
+        /**
+         * Create cache with default configuration.
+         */
+        explicit cache(resolver& upstream);
+
+        cache(resolver& upstream, config settings);
+
+        cache(const cache&) = delete;
+        cache& operator=(const cache&) = delete;
+
+        /**
+         * Resolve name to IPv4 and IPv6 addresses, see
+         * resolver::async_resolve. Cached answer is delivered by posting
+         * handler to resolver's io_context.
+         */
+        void async_resolve(std::string_view name, resolver::handler callback);
+
+        /**
+         * Resolve name to addresses of one IP version.
+         */
+        void async_resolve(ip protocol, std::string_view name, resolver::handler callback);
+
+        /**
+         * Get cached answer without waiting, returns false if there is
+         * no fresh entry for name. Otherwise result and ec are set as
+         * they would be passed to handler of async_resolve (ec is set
+         * for cached failures) and true is returned.
+         *
+         * Misses are not counted, since caller is expected to fall back
+         * to async_resolve.
+         */
+        bool try_resolve(ip protocol, std::string_view name, answer& result, std::error_code& ec);
+
+        /**
+         * Drop all cached answers. Lookups in flight are not affected.
+         */
+        void clear();
+
+        /**
+         * Sum of counters over all shards.
+         */
+        statistics stats() const;
+
+        const config& settings() const noexcept {
+            return config_;
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct entry {
+            std::error_code ec;
+            answer result;
+            clock::time_point expires, refresh_at;
+            unsigned hits = 0;
+
+            /// Result is stored (but may be expired).
+            bool valid = false;
+
+            /// Query for entry is in flight.
+            bool updating = false;
+
+            /// Lookups waiting for query.
+            std::vector<resolver::handler> waiters;
+        };
+
+        // Aligned to avoid false sharing of locks between shards.
+        struct alignas(64) shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, entry> entries;
+            statistics counters;
+        };
+
+        /// Family of key, both families are cached separately.
+        enum class family : char { any = '*', v4 = '4', v6 = '6' };
+
+        void resolve(family kind, std::string_view name, resolver::handler callback);
+        bool find(shard& part, const std::string& key, clock::time_point now, answer& result, std::error_code& ec,
+                  bool& refresh);
+        void query(const std::string& key);
+        void store(const std::string& key, std::error_code ec, answer result);
+        void make_room(shard& part, clock::time_point now);
+        shard& shard_of(const std::string& key) const noexcept;
+
+        /// Family tag followed by lowercase name without trailing dot.
+        static std::string make_key(family kind, std::string_view name);
+
+        resolver& upstream_;
+        config config_;
+        size_t shard_capacity_;
+        std::unique_ptr<shard[]> shards_;
+    };
+} // namespace libwire::dns
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <libwire/address.hpp>
+#include <libwire/endpoint.hpp>
+#include <libwire/io_context.hpp>
+#include <libwire/udp/socket.hpp>
+
+/**
+ * \file dns/resolver.hpp
+ *
+ * This file defines dns::resolver type, asynchronous stub resolver
+ * talking to DNS servers directly.
+ */
+
+namespace libwire::dns {
+    /**
+     * Addresses of resolved name and time they stay valid.
+     */
+    struct answer {
+        std::vector<address> addresses;
+
+        /**
+         * Minimum TTL of records used to build answer. For failed
+         * lookup (error::host_not_found, error::no_address) it's
+         * negative caching TTL reported by server, 0 if server didn't
+         * report it or lookup failed for other reason.
+         */
+        std::chrono::seconds ttl{0};
+    };
+
+    /**
+     * Stub resolver, sends queries to recursive DNS servers (usually
+     * ones listed in /etc/resolv.conf) over UDP and waits for replies
+     * using io_context, so unlike \ref resolve it never blocks calling
+     * thread.
+     *
+     * All queries share one UDP socket and are matched with replies
+     * by random 16-bit ID, question section and source address, so
+     * many lookups can be in flight at once. Unanswered query is sent
+     * again after timeout, to next server in list, until all attempts
+     * are used. If reply is truncated, query is repeated over TCP.
+     *
+     * Quick usage example:
+     * \code
+     * io_context context;
+     * dns::resolver resolver{context};
+     * resolver.async_resolve("example.com", [](std::error_code ec, dns::answer result) {
+     *     // ...
+     * });
+     * context.run();
+     * \endcode
+     *
+     * Names are always queried as fully qualified, search domains from
+     * resolv.conf are not applied. Numeric addresses are returned as is
+     * without any query.
+     *
+     * Resolver keeps operations in io_context only while lookups are in
+     * flight, so run() returns when they are finished. Resolver can be
+     * destroyed at any time, including from lookup handler: lookups in
+     * flight are abandoned and their handlers are never called.
+     *
+     * Like io_context, currently implemented only for Linux.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: safe
+     */
+    class resolver {
+    public:
+        struct config {
+            /**
+             * Servers are tried in order, if list is empty resolver
+             * uses server on localhost.
+             */
+            std::vector<endpoint> nameservers;
+
+            /// Time to wait for reply before trying next server.
+            std::chrono::milliseconds timeout = std::chrono::seconds(5);
+
+            /// Count of times each server is tried.
+            unsigned attempts = 2;
+
+            /**
+             * Read configuration in resolv.conf(5) format, only
+             * nameserver lines and timeout and attempts options are
+             * used. Unknown or malformed lines are ignored.
+             */
+            static config parse(std::string_view text);
+
+            /**
+             * Read and parse file, defaults are returned if file
+             * can't be read (glibc resolver does the same).
+             */
+            static config load(const std::string& path = "/etc/resolv.conf");
+        };
+
+        /**
+         * Handler signature: void(std::error_code, dns::answer).
+         *
+         * Errors are error::host_not_found, error::no_address,
+         * error::host_not_found_try_again (servers failed to answer),
+         * error::timeout, error::invalid_argument (malformed name) and
+         * socket errors.
+         */
+        using handler = std::function<void(std::error_code ec, answer result)>;
+
+        /**
+         * Create resolver using configuration from /etc/resolv.conf,
+         * set ec if any error occurred.
+         */
+        resolver(io_context& context, std::error_code& ec);
+
+        /**
+         * Create resolver with explicit configuration, set ec if any
+         * error occurred.
+         */
+        resolver(io_context& context, config settings, std::error_code& ec);
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        explicit resolver(io_context& context);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        resolver(io_context& context, config settings);
+#endif
+
+        resolver(const resolver&) = delete;
+        resolver& operator=(const resolver&) = delete;
+
+        ~resolver();
+
+        /**
+         * Resolve name to IPv4 and IPv6 addresses, A and AAAA queries are
+         * sent at once. IPv4 addresses come first in result. Lookup fails
+         * only if both queries failed.
+         *
+         * Handler is called from thread executing io_context::run().
+         */
+        void async_resolve(std::string_view name, handler callback);
+
+        /**
+         * Resolve name to addresses of one IP version.
+         */
+        void async_resolve(ip protocol, std::string_view name, handler callback);
+
+        const config& settings() const noexcept {
+            return config_;
+        }
+
+        /**
+         * io_context used for all operations, handlers are called from
+         * threads running it.
+         */
+        io_context& context() const noexcept {
+            return context_;
+        }
+
+    private:
+        struct lookup;
+        struct query;
+
+        /**
+         * Shared with handlers queued in io_context, so completions which
+         * run after destruction see that resolver is gone.
+         */
+        struct lifetime {
+            std::mutex mutex;
+            resolver* owner = nullptr;
+        };
+
+        template<typename Function>
+        auto guarded(Function function);
+
+        void open(std::error_code& ec) noexcept;
+        void start_query(const std::shared_ptr<lookup>& owner, std::string_view name, ip protocol);
+        void transmit(query& q);
+        void start_receive();
+        void on_receive(const std::error_code& ec, size_t size, const endpoint& source);
+        void on_timeout(uint16_t id, uint64_t serial, unsigned arm);
+        bool handle_reply(query& q, const uint8_t* message, size_t size, const endpoint& server);
+        void start_tcp(query& q, const endpoint& server);
+        void on_tcp_step(uint16_t id, uint64_t serial, const std::error_code& ec);
+        void fail_over(query& q, const std::error_code& ec);
+        void finish(query& q, const std::error_code& ec, std::vector<address> addresses, uint32_t ttl);
+        void complete(lookup& owner, const std::error_code& ec, unsigned family, std::vector<address> addresses,
+                      uint32_t ttl);
+        query* find(uint16_t id, uint64_t serial) noexcept;
+
+        io_context& context_;
+        config config_;
+        udp::socket socket_;
+
+        std::shared_ptr<lifetime> lifetime_ = std::make_shared<lifetime>();
+        std::unordered_map<uint16_t, std::unique_ptr<query>> queries_;
+        std::mt19937 random_;
+        uint64_t next_serial_ = 0;
+        bool receiving_ = false;
+        std::array<uint8_t, 4096> receive_buffer_{};
+    };
+} // namespace libwire::dns
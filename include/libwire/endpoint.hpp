@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <libwire/address.hpp>
+
+#ifdef _WIN32
+#    include <winsock2.h>
+#    include <ws2tcpip.h>
+#else
+#    include <sys/socket.h>
+#    include <netinet/in.h>
+#endif
+
+/**
+ * \file endpoint.hpp
+ *
+ * This file defines endpoint type, (address, port) pair stored in form
+ * used by operating system.
+ */
+
+namespace libwire {
+    /**
+     * IPv4 or IPv6 transport endpoint (address and port) stored as native
+     * sockaddr_in or sockaddr_in6 structure.
+     *
+     * Socket functions taking std::tuple<address, uint16_t> have to
+     * convert it to native form on every call, functions taking endpoint
+     * pass it to the system as is, with correct length. Convert endpoint
+     * once and reuse it if you send many datagrams to the same peer.
+     *
+     * Endpoint is implicitly constructible from tuple and convertible
+     * back to it. Default-constructed endpoint has no address family
+     * and can only be assigned to (or used as output argument).
+     *
+     * **Example**
+     * \code
+     * endpoint peer{ipv4::loopback, 7777};
+     * for (auto& datagram : datagrams) sock.write_to(memory_view(datagram.data(), datagram.size()), peer);
+     *
+     * endpoint source;
+     * size_t size = sock.read_from(memory_view(buffer.data(), buffer.size()), source);
+     * \endcode
+     */
+    class endpoint {
+    public:
+        endpoint() noexcept : storage_{} {
+        }
+
+        endpoint(const libwire::address& address, uint16_t port) noexcept;
+
+        endpoint(const std::tuple<libwire::address, uint16_t>& address_port) noexcept // NOLINT(hicpp-explicit-conversions)
+            : endpoint(std::get<0>(address_port), std::get<1>(address_port)) {
+        }
+
+        /**
+         * Construct endpoint from native structure, length is size of
+         * structure pointed by native. Endpoint is left empty if address
+         * family is not AF_INET or AF_INET6.
+         */
+        endpoint(const sockaddr* native, socklen_t length) noexcept;
+
+        /**
+         * IP version of address, undefined for empty endpoint.
+         */
+        ip version() const noexcept {
+            return storage_.base.sa_family == AF_INET6 ? ip::v6 : ip::v4;
+        }
+
+        libwire::address address() const noexcept;
+
+        uint16_t port() const noexcept;
+
+        /**
+         * Check whether endpoint holds address.
+         */
+        bool empty() const noexcept {
+            return storage_.base.sa_family != AF_INET && storage_.base.sa_family != AF_INET6;
+        }
+
+        operator std::tuple<libwire::address, uint16_t>() const noexcept { // NOLINT(hicpp-explicit-conversions)
+            return {address(), port()};
+        }
+
+        /**
+         * Pointer to native structure to be passed to system calls.
+         */
+        const sockaddr* data() const noexcept {
+            return &storage_.base;
+        }
+
+        sockaddr* data() noexcept {
+            return &storage_.base;
+        }
+
+        /**
+         * Length of native structure (depends on address family).
+         */
+        socklen_t size() const noexcept {
+            return storage_.base.sa_family == AF_INET ? socklen_t(sizeof(sockaddr_in))
+                                                      : socklen_t(sizeof(sockaddr_in6));
+        }
+
+        /**
+         * Size of storage available for system calls which return address
+         * (recvfrom, accept, ...).
+         */
+        static constexpr socklen_t capacity() noexcept {
+            return socklen_t(sizeof(storage));
+        }
+
+        /**
+         * Same endpoint with IPv4 address converted to IPv4-mapped IPv6
+         * address (::ffff:a.b.c.d), as expected by dual-stack sockets.
+         * IPv6 endpoints are returned unchanged.
+         */
+        endpoint v4_mapped() const noexcept;
+
+        /**
+         * Convert IPv4-mapped IPv6 address to plain IPv4 one, called
+         * for endpoints filled by system calls of dual-stack sockets.
+         */
+        void unmap() noexcept;
+
+        /**
+         * Text in "127.0.0.1:80" or "[::1]:80" form, empty for empty
+         * endpoint.
+         */
+        std::string to_string() const;
+
+        /**
+         * Maximum length of text written by to_chars().
+         */
+        static constexpr size_t max_text_size = libwire::address::max_text_size + 8;
+
+        /**
+         * Write same text as to_string() gives into [first, last) without
+         * allocating, see address::to_chars().
+         */
+        std::to_chars_result to_chars(char* first, char* last) const noexcept;
+
+        bool operator==(const endpoint&) const noexcept;
+        bool operator!=(const endpoint&) const noexcept;
+
+    private:
+        union storage {
+            sockaddr base;
+            sockaddr_in v4;
+            sockaddr_in6 v6;
+        } storage_;
+    };
+} // namespace libwire
@@ -0,0 +1,445 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <libwire/address.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define LIBWIRE_ENDPOINT_MAP_SSE2
+#    include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif
+
+/**
+ * \file endpoint_map.hpp
+ *
+ * This file defines endpoint_map type, hash table keyed by (address, port)
+ * pair, intended for lookup of per-peer state when many peers are served
+ * using single UDP socket.
+ */
+
+namespace libwire {
+    /**
+     * Hash function for (address, port) pair.
+     *
+     * Address is hashed as two 64-bit words using folded 64x64->128
+     * multiplication, so cost doesn't depend on address bytes.
+     * Can be used with std::unordered_map too.
+     */
+    struct endpoint_hash {
+        std::size_t operator()(const std::tuple<address, uint16_t>& endpoint) const noexcept {
+            return std::size_t(hash(std::get<0>(endpoint), std::get<1>(endpoint)));
+        }
+
+        static uint64_t hash(const address& addr, uint16_t port) noexcept {
+            uint64_t low, high;
+            std::memcpy(&low, addr.parts.data(), sizeof(low));
+            std::memcpy(&high, addr.parts.data() + sizeof(low), sizeof(high));
+            uint64_t meta = (uint64_t(port) << 32u) | uint64_t(addr.version);
+            return mix(mix(low ^ 0xa0761d6478bd642full, high ^ 0xe7037ed1a0b428dbull) ^ meta,
+                       0x8ebc6af09c88c6e3ull);
+        }
+
+    private:
+        static uint64_t mix(uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+            __extension__ using uint128 = unsigned __int128;
+            uint128 result = uint128(a) * b;
+            return uint64_t(result) ^ uint64_t(result >> 64u);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            uint64_t high;
+            uint64_t low = _umul128(a, b, &high);
+            return low ^ high;
+#else
+            uint64_t a_low = uint32_t(a), a_high = a >> 32u, b_low = uint32_t(b), b_high = b >> 32u;
+            uint64_t low_low = a_low * b_low, high_low = a_high * b_low;
+            uint64_t low_high = a_low * b_high, high_high = a_high * b_high;
+            uint64_t cross = (low_low >> 32u) + uint32_t(high_low) + low_high;
+            uint64_t high = high_high + (high_low >> 32u) + (cross >> 32u);
+            uint64_t low = (cross << 32u) | uint32_t(low_low);
+            return low ^ high;
+#endif
+        }
+    };
+
+    /**
+     * Hash table mapping (address, port) pairs to values of type Value.
+     *
+     * Open addressing table with layout similar to Abseil's "Swiss
+     * table": slots are stored inline in single array, separate array
+     * holds one control byte per slot (empty, deleted or 7 bits of key
+     * hash). Lookup compares whole group of 16 control bytes at once
+     * (using SSE2 when available), so keys are compared only for slots
+     * whose hash bits match, and probing usually touches one group and
+     * one slot, without pointer chasing of node-based std::unordered_map.
+     *
+     * Table grows by doubling when 7/8 of slots are used. Erased slots
+     * are reused by insertions and purged on growth.
+     *
+     * Pointers to values are invalidated by insertions (if table grows),
+     * reserve() and erasure of corresponding key. Value should have
+     * non-throwing move constructor.
+     *
+     * **Example**
+     * \code
+     * endpoint_map<session_state> sessions(1'000'000);
+     * auto [size, source] = socket.read(memory_view(buffer.data(), buffer.size()));
+     * session_state& state = sessions[source];
+     * \endcode
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: unsafe
+     */
+    template<typename Value>
+    class endpoint_map {
+    public:
+        using key_type = std::tuple<address, uint16_t>;
+        using mapped_type = Value;
+
+        endpoint_map() noexcept = default;
+
+        /**
+         * Construct map with space for expected_size entries without
+         * growth.
+         */
+        explicit endpoint_map(size_t expected_size) {
+            reserve(expected_size);
+        }
+
+        endpoint_map(const endpoint_map&) = delete;
+        endpoint_map& operator=(const endpoint_map&) = delete;
+
+        endpoint_map(endpoint_map&& other) noexcept {
+            swap(other);
+        }
+
+        endpoint_map& operator=(endpoint_map&& other) noexcept {
+            endpoint_map(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~endpoint_map() {
+            destroy_slots();
+            deallocate();
+        }
+
+        void swap(endpoint_map& other) noexcept {
+            std::swap(control_, other.control_);
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(size_, other.size_);
+            std::swap(growth_left_, other.growth_left_);
+        }
+
+        size_t size() const noexcept {
+            return size_;
+        }
+
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+
+        /**
+         * Number of slots, table grows when size() reaches 7/8 of it.
+         */
+        size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+        /**
+         * Get pointer to value for key or nullptr if there is no such key.
+         */
+        Value* find(const key_type& key) noexcept {
+            size_t index = find_index(key, endpoint_hash::hash(std::get<0>(key), std::get<1>(key)));
+            return index == npos ? nullptr : &slots_[index].value;
+        }
+
+        const Value* find(const key_type& key) const noexcept {
+            return const_cast<endpoint_map*>(this)->find(key);
+        }
+
+        bool contains(const key_type& key) const noexcept {
+            return find(key) != nullptr;
+        }
+
+        /**
+         * Insert value constructed from args if key is not present.
+         *
+         * Returns pointer to value for key and true if value was
+         * inserted, false if key already existed (args are not used then).
+         */
+        template<typename... Args>
+        std::pair<Value*, bool> try_emplace(const key_type& key, Args&&... args);
+
+        /**
+         * Get reference to value for key, inserting value-initialized
+         * one if key is not present.
+         */
+        Value& operator[](const key_type& key) {
+            return *try_emplace(key).first;
+        }
+
+        /**
+         * Remove key from map, returns false if there was no such key.
+         */
+        bool erase(const key_type& key) noexcept;
+
+        /**
+         * Remove all entries, capacity is kept.
+         */
+        void clear() noexcept;
+
+        /**
+         * Grow table so it can hold at least count entries without
+         * further growth.
+         */
+        void reserve(size_t count);
+
+        /**
+         * Call callback(const key_type&, Value&) for every entry, in
+         * unspecified order. Callback must not modify map.
+         */
+        template<typename Callback>
+        void for_each(Callback&& callback);
+
+    private:
+        static constexpr size_t group_size = 16;
+        static constexpr size_t npos = ~size_t(0);
+        static constexpr int8_t empty_slot = -128, deleted_slot = -2;
+
+        struct slot {
+            template<typename... Args>
+            slot(const key_type& key, Args&&... args) : key(key), value(std::forward<Args>(args)...) {
+            }
+
+            key_type key;
+            Value value;
+        };
+
+        static size_t max_load(size_t capacity) noexcept {
+            return capacity - capacity / 8;
+        }
+
+        static unsigned lowest_bit(uint32_t mask) noexcept {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return unsigned(index);
+#else
+            return unsigned(__builtin_ctz(mask));
+#endif
+        }
+
+        static bool equal(const key_type& a, const key_type& b) noexcept {
+            const address& a_address = std::get<0>(a);
+            const address& b_address = std::get<0>(b);
+            return std::get<1>(a) == std::get<1>(b) && a_address.version == b_address.version &&
+                   std::memcmp(a_address.parts.data(), b_address.parts.data(), a_address.parts.size()) == 0;
+        }
+
+        /*
+         * Bit masks of group positions whose control byte is equal to
+         * hash bits, empty, or empty/deleted (both have sign bit set).
+         */
+#ifdef LIBWIRE_ENDPOINT_MAP_SSE2
+        static uint32_t match(const int8_t* group, int8_t hash_bits) noexcept {
+            __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(hash_bits))));
+        }
+
+        static uint32_t match_empty(const int8_t* group) noexcept {
+            return match(group, empty_slot);
+        }
+
+        static uint32_t match_free(const int8_t* group) noexcept {
+            return uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+        }
+#else
+        static uint32_t match(const int8_t* group, int8_t hash_bits) noexcept {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < group_size; ++i) mask |= uint32_t(group[i] == hash_bits) << i;
+            return mask;
+        }
+
+        static uint32_t match_empty(const int8_t* group) noexcept {
+            return match(group, empty_slot);
+        }
+
+        static uint32_t match_free(const int8_t* group) noexcept {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < group_size; ++i) mask |= uint32_t(group[i] < 0) << i;
+            return mask;
+        }
+#endif
+
+        /*
+         * Groups are probed in triangular sequence (start, +1, +2, ...),
+         * which visits every group when number of groups is power of two.
+         */
+        size_t find_index(const key_type& key, uint64_t hash) const noexcept {
+            if (capacity_ == 0) return npos;
+            size_t groups_mask = capacity_ / group_size - 1;
+            size_t group = size_t(hash >> 7u) & groups_mask;
+            auto hash_bits = int8_t(hash & 0x7Fu);
+            for (size_t step = 1;; ++step) {
+                const int8_t* control = control_ + group * group_size;
+                for (uint32_t mask = match(control, hash_bits); mask != 0; mask &= mask - 1) {
+                    size_t index = group * group_size + lowest_bit(mask);
+                    if (equal(slots_[index].key, key)) return index;
+                }
+                if (match_empty(control) != 0) return npos;
+                group = (group + step) & groups_mask;
+            }
+        }
+
+        size_t find_free_index(uint64_t hash) const noexcept {
+            size_t groups_mask = capacity_ / group_size - 1;
+            size_t group = size_t(hash >> 7u) & groups_mask;
+            for (size_t step = 1;; ++step) {
+                uint32_t mask = match_free(control_ + group * group_size);
+                if (mask != 0) return group * group_size + lowest_bit(mask);
+                group = (group + step) & groups_mask;
+            }
+        }
+
+        void rehash(size_t new_capacity);
+
+        void destroy_slots() noexcept {
+            for (size_t i = 0; i < capacity_; ++i) {
+                if (control_[i] >= 0) slots_[i].~slot();
+            }
+        }
+
+        void deallocate() noexcept {
+            if (capacity_ == 0) return;
+            std::allocator<slot>().deallocate(slots_, capacity_);
+            delete[] control_;
+        }
+
+        int8_t* control_ = nullptr;
+        slot* slots_ = nullptr;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+        size_t growth_left_ = 0;
+    };
+
+    template<typename Value>
+    template<typename... Args>
+    std::pair<Value*, bool> endpoint_map<Value>::try_emplace(const key_type& key, Args&&... args) {
+        uint64_t hash = endpoint_hash::hash(std::get<0>(key), std::get<1>(key));
+        size_t index = find_index(key, hash);
+        if (index != npos) return {&slots_[index].value, false};
+
+        if (capacity_ == 0) rehash(group_size);
+        index = find_free_index(hash);
+        // Reusing deleted slot doesn't change load.
+        if (growth_left_ == 0 && control_[index] == empty_slot) {
+            // Mostly tombstones? Purge them instead of growing.
+            rehash(size_ < max_load(capacity_) / 2 ? capacity_ : capacity_ * 2);
+            index = find_free_index(hash);
+        }
+
+        new (&slots_[index]) slot(key, std::forward<Args>(args)...);
+        if (control_[index] == empty_slot) --growth_left_;
+        control_[index] = int8_t(hash & 0x7Fu);
+        ++size_;
+        return {&slots_[index].value, true};
+    }
+
+    template<typename Value>
+    bool endpoint_map<Value>::erase(const key_type& key) noexcept {
+        size_t index = find_index(key, endpoint_hash::hash(std::get<0>(key), std::get<1>(key)));
+        if (index == npos) return false;
+
+        slots_[index].~slot();
+        --size_;
+        // Probing stops at group with empty slot, so if group already has
+        // one, no probe sequence went past it and slot can be made empty.
+        if (match_empty(control_ + index / group_size * group_size) != 0) {
+            control_[index] = empty_slot;
+            ++growth_left_;
+        } else {
+            control_[index] = deleted_slot;
+        }
+        return true;
+    }
+
+    template<typename Value>
+    void endpoint_map<Value>::clear() noexcept {
+        destroy_slots();
+        if (capacity_ != 0) std::memset(control_, empty_slot, capacity_);
+        size_ = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    template<typename Value>
+    void endpoint_map<Value>::reserve(size_t count) {
+        size_t new_capacity = group_size;
+        while (max_load(new_capacity) < count) new_capacity *= 2;
+        if (new_capacity > capacity_) rehash(new_capacity);
+    }
+
+    template<typename Value>
+    template<typename Callback>
+    void endpoint_map<Value>::for_each(Callback&& callback) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (control_[i] >= 0) callback(const_cast<const key_type&>(slots_[i].key), slots_[i].value);
+        }
+    }
+
+    template<typename Value>
+    void endpoint_map<Value>::rehash(size_t new_capacity) {
+        std::unique_ptr<int8_t[]> new_control(new int8_t[new_capacity]);
+        slot* new_slots = std::allocator<slot>().allocate(new_capacity);
+        std::memset(new_control.get(), empty_slot, new_capacity);
+
+        endpoint_map<Value> old;
+        swap(old);
+        control_ = new_control.release();
+        slots_ = new_slots;
+        capacity_ = new_capacity;
+        size_ = old.size_;
+        growth_left_ = max_load(new_capacity) - size_;
+
+        for (size_t i = 0; i < old.capacity_; ++i) {
+            if (old.control_[i] < 0) continue;
+            slot& source = old.slots_[i];
+            uint64_t hash = endpoint_hash::hash(std::get<0>(source.key), std::get<1>(source.key));
+            size_t index = find_free_index(hash);
+            new (&slots_[index]) slot(source.key, std::move(source.value));
+            control_[index] = int8_t(hash & 0x7Fu);
+        }
+        // Old storage is destroyed with moved-from values by old destructor.
+    }
+} // namespace libwire
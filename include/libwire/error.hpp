@@ -250,6 +250,11 @@ namespace libwire::error {
          * Remote side of connection finished transmission.
          */
         end_of_file,
+
+        /**
+         * Asynchronous operation was canceled before completion.
+         */
+        operation_aborted,
     };
 
     enum dns_condition {
@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * This file defines parsing and formatting routines for textual IP
+ * addresses used by libwire::address.
+ *
+ * All routines work on exact bounds of input, text doesn't have to be
+ * NUL-terminated and nothing is allocated. Accepted syntax and produced
+ * text match inet_pton/inet_ntop.
+ *
+ * parse_ipv4() dispatches to fastest kernel available, other kernels
+ * are exposed for tests and benchmarks only.
+ */
+
+#if !defined(LIBWIRE_X86_KERNELS) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#    define LIBWIRE_X86_KERNELS
+#endif
+
+namespace libwire::internal_ {
+    /**
+     * Maximum length of text written by format_ipv4().
+     */
+    constexpr size_t ipv4_text_max = 15;
+
+    /**
+     * Maximum length of text written by format_ipv6().
+     */
+    constexpr size_t ipv6_text_max = 45;
+
+    constexpr bool ascii_digit(char ch) {
+        return unsigned(ch - '0') < 10;
+    }
+
+    constexpr int ascii_hex_value(char ch) {
+        if (ascii_digit(ch)) return ch - '0';
+        unsigned lower = unsigned(ch | 0x20) - 'a';
+        return lower < 6 ? int(lower) + 10 : -1;
+    }
+
+    /**
+     * Parse dotted-quad IPv4 address, writes 4 bytes to output on
+     * success. Output is unspecified on failure.
+     */
+    bool parse_ipv4(const char* text, size_t size, uint8_t* output) noexcept;
+
+    /**
+     * Portable kernel of parse_ipv4(), also usable in constant
+     * expressions.
+     */
+    constexpr bool parse_ipv4_scalar(const char* text, size_t size, uint8_t* output) noexcept {
+        const char* end = text + size;
+        for (int octet = 0; octet < 4; ++octet) {
+            if (text == end || !ascii_digit(*text)) return false;
+            unsigned value = unsigned(*text++ - '0');
+            while (text != end && ascii_digit(*text)) {
+                if (value == 0) return false; // Leading zero.
+                value = value * 10 + unsigned(*text++ - '0');
+                if (value > 255) return false;
+            }
+            output[octet] = uint8_t(value);
+
+            if (octet != 3) {
+                if (text == end || *text != '.') return false;
+                ++text;
+            }
+        }
+        return text == end;
+    }
+
+#ifdef LIBWIRE_X86_KERNELS
+    bool parse_ipv4_sse2(const char* text, size_t size, uint8_t* output) noexcept;
+#endif
+
+    /**
+     * Parse IPv6 address (RFC 4291 section 2.2, including "::" and
+     * trailing dotted-quad forms), writes 16 bytes to output on success.
+     * Output is unspecified on failure.
+     *
+     * Usable in constant expressions.
+     */
+    constexpr bool parse_ipv6(const char* text, size_t size, uint8_t* output) noexcept {
+        uint8_t result[16] = {};
+        const char* end = text + size;
+        size_t written = 0; // Bytes of result filled.
+        size_t gap = 16;    // Offset in result where "::" is, 16 if none.
+
+        if (text != end && *text == ':') {
+            if (end - text < 2 || text[1] != ':') return false;
+            text += 2;
+            gap = 0;
+        }
+
+        while (text != end) {
+            const char* group = text;
+            unsigned value = 0;
+            while (text != end && ascii_hex_value(*text) >= 0) {
+                if (text - group == 4) return false;
+                value = (value << 4) | unsigned(ascii_hex_value(*text++));
+            }
+            if (text == group) return false;
+
+            if (text != end && *text == '.') {
+                // Trailing dotted-quad takes place of last two groups.
+                if (written > 12 || !parse_ipv4_scalar(group, size_t(end - group), result + written)) return false;
+                written += 4;
+                break;
+            }
+
+            if (written == 16) return false;
+            result[written++] = uint8_t(value >> 8);
+            result[written++] = uint8_t(value);
+
+            if (text == end) break;
+            if (*text != ':') return false;
+            if (++text == end) return false;
+            if (*text == ':') {
+                if (gap != 16) return false;
+                gap = written;
+                ++text;
+            }
+        }
+
+        if (gap == 16) {
+            if (written != 16) return false;
+            for (size_t i = 0; i < 16; ++i) output[i] = result[i];
+            return true;
+        }
+        // "::" must stand for at least one group.
+        if (written == 16) return false;
+        size_t shift = 16 - written;
+        for (size_t i = 0; i < 16; ++i) output[i] = i < gap ? result[i] : i < gap + shift ? 0 : result[i - shift];
+        return true;
+    }
+
+    /**
+     * Parse decimal port number without sign, at most 65535.
+     */
+    constexpr bool parse_port(const char* text, size_t size, uint16_t& output) noexcept {
+        if (size == 0 || size > 5) return false;
+        unsigned value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (!ascii_digit(text[i])) return false;
+            value = value * 10 + unsigned(text[i] - '0');
+        }
+        if (value > 65535) return false;
+        output = uint16_t(value);
+        return true;
+    }
+
+    /**
+     * Parse "a.b.c.d:port" or "[IPv6]:port" endpoint. Writes 4 or 16
+     * bytes of address (depending on ipv6 flag set) and port on success.
+     *
+     * Usable in constant expressions.
+     */
+    constexpr bool parse_endpoint(const char* text, size_t size, uint8_t* address, bool& ipv6,
+                                  uint16_t& port) noexcept {
+        size_t colon = size;
+        while (colon != 0 && text[colon - 1] != ':') --colon;
+        if (colon < 2 || !parse_port(text + colon, size - colon, port)) return false;
+
+        ipv6 = text[0] == '[';
+        if (!ipv6) return parse_ipv4_scalar(text, colon - 1, address);
+        return colon >= 3 && text[colon - 2] == ']' && parse_ipv6(text + 1, colon - 3, address);
+    }
+
+    /**
+     * Parse "address/length" network prefix. Writes 4 or 16 bytes of
+     * address (depending on ipv6 flag set) and prefix length on success.
+     *
+     * Usable in constant expressions.
+     */
+    constexpr bool parse_prefix(const char* text, size_t size, uint8_t* address, bool& ipv6,
+                                uint8_t& length) noexcept {
+        size_t slash = size;
+        while (slash != 0 && text[slash - 1] != '/') --slash;
+        if (slash < 2) return false;
+
+        const char* length_text = text + slash;
+        size_t length_size = size - slash;
+        if (length_size == 0 || length_size > 3 || (length_size > 1 && length_text[0] == '0')) return false;
+        unsigned value = 0;
+        for (size_t i = 0; i < length_size; ++i) {
+            if (!ascii_digit(length_text[i])) return false;
+            value = value * 10 + unsigned(length_text[i] - '0');
+        }
+
+        ipv6 = false;
+        for (size_t i = 0; i < slash - 1; ++i) ipv6 |= text[i] == ':';
+        if (value > (ipv6 ? 128u : 32u)) return false;
+        length = uint8_t(value);
+        return ipv6 ? parse_ipv6(text, slash - 1, address) : parse_ipv4_scalar(text, slash - 1, address);
+    }
+
+    /**
+     * Write IPv4 address from 4 bytes of input. Output must have space
+     * for at least ipv4_text_max characters. Returns pointer past last
+     * written character, no terminator is written.
+     */
+    char* format_ipv4(const uint8_t* input, char* output) noexcept;
+
+    /**
+     * Write compacted IPv6 address from 16 bytes of input. Output must
+     * have space for at least ipv6_text_max characters. Returns pointer
+     * past last written character, no terminator is written.
+     */
+    char* format_ipv6(const uint8_t* input, char* output) noexcept;
+} // namespace libwire::internal_
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <libwire/address.hpp>
+
+/**
+ * This file defines encoding of DNS queries and decoding of replies
+ * (RFC 1035) used by dns::resolver.
+ *
+ * Only subset needed for address lookup is implemented: one question
+ * per message, A and AAAA answers, CNAME chains and SOA records for
+ * negative caching (RFC 2308). Queries carry EDNS(0) record (RFC 6891)
+ * so bigger replies fit into UDP datagram.
+ */
+
+namespace libwire::internal_ {
+    enum class dns_type : uint16_t {
+        a = 1,
+        cname = 5,
+        soa = 6,
+        aaaa = 28,
+        opt = 41,
+    };
+
+    enum dns_rcode : uint8_t {
+        no_error = 0,
+        format_error = 1,
+        server_failure = 2,
+        name_error = 3,
+        not_implemented = 4,
+        refused = 5,
+    };
+
+    constexpr size_t dns_header_size = 12;
+
+    /**
+     * Size of query for longest possible name, including EDNS(0) record.
+     */
+    constexpr size_t dns_max_query_size = dns_header_size + 255 + 4 + 11;
+
+    /**
+     * UDP payload size advertised in queries, small enough to avoid
+     * IP fragmentation on common paths (DNS Flag Day 2020).
+     */
+    constexpr uint16_t dns_udp_payload_size = 1232;
+
+    /**
+     * Maximum count of CNAME records followed in reply.
+     */
+    constexpr unsigned dns_max_cname_chain = 16;
+
+    /**
+     * Write recursive query for name into output which should have
+     * space for at least dns_max_query_size bytes. Name may have
+     * trailing dot.
+     *
+     * Returns size of message or 0 if name is not valid domain name
+     * (empty, empty label, label longer than 63 or name longer than
+     * 255 bytes in wire format).
+     */
+    size_t dns_write_query(uint16_t id, std::string_view name, dns_type type, uint8_t* output) noexcept;
+
+    /**
+     * ID of message, size should be at least dns_header_size.
+     */
+    inline uint16_t dns_message_id(const uint8_t* message) noexcept {
+        return uint16_t((message[0] << 8u) | message[1]);
+    }
+
+    struct dns_reply {
+        uint8_t rcode = no_error;
+
+        /// Reply didn't fit into datagram, query should be repeated over TCP.
+        bool truncated = false;
+
+        /// Addresses of requested type, CNAME chain starting at queried name is followed.
+        std::vector<address> addresses;
+
+        /// Minimum TTL of records used (CNAMEs included). If there is
+        /// no addresses - negative caching TTL from SOA record, 0 if
+        /// server didn't send it.
+        uint32_t ttl = 0;
+    };
+
+    /**
+     * Decode reply to query for name and type. Returns false if message
+     * is malformed or it's not a reply to such query (question doesn't
+     * match, names are compared case-insensitively). ID is not checked.
+     *
+     * Records are not decoded if reply is truncated.
+     */
+    bool dns_read_reply(const uint8_t* message, size_t size, std::string_view name, dns_type type,
+                        dns_reply& reply);
+} // namespace libwire::internal_
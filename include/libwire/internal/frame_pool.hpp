@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+
+namespace libwire {
+    class io_context;
+}
+
+namespace libwire::internal_ {
+    /**
+     * Cache of memory blocks used for short-lived objects created by
+     * io_context on each request: operations and coroutine frames.
+     *
+     * Blocks are grouped in size classes and returned to free list on
+     * deallocation instead of global allocator, so after warm-up handling
+     * of request doesn't allocate memory. Cached blocks are freed only
+     * when pool is destroyed.
+     */
+    class frame_pool {
+    public:
+        frame_pool() = default;
+
+        frame_pool(const frame_pool&) = delete;
+        frame_pool& operator=(const frame_pool&) = delete;
+
+        ~frame_pool();
+
+        /**
+         * Allocate block from pool or using global operator new if pool
+         * is nullptr or size is too big. Throws std::bad_alloc on failure.
+         *
+         * Block must be freed using \ref deallocate.
+         */
+        static void* allocate(frame_pool* pool, size_t size);
+
+        /**
+         * Return block to pool it's allocated from.
+         */
+        static void deallocate(void* pointer) noexcept;
+
+    private:
+        /// Blocks are rounded up to multiple of this value.
+        static constexpr size_t granularity = 64;
+        static constexpr size_t size_classes = 64;
+
+        /// Stored before each block, padded to keep block alignment.
+        struct alignas(alignof(std::max_align_t)) header {
+            frame_pool* pool;
+            size_t size_class;
+        };
+
+        struct free_block {
+            free_block* next;
+        };
+
+        std::mutex mutex_;
+        std::array<free_block*, size_classes> free_{};
+    };
+
+    /**
+     * Pool of io_context executing run() in calling thread,
+     * nullptr if there is no such context.
+     */
+    frame_pool* current_frame_pool() noexcept;
+
+    /**
+     * Node of list of coroutines owned by io_context, stored in
+     * coroutine promise. Coroutines not finished when io_context is
+     * destroyed are destroyed using destroy function.
+     */
+    struct spawned_frame {
+        void (*destroy)(spawned_frame* frame) noexcept = nullptr;
+        spawned_frame* prev = nullptr;
+        spawned_frame* next = nullptr;
+    };
+
+    /**
+     * Access to io_context internals used by coroutine support, which
+     * is implemented in header only because it requires C++20.
+     */
+    struct coroutine_access {
+        static frame_pool& pool(io_context& context) noexcept;
+
+        static void attach(io_context& context, spawned_frame* frame) noexcept;
+        static void detach(io_context& context, spawned_frame* frame) noexcept;
+    };
+} // namespace libwire::internal_
@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <system_error>
+#include <libwire/internal/io_operation.hpp>
+
+namespace libwire::internal_ {
+    /**
+     * Interface between io_context and OS event notification mechanism.
+     *
+     * Backend is responsible only for waiting on operations, handlers
+     * are executed by io_context using completed operations returned
+     * from \ref wait or passed to \ref post.
+     */
+    class io_backend {
+    public:
+        explicit io_backend(io_context& owner) noexcept : owner_(owner) {
+        }
+
+        io_backend(const io_backend&) = delete;
+        io_backend& operator=(const io_backend&) = delete;
+
+        /**
+         * Destroy pending operations without calling their handlers.
+         */
+        virtual ~io_backend() = default;
+
+        /**
+         * Wait for operation readiness or submit request for it.
+         * Socket is already in non-blocking mode.
+         */
+        virtual void start(socket& socket, io_operation* op, io_direction dir) = 0;
+
+        /**
+         * Complete all operations on descriptor with ECANCELED.
+         */
+        virtual void cancel(socket::native_handle_t handle) noexcept = 0;
+
+        /**
+         * Complete single pending operation with ECANCELED, nothing is done
+         * if it's already completed. Called after timed_out flag is set,
+         * operation is not destroyed until this function returns.
+         */
+        virtual void cancel_operation(io_operation* op) noexcept = 0;
+
+        /**
+         * Let backend cache kernel reference to descriptor, so it
+         * isn't looked up on each operation.
+         */
+        virtual void register_descriptor(socket::native_handle_t /* handle */, std::error_code& /* ec */) noexcept {
+        }
+
+        virtual void unregister_descriptor(socket::native_handle_t /* handle */) noexcept {
+        }
+
+        /**
+         * Wait for events at most timeout milliseconds (-1 means no limit,
+         * 0 means don't block) and add completed operations to completed
+         * queue.
+         */
+        virtual void wait(int timeout, op_queue& completed) = 0;
+
+        /**
+         * Make requests started by calling thread visible to kernel,
+         * called when thread stops executing run().
+         */
+        virtual void flush() noexcept {
+        }
+
+        /**
+         * Wake up threads blocked in \ref wait.
+         */
+        virtual void interrupt() noexcept = 0;
+
+    protected:
+        /**
+         * Pass completed operation to io_context.
+         */
+        void post(io_operation* op);
+
+        /**
+         * Account for operation posted more than once (multishot).
+         */
+        void work_started() noexcept;
+
+        /**
+         * Release work counted for operation which will not be posted.
+         */
+        void work_finished() noexcept;
+
+        /**
+         * Move part of completed operations to queue shared by all
+         * threads if there are other threads executing run().
+         *
+         * Returns count of other threads that have work now, backend
+         * should wake up that many threads if they can't notice shared
+         * queue by themselves.
+         */
+        size_t share(op_queue& completed);
+
+        /**
+         * Check whether calling thread executes run() of owner.
+         */
+        bool running_in_this_thread() const noexcept;
+
+        io_context& owner_;
+    };
+
+    /**
+     * Backend based on epoll readiness notification.
+     */
+    std::unique_ptr<io_backend> make_epoll_backend(io_context& owner, std::error_code& ec);
+
+#ifdef LIBWIRE_IO_URING
+    /**
+     * Backend based on io_uring, fails if running kernel doesn't support
+     * all required features.
+     */
+    std::unique_ptr<io_backend> make_uring_backend(io_context& owner, std::error_code& ec);
+#endif
+} // namespace libwire::internal_
@@ -0,0 +1,909 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <libwire/error.hpp>
+#include <libwire/internal/frame_pool.hpp>
+#include <libwire/memory_view.hpp>
+#include <libwire/tcp/listener.hpp>
+#include <libwire/tcp/socket.hpp>
+#include <libwire/timing_wheel.hpp>
+#include <libwire/udp/socket.hpp>
+
+namespace libwire {
+    class io_context;
+}
+
+namespace libwire::internal_ {
+    enum class io_direction { read, write };
+
+    /**
+     * Size of buffers used by multishot receive, both for buffers provided
+     * to kernel (io_uring) and for buffers owned by operation (epoll).
+     */
+    constexpr size_t multishot_buffer_size = 16 * 1024;
+
+    /**
+     * Description of operation for completion-based backends (io_uring).
+     *
+     * Kind none means that operation has no native equivalent and
+     * should be emulated using readiness notification and perform().
+     */
+    struct native_request {
+        enum kind_t : uint8_t { none, accept, recv, send, recvmsg, sendmsg };
+
+        kind_t kind = none;
+        void* buffer = nullptr;
+        size_t length = 0;
+        msghdr* message = nullptr;
+
+        /// Where to store peer address length (accept only), address itself goes to buffer.
+        socklen_t* address_length = nullptr;
+
+        /// Keep request active and report each result separately.
+        bool multishot = false;
+
+        /// Let backend choose buffer for received data (recv only).
+        bool provided_buffer = false;
+    };
+
+    enum class native_status {
+        /// Operation is finished, handler can be called.
+        finished,
+
+        /// Multishot operation produced result, more results will follow.
+        more,
+
+        /// Request should be submitted again (partial transfer).
+        resubmit,
+    };
+
+    /**
+     * Pool of buffers selected by kernel for multishot receive.
+     */
+    class buffer_pool {
+    public:
+        virtual void recycle(uint16_t id) noexcept = 0;
+
+    protected:
+        ~buffer_pool() = default;
+    };
+
+    /**
+     * Buffer with received data, should be returned to pool using
+     * release() once data is no longer needed.
+     */
+    struct provided_buffer {
+        void release() noexcept {
+            if (pool != nullptr) pool->recycle(id);
+            pool = nullptr;
+        }
+
+        memory_view<uint8_t> data{nullptr, 0};
+        buffer_pool* pool = nullptr;
+        uint16_t id = 0;
+    };
+
+    /**
+     * Base for operations queued in io_context.
+     *
+     * Operations are allocated when started and destroyed right
+     * before handler invocation so handler can start next operation
+     * without holding two operations in memory.
+     *
+     * Each operation can be executed in two ways: by readiness backend
+     * (epoll) which calls perform() when descriptor is ready, or by
+     * completion backend (io_uring) which submits request described
+     * by native() and passes its result to on_native_result().
+     *
+     * Operations started by io_context are allocated from its
+     * frame_pool, so deletion returns memory to that pool.
+     */
+    struct io_operation {
+        virtual ~io_operation() = default;
+
+        static void* operator new(size_t size) {
+            return frame_pool::allocate(nullptr, size);
+        }
+
+        static void* operator new(size_t size, frame_pool& pool) {
+            return frame_pool::allocate(&pool, size);
+        }
+
+        static void operator delete(void* pointer) noexcept {
+            frame_pool::deallocate(pointer);
+        }
+
+        static void operator delete(void* pointer, frame_pool&) noexcept {
+            frame_pool::deallocate(pointer);
+        }
+
+        /**
+         * Try to make progress without blocking. Returns true if operation
+         * is finished (successfully or not) and handler can be called.
+         */
+        virtual bool perform() noexcept = 0;
+
+        /**
+         * Invoke completion handler and destroy operation.
+         */
+        virtual void complete() = 0;
+
+        /**
+         * Describe system call equivalent to this operation.
+         */
+        virtual native_request native() noexcept {
+            return {};
+        }
+
+        /**
+         * Handle result of request returned by native(), result is return
+         * value of system call or negated errno value, more is set if
+         * multishot request stays active.
+         */
+        virtual native_status on_native_result(int /* result */, bool /* more */,
+                                               provided_buffer& /* buffer */) noexcept {
+            return native_status::finished;
+        }
+
+        /**
+         * Multishot operations only: mark operation as scheduled for
+         * handler invocation if it has undelivered results. Returns
+         * true if caller should post operation.
+         */
+        virtual bool schedule() noexcept {
+            return true;
+        }
+
+        io_operation* next = nullptr;
+        std::error_code ec;
+
+        /// Set by backend if operation is executed using native().
+        bool native_mode = false;
+
+        /// Set if operation started again after delivering result.
+        bool restarted = false;
+
+        /// Free for use by backend while operation is pending.
+        uint32_t backend_data = 0;
+
+        /// Armed in io_context timers if operation is started with timeout.
+        timing_wheel::timer deadline;
+
+        /// Descriptor operation is started on, set by io_context.
+        socket::native_handle_t handle = -1;
+
+        /// Set before backend is asked to cancel operation because of deadline.
+        std::atomic<bool> timed_out{false};
+    };
+
+    /**
+     * Start operation again after multishot result delivered in
+     * readiness mode.
+     */
+    void restart_operation(io_context& context, socket& socket, io_operation* op, io_direction dir);
+
+    /**
+     * Message header with storage for single buffer and address,
+     * used for native recvmsg/sendmsg requests.
+     */
+    struct native_message {
+        /**
+         * Fill header to receive into or send from buffer,
+         * destination is used only for sending, v4_mapped requests
+         * conversion of IPv4 destination to IPv4-mapped address.
+         */
+        void prepare(void* data, size_t size, const endpoint* destination, bool v4_mapped = false) noexcept;
+
+        /**
+         * Address of datagram source filled by recvmsg.
+         */
+        std::tuple<address, uint16_t> source() const noexcept;
+
+        msghdr header{};
+        iovec vector{};
+        sockaddr_storage address_storage{};
+    };
+
+    /**
+     * Access to socket state not exposed in public API.
+     */
+    struct io_access {
+        /**
+         * Update tcp::socket open state after I/O done bypassing it.
+         */
+        static void update_state(tcp::socket& socket, const std::error_code& ec) noexcept {
+            socket.open = (ec != error::generic::disconnected);
+        }
+
+        /**
+         * Replace tcp::socket descriptor with new unconnected one.
+         */
+        static void reopen(tcp::socket& socket, ip ip_version, std::error_code& ec) noexcept {
+            socket.implementation_ = internal_::socket(ip_version, transport::tcp, ec);
+            socket.open = false;
+        }
+
+        static void set_open(tcp::socket& socket, bool open) noexcept {
+            socket.open = open;
+        }
+    };
+
+    inline std::error_code native_error(int result) noexcept {
+        return {-result, error::system_category()};
+    }
+
+    /**
+     * Intrusive FIFO queue of operations.
+     */
+    class op_queue {
+    public:
+        bool empty() const noexcept {
+            return head_ == nullptr;
+        }
+
+        io_operation* front() const noexcept {
+            return head_;
+        }
+
+        void push(io_operation* op) noexcept {
+            op->next = nullptr;
+            if (tail_ != nullptr) {
+                tail_->next = op;
+            } else {
+                head_ = op;
+            }
+            tail_ = op;
+        }
+
+        io_operation* pop() noexcept {
+            io_operation* op = head_;
+            if (op == nullptr) return nullptr;
+            head_ = op->next;
+            if (head_ == nullptr) tail_ = nullptr;
+            op->next = nullptr;
+            return op;
+        }
+
+        /**
+         * Remove operation from queue, returns false if it's not queued. O(n).
+         */
+        bool remove(io_operation* op) noexcept {
+            io_operation* previous = nullptr;
+            for (io_operation* current = head_; current != nullptr; previous = current, current = current->next) {
+                if (current != op) continue;
+                if (previous != nullptr) {
+                    previous->next = op->next;
+                } else {
+                    head_ = op->next;
+                }
+                if (tail_ == op) tail_ = previous;
+                op->next = nullptr;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Move all operations from other queue to the end of this one.
+         */
+        void splice(op_queue& other) noexcept {
+            if (other.empty()) return;
+            if (tail_ != nullptr) {
+                tail_->next = other.head_;
+            } else {
+                head_ = other.head_;
+            }
+            tail_ = other.tail_;
+            other.head_ = other.tail_ = nullptr;
+        }
+
+    private:
+        io_operation* head_ = nullptr;
+        io_operation* tail_ = nullptr;
+    };
+
+    /**
+     * Clear ec and return true if it means "operation would block".
+     */
+    inline bool retry_later(std::error_code& ec) noexcept {
+        if (ec != error::try_again) return false;
+        ec.clear();
+        return true;
+    }
+
+    /**
+     * Base for operations which deliver several results to one handler.
+     *
+     * In readiness mode operation produces one result, and after handler
+     * invocation it's started again. In native mode results are queued as
+     * kernel reports them and delivered in order by one thread at a time.
+     */
+    template<typename Result>
+    struct multishot_operation : io_operation {
+        bool schedule() noexcept override {
+            std::lock_guard lock(mutex);
+            if (scheduled || results.empty()) return false;
+            scheduled = true;
+            return true;
+        }
+
+        void push(Result result, bool last) {
+            std::lock_guard lock(mutex);
+            results.push_back(std::move(result));
+            finished = last;
+        }
+
+        /**
+         * Take next result for delivery. Returns false if there is nothing
+         * left, done is set then if operation will not produce results anymore.
+         */
+        bool take(Result& result, bool& done) {
+            std::lock_guard lock(mutex);
+            if (results.empty()) {
+                scheduled = false;
+                done = finished;
+                return false;
+            }
+            result = std::move(results.front());
+            results.pop_front();
+            return true;
+        }
+
+        std::mutex mutex;
+        std::deque<Result> results;
+        bool scheduled = false;
+        bool finished = false;
+    };
+
+    template<typename Handler>
+    struct post_operation final : io_operation {
+        explicit post_operation(Handler handler) : handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            return true;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            delete this;
+            local_handler();
+        }
+
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct accept_operation final : io_operation {
+        accept_operation(tcp::listener& listener, Handler handler)
+            : listener(listener), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            result = tcp::socket(listener.implementation().try_accept(ec, false, listener.filter()));
+            return !retry_later(ec);
+        }
+
+        native_request native() noexcept override {
+            native_request request;
+            request.kind = native_request::accept;
+            request.buffer = &peer_address;
+            request.address_length = &peer_address_length;
+            return request;
+        }
+
+        native_status on_native_result(int native_result, bool, provided_buffer&) noexcept override {
+            if (native_result < 0) {
+                ec = native_error(native_result);
+                return native_status::finished;
+            }
+
+            const internal_::socket& implementation = listener.implementation();
+            internal_::socket accepted(native_result, implementation.ip_version, implementation.transport_protocol,
+                                       peer_address);
+            accepted.state.ipv6 = implementation.state.ipv6;
+            if (const auto* filter = listener.filter()) {
+                endpoint peer(reinterpret_cast<const sockaddr*>(&peer_address), peer_address_length);
+                if (implementation.state.ipv6) peer.unmap();
+                if (!(*filter)(peer)) {
+                    // Closed by destructor of accepted, wait for next one.
+                    peer_address_length = sizeof(sockaddr_storage);
+                    return native_status::resubmit;
+                }
+            }
+            result = tcp::socket(std::move(accepted));
+            return native_status::finished;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            tcp::socket local_result = std::move(result);
+            delete this;
+            local_handler(local_ec, std::move(local_result));
+        }
+
+        tcp::listener& listener;
+        tcp::socket result;
+        sockaddr_storage peer_address{};
+        socklen_t peer_address_length = sizeof(sockaddr_storage);
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct accept_multishot_operation final : multishot_operation<std::pair<std::error_code, tcp::socket>> {
+        accept_multishot_operation(io_context& context, tcp::listener& listener, Handler handler)
+            : context(context), listener(listener), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            std::error_code accept_ec;
+            tcp::socket accepted(listener.implementation().try_accept(accept_ec, false, listener.filter()));
+            if (retry_later(accept_ec)) return false;
+            push({accept_ec, std::move(accepted)}, true);
+            return true;
+        }
+
+        native_request native() noexcept override {
+            native_request request;
+            request.kind = native_request::accept;
+            request.multishot = true;
+            return request;
+        }
+
+        native_status on_native_result(int native_result, bool more, provided_buffer&) noexcept override {
+            if (native_result < 0) {
+                push({native_error(native_result), tcp::socket()}, true);
+                return native_status::finished;
+            }
+
+            const internal_::socket& implementation = listener.implementation();
+            internal_::socket accepted(native_result, implementation.ip_version, implementation.transport_protocol);
+            accepted.state.ipv6 = implementation.state.ipv6;
+            const auto* filter = listener.filter();
+            bool allowed = filter == nullptr;
+            if (!allowed) {
+                endpoint peer(accepted.remote_endpoint());
+                if (implementation.state.ipv6) peer.unmap();
+                allowed = (*filter)(peer);
+            }
+            if (allowed) push({std::error_code(), tcp::socket(std::move(accepted))}, false);
+            // Kernel may stop multishot request on its own (e.g. on CQ overflow).
+            return more ? native_status::more : native_status::resubmit;
+        }
+
+        void complete() override {
+            std::pair<std::error_code, tcp::socket> result;
+            bool done = false;
+            if (!native_mode) {
+                // No result means that operation failed before system call.
+                if (!take(result, done)) result.first = ec;
+                handler(result.first, std::move(result.second));
+                if (result.first) {
+                    delete this;
+                } else {
+                    restart_operation(context, listener.implementation(), this, io_direction::read);
+                }
+                return;
+            }
+
+            while (take(result, done)) handler(result.first, std::move(result.second));
+            if (done) delete this;
+        }
+
+        io_context& context;
+        tcp::listener& listener;
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct read_operation final : io_operation {
+        read_operation(tcp::socket& socket, memory_view<uint8_t> buffer, bool read_all, Handler handler)
+            : socket(socket), buffer(buffer), read_all(read_all), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            while (transferred < buffer.size()) {
+                memory_view<uint8_t> rest(buffer.data() + transferred, buffer.size() - transferred);
+                socket.read_some(rest.size(), rest, ec);
+                transferred += rest.size();
+                if (ec) return !retry_later(ec);
+                if (!read_all) break;
+            }
+            return true;
+        }
+
+        native_request native() noexcept override {
+            native_request request;
+            request.kind = native_request::recv;
+            request.buffer = buffer.data() + transferred;
+            request.length = buffer.size() - transferred;
+            return request;
+        }
+
+        native_status on_native_result(int result, bool, provided_buffer&) noexcept override {
+            if (result < 0) {
+                ec = native_error(result);
+            } else if (result == 0 && transferred < buffer.size()) {
+                ec = std::error_code(EOF, error::system_category());
+            } else {
+                transferred += size_t(result);
+                if (read_all && transferred < buffer.size()) return native_status::resubmit;
+            }
+            io_access::update_state(socket, ec);
+            return native_status::finished;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            size_t local_transferred = transferred;
+            delete this;
+            local_handler(local_ec, local_transferred);
+        }
+
+        tcp::socket& socket;
+        memory_view<uint8_t> buffer;
+        bool read_all;
+        size_t transferred = 0;
+        Handler handler;
+    };
+
+    struct received_chunk {
+        std::error_code ec;
+        provided_buffer buffer;
+    };
+
+    template<typename Handler>
+    struct receive_multishot_operation final : multishot_operation<received_chunk> {
+        receive_multishot_operation(io_context& context, tcp::socket& socket, Handler handler)
+            : context(context), socket(socket), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            if (!own_buffer) own_buffer.reset(new (std::nothrow) uint8_t[multishot_buffer_size]);
+            if (!own_buffer) {
+                push({std::make_error_code(std::errc::not_enough_memory), {}}, true);
+                return true;
+            }
+
+            received_chunk chunk;
+            chunk.buffer.data = memory_view<uint8_t>(own_buffer.get(), multishot_buffer_size);
+            socket.read_some(multishot_buffer_size, chunk.buffer.data, chunk.ec);
+            if (retry_later(chunk.ec)) return false;
+            push(chunk, true);
+            return true;
+        }
+
+        native_request native() noexcept override {
+            native_request request;
+            request.kind = native_request::recv;
+            request.multishot = true;
+            request.provided_buffer = true;
+            return request;
+        }
+
+        native_status on_native_result(int result, bool more, provided_buffer& buffer) noexcept override {
+            received_chunk chunk;
+            if (result == -ENOBUFS) {
+                // All provided buffers are in use, wait until some is released.
+                return native_status::resubmit;
+            }
+            if (result < 0) {
+                chunk.ec = native_error(result);
+            } else if (result == 0) {
+                chunk.ec = std::error_code(EOF, error::system_category());
+            } else {
+                chunk.buffer = buffer;
+                chunk.buffer.data = memory_view<uint8_t>(buffer.data.data(), size_t(result));
+                buffer.pool = nullptr;
+                push(chunk, false);
+                return more ? native_status::more : native_status::resubmit;
+            }
+            io_access::update_state(socket, chunk.ec);
+            push(chunk, true);
+            return native_status::finished;
+        }
+
+        void complete() override {
+            received_chunk chunk;
+            bool done = false;
+            if (!native_mode) {
+                if (!take(chunk, done)) chunk.ec = ec;
+                handler(chunk.ec, memory_view<const uint8_t>(chunk.buffer.data));
+                if (chunk.ec) {
+                    delete this;
+                } else {
+                    restart_operation(context, socket.implementation(), this, io_direction::read);
+                }
+                return;
+            }
+
+            while (take(chunk, done)) {
+                handler(chunk.ec, memory_view<const uint8_t>(chunk.buffer.data));
+                chunk.buffer.release();
+            }
+            if (done) delete this;
+        }
+
+        io_context& context;
+        tcp::socket& socket;
+        std::unique_ptr<uint8_t[]> own_buffer;
+        Handler handler;
+    };
+
+    template<typename Buffer, typename Handler>
+    struct read_until_operation final : io_operation {
+        read_until_operation(tcp::socket& socket, uint8_t delimiter, Buffer& buffer, size_t max_size,
+                             Handler handler)
+            : socket(socket), delimiter(delimiter), buffer(buffer), max_size(max_size), handler(std::move(handler)) {
+            buffer.clear();
+        }
+
+        /*
+         * Data is peeked first and then only bytes up to delimiter are
+         * consumed, so we need two system calls per chunk instead of one
+         * per byte and never read past delimiter.
+         */
+        bool perform() noexcept override {
+            uint8_t chunk[4096];
+            for (;;) {
+                size_t limit = max_size != 0 ? max_size - buffer.size() : sizeof(chunk);
+                // + 1 to consume delimiter right after max_size bytes.
+                size_t available = socket.implementation().peek(chunk, std::min(limit + 1, sizeof(chunk)), ec);
+                if (ec) {
+                    if (retry_later(ec)) return false;
+                    // Let tcp::socket notice disconnection.
+                    memory_view<uint8_t> view(chunk, 1);
+                    if (ec == error::end_of_file) socket.read_some(1, view, ec);
+                    return true;
+                }
+
+                auto* found = static_cast<uint8_t*>(std::memchr(chunk, delimiter, available));
+                size_t data_size = found != nullptr ? size_t(found - chunk) : available;
+                bool done = found != nullptr && data_size <= limit;
+                if (!done) data_size = std::min(data_size, limit);
+
+                memory_view<uint8_t> view(chunk, data_size + (done ? 1 : 0));
+                socket.read_some(view.size(), view, ec);
+                if (ec) return true;
+
+                auto* first = reinterpret_cast<const typename Buffer::value_type*>(chunk);
+                buffer.insert(buffer.end(), first, first + data_size);
+                if (done || (max_size != 0 && buffer.size() == max_size)) return true;
+            }
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            size_t size = buffer.size();
+            delete this;
+            local_handler(local_ec, size);
+        }
+
+        tcp::socket& socket;
+        uint8_t delimiter;
+        Buffer& buffer;
+        size_t max_size;
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct write_operation final : io_operation {
+        write_operation(tcp::socket& socket, memory_view<const uint8_t> buffer, Handler handler)
+            : socket(socket), buffer(buffer), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            while (transferred < buffer.size()) {
+                memory_view<const uint8_t> rest(buffer.data() + transferred, buffer.size() - transferred);
+                transferred += socket.write(rest, ec);
+                if (ec) return !retry_later(ec);
+            }
+            return true;
+        }
+
+        native_request native() noexcept override {
+            native_request request;
+            request.kind = native_request::send;
+            request.buffer = const_cast<uint8_t*>(buffer.data() + transferred);
+            request.length = buffer.size() - transferred;
+            return request;
+        }
+
+        native_status on_native_result(int result, bool, provided_buffer&) noexcept override {
+            if (result < 0) {
+                ec = native_error(result);
+            } else {
+                transferred += size_t(result);
+                if (transferred < buffer.size()) return native_status::resubmit;
+            }
+            io_access::update_state(socket, ec);
+            return native_status::finished;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            size_t local_transferred = transferred;
+            delete this;
+            local_handler(local_ec, local_transferred);
+        }
+
+        tcp::socket& socket;
+        memory_view<const uint8_t> buffer;
+        size_t transferred = 0;
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct connect_operation final : io_operation {
+        connect_operation(tcp::socket& socket, address target, uint16_t port, Handler handler)
+            : socket(socket), target(target), port(port), handler(std::move(handler)) {
+        }
+
+        /*
+         * First call starts connection, when socket becomes writable
+         * result is taken from SO_ERROR.
+         */
+        bool perform() noexcept override {
+            if (!connecting) {
+                connecting = true;
+                socket.implementation().connect(target, port, ec);
+                if (ec == error::in_progress) {
+                    ec.clear();
+                    return false;
+                }
+            } else {
+                int status = 0;
+                socklen_t length = sizeof(status);
+                if (getsockopt(socket.native_handle(), SOL_SOCKET, SO_ERROR, &status, &length) == -1) {
+                    status = errno;
+                }
+                if (status != 0) ec = std::error_code(status, error::system_category());
+            }
+            io_access::set_open(socket, !ec);
+            return true;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            delete this;
+            local_handler(local_ec);
+        }
+
+        tcp::socket& socket;
+        address target;
+        uint16_t port;
+        bool connecting = false;
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct receive_from_operation final : io_operation {
+        receive_from_operation(udp::socket& socket, memory_view<uint8_t> buffer, Handler handler)
+            : socket(socket), buffer(buffer), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            memory_view<uint8_t> view = buffer;
+            source = socket.read(buffer.size(), view, ec);
+            transferred = view.size();
+            return !retry_later(ec);
+        }
+
+        native_request native() noexcept override {
+            message.prepare(buffer.data(), buffer.size(), nullptr);
+            native_request request;
+            request.kind = native_request::recvmsg;
+            request.message = &message.header;
+            return request;
+        }
+
+        native_status on_native_result(int result, bool, provided_buffer&) noexcept override {
+            if (result < 0) {
+                ec = native_error(result);
+            } else {
+                transferred = size_t(result);
+                source = message.source();
+            }
+            return native_status::finished;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            size_t local_transferred = transferred;
+            std::tuple<address, uint16_t> local_source = source;
+            delete this;
+            local_handler(local_ec, local_transferred, local_source);
+        }
+
+        udp::socket& socket;
+        memory_view<uint8_t> buffer;
+        size_t transferred = 0;
+        std::tuple<address, uint16_t> source{address{0, 0, 0, 0}, 0};
+        native_message message;
+        Handler handler;
+    };
+
+    template<typename Handler>
+    struct send_to_operation final : io_operation {
+        send_to_operation(udp::socket& socket, memory_view<const uint8_t> buffer, const endpoint& destination,
+                          Handler handler)
+            : socket(socket), buffer(buffer), destination(destination), handler(std::move(handler)) {
+        }
+
+        bool perform() noexcept override {
+            transferred = socket.implementation().send_to(buffer.data(), buffer.size(), ec, destination);
+            return !retry_later(ec);
+        }
+
+        native_request native() noexcept override {
+            message.prepare(const_cast<uint8_t*>(buffer.data()), buffer.size(), &destination,
+                            socket.implementation().state.ipv6);
+            native_request request;
+            request.kind = native_request::sendmsg;
+            request.message = &message.header;
+            return request;
+        }
+
+        native_status on_native_result(int result, bool, provided_buffer&) noexcept override {
+            if (result < 0) {
+                ec = native_error(result);
+            } else {
+                transferred = size_t(result);
+            }
+            return native_status::finished;
+        }
+
+        void complete() override {
+            Handler local_handler(std::move(handler));
+            std::error_code local_ec = ec;
+            size_t local_transferred = transferred;
+            delete this;
+            local_handler(local_ec, local_transferred);
+        }
+
+        udp::socket& socket;
+        memory_view<const uint8_t> buffer;
+        endpoint destination;
+        size_t transferred = 0;
+        native_message message;
+        Handler handler;
+    };
+} // namespace libwire::internal_
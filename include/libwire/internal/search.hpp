@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * This file defines byte sequence search routines used in buffered
+ * stream implementation.
+ *
+ * search() dispatches to fastest kernel supported by CPU, it's picked
+ * once at startup using CPUID. Other functions are exposed for tests and
+ * benchmarks only.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    define LIBWIRE_X86_KERNELS
+#endif
+
+namespace libwire::internal_ {
+    /**
+     * Find first occurrence of needle in haystack.
+     *
+     * Returns offset of first needle byte or haystack_size if needle is
+     * not found. needle_size must be non-zero.
+     */
+    size_t search(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle, size_t needle_size) noexcept;
+
+    /**
+     * Name of kernel used by \ref search: "scalar", "sse2" or "avx2".
+     */
+    const char* search_kernel() noexcept;
+
+    size_t search_scalar(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                         size_t needle_size) noexcept;
+
+#ifdef LIBWIRE_X86_KERNELS
+    size_t search_sse2(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                       size_t needle_size) noexcept;
+
+    /**
+     * \warning Calling this function on CPU without AVX2 support will
+     * crash program. Check search_avx2_supported() first.
+     */
+    size_t search_avx2(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                       size_t needle_size) noexcept;
+
+    bool search_avx2_supported() noexcept;
+#endif
+} // namespace libwire::internal_
@@ -23,17 +23,41 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <tuple>
 #include <system_error>
 #include <optional>
 #include <libwire/address.hpp>
+#include <libwire/endpoint.hpp>
 #include <libwire/protocols.hpp>
+#include <libwire/zero_copy.hpp>
 
 #ifdef _WIN32
 #    include <winsock2.h>
+#else
+#    include <sys/socket.h>
 #endif
 
 namespace libwire::internal_ {
+    /**
+     * Description of one datagram for batched I/O, see
+     * \ref socket::receive_many and \ref socket::send_many.
+     */
+    struct datagram_header {
+        /// Datagram memory, capacity is used only for receive.
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+
+        /// Size of received datagram or datagram to send.
+        size_t size = 0;
+
+        /// Set on receive if datagram was larger than capacity and was cut.
+        bool truncated = false;
+
+        /// Source or destination endpoint, empty if none.
+        endpoint address;
+    };
+
     /**
      * Thin C++ wrapper for BSD-like sockets.
      */
@@ -64,12 +88,25 @@ namespace libwire::internal_ {
             : ip_version(ip_version), transport_protocol(transport_protocol), handle(handle) {
         }
 
+        /**
+         * Wrap accepted socket handle, peer_address is remote address reported
+         * by accept call and will be returned by \ref remote_endpoint.
+         */
+        socket(native_handle_t handle, ip ip_version, transport transport_protocol,
+               const sockaddr_storage& peer_address) noexcept;
+
         /**
          * Allocate new socket with specified family (network protocol)
          * and socket type (transport protocol).
          */
         socket(ip ipver, transport transport, std::error_code& ec) noexcept;
 
+        /**
+         * Allocate new IPv6 socket with IPV6_V6ONLY option disabled,
+         * see \ref libwire::dual_stack.
+         */
+        socket(dual_stack_t, transport transport, std::error_code& ec) noexcept;
+
         socket(const socket&) = delete;
         socket(socket&&) noexcept;
         socket& operator=(const socket&) = delete;
@@ -88,6 +125,8 @@ namespace libwire::internal_ {
          */
         void connect(address target, uint16_t port, std::error_code& ec) noexcept;
 
+        void connect(const endpoint& target, std::error_code& ec) noexcept;
+
         /**
          * Shutdown read/write parts of full-duplex connection.
          */
@@ -99,6 +138,8 @@ namespace libwire::internal_ {
          */
         void bind(uint16_t port, address interface_address, std::error_code& ec) noexcept;
 
+        void bind(const endpoint& local, std::error_code& ec) noexcept;
+
         /**
          * Start accepting connections on this listener socket.
          *
@@ -107,11 +148,42 @@ namespace libwire::internal_ {
          */
         void listen(int backlog, std::error_code& ec) noexcept;
 
+        /**
+         * Predicate deciding whether connection from peer should be
+         * accepted, see tcp::listener::set_peer_filter.
+         */
+        using peer_filter = std::function<bool(const endpoint& peer)>;
+
         /**
          * Extract and accept first connection from queue and create socket for it,
          * set ec if any error occurred.
+         *
+         * Peer endpoint reported by the same system call is stored in the
+         * returned socket, see \ref peer. If non_blocking is true, returned
+         * socket is created in non-blocking mode (atomically on Linux).
+         *
+         * If filter is not null, connections it rejects are closed right
+         * after the system call and next connection is taken.
+         */
+        socket accept(std::error_code& ec, bool non_blocking = false, const peer_filter* filter = nullptr) noexcept;
+
+        /**
+         * Same as \ref accept but never waits for connection, if queue is
+         * empty try_again error is reported even for blocking socket.
+         *
+         * Listener socket should be in (at least internal) non-blocking mode.
+         */
+        socket try_accept(std::error_code& ec, bool non_blocking = false,
+                          const peer_filter* filter = nullptr) noexcept;
+
+        /**
+         * Switch socket to non-blocking mode without changing user-visible
+         * mode (libwire::non_blocking option), set ec if any error occurred.
+         *
+         * Operations that should block in user's mode wait for readiness
+         * themselves. Does nothing if socket is already non-blocking.
          */
-        socket accept(std::error_code& ec) noexcept;
+        void make_internal_non_blocking(std::error_code& ec) noexcept;
 
         /**
          * Write length_bytes from input to socket, set ec if any error
@@ -125,6 +197,87 @@ namespace libwire::internal_ {
          */
         size_t read(void* output, size_t length_bytes, std::error_code& ec) noexcept;
 
+        /**
+         * Read at most length_bytes from socket to output, set ec if any error
+         * occurred and return real count of data read.
+         *
+         * Unlike \ref read it returns as soon as any data is available, so
+         * short read is not an EOF. EOF is reported only if 0 bytes received.
+         */
+        size_t read_some(void* output, size_t length_bytes, std::error_code& ec) noexcept;
+
+        /**
+         * Same as \ref read_some but leaves data in socket receive queue,
+         * so it will be returned again by next read.
+         */
+        size_t peek(void* output, size_t length_bytes, std::error_code& ec) noexcept;
+
+        /**
+         * Check without blocking that connection has no pending input
+         * and is not closed by peer, i.e. it can be reused for next
+         * request. Doesn't consume or copy any data.
+         */
+        bool idle_usable() const noexcept;
+
+        /**
+         * Write data from several buffers to socket using single system
+         * call where possible (gather write), set ec if any error occurred and
+         * return real count of data written.
+         *
+         * In blocking mode partial writes are continued from the byte where
+         * they stopped, so all data is written unless error occurred. In
+         * non-blocking mode partial write is returned as is.
+         */
+        size_t write(const memory_view<const uint8_t>* buffers, size_t buffers_count, std::error_code& ec) noexcept;
+
+        /**
+         * Read data from socket into several buffers using single system
+         * call where possible (scatter read), set ec if any error occurred and
+         * return real count of data read.
+         *
+         * Buffers are filled in order, semantics are same as for \ref read.
+         */
+        size_t read(const memory_view<uint8_t>* buffers, size_t buffers_count, std::error_code& ec) noexcept;
+
+        /**
+         * Write length_bytes from input to socket without copying them into
+         * kernel buffer (MSG_ZEROCOPY), set ec if any error occurred and
+         * return real count of data written.
+         *
+         * id is set to sequence number of this write if kernel still uses
+         * input and will report completion later, otherwise it's reset and
+         * input can be reused immediately (small write, zero-copy is not
+         * enabled or not supported).
+         */
+        size_t write_zero_copy(const void* input, size_t length_bytes, std::optional<uint32_t>& id,
+                               std::error_code& ec) noexcept;
+
+        /**
+         * Read at most max_count zero-copy completion notifications from socket
+         * error queue into output without blocking, set ec if any error occurred
+         * and return real count of notifications read.
+         */
+        size_t read_zero_copy_completions(zero_copy_completion* output, size_t max_count,
+                                          std::error_code& ec) noexcept;
+
+#ifndef _WIN32
+        /**
+         * Send length bytes from file starting at offset without copying
+         * them to user-space (sendfile), set ec if any error occurred and
+         * return real count of data sent.
+         *
+         * Less data is sent if file ends earlier, file offset is not changed.
+         */
+        size_t send_file(int file, uint64_t offset, size_t length, std::error_code& ec) noexcept;
+
+        /**
+         * Receive length bytes from socket and write them into file at
+         * offset without copying them to user-space (splice), set ec
+         * if any error occurred and return real count of data written to file.
+         */
+        size_t receive_to_file(int file, uint64_t offset, size_t length, std::error_code& ec) noexcept;
+#endif
+
         /**
          * Send length_bytes from input to destination, set ec if any error
          * occurred.
@@ -132,6 +285,14 @@ namespace libwire::internal_ {
         size_t send_to(const void* input, size_t length_bytes, std::error_code& ec,
                        std::optional<std::tuple<address, uint16_t>> destination) noexcept;
 
+        /**
+         * Same as above but destination is already in native form, so
+         * no conversion is done (except mapping IPv4 endpoint for IPv6
+         * socket).
+         */
+        size_t send_to(const void* input, size_t length_bytes, std::error_code& ec,
+                       const endpoint& destination) noexcept;
+
         /**
          * Read length_bytes from socket datagram queue to output, set ec if
          * any occurred, return source endpoint and actual size of datagram.
@@ -139,6 +300,52 @@ namespace libwire::internal_ {
         std::tuple<address, uint16_t, size_t> receive_from(void* output, size_t length_bytes,
                                                            std::error_code& ec) noexcept;
 
+        /**
+         * Same as above but source endpoint is written directly by system
+         * call into source, return actual size of datagram.
+         */
+        size_t receive_from(void* output, size_t length_bytes, endpoint& source, std::error_code& ec) noexcept;
+
+        /**
+         * Receive up to count datagrams into buffers described by headers using
+         * as few system calls as possible (recvmmsg), set ec if any error occurred
+         * and return count of datagrams received.
+         *
+         * Waits only for first datagram, rest are taken only if they are already
+         * queued. Datagrams larger than capacity are truncated, it's reported by
+         * truncated flag of header on Linux only.
+         */
+        size_t receive_many(datagram_header* headers, size_t count, std::error_code& ec) noexcept;
+
+        /**
+         * Send count datagrams described by headers using as few system calls as
+         * possible (sendmmsg) and return count of datagrams sent, ec is set only
+         * if error occurred before any datagram is sent.
+         */
+        size_t send_many(const datagram_header* headers, size_t count, std::error_code& ec) noexcept;
+
+        /**
+         * Send length_bytes from input as datagrams of segment_size bytes (last
+         * one can be shorter) to destination, set ec if any error occurred before
+         * anything was sent and return count of bytes sent.
+         *
+         * Uses UDP segmentation offload (UDP_SEGMENT) so kernel splits buffer
+         * into datagrams, falls back to sending datagrams one by one if it's
+         * not supported.
+         */
+        size_t send_segmented(const void* input, size_t length_bytes, size_t segment_size, std::error_code& ec,
+                              std::optional<std::tuple<address, uint16_t>> destination) noexcept;
+
+        /**
+         * Same as \ref receive_from but if receive offload (UDP_GRO) is enabled,
+         * several datagrams from same source can be received at once, segment_size
+         * is set to size of each of them (except last which can be shorter).
+         * truncated is set if data didn't fit into output (Linux only).
+         */
+        std::tuple<address, uint16_t, size_t> receive_coalesced(void* output, size_t length_bytes,
+                                                                size_t& segment_size, bool& truncated,
+                                                                std::error_code& ec) noexcept;
+
         /**
          * Allows to check whether socket is initialized and can be operated on.
          */
@@ -157,8 +364,30 @@ namespace libwire::internal_ {
 
             /// Do we really have non-blocking socket now?
             bool internal_non_blocking : 1;
+
+            /// Is SO_ZEROCOPY enabled?
+            bool zero_copy : 1;
+
+            /// Did kernel report that zero-copy writes are copied anyway?
+            bool zero_copy_copied : 1;
+
+            /// Is UDP_GRO enabled?
+            bool receive_offload : 1;
+
+            /// Did kernel reject UDP_SEGMENT?
+            bool segmentation_offload_unsupported : 1;
+
+            /// Is this IPv6 socket? IPv4 endpoints are passed to it as IPv4-mapped
+            /// addresses, which works if IPV6_V6ONLY is disabled (see dual_stack).
+            bool ipv6 : 1;
         } state{};
 
+        /// Sequence number of next zero-copy write.
+        uint32_t zero_copy_next_id = 0;
+
+        /// Remote endpoint known without getpeername() call (filled by accept()).
+        std::optional<std::tuple<address, uint16_t>> peer;
+
         native_handle_t handle = not_initialized;
     };
 } // namespace libwire::internal_
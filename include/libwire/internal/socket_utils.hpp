@@ -34,6 +34,7 @@
 
 #ifdef _WIN32
 #    include <winsock2.h>
+#    include <ws2tcpip.h>
 #else
 #    include <sys/socket.h>
 #    include <netinet/in.h>
@@ -44,13 +45,29 @@
 #endif
 
 namespace libwire::internal_ {
+    /**
+     * Convert sockaddr to socket endpoint (tuple).
+     *
+     * IPv4-mapped IPv6 addresses (::ffff:a.b.c.d), which are reported
+     * for IPv4 peers of dual-stack sockets, are converted to ip::v4
+     * addresses.
+     */
     std::tuple<address, uint16_t> sockaddr_to_endpoint(sockaddr_storage in);
 
     /**
      * Convert socket endpoint (tuple) to sockaddr used by BSD-like
      * sockets interface.
+     *
+     * If v4_mapped is true IPv4 address is converted to IPv4-mapped
+     * IPv6 address, as required by dual-stack sockets.
+     */
+    sockaddr_storage endpoint_to_sockaddr(std::tuple<address, uint16_t> in, bool v4_mapped = false);
+
+    /**
+     * Size of address structure stored in sockaddr_storage, to be passed
+     * to system calls.
      */
-    sockaddr_storage endpoint_to_sockaddr(std::tuple<address, uint16_t> in);
+    socklen_t sockaddr_length(const sockaddr_storage& in) noexcept;
 
     int last_socket_error();
 
@@ -0,0 +1,547 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <libwire/internal/io_operation.hpp>
+
+namespace libwire::internal_ {
+    class io_backend;
+    struct coroutine_access;
+}
+
+namespace libwire {
+    /**
+     * Event loop for asynchronous operations on sockets.
+     *
+     * Operations are started using async_* functions and their completion
+     * handlers are called from threads executing run(). run() can be called
+     * from several threads at once, handlers are distributed between them.
+     *
+     * Quick usage example:
+     * \code
+     * io_context context;
+     * tcp::listener listener{ipv4::any, 7777};
+     * context.async_accept(listener, [&](std::error_code ec, tcp::socket sock) {
+     *     // ...
+     * });
+     * context.run();
+     * \endcode
+     *
+     * Handler is never called from async_* function itself, even if
+     * operation completes immediately.
+     *
+     * Sockets used with io_context are switched to non-blocking mode
+     * internally. Socket and buffers passed to operation must stay alive
+     * until handler is called. Only one read and one write operation
+     * should be pending for socket at a time, to abandon them call
+     * \ref cancel before closing socket.
+     *
+     * Currently implemented only for Linux. Events are received using
+     * io_uring if library is built with it (LIBWIRE_IO_BACKEND CMake
+     * option) and running kernel supports it, otherwise epoll is used.
+     * With io_uring operations are executed by kernel directly instead
+     * of waiting for readiness and then doing system call, so one
+     * io_uring_enter call serves many operations.
+     *
+     * Read, write and connect operations can be started with timeout,
+     * handler is called with error::timeout if operation is not
+     * completed in time. Deadlines are kept in single \ref timing_wheel,
+     * so arming and disarming them is cheap even with many connections,
+     * unlike receive_timeout and send_timeout options. Same wheel is used
+     * for user timers, see \ref schedule.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: safe
+     */
+    class io_context {
+    public:
+        enum class backend_type {
+            /// io_uring if available, epoll otherwise.
+            automatic,
+            epoll,
+            /// Falls back to epoll if io_uring is not available.
+            io_uring,
+        };
+
+        /**
+         * Allocate event loop resources, set ec if any error occurred.
+         */
+        explicit io_context(std::error_code& ec, backend_type preferred = backend_type::automatic) noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        explicit io_context(backend_type preferred = backend_type::automatic);
+#endif
+
+        io_context(const io_context&) = delete;
+        io_context& operator=(const io_context&) = delete;
+
+        /**
+         * Destroy pending operations without calling their handlers.
+         */
+        ~io_context();
+
+        /**
+         * Run event loop until there is no pending operations left or
+         * stop() called. Returns count of handlers executed.
+         *
+         * Exceptions thrown by handlers are propagated to caller, it's
+         * safe to call run() again after this.
+         */
+        size_t run();
+
+        /**
+         * Same as run() but returns after first executed handler.
+         */
+        size_t run_one();
+
+        /**
+         * Execute handlers ready to run without blocking.
+         * Returns count of handlers executed.
+         */
+        size_t poll();
+
+        /**
+         * Make all threads executing run() return as soon as possible.
+         *
+         * Pending operations are not canceled and will continue after
+         * restart() and run().
+         */
+        void stop() noexcept;
+
+        bool stopped() const noexcept;
+
+        /**
+         * Reset stopped state so run() can be called again.
+         */
+        void restart() noexcept;
+
+        /**
+         * Backend actually used by this io_context, never automatic.
+         */
+        backend_type backend() const noexcept;
+
+        /**
+         * Request handler invocation without arguments from run().
+         */
+        template<typename Handler>
+        void post(Handler&& handler);
+
+        /**
+         * Accept connection from listener queue.
+         *
+         * Handler signature: void(std::error_code, tcp::socket).
+         */
+        template<typename Handler>
+        void async_accept(tcp::listener& listener, Handler&& handler);
+
+        /**
+         * Accept connections from listener queue until error occurred or
+         * operation canceled, handler is called for each connection.
+         *
+         * Handler is last called with error set (error::operation_aborted
+         * after \ref cancel), operation is finished after this. Handler
+         * must not throw.
+         *
+         * With io_uring single request is used for all connections
+         * (multishot accept).
+         *
+         * Handler signature: void(std::error_code, tcp::socket).
+         */
+        template<typename Handler>
+        void async_accept_multishot(tcp::listener& listener, Handler&& handler);
+
+        /**
+         * Read exactly buffer.size() bytes from socket into buffer, fail
+         * earlier only if error occurred or EOF hit.
+         *
+         * Handler signature: void(std::error_code, size_t bytes_read).
+         */
+        template<typename Handler>
+        void async_read(tcp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler);
+
+        /**
+         * Same as async_read(), but fails with error::timeout if whole
+         * buffer is not read in specified time. Bytes read before timeout
+         * are reported in handler.
+         */
+        template<typename Handler>
+        void async_read(tcp::socket& socket, memory_view<uint8_t> buffer, std::chrono::milliseconds timeout,
+                        Handler&& handler);
+
+        /**
+         * Read at most buffer.size() bytes from socket into buffer, completes
+         * as soon as any data is available.
+         *
+         * Handler signature: void(std::error_code, size_t bytes_read).
+         */
+        template<typename Handler>
+        void async_read_some(tcp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler);
+
+        /**
+         * Same as async_read_some(), but fails with error::timeout if no
+         * data received in specified time.
+         */
+        template<typename Handler>
+        void async_read_some(tcp::socket& socket, memory_view<uint8_t> buffer, std::chrono::milliseconds timeout,
+                             Handler&& handler);
+
+        /**
+         * Receive data from socket until error occurred or operation
+         * canceled, handler is called for each received chunk.
+         *
+         * Data is stored in buffers owned by io_context and valid only
+         * until handler returns. Handler is last called with error set
+         * (error::end_of_file, error::operation_aborted, etc) and empty
+         * data, operation is finished after this. Handler must not throw.
+         *
+         * With io_uring single request is used for all chunks (multishot
+         * receive) and data is placed into buffers provided to kernel in
+         * advance, so no memory is pinned by idle connections.
+         *
+         * Handler signature: void(std::error_code, memory_view<const uint8_t> data).
+         */
+        template<typename Handler>
+        void async_receive_multishot(tcp::socket& socket, Handler&& handler);
+
+        /**
+         * Read from socket into buffer until delimiter is found or max_size
+         * bytes read, see \ref tcp::socket::read_until.
+         *
+         * Delimiter is removed from socket stream but not appended to
+         * buffer. Bytes after delimiter are not consumed.
+         *
+         * Handler signature: void(std::error_code, size_t buffer_size).
+         *
+         * **Buffer type requirements:** clear(), size() and
+         * insert(end, first, last) with behavior defined in SequenceContainer.
+         */
+        template<typename Buffer, typename Handler>
+        void async_read_until(tcp::socket& socket, uint8_t delimiter, Buffer& buffer, Handler&& handler,
+                              size_t max_size = 0);
+
+        /**
+         * Open new descriptor for socket and connect it to remote endpoint,
+         * see \ref tcp::socket::connect.
+         *
+         * Handler signature: void(std::error_code).
+         */
+        template<typename Handler>
+        void async_connect(tcp::socket& socket, address target, uint16_t port, Handler&& handler);
+
+        /**
+         * Same as async_connect(), but fails with error::timeout if
+         * connection is not established in specified time.
+         */
+        template<typename Handler>
+        void async_connect(tcp::socket& socket, address target, uint16_t port, std::chrono::milliseconds timeout,
+                           Handler&& handler);
+
+        /**
+         * Write whole buffer to socket, fail earlier only if error occurred.
+         *
+         * Handler signature: void(std::error_code, size_t bytes_written).
+         */
+        template<typename Handler>
+        void async_write(tcp::socket& socket, memory_view<const uint8_t> buffer, Handler&& handler);
+
+        /**
+         * Same as async_write(), but fails with error::timeout if whole
+         * buffer is not written in specified time. Bytes written before
+         * timeout are reported in handler.
+         */
+        template<typename Handler>
+        void async_write(tcp::socket& socket, memory_view<const uint8_t> buffer, std::chrono::milliseconds timeout,
+                         Handler&& handler);
+
+        /**
+         * Receive one datagram into buffer, it will be truncated if it's
+         * bigger than buffer.size().
+         *
+         * Handler signature: void(std::error_code, size_t bytes_read,
+         * std::tuple<address, uint16_t> source).
+         */
+        template<typename Handler>
+        void async_receive_from(udp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler);
+
+        /**
+         * Send buffer as one datagram to destination.
+         *
+         * Destination is converted to native form once, when operation
+         * is started.
+         *
+         * Handler signature: void(std::error_code, size_t bytes_written).
+         */
+        template<typename Handler>
+        void async_send_to(udp::socket& socket, memory_view<const uint8_t> buffer, const endpoint& destination,
+                           Handler&& handler);
+
+        /**
+         * Call timer callback from thread executing run() after timeout,
+         * timer is rescheduled if it's already armed. Armed timers keep
+         * run() from returning.
+         *
+         * Intended for idle connection reaping: schedule timer after each
+         * completed operation and close connection in callback.
+         *
+         * Callback is executed with timers lock held, so it should be
+         * short. It can schedule and cancel timers and start operations,
+         * and it's not counted as executed handler.
+         *
+         * \warning Timer must be disarmed using \ref cancel_timer before
+         * destruction, timing_wheel::timer::cancel() is not synchronized
+         * with threads executing run().
+         */
+        void schedule(timing_wheel::timer& timer, std::chrono::milliseconds timeout);
+
+        /**
+         * Disarm timer armed by \ref schedule, returns false if it's not
+         * armed (already expired or never scheduled).
+         */
+        bool cancel_timer(timing_wheel::timer& timer) noexcept;
+
+        /**
+         * Let backend keep reference to socket to save descriptor lookup
+         * on each operation (io_uring registered files), set ec if any
+         * error occurred. No-op for epoll.
+         *
+         * \warning Kernel keeps socket alive while it's registered, so
+         * \ref unregister_socket must be called before closing socket.
+         */
+        template<typename Socket>
+        void register_socket(Socket& socket, std::error_code& ec) noexcept {
+            register_descriptor(socket.native_handle(), ec);
+        }
+
+        /**
+         * Drop reference obtained by \ref register_socket.
+         */
+        template<typename Socket>
+        void unregister_socket(Socket& socket) noexcept {
+            unregister_descriptor(socket.native_handle());
+        }
+
+        /**
+         * Complete all pending operations on socket with
+         * error::operation_aborted.
+         */
+        template<typename Socket>
+        void cancel(Socket& socket) noexcept {
+            cancel_descriptor(socket.native_handle());
+        }
+
+    private:
+        friend class internal_::io_backend;
+        friend struct internal_::coroutine_access;
+        friend internal_::frame_pool* internal_::current_frame_pool() noexcept;
+        friend void internal_::restart_operation(io_context&, internal_::socket&, internal_::io_operation*,
+                                                 internal_::io_direction);
+
+        struct thread_state;
+
+        void open(backend_type preferred, std::error_code& ec) noexcept;
+        void start(internal_::socket& socket, internal_::io_operation* op, internal_::io_direction dir);
+        void start(internal_::socket& socket, internal_::io_operation* op, internal_::io_direction dir,
+                   std::chrono::milliseconds timeout);
+        void enqueue_post(internal_::io_operation* op);
+        void post_completion(internal_::io_operation* op);
+        size_t share_completions(internal_::op_queue& completed);
+        bool running_in_this_thread() const noexcept;
+        void cancel_descriptor(internal_::socket::native_handle_t handle) noexcept;
+        void register_descriptor(internal_::socket::native_handle_t handle, std::error_code& ec) noexcept;
+        void unregister_descriptor(internal_::socket::native_handle_t handle) noexcept;
+        bool run_one_impl(thread_state& thread, bool block);
+        void arm_timer(timing_wheel::timer& timer, std::chrono::milliseconds timeout);
+        void update_timers_state() noexcept;
+        int expire_timers();
+        void expire_deadline(internal_::io_operation* op) noexcept;
+        void disarm_deadline(internal_::io_operation* op) noexcept;
+        void interrupt() noexcept;
+        void work_finished() noexcept;
+
+        // Declared first, so it's destroyed after everything allocated from it.
+        internal_::frame_pool frames_;
+
+        /// Coroutines started by coro::spawn and not finished yet.
+        std::mutex spawned_mutex_;
+        internal_::spawned_frame* spawned_ = nullptr;
+
+        /// User timers and operation deadlines. Recursive because timer
+        /// callbacks are executed with it held and can schedule timers.
+        std::recursive_mutex timers_mutex_;
+        timing_wheel timers_;
+
+        /// Copies of timers_ state readable without lock, next_timer_ is
+        /// clock ticks since epoch.
+        std::atomic<size_t> armed_timers_{0};
+        std::atomic<timing_wheel::clock::rep> next_timer_{0};
+
+        std::unique_ptr<internal_::io_backend> backend_;
+        backend_type backend_type_ = backend_type::epoll;
+
+        std::atomic<size_t> outstanding_{0};
+        std::atomic<bool> stopped_{false};
+        std::atomic<unsigned> running_threads_{0};
+
+        std::mutex queue_mutex_;
+        internal_::op_queue queue_;
+    };
+
+    template<typename Handler>
+    void io_context::post(Handler&& handler) {
+        enqueue_post(new (frames_) internal_::post_operation<std::decay_t<Handler>>(std::forward<Handler>(handler)));
+    }
+
+    template<typename Handler>
+    void io_context::async_accept(tcp::listener& listener, Handler&& handler) {
+        using operation = internal_::accept_operation<std::decay_t<Handler>>;
+        start(listener.implementation(), new (frames_) operation(listener, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_accept_multishot(tcp::listener& listener, Handler&& handler) {
+        using operation = internal_::accept_multishot_operation<std::decay_t<Handler>>;
+        start(listener.implementation(), new (frames_) operation(*this, listener, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_read(tcp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler) {
+        using operation = internal_::read_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, true, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_read(tcp::socket& socket, memory_view<uint8_t> buffer, std::chrono::milliseconds timeout,
+                                Handler&& handler) {
+        using operation = internal_::read_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, true, std::forward<Handler>(handler)),
+              internal_::io_direction::read, timeout);
+    }
+
+    template<typename Handler>
+    void io_context::async_read_some(tcp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler) {
+        using operation = internal_::read_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, false, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_read_some(tcp::socket& socket, memory_view<uint8_t> buffer,
+                                     std::chrono::milliseconds timeout, Handler&& handler) {
+        using operation = internal_::read_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, false, std::forward<Handler>(handler)),
+              internal_::io_direction::read, timeout);
+    }
+
+    template<typename Handler>
+    void io_context::async_receive_multishot(tcp::socket& socket, Handler&& handler) {
+        using operation = internal_::receive_multishot_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(*this, socket, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Buffer, typename Handler>
+    void io_context::async_read_until(tcp::socket& socket, uint8_t delimiter, Buffer& buffer, Handler&& handler,
+                                      size_t max_size) {
+        using operation = internal_::read_until_operation<Buffer, std::decay_t<Handler>>;
+        start(socket.implementation(),
+              new (frames_) operation(socket, delimiter, buffer, max_size, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_connect(tcp::socket& socket, address target, uint16_t port, Handler&& handler) {
+        using operation = internal_::connect_operation<std::decay_t<Handler>>;
+        auto* op = new (frames_) operation(socket, target, port, std::forward<Handler>(handler));
+
+        std::error_code ec;
+        internal_::io_access::reopen(socket, target.version, ec);
+        if (ec) {
+            op->ec = ec;
+            enqueue_post(op);
+            return;
+        }
+        start(socket.implementation(), op, internal_::io_direction::write);
+    }
+
+    template<typename Handler>
+    void io_context::async_connect(tcp::socket& socket, address target, uint16_t port,
+                                   std::chrono::milliseconds timeout, Handler&& handler) {
+        using operation = internal_::connect_operation<std::decay_t<Handler>>;
+        auto* op = new (frames_) operation(socket, target, port, std::forward<Handler>(handler));
+
+        std::error_code ec;
+        internal_::io_access::reopen(socket, target.version, ec);
+        if (ec) {
+            op->ec = ec;
+            enqueue_post(op);
+            return;
+        }
+        start(socket.implementation(), op, internal_::io_direction::write, timeout);
+    }
+
+    template<typename Handler>
+    void io_context::async_write(tcp::socket& socket, memory_view<const uint8_t> buffer, Handler&& handler) {
+        using operation = internal_::write_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, std::forward<Handler>(handler)),
+              internal_::io_direction::write);
+    }
+
+    template<typename Handler>
+    void io_context::async_write(tcp::socket& socket, memory_view<const uint8_t> buffer,
+                                 std::chrono::milliseconds timeout, Handler&& handler) {
+        using operation = internal_::write_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, std::forward<Handler>(handler)),
+              internal_::io_direction::write, timeout);
+    }
+
+    template<typename Handler>
+    void io_context::async_receive_from(udp::socket& socket, memory_view<uint8_t> buffer, Handler&& handler) {
+        using operation = internal_::receive_from_operation<std::decay_t<Handler>>;
+        start(socket.implementation(), new (frames_) operation(socket, buffer, std::forward<Handler>(handler)),
+              internal_::io_direction::read);
+    }
+
+    template<typename Handler>
+    void io_context::async_send_to(udp::socket& socket, memory_view<const uint8_t> buffer,
+                                   const endpoint& destination, Handler&& handler) {
+        using operation = internal_::send_to_operation<std::decay_t<Handler>>;
+        start(socket.implementation(),
+              new (frames_) operation(socket, buffer, destination, std::forward<Handler>(handler)),
+              internal_::io_direction::write);
+    }
+} // namespace libwire
@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <iterator>
 #include <stdexcept>
+#include <type_traits>
 
 /**
  * Defines memory_view wrapper.
@@ -75,6 +76,12 @@ namespace libwire {
         memory_view() noexcept = default;
         memory_view(T* memory, size_t size_bytes) noexcept;
 
+        /**
+         * Allow implicit conversion from mutable view to read-only view.
+         */
+        template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+        memory_view(const memory_view<U>& other) noexcept;
+
 #ifdef __cpp_exceptions
         const_reference at(size_t) const;
 #endif
@@ -161,6 +168,12 @@ namespace libwire {
         : data_(memory), size_(size_bytes), capacity_(size_bytes) {
     }
 
+    template<typename T>
+    template<typename U, typename>
+    memory_view<T>::memory_view(const memory_view<U>& other) noexcept
+        : data_(other.data()), size_(other.size()), capacity_(other.capacity()) {
+    }
+
 #ifdef __cpp_exceptions
     template<typename T>
     const T& memory_view<T>::at(size_t i) const {
@@ -304,6 +317,25 @@ namespace libwire {
         std::swap(this->capacity_, other.capacity_);
     }
 
+    /**
+     * Create view of contiguous container with byte elements (std::string,
+     * std::vector<uint8_t>, etc).
+     *
+     * View is read-only (memory_view<const uint8_t>) if container
+     * is const.
+     *
+     * \warning View doesn't extends lifetime of container.
+     */
+    template<typename Container>
+    auto make_view(Container&& container) noexcept {
+        using element_type = std::remove_pointer_t<decltype(container.data())>;
+        static_assert(sizeof(element_type) == sizeof(uint8_t), "make_view can't be used with non-byte elements");
+
+        using byte_type = std::conditional_t<std::is_const_v<element_type>, const uint8_t, uint8_t>;
+        return memory_view<byte_type>(reinterpret_cast<byte_type*>(container.data()), container.size());
+    }
+
     extern template class memory_view<uint8_t>;
+    extern template class memory_view<const uint8_t>;
     extern template class memory_view<int8_t>;
 } // namespace libwire
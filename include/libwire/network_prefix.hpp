@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <libwire/address.hpp>
+
+/**
+ * \file network_prefix.hpp
+ *
+ * This file defines CIDR network prefix (address with prefix length).
+ */
+
+namespace libwire {
+    /**
+     * IPv4 or IPv6 network prefix in CIDR notation, e.g. 10.0.0.0/8 or
+     * 2001:db8::/32.
+     *
+     * Bits of base address past prefix length are always zero, they are
+     * cleared on construction, so 10.1.2.3/8 is stored as 10.0.0.0/8.
+     *
+     * See \ref prefix_table for matching addresses against large sets
+     * of prefixes.
+     */
+    struct network_prefix {
+        /**
+         * Construct prefix from base address and length in bits. Length
+         * is clamped to address size (32 for IPv4, 128 for IPv6).
+         */
+        constexpr network_prefix(const address& base, uint8_t length) noexcept
+            : base(base), length(length > max_length(base.version) ? max_length(base.version) : length) {
+            for (size_t i = 0; i < this->base.parts.size(); ++i) this->base.parts[i] &= byte_mask(this->length, i);
+        }
+
+        /**
+         * Parse prefix in "address/length" form.
+         *
+         * Throws std::invalid_argument if supplied string is not a
+         * valid prefix.
+         */
+        explicit network_prefix(std::string_view text);
+
+        /**
+         * Parse prefix in "address/length" form.
+         *
+         * Sets success to true if supplied prefix is valid, false
+         * otherwise. Value of prefix is undefined if success is false.
+         */
+        network_prefix(std::string_view text, bool& success) noexcept;
+
+        /**
+         * Check whether address belongs to this network. Addresses of
+         * other IP version never do.
+         */
+        constexpr bool contains(const address& addr) const noexcept {
+            if (addr.version != base.version) return false;
+            for (size_t i = 0; i < base.parts.size(); ++i) {
+                if ((addr.parts[i] & byte_mask(length, i)) != base.parts[i]) return false;
+            }
+            return true;
+        }
+
+        /**
+         * Maximum length of text written by to_chars().
+         */
+        static constexpr size_t max_text_size = address::max_text_size + 4;
+
+        std::string to_string() const;
+
+        /**
+         * Write same text as to_string() gives into [first, last) without
+         * allocating, see address::to_chars().
+         */
+        std::to_chars_result to_chars(char* first, char* last) const noexcept;
+
+        constexpr bool operator==(const network_prefix& o) const noexcept {
+            return length == o.length && base == o.base;
+        }
+
+        constexpr bool operator!=(const network_prefix& o) const noexcept {
+            return !(*this == o);
+        }
+
+        static constexpr uint8_t max_length(ip version) noexcept {
+            return version == ip::v4 ? 32 : 128;
+        }
+
+        address base;
+        uint8_t length;
+
+    private:
+        // Mask for byte at index of address with prefix of given length.
+        static constexpr uint8_t byte_mask(unsigned length, size_t index) noexcept {
+            if (length >= (index + 1) * 8) return 0xff;
+            if (length <= index * 8) return 0;
+            return uint8_t(0xff << (8 - (length - index * 8)));
+        }
+    };
+
+    inline namespace literals {
+        /**
+         * Network prefix, "10.0.0.0/8"_net or "2001:db8::/32"_net.
+         *
+         * See \ref literals for compile-time evaluation rules.
+         */
+        constexpr network_prefix operator""_net(const char* text, size_t size) {
+            address base{0, 0, 0, 0};
+            bool ipv6 = false;
+            uint8_t length = 0;
+            if (!internal_::parse_prefix(text, size, base.parts.data(), ipv6, length)) {
+                internal_::invalid_address_literal();
+            }
+            if (ipv6) base.version = ip::v6;
+            return {base, length};
+        }
+    } // namespace literals
+} // namespace libwire
@@ -79,7 +79,8 @@ namespace libwire {
     /**
      * Specify timeout for blocking read operations.
      *
-     * Doesn't affects asynchronous and non-blocking operations.
+     * Doesn't affects asynchronous and non-blocking operations, pass
+     * timeout to io_context::async_read instead.
      *
      * \warning Socket may be left in inconsistent state after timeout, it's
      * unsafe to use it and your only choice is close().
@@ -107,7 +108,8 @@ namespace libwire {
     /**
      * Specify timeout for blocking write operations.
      *
-     * Doesn't affects asynchronous and non-blocking operations.
+     * Doesn't affects asynchronous and non-blocking operations, pass
+     * timeout to io_context::async_write instead.
      *
      * \warning Socket may be left in inconsistent state after timeout, it's
      * unsafe to use it and your only choice is close().
@@ -149,4 +151,52 @@ namespace libwire {
     };
 
     constexpr receive_buffer_size_t receive_buffer_size{};
+
+    struct zero_copy_t {
+        template<typename Socket>
+        static void set(Socket& socket, bool enable) noexcept {
+            set_impl(socket.implementation(), enable);
+        }
+
+        template<typename Socket>
+        static bool get(const Socket& socket) noexcept {
+            return get_impl(socket.implementation());
+        }
+
+    private:
+        static bool get_impl(const internal_::socket&) noexcept;
+        static void set_impl(internal_::socket&, bool) noexcept;
+    };
+
+    /**
+     * Allow zero-copy writes (SO_ZEROCOPY), see \ref tcp::socket::write_zero_copy.
+     *
+     * Option stays disabled if it's not supported by OS, zero-copy writes
+     * are performed as usual writes in this case.
+     */
+    constexpr zero_copy_t zero_copy{};
+
+    struct ipv6_only_t {
+        template<typename Socket>
+        static void set(Socket& socket, bool enable) noexcept {
+            set_impl(socket.implementation(), enable);
+        }
+
+        template<typename Socket>
+        static bool get(const Socket& socket) noexcept {
+            return get_impl(socket.implementation());
+        }
+
+    private:
+        static bool get_impl(const internal_::socket&) noexcept;
+        static void set_impl(internal_::socket&, bool) noexcept;
+    };
+
+    /**
+     * Restrict IPv6 socket to IPv6 traffic only (IPV6_V6ONLY).
+     *
+     * Disabled for sockets created with \ref dual_stack tag. Must be
+     * changed before bind(), has no effect for IPv4 sockets.
+     */
+    constexpr ipv6_only_t ipv6_only{};
 } // namespace libwire
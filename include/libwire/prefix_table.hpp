@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <libwire/address.hpp>
+#include <libwire/network_prefix.hpp>
+
+/**
+ * \file prefix_table.hpp
+ *
+ * This file defines prefix_table type, longest-prefix-match table for
+ * IPv4 and IPv6 network prefixes, intended for filtering of peers by
+ * large allow/deny lists.
+ */
+
+namespace libwire {
+    /**
+     * Longest-prefix-match table mapping network prefixes to 32-bit
+     * values (e.g. allow/deny action or index into caller's array).
+     *
+     * Lookups use compressed multibit trie ("poptrie", Asai & Ohara,
+     * SIGCOMM 2015): top 16 bits of address index direct array, then
+     * every level consumes 6 bits using node with two 64-bit bitmaps,
+     * one marking child nodes and one marking starts of runs of equal
+     * leaves. Position in child and leaf arrays is found by population
+     * count, so nodes are 24 bytes and typical IPv4 lookup touches
+     * direct array and two or three nodes. Both IP versions are kept in
+     * separate tries of the same table.
+     *
+     * Table is updated by copy-on-write: every change builds new trie
+     * from sorted list of prefixes (cost is proportional to table size)
+     * and publishes it atomically, so use assign() to load whole list
+     * at once instead of inserting prefixes one by one.
+     *
+     * **Example**
+     * \code
+     * enum : uint32_t { allow, deny };
+     * prefix_table filter;
+     * filter.assign({{"10.0.0.0/8"_net, allow}, {"10.66.0.0/16"_net, deny}});
+     * filter.lookup("10.66.1.1"_ipv4); // deny
+     * filter.lookup("192.168.0.1"_ipv4); // prefix_table::no_match
+     * \endcode
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: safe. lookup() is lock-free and can run concurrently with
+     *   updates, it sees either old or new table. Updates are serialized
+     *   and wait for lookups that may still use old table before
+     *   freeing it.
+     */
+    class prefix_table {
+    public:
+        /**
+         * Value returned by lookup() if no prefix contains the address.
+         * Can't be stored in table.
+         */
+        static constexpr uint32_t no_match = UINT32_MAX;
+
+        /**
+         * Construct empty table.
+         */
+        prefix_table();
+
+        prefix_table(const prefix_table&) = delete;
+        prefix_table& operator=(const prefix_table&) = delete;
+
+        ~prefix_table();
+
+        /**
+         * Find value of longest prefix containing address, no_match if
+         * there is no such prefix.
+         */
+        uint32_t lookup(const address& addr) const noexcept;
+
+        /**
+         * Add prefix with value or replace value of existing prefix.
+         */
+        void insert(const network_prefix& prefix, uint32_t value);
+
+        /**
+         * Remove prefix, returns false if there was no such prefix.
+         */
+        bool erase(const network_prefix& prefix);
+
+        /**
+         * Replace contents of table. If list contains same prefix
+         * several times, last value is used.
+         */
+        void assign(const std::vector<std::pair<network_prefix, uint32_t>>& entries);
+
+        void clear();
+
+        /**
+         * Count of prefixes in table.
+         */
+        size_t size() const noexcept;
+
+        /**
+         * Bytes used by lookup structures of current table.
+         */
+        size_t memory_usage() const noexcept;
+
+    private:
+        struct snapshot;
+
+        // Lookups count themselves in one of two groups (by parity of
+        // epoch_) so update can wait only for lookups which started
+        // before it switched epoch. Counters are sharded by thread to
+        // avoid contention.
+        static constexpr size_t reader_shards = 16;
+
+        struct alignas(64) reader_counter {
+            std::atomic<size_t> active{0};
+        };
+
+        class read_guard;
+
+        void publish(snapshot* next);
+
+        std::atomic<const snapshot*> current_;
+        std::atomic<unsigned> epoch_{0};
+        mutable reader_counter readers_[2][reader_shards];
+        std::mutex update_mutex_;
+    };
+} // namespace libwire
@@ -29,4 +29,22 @@ namespace libwire {
     };
 
     enum class transport { tcp = 1 << 3, udp = 1 << 4 };
+
+    /**
+     * Tag type for \ref dual_stack.
+     */
+    struct dual_stack_t {
+        explicit dual_stack_t() = default;
+    };
+
+    /**
+     * Tag for creating IPv6 socket which also handles IPv4 traffic
+     * (IPV6_V6ONLY option is disabled), so one socket can serve both
+     * IP versions.
+     *
+     * IPv4 peers are reported as usual ip::v4 addresses, not as
+     * IPv4-mapped IPv6 ones (::ffff:a.b.c.d), and ip::v4 addresses can
+     * be used as destination.
+     */
+    inline constexpr dual_stack_t dual_stack{};
 } // namespace libwire
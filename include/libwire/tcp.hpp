@@ -25,6 +25,9 @@
  */
 namespace libwire::tcp {} // namespace libwire::tcp
 
+#include "tcp/buffered_stream.hpp"
+#include "tcp/connection_pool.hpp"
 #include "tcp/listener.hpp"
+#include "tcp/sharded_listener.hpp"
 #include "tcp/socket.hpp"
 #include "tcp/options.hpp"
@@ -0,0 +1,564 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <libwire/internal/search.hpp>
+#include <libwire/tcp/socket.hpp>
+
+/*
+ * If you had to open this file to find answer for your question - we are so
+ * sorry. Please open issue with your question so we can update documentation
+ * to answer it.
+ */
+
+/**
+ * \file tcp/buffered_stream.hpp
+ *
+ * This file defines tcp::buffered_stream type, read-ahead buffer on top of
+ * tcp::socket.
+ */
+
+namespace libwire::tcp {
+    /**
+     * TCP socket with read-ahead buffer.
+     *
+     * \ref socket::read_until can't read past delimiter so it have to
+     * receive stream one byte at time, one system call per byte.
+     * buffered_stream instead receives as much data as available (up to
+     * buffer size) in one call and serves \ref read, \ref read_until and
+     * \ref peek from internal buffer. Underlying socket is touched only when
+     * buffer is drained.
+     *
+     * Writes are passed to underlying socket as is.
+     *
+     * Quick usage example:
+     * \code
+     * tcp::buffered_stream stream{listener.accept()};
+     * auto line = stream.read_until<std::string>('\n');
+     * stream.write(line);
+     * \endcode
+     *
+     * \warning Don't read from \ref next_layer directly while there is
+     * buffered data, otherwise you will receive data out of order.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: unsafe
+     */
+    class buffered_stream {
+    public:
+        /**
+         * Default size of read-ahead buffer.
+         */
+        static constexpr size_t default_buffer_size = 8192;
+
+        /**
+         * Create stream without underlying connection.
+         *
+         * Use \ref next_layer to connect it.
+         */
+        explicit buffered_stream(size_t buffer_size = default_buffer_size);
+
+        /**
+         * Take ownership of connected socket and allocate buffer of
+         * buffer_size bytes.
+         */
+        explicit buffered_stream(socket&& sock, size_t buffer_size = default_buffer_size);
+
+        buffered_stream(const buffered_stream&) = delete;
+        buffered_stream(buffered_stream&&) noexcept = default;
+
+        buffered_stream& operator=(const buffered_stream&) = delete;
+        buffered_stream& operator=(buffered_stream&&) noexcept = default;
+
+        ~buffered_stream() = default;
+
+        /**
+         * Get underlying socket.
+         */
+        socket& next_layer() noexcept;
+        const socket& next_layer() const noexcept;
+
+        /**
+         * Size of read-ahead buffer, i.e. maximum amount of data
+         * that can be received by one system call.
+         */
+        size_t buffer_size() const noexcept;
+
+        /**
+         * Amount of bytes received but not consumed yet.
+         */
+        size_t available() const noexcept;
+
+        /**
+         * Receive more data into buffer, blocks if socket is in blocking mode
+         * and there is no data available.
+         *
+         * Returns amount of bytes received. 0 is returned if there is no free
+         * space left in buffer or if error occurred.
+         */
+        size_t fill(std::error_code& ec) noexcept;
+
+        /**
+         * Discard all buffered data.
+         */
+        void discard() noexcept;
+
+        /**
+         * Read bytes_count bytes from stream into buffer passed by reference.
+         * Buffer will be resized to actual count of bytes received.
+         *
+         * Semantics are same as \ref socket::read. Buffered data is consumed
+         * first, requests bigger than \ref buffer_size are passed directly
+         * to socket to avoid copying data twice.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read(size_t bytes_count, Buffer&, std::error_code&) noexcept;
+
+        /**
+         * Same as overload with Buffer argument but return newly allocated
+         * buffer every time.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read(size_t bytes_count, std::error_code&) noexcept;
+
+        /**
+         * Copy bytes_count bytes from stream into buffer passed by
+         * reference without consuming them, so next read will return same
+         * data.
+         *
+         * Blocks until requested amount of data is buffered, EOF is hit or
+         * (for non-blocking socket) no more data is available. bytes_count
+         * can't be bigger than \ref buffer_size, it's silently truncated.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& peek(size_t bytes_count, Buffer&, std::error_code&) noexcept;
+
+        /**
+         * Same as overload with Buffer argument but return newly allocated
+         * buffer every time.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer peek(size_t bytes_count, std::error_code&) noexcept;
+
+        /**
+         * Read from stream until given byte is found or max_size bytes read.
+         *
+         * Semantics are same as \ref socket::read_until except that bytes
+         * after delimiter are not lost and will be returned by next read.
+         * If max_size is reached then next byte is left in stream.
+         *
+         * Incomplete line is kept in stream, so if non-blocking socket
+         * reports error::try_again buf is empty and next call continues
+         * reading same line. Lines longer than \ref buffer_size make
+         * buffer grow until they are consumed.
+         *
+         * **Buffer Type Requirements**
+         *
+         * size(), clear() and insert(end(), first, last) functions with
+         * behavior defined in SequenceContainer concept.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_until(uint8_t delimiter, Buffer& buf, std::error_code&, size_t max_size = 0) noexcept;
+
+        /**
+         * Same as overload with buffer argument but returns newly
+         * allocated buffer every time.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read_until(uint8_t delimiter, std::error_code&, size_t max_size = 0) noexcept;
+
+        /**
+         * Read from stream until given sequence of bytes (e.g. "\r\n") is
+         * found or max_size bytes read.
+         *
+         * Same as overload with single-byte delimiter otherwise.
+         * Delimiter can't be empty or longer than \ref buffer_size.
+         *
+         * \note If EOF or error is hit before delimiter is found then
+         * all received data is appended to buffer, including partially
+         * received delimiter.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_until(std::string_view delimiter, Buffer& buf, std::error_code&, size_t max_size = 0) noexcept;
+
+        /**
+         * Same as overload with buffer argument but returns newly
+         * allocated buffer every time.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read_until(std::string_view delimiter, std::error_code&, size_t max_size = 0) noexcept;
+
+        /**
+         * Write contents of buffer to underlying socket.
+         *
+         * See \ref socket::write.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        size_t write(const Buffer&, std::error_code&) noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read(size_t bytes_count, Buffer&);
+
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read(size_t bytes_count);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& peek(size_t bytes_count, Buffer&);
+
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer peek(size_t bytes_count);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_until(uint8_t delimiter, Buffer& buf, size_t max_size = 0);
+
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read_until(uint8_t delimiter, size_t max_size = 0);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_until(std::string_view delimiter, Buffer& buf, size_t max_size = 0);
+
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer read_until(std::string_view delimiter, size_t max_size = 0);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        size_t write(const Buffer&);
+#endif // ifdef __cpp_exceptions
+
+    private:
+        /**
+         * Move up to max_bytes of buffered data to output.
+         */
+        size_t take(void* output, size_t max_bytes) noexcept;
+
+        /**
+         * Move count bytes of buffered data to the end of output.
+         */
+        template<typename Buffer>
+        void append_to(Buffer& output, size_t count);
+
+        template<typename Buffer>
+        Buffer& read_until_impl(const uint8_t* delimiter, size_t delimiter_size, Buffer& buf, std::error_code& ec,
+                                size_t max_size) noexcept;
+
+        socket next_layer_;
+        size_t buffer_size_;
+
+        // May be temporarily bigger than buffer_size_ while incomplete
+        // line longer than it is buffered.
+        std::vector<uint8_t> buffer_;
+
+        // Buffered data is stored in [begin_, end_) range of buffer_.
+        size_t begin_ = 0;
+        size_t end_ = 0;
+    };
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read(size_t bytes_count, Buffer& output, std::error_code& ec) noexcept {
+        static_assert(sizeof(std::remove_pointer_t<decltype(output.data())>) == sizeof(uint8_t),
+                      "buffered_stream::read can't be used with container with non-byte elements");
+
+        output.resize(bytes_count);
+        auto* out = reinterpret_cast<uint8_t*>(output.data());
+        size_t received = 0;
+        while (received < bytes_count) {
+            if (available() == 0) {
+                if (bytes_count - received >= buffer_.size()) {
+                    memory_view<uint8_t> tail{out + received, bytes_count - received};
+                    next_layer_.read(tail.size(), tail, ec);
+                    received += tail.size();
+                    break;
+                }
+                if (fill(ec) == 0) break;
+            }
+            received += take(out + received, bytes_count - received);
+        }
+
+        // Non-blocking read returns whatever is available.
+        if (received != 0 && ec == error::try_again) ec.clear();
+
+        output.resize(received);
+        return output;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read(size_t bytes_count, std::error_code& ec) noexcept {
+        Buffer buffer{};
+        return read(bytes_count, buffer, ec);
+    }
+
+    extern template std::vector<uint8_t> buffered_stream::read(size_t, std::error_code&);
+    extern template std::string buffered_stream::read(size_t, std::error_code&);
+
+    extern template std::vector<uint8_t>& buffered_stream::read(size_t, std::vector<uint8_t>&, std::error_code&);
+    extern template std::string& buffered_stream::read(size_t, std::string&, std::error_code&);
+
+    template<typename Buffer>
+    Buffer& buffered_stream::peek(size_t bytes_count, Buffer& output, std::error_code& ec) noexcept {
+        static_assert(sizeof(std::remove_pointer_t<decltype(output.data())>) == sizeof(uint8_t),
+                      "buffered_stream::peek can't be used with container with non-byte elements");
+
+        bytes_count = std::min(bytes_count, buffer_.size());
+        while (available() < bytes_count) {
+            if (fill(ec) == 0) break;
+        }
+
+        if (available() != 0 && ec == error::try_again) ec.clear();
+
+        size_t peeked = std::min(bytes_count, available());
+        output.resize(peeked);
+        std::memcpy(output.data(), buffer_.data() + begin_, peeked);
+        return output;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::peek(size_t bytes_count, std::error_code& ec) noexcept {
+        Buffer buffer{};
+        return peek(bytes_count, buffer, ec);
+    }
+
+    extern template std::vector<uint8_t> buffered_stream::peek(size_t, std::error_code&);
+    extern template std::string buffered_stream::peek(size_t, std::error_code&);
+
+    extern template std::vector<uint8_t>& buffered_stream::peek(size_t, std::vector<uint8_t>&, std::error_code&);
+    extern template std::string& buffered_stream::peek(size_t, std::string&, std::error_code&);
+
+    template<typename Buffer>
+    void buffered_stream::append_to(Buffer& output, size_t count) {
+        // Reinterpret cast is only way to safetly convert bytes between char and unsigned char representation.
+        auto* first = reinterpret_cast<const typename Buffer::value_type*>(buffer_.data() + begin_);
+        output.insert(output.end(), first, first + count);
+        begin_ += count;
+    }
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read_until_impl(const uint8_t* delimiter, size_t delimiter_size, Buffer& buf,
+                                             std::error_code& ec, size_t max_size) noexcept {
+        assert(delimiter_size != 0 && delimiter_size <= buffer_.size());
+
+        size_t limit = max_size == 0 ? SIZE_MAX : max_size;
+
+        // Bytes stay buffered until line is complete, so if non-blocking
+        // socket runs out of data next call continues from same place.
+        // Only [0, scanned) is known to contain no delimiter start.
+        size_t scanned = 0;
+        buf.clear();
+        while (true) {
+            const uint8_t* data = buffer_.data() + begin_;
+            size_t position =
+                scanned + internal_::search(data + scanned, available() - scanned, delimiter, delimiter_size);
+            if (position != available()) {
+                if (position > limit) {
+                    append_to(buf, limit);
+                    return buf;
+                }
+                append_to(buf, position);
+                begin_ += delimiter_size;
+                return buf;
+            }
+
+            // max_size bytes are buffered and delimiter doesn't follow them,
+            // like socket::read_until.
+            if (available() >= limit && available() - limit >= delimiter_size) {
+                append_to(buf, limit);
+                return buf;
+            }
+            scanned = available() >= delimiter_size ? available() - (delimiter_size - 1) : 0;
+
+            // Line is longer than buffer, grow it until line is consumed.
+            if (available() == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+
+            if (fill(ec) == 0) {
+                if (ec && ec != error::try_again) append_to(buf, std::min(available(), limit));
+                return buf;
+            }
+        }
+    }
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read_until(uint8_t delimiter, Buffer& buf, std::error_code& ec,
+                                        size_t max_size) noexcept {
+        return read_until_impl(&delimiter, 1, buf, ec, max_size);
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read_until(uint8_t delimiter, std::error_code& ec, size_t max_size) noexcept {
+        Buffer buffer{};
+        read_until(delimiter, buffer, ec, max_size);
+        return buffer;
+    }
+
+    extern template std::vector<uint8_t> buffered_stream::read_until(uint8_t, std::error_code&, size_t);
+    extern template std::string buffered_stream::read_until(uint8_t, std::error_code&, size_t);
+
+    extern template std::vector<uint8_t>& buffered_stream::read_until(uint8_t, std::vector<uint8_t>&,
+                                                                      std::error_code&, size_t);
+    extern template std::string& buffered_stream::read_until(uint8_t, std::string&, std::error_code&, size_t);
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read_until(std::string_view delimiter, Buffer& buf, std::error_code& ec,
+                                        size_t max_size) noexcept {
+        return read_until_impl(reinterpret_cast<const uint8_t*>(delimiter.data()), delimiter.size(), buf, ec,
+                               max_size);
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read_until(std::string_view delimiter, std::error_code& ec, size_t max_size) noexcept {
+        Buffer buffer{};
+        read_until(delimiter, buffer, ec, max_size);
+        return buffer;
+    }
+
+    extern template std::vector<uint8_t> buffered_stream::read_until(std::string_view, std::error_code&, size_t);
+    extern template std::string buffered_stream::read_until(std::string_view, std::error_code&, size_t);
+
+    extern template std::vector<uint8_t>& buffered_stream::read_until(std::string_view, std::vector<uint8_t>&,
+                                                                      std::error_code&, size_t);
+    extern template std::string& buffered_stream::read_until(std::string_view, std::string&, std::error_code&,
+                                                             size_t);
+
+    template<typename Buffer>
+    size_t buffered_stream::write(const Buffer& input, std::error_code& ec) noexcept {
+        return next_layer_.write(input, ec);
+    }
+
+#ifdef __cpp_exceptions
+    template<typename Buffer>
+    Buffer& buffered_stream::read(size_t bytes_count, Buffer& output) {
+        std::error_code ec;
+        read<Buffer>(bytes_count, output, ec);
+        if (ec) throw std::system_error(ec);
+        return output;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read(size_t bytes_count) {
+        Buffer buffer{};
+        return read(bytes_count, buffer);
+    }
+
+    extern template std::vector<uint8_t>& buffered_stream::read(size_t, std::vector<uint8_t>&);
+    extern template std::string& buffered_stream::read(size_t, std::string&);
+
+    extern template std::vector<uint8_t> buffered_stream::read(size_t);
+    extern template std::string buffered_stream::read(size_t);
+
+    template<typename Buffer>
+    Buffer& buffered_stream::peek(size_t bytes_count, Buffer& output) {
+        std::error_code ec;
+        peek<Buffer>(bytes_count, output, ec);
+        if (ec) throw std::system_error(ec);
+        return output;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::peek(size_t bytes_count) {
+        Buffer buffer{};
+        return peek(bytes_count, buffer);
+    }
+
+    extern template std::vector<uint8_t>& buffered_stream::peek(size_t, std::vector<uint8_t>&);
+    extern template std::string& buffered_stream::peek(size_t, std::string&);
+
+    extern template std::vector<uint8_t> buffered_stream::peek(size_t);
+    extern template std::string buffered_stream::peek(size_t);
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read_until(uint8_t delimiter, Buffer& buf, size_t max_size) {
+        std::error_code ec;
+        read_until<Buffer>(delimiter, buf, ec, max_size);
+        if (ec) throw std::system_error(ec);
+        return buf;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read_until(uint8_t delimiter, size_t max_size) {
+        std::error_code ec;
+        auto res = read_until<Buffer>(delimiter, ec, max_size);
+        if (ec) throw std::system_error(ec);
+        return res;
+    }
+
+    extern template std::vector<uint8_t>& buffered_stream::read_until(uint8_t, std::vector<uint8_t>&, size_t);
+    extern template std::string& buffered_stream::read_until(uint8_t, std::string&, size_t);
+
+    extern template std::vector<uint8_t> buffered_stream::read_until(uint8_t, size_t);
+    extern template std::string buffered_stream::read_until(uint8_t, size_t);
+
+    template<typename Buffer>
+    Buffer& buffered_stream::read_until(std::string_view delimiter, Buffer& buf, size_t max_size) {
+        std::error_code ec;
+        read_until<Buffer>(delimiter, buf, ec, max_size);
+        if (ec) throw std::system_error(ec);
+        return buf;
+    }
+
+    template<typename Buffer>
+    Buffer buffered_stream::read_until(std::string_view delimiter, size_t max_size) {
+        std::error_code ec;
+        auto res = read_until<Buffer>(delimiter, ec, max_size);
+        if (ec) throw std::system_error(ec);
+        return res;
+    }
+
+    extern template std::vector<uint8_t>& buffered_stream::read_until(std::string_view, std::vector<uint8_t>&,
+                                                                      size_t);
+    extern template std::string& buffered_stream::read_until(std::string_view, std::string&, size_t);
+
+    extern template std::vector<uint8_t> buffered_stream::read_until(std::string_view, size_t);
+    extern template std::string buffered_stream::read_until(std::string_view, size_t);
+
+    template<typename Buffer>
+    size_t buffered_stream::write(const Buffer& input) {
+        return next_layer_.write(input);
+    }
+#endif // ifdef __cpp_exceptions
+} // namespace libwire::tcp
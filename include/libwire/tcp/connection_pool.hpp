@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <libwire/address.hpp>
+#include <libwire/tcp/socket.hpp>
+
+/**
+ * \file tcp/connection_pool.hpp
+ *
+ * This file defines tcp::connection_pool type, cache of established
+ * outgoing connections.
+ */
+
+namespace libwire::tcp {
+    /**
+     * Cache of established outgoing connections keyed by remote
+     * endpoint, saves TCP handshake (and slow start) for each request.
+     *
+     * Connection is taken from pool using \ref checkout and returned
+     * back when \ref connection handle is destroyed. If there is no idle
+     * connection to endpoint, new one is opened.
+     *
+     * Idle connection is checked before checkout: it's dropped if it
+     * stayed idle longer than idle_timeout or if peer closed it (or sent
+     * unexpected data) meanwhile, this costs one non-blocking
+     * recv(MSG_PEEK) call.
+     *
+     * Endpoints are spread across independently locked shards, and idle
+     * connections of each endpoint are kept in several stripes selected
+     * by calling thread, so threads rarely contend even when all of them
+     * talk to the same backend.
+     *
+     * Quick usage example:
+     * \code
+     * tcp::connection_pool pool;
+     * {
+     *     auto connection = pool.checkout(backend_address, 8080);
+     *     connection->write(request);
+     *     auto response = connection->read(response_size);
+     * } // Connection returned to pool here.
+     * \endcode
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: safe
+     */
+    class connection_pool {
+    public:
+        struct limits {
+            /// Maximum count of idle connections kept per endpoint,
+            /// connections returned above this limit are closed.
+            size_t max_idle = 16;
+
+            /// Maximum count of open connections (idle and checked out)
+            /// per endpoint, 0 means no limit.
+            size_t max_total = 0;
+
+            /// Connections idle for longer are closed instead of reuse.
+            std::chrono::milliseconds idle_timeout = std::chrono::seconds(60);
+
+            /// Check that peer didn't close idle connection before checkout.
+            bool check_health = true;
+        };
+
+        class connection;
+
+        connection_pool();
+
+        explicit connection_pool(limits pool_limits);
+
+        connection_pool(const connection_pool&) = delete;
+        connection_pool& operator=(const connection_pool&) = delete;
+
+        /**
+         * Close all idle connections. Pool must not be destroyed while
+         * there are checked out connections.
+         */
+        ~connection_pool();
+
+        /**
+         * Take idle connection to endpoint or open new one.
+         *
+         * Fails with error::try_again if max_total connections to endpoint
+         * are already open and none of them is idle, other errors are
+         * same as for \ref socket::connect.
+         */
+        connection checkout(address target, uint16_t port, std::error_code& ec);
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        connection checkout(address target, uint16_t port);
+#endif
+
+        /**
+         * Open up to count connections to endpoint ahead of time and keep
+         * them idle, limits are respected. Returns count of connections
+         * added, stops at first error.
+         */
+        size_t prewarm(address target, uint16_t port, size_t count, std::error_code& ec);
+
+        /**
+         * Close connections idle for longer than idle_timeout, returns
+         * count of closed connections.
+         *
+         * Expired connections are never returned by \ref checkout, but
+         * they still hold descriptors until this function is called
+         * (e.g. periodically using io_context::schedule) or they are
+         * found by checkout.
+         */
+        size_t reap_idle();
+
+        /**
+         * Count of idle connections to endpoint.
+         */
+        size_t idle_count(address target, uint16_t port) const;
+
+        /**
+         * Count of open connections (idle and checked out) to endpoint.
+         */
+        size_t open_count(address target, uint16_t port) const;
+
+        const limits& pool_limits() const noexcept {
+            return limits_;
+        }
+
+    private:
+        struct endpoint_state;
+        struct shard;
+
+        endpoint_state* find(address target, uint16_t port) const;
+        endpoint_state& find_or_create(address target, uint16_t port);
+        bool take_idle(endpoint_state& endpoint, socket& result);
+        bool reserve(endpoint_state& endpoint) noexcept;
+        void give_back(endpoint_state& endpoint, socket&& socket, bool reusable) noexcept;
+
+        limits limits_;
+        std::unique_ptr<shard[]> shards_;
+    };
+
+    /**
+     * Connection checked out from pool, returns it to pool when destroyed.
+     *
+     * Connection should be discarded if protocol state is unknown after
+     * error (e.g. response was not read completely), otherwise next user
+     * will get garbage.
+     */
+    class connection_pool::connection {
+    public:
+        connection() noexcept = default;
+
+        connection(const connection&) = delete;
+        connection& operator=(const connection&) = delete;
+
+        connection(connection&& other) noexcept;
+        connection& operator=(connection&& other) noexcept;
+
+        ~connection() {
+            release();
+        }
+
+        /**
+         * Check whether handle holds connection.
+         */
+        explicit operator bool() const noexcept {
+            return endpoint_ != nullptr;
+        }
+
+        tcp::socket& socket() noexcept {
+            return socket_;
+        }
+
+        tcp::socket* operator->() noexcept {
+            return &socket_;
+        }
+
+        /**
+         * Return connection to pool now, handle becomes empty. Closed
+         * sockets are not kept in pool.
+         */
+        void release() noexcept;
+
+        /**
+         * Close connection instead of returning it to pool, handle
+         * becomes empty.
+         */
+        void discard() noexcept;
+
+    private:
+        friend class connection_pool;
+
+        connection(connection_pool& pool, endpoint_state& endpoint, tcp::socket&& socket) noexcept
+            : pool_(&pool), endpoint_(&endpoint), socket_(std::move(socket)) {
+        }
+
+        connection_pool* pool_ = nullptr;
+        endpoint_state* endpoint_ = nullptr;
+        tcp::socket socket_;
+    };
+} // namespace libwire::tcp
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <vector>
 #include <libwire/tcp/socket.hpp>
 
 /*
@@ -74,11 +75,24 @@ namespace libwire::tcp {
             listen(local_endpoint, port, ec, backlog);
         }
 
+        /**
+         * Construct dual-stack listener and start accepting connections.
+         * See \ref listen documentation for arguments description.
+         */
+        inline listener(dual_stack_t, uint16_t port, std::error_code& ec,
+                        unsigned backlog = internal_::socket::max_pending_connections) noexcept {
+            listen(dual_stack, port, ec, backlog);
+        }
+
 #ifdef __cpp_exceptions
         inline listener(address local_endpoint, uint16_t port,
                         unsigned backlog = internal_::socket::max_pending_connections) {
             listen(local_endpoint, port, backlog);
         }
+
+        inline listener(dual_stack_t, uint16_t port, unsigned backlog = internal_::socket::max_pending_connections) {
+            listen(dual_stack, port, backlog);
+        }
 #endif
 
         internal_::socket::native_handle_t native_handle() const noexcept;
@@ -125,21 +139,112 @@ namespace libwire::tcp {
         void listen(address local_address, uint16_t port, std::error_code& ec,
                     unsigned max_backlog = internal_::socket::max_pending_connections) noexcept;
 
+        /**
+         * Start listening for incoming IPv4 and IPv6 connections on
+         * specified port of all interfaces using single IPv6 socket,
+         * see \ref libwire::dual_stack.
+         *
+         * Peer endpoints of IPv4 connections are reported as ip::v4
+         * addresses.
+         */
+        void listen(dual_stack_t, uint16_t port, std::error_code& ec,
+                    unsigned max_backlog = internal_::socket::max_pending_connections) noexcept;
+
+        /**
+         * Predicate called with peer endpoint of every incoming
+         * connection, returns true if connection should be accepted.
+         */
+        using peer_filter = internal_::socket::peer_filter;
+
+        /**
+         * Set predicate deciding whether to accept connection from peer.
+         *
+         * Filter is called with peer endpoint reported by the same system
+         * call that took connection from queue, before socket object is
+         * created for it. Rejected connections are closed immediately and
+         * never returned, accept() continues with next connection in
+         * queue. Applies to accept(), accept_many() and async accept
+         * operations of io_context (with io_uring multishot accept peer
+         * address is not reported, so it's asked with one extra system
+         * call).
+         *
+         * Filter is called from thread that accepts connection and must
+         * not throw. Empty function removes filter.
+         *
+         * **Example**
+         * \code
+         * prefix_table deny_list;
+         * listener.set_peer_filter([&](const endpoint& peer) {
+         *     return deny_list.lookup(peer.address()) == prefix_table::no_match;
+         * });
+         * \endcode
+         */
+        void set_peer_filter(peer_filter filter);
+
+        /**
+         * Filter set by set_peer_filter(), nullptr if there is none.
+         */
+        const peer_filter* filter() const noexcept;
+
         /**
          * Accept first connection from listener queue and create
          * socket for it.
          *
+         * Peer address is obtained by the same system call and
+         * cached in returned socket, so socket::remote_endpoint()
+         * doesn't need to ask the kernel for it again.
+         *
+         * If non_blocking is true returned socket is already in
+         * non-blocking mode (see libwire::non_blocking), on Linux
+         * flag is set atomically by accept4().
+         *
          * Any errors occurred (open sockets limit hit, for example)
          * will be reported through ec argument.
          */
-        socket accept(std::error_code& ec) noexcept;
+        socket accept(std::error_code& ec, bool non_blocking = false) noexcept;
+
+        /**
+         * Accept up to max connections which are already in listener
+         * queue and append sockets for them to output, return count of
+         * accepted connections.
+         *
+         * Allows to take whole burst of connections with one wakeup.
+         * Waits only for the first connection (unless listener is in
+         * non-blocking mode, then try_again is reported), rest of queue
+         * is drained until it's empty or max is reached. Peer endpoints
+         * are cached in accepted sockets just like with accept().
+         *
+         * Listener is switched to non-blocking mode internally, this is
+         * not visible to user: accept() still waits for connection.
+         *
+         * Error is reported through ec only if no connection was accepted,
+         * otherwise it will be reported by next call.
+         *
+         * **Example**
+         * \code
+         * std::vector<tcp::socket> batch;
+         * for (;;) {
+         *     batch.clear();
+         *     listener.accept_many(64, batch, ec);
+         *     for (auto& socket : batch) workers.dispatch(std::move(socket));
+         * }
+         * \endcode
+         */
+        size_t accept_many(size_t max, std::vector<socket>& output, std::error_code& ec,
+                           bool non_blocking = false) noexcept;
 
 #ifdef __cpp_exceptions
         /**
          * Same as overload with error code but throws std::system_error
          * instead of setting error code argument.
          */
-        socket accept();
+        socket accept(bool non_blocking = false);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t accept_many(size_t max, std::vector<socket>& output, bool non_blocking = false);
 
         /**
          * Same as overload with error code but throws std::system_error
@@ -147,10 +252,17 @@ namespace libwire::tcp {
          */
         void listen(address local_address, uint16_t port,
                     unsigned max_backlog = internal_::socket::max_pending_connections);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void listen(dual_stack_t, uint16_t port, unsigned max_backlog = internal_::socket::max_pending_connections);
 #endif // ifdef __cpp_exceptions
 
     private:
         internal_::socket implementation_;
+        peer_filter filter_;
     };
 
     template<typename Option>
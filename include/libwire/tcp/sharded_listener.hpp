@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <libwire/tcp/listener.hpp>
+
+/**
+ * \file tcp/sharded_listener.hpp
+ *
+ * This file defines tcp::sharded_listener type, set of listeners sharing
+ * one endpoint using SO_REUSEPORT.
+ */
+
+namespace libwire::tcp {
+    /**
+     * Several listening sockets bound to the same endpoint using
+     * SO_REUSEPORT, each with own accept queue.
+     *
+     * Kernel distributes incoming connections between shards (by hash
+     * of connection endpoints, or by CPU after \ref steer_by_cpu), so
+     * threads accepting from different shards never contend on single
+     * queue. Usually each worker thread owns one shard:
+     * \code
+     * tcp::sharded_listener listener{ipv4::any, 7777, workers_count};
+     * listener.steer_by_cpu();
+     * for (size_t i = 0; i < workers_count; ++i) {
+     *     workers.emplace_back([&listener, i] {
+     *         listener.pin_current_thread(i);
+     *         for (;;) handle(listener.shard(i).accept());
+     *     });
+     * }
+     * \endcode
+     *
+     * Connections already queued in shard are reset when it's closed, so
+     * all shards should be accepted from until listener is destroyed.
+     *
+     * Supported only on Linux 3.9+, CPU steering needs Linux 4.5+.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: unsafe, but different shards can be used concurrently.
+     */
+    class sharded_listener {
+    public:
+        sharded_listener() noexcept = default;
+
+        sharded_listener(const sharded_listener&) = delete;
+        sharded_listener(sharded_listener&&) noexcept = default;
+
+        sharded_listener& operator=(const sharded_listener&) = delete;
+        sharded_listener& operator=(sharded_listener&&) noexcept = default;
+
+        /**
+         * Construct listener and start accepting connections.
+         * See \ref listen documentation for arguments description.
+         */
+        sharded_listener(address local_address, uint16_t port, size_t shards_count, std::error_code& ec,
+                         unsigned backlog = internal_::socket::max_pending_connections) noexcept {
+            listen(local_address, port, shards_count, ec, backlog);
+        }
+
+#ifdef __cpp_exceptions
+        sharded_listener(address local_address, uint16_t port, size_t shards_count,
+                         unsigned backlog = internal_::socket::max_pending_connections) {
+            listen(local_address, port, shards_count, backlog);
+        }
+#endif
+
+        /**
+         * Open shards_count sockets with SO_REUSEPORT, bind them to
+         * specified endpoint and start listening. If port is 0, port
+         * picked for first shard is used for all of them. backlog is size
+         * of each shard's queue.
+         *
+         * Previously opened shards are closed first. On error no shards
+         * are left open.
+         */
+        void listen(address local_address, uint16_t port, size_t shards_count, std::error_code& ec,
+                    unsigned backlog = internal_::socket::max_pending_connections) noexcept;
+
+        /**
+         * Attach classic BPF program which sends connection to shard
+         * number (CPU % shards count), where CPU is the one which handled
+         * incoming SYN (usually same as CPU receiving NIC interrupt, see
+         * SO_INCOMING_CPU). Shard i gets connections from CPUs i,
+         * i + shards count and so on.
+         *
+         * Together with \ref pin_current_thread it keeps connection
+         * processing on one CPU, so socket data stays in its cache.
+         */
+        void steer_by_cpu(std::error_code& ec) noexcept;
+
+        /**
+         * Restrict calling thread to CPUs whose connections are steered
+         * to specified shard by \ref steer_by_cpu.
+         */
+        void pin_current_thread(size_t shard_index, std::error_code& ec) const noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void listen(address local_address, uint16_t port, size_t shards_count,
+                    unsigned backlog = internal_::socket::max_pending_connections);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void steer_by_cpu();
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void pin_current_thread(size_t shard_index) const;
+#endif // ifdef __cpp_exceptions
+
+        /**
+         * Count of shards, 0 if listener is not open.
+         */
+        size_t size() const noexcept {
+            return shards_.size();
+        }
+
+        listener& shard(size_t index) noexcept {
+            return shards_[index];
+        }
+
+        const listener& shard(size_t index) const noexcept {
+            return shards_[index];
+        }
+
+        /**
+         * Port all shards are bound to.
+         */
+        uint16_t port() const noexcept;
+
+    private:
+        std::vector<listener> shards_;
+    };
+} // namespace libwire::tcp
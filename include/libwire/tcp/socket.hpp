@@ -26,6 +26,9 @@
 #include <tuple>
 #include <system_error>
 #include <vector>
+#include <initializer_list>
+#include <optional>
+#include <libwire/byte_buffer.hpp>
 #include <libwire/error.hpp>
 #include <libwire/internal/socket.hpp>
 
@@ -41,6 +44,10 @@
  * This file defines tcp::socket type, base class for outgoing TCP connections.
  */
 
+namespace libwire::internal_ {
+    struct io_access;
+}
+
 namespace libwire::tcp {
     /**
      * Descriptor wrapper for TCP socket.
@@ -230,6 +237,8 @@ namespace libwire::tcp {
          * Get address and port of remote end of connection.
          *
          * Usually same as address/port passed in \ref connect.
+         * Endpoint known from connect() or listener::accept() is
+         * returned without system call.
          *
          * If socket is not connected - {{0, 0, 0, 0}, 0} will be returned.
          */
@@ -245,6 +254,8 @@ namespace libwire::tcp {
          */
         void connect(address, uint16_t port, std::error_code& ec) noexcept;
 
+        void connect(const endpoint& target, std::error_code& ec) noexcept;
+
         /**
          * Shutdown reading/writing part of full-duplex connection
          * (or both if read and write is true).
@@ -298,6 +309,10 @@ namespace libwire::tcp {
          * Buffer must be container that encapsulates dynamic array,
          * so it must have data, size and resize member functions with
          * behavior as in std::vector.
+         *
+         * Buffer is resized to bytes_count before reading, use
+         * libwire::byte_buffer or memory_view to avoid zero-filling
+         * it every time.
          */
         template<typename Buffer = std::vector<uint8_t>>
         Buffer& read(size_t bytes_count, Buffer&, std::error_code&) noexcept;
@@ -309,6 +324,20 @@ namespace libwire::tcp {
         template<typename Buffer = std::vector<uint8_t>>
         Buffer read(size_t bytes_count, std::error_code&) noexcept;
 
+        /**
+         * Read at most max_bytes bytes from socket into buffer passed by
+         * reference. Buffer will be resized to actual count of bytes
+         * received.
+         *
+         * Unlike \ref read this function returns as soon as any data is
+         * available, even for blocking socket. Thus short read doesn't
+         * means EOF, EOF is reported using error code.
+         *
+         * Buffer type requirements are same as for \ref read.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_some(size_t max_bytes, Buffer&, std::error_code&) noexcept;
+
         /**
          * Read from socket until until gives byte is found or max_size
          * bytes read.
@@ -318,6 +347,10 @@ namespace libwire::tcp {
          *
          * \note max_size = 0 is a special case and means "no limit".
          *
+         * \note This function performs one system call per byte because it
+         * can't read past delimiter. Use \ref buffered_stream if you read
+         * a lot of delimited data.
+         *
          * **Buffer Type Requirements**
          *
          * size(), clear() and push_back() functions with behavior defined in
@@ -350,6 +383,108 @@ namespace libwire::tcp {
         template<typename Buffer = std::vector<uint8_t>>
         size_t write(const Buffer&, std::error_code&) noexcept;
 
+        /**
+         * Write contents of several buffers to socket as one
+         * contiguous stream (gather write).
+         *
+         * Useful to send header and body without copying them into one
+         * buffer or paying for two system calls:
+         * \code
+         * socket.write({make_view(header), make_view(body)}, ec);
+         * \endcode
+         *
+         * Returns actual amount of bytes written, same as total size of all
+         * buffers unless error occurred or socket is in non-blocking mode.
+         * Non-blocking write can stop in the middle of any buffer.
+         */
+        size_t write(std::initializer_list<memory_view<const uint8_t>> buffers, std::error_code&) noexcept;
+
+        /**
+         * Same as overload with initializer_list but accepts vector of
+         * buffers.
+         */
+        size_t write(const std::vector<memory_view<const uint8_t>>& buffers, std::error_code&) noexcept;
+
+        /**
+         * Read data from socket into several buffers (scatter read).
+         *
+         * Buffers are filled in order and not resized, semantics are same
+         * as for \ref read of total size of all buffers. Returns actual
+         * amount of bytes read.
+         */
+        size_t read(std::initializer_list<memory_view<uint8_t>> buffers, std::error_code&) noexcept;
+
+        /**
+         * Same as overload with initializer_list but accepts vector of
+         * buffers.
+         */
+        size_t read(const std::vector<memory_view<uint8_t>>& buffers, std::error_code&) noexcept;
+
+        /**
+         * Write contents of buffer to socket without copying it into
+         * kernel buffer, pages are pinned and sent directly by network
+         * device (MSG_ZEROCOPY).
+         *
+         * Requires \ref zero_copy option to be enabled. Useful only for large
+         * buffers, writes smaller than \ref zero_copy_threshold are always
+         * copied.
+         *
+         * If id is set after the call, buffer is still used by kernel and
+         * **must not be modified or freed** until completion covering id
+         * is received using \ref poll_zero_copy_completions. Otherwise data
+         * was copied as in \ref write (zero-copy is unavailable, buffer is
+         * small or kernel reported that it copies data anyway, as it does
+         * for loopback connections) and buffer can be reused immediately.
+         *
+         * Returns actual amount of bytes written, same as \ref write.
+         */
+        size_t write_zero_copy(memory_view<const uint8_t> buffer, std::optional<uint32_t>& id,
+                               std::error_code&) noexcept;
+
+        /**
+         * Call handler with const zero_copy_completion& argument for every
+         * pending notification about zero-copy write completion.
+         *
+         * Never blocks. Socket is reported by poll() & co. with error
+         * condition (POLLERR) when notifications are available, so this
+         * function can be called when such event is received.
+         *
+         * Returns count of notifications handled.
+         */
+        template<typename Handler>
+        size_t poll_zero_copy_completions(Handler&& handler, std::error_code&) noexcept;
+
+#ifndef _WIN32
+        /**
+         * Send length bytes from file (referred by file descriptor) starting
+         * at offset. Data is passed to socket directly by the kernel
+         * (sendfile), without copying it to and from user-space buffer.
+         *
+         * Returns actual amount of bytes sent. It's less than length if
+         * file ends earlier or socket is in non-blocking mode and send buffer
+         * is full. In latter case transfer can be resumed by calling
+         * send_file again with offset advanced by returned value.
+         *
+         * File offset is not changed, so same file can be sent to several
+         * sockets concurrently.
+         */
+        size_t send_file(int file_descriptor, uint64_t offset, size_t length, std::error_code&) noexcept;
+
+        /**
+         * Receive length bytes from socket and write them to file (referred
+         * by file descriptor) starting at offset, without copying data to
+         * user-space buffer (splice through pipe).
+         *
+         * Returns actual amount of bytes written to file. In non-blocking mode
+         * it's likely that less bytes will be received, transfer can be resumed
+         * by calling receive_to_file again with offset advanced by returned value.
+         * Blocking call returns less bytes only if EOF hit or error occurred.
+         *
+         * \warning If write to file fails, data already taken from socket is lost.
+         */
+        size_t receive_to_file(int file_descriptor, uint64_t offset, size_t length, std::error_code&) noexcept;
+#endif
+
 #ifdef __cpp_exceptions
         /**
          * Same as overload with error code but throws std::system_error
@@ -357,6 +492,12 @@ namespace libwire::tcp {
          */
         void connect(address, uint16_t port);
 
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void connect(const endpoint& target);
+
         /**
          * Same as overload with error code but throws std::system_error
          * instead of setting error code argument.
@@ -367,6 +508,13 @@ namespace libwire::tcp {
         template<typename Buffer = std::vector<uint8_t>>
         Buffer read(size_t bytes_count);
 
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Buffer = std::vector<uint8_t>>
+        Buffer& read_some(size_t max_bytes, Buffer&);
+
         /**
          * Same as overload with error code but throws std::system_error
          * instead of setting error code argument.
@@ -374,6 +522,49 @@ namespace libwire::tcp {
         template<typename Buffer = std::vector<uint8_t>>
         size_t write(const Buffer&);
 
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t write(std::initializer_list<memory_view<const uint8_t>> buffers);
+
+        size_t write(const std::vector<memory_view<const uint8_t>>& buffers);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t read(std::initializer_list<memory_view<uint8_t>> buffers);
+
+        size_t read(const std::vector<memory_view<uint8_t>>& buffers);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t write_zero_copy(memory_view<const uint8_t> buffer, std::optional<uint32_t>& id);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        template<typename Handler>
+        size_t poll_zero_copy_completions(Handler&& handler);
+
+#    ifndef _WIN32
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t send_file(int file_descriptor, uint64_t offset, size_t length);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        size_t receive_to_file(int file_descriptor, uint64_t offset, size_t length);
+#    endif
+
         /**
          * Same as overload with error code but throws std::system_error
          * instead of setting error code argument.
@@ -391,6 +582,8 @@ namespace libwire::tcp {
 
         ///@}
     private:
+        friend struct internal_::io_access;
+
         internal_::socket implementation_;
 
         // Used as internal socket state tracker.
@@ -418,9 +611,41 @@ namespace libwire::tcp {
 
     extern template std::vector<uint8_t> socket::read(size_t, std::error_code&);
     extern template std::string socket::read(size_t, std::error_code&);
+    extern template byte_buffer socket::read(size_t, std::error_code&);
 
     extern template std::vector<uint8_t>& socket::read(size_t, std::vector<uint8_t>&, std::error_code&);
     extern template std::string& socket::read(size_t, std::string&, std::error_code&);
+    extern template byte_buffer& socket::read(size_t, byte_buffer&, std::error_code&);
+
+    template<typename Buffer>
+    Buffer& socket::read_some(size_t max_bytes, Buffer& output, std::error_code& ec) noexcept {
+        static_assert(sizeof(std::remove_pointer_t<decltype(output.data())>) == sizeof(uint8_t),
+                      "socket::read_some can't be used with container with non-byte elements");
+
+        output.resize(max_bytes);
+        size_t bytes_received = implementation_.read_some(output.data(), max_bytes, ec);
+        output.resize(bytes_received);
+        open = (ec != error::generic::disconnected);
+
+        return output;
+    }
+
+    extern template std::vector<uint8_t>& socket::read_some(size_t, std::vector<uint8_t>&, std::error_code&);
+    extern template std::string& socket::read_some(size_t, std::string&, std::error_code&);
+    extern template byte_buffer& socket::read_some(size_t, byte_buffer&, std::error_code&);
+
+    template<typename Handler>
+    size_t socket::poll_zero_copy_completions(Handler&& handler, std::error_code& ec) noexcept {
+        zero_copy_completion completions[16];
+        size_t total = 0;
+        size_t count;
+        do {
+            count = implementation_.read_zero_copy_completions(completions, 16, ec);
+            for (size_t i = 0; i < count; ++i) handler(static_cast<const zero_copy_completion&>(completions[i]));
+            total += count;
+        } while (count == 16 && !ec);
+        return total;
+    }
 
     template<typename Buffer>
     size_t socket::write(const Buffer& input, std::error_code& ec) noexcept {
@@ -434,6 +659,7 @@ namespace libwire::tcp {
 
     extern template size_t socket::write(const std::vector<uint8_t>&, std::error_code&);
     extern template size_t socket::write(const std::string&, std::error_code&);
+    extern template size_t socket::write(const byte_buffer&, std::error_code&);
 
     template<typename Buffer>
     Buffer& socket::read_until(uint8_t delimiter, Buffer& buf, std::error_code& ec, size_t max_size) noexcept {
@@ -479,9 +705,31 @@ namespace libwire::tcp {
 
     extern template std::vector<uint8_t>& socket::read(size_t, std::vector<uint8_t>&);
     extern template std::string& socket::read(size_t, std::string&);
+    extern template byte_buffer& socket::read(size_t, byte_buffer&);
 
     extern template std::vector<uint8_t> socket::read(size_t);
     extern template std::string socket::read(size_t);
+    extern template byte_buffer socket::read(size_t);
+
+    template<typename Buffer>
+    Buffer& socket::read_some(size_t max_bytes, Buffer& output) {
+        std::error_code ec;
+        read_some<Buffer>(max_bytes, output, ec);
+        if (ec) throw std::system_error(ec);
+        return output;
+    }
+
+    extern template std::vector<uint8_t>& socket::read_some(size_t, std::vector<uint8_t>&);
+    extern template std::string& socket::read_some(size_t, std::string&);
+    extern template byte_buffer& socket::read_some(size_t, byte_buffer&);
+
+    template<typename Handler>
+    size_t socket::poll_zero_copy_completions(Handler&& handler) {
+        std::error_code ec;
+        size_t count = poll_zero_copy_completions(std::forward<Handler>(handler), ec);
+        if (ec) throw std::system_error(ec);
+        return count;
+    }
 
     template<typename Buffer>
     size_t socket::write(const Buffer& input) {
@@ -493,6 +741,7 @@ namespace libwire::tcp {
 
     extern template size_t socket::write(const std::vector<uint8_t>&);
     extern template size_t socket::write(const std::string&);
+    extern template size_t socket::write(const byte_buffer&);
 
     template<typename Buffer>
     Buffer& socket::read_until(uint8_t delimiter, Buffer& buf, size_t max_size) {
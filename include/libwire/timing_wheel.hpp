@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+/**
+ * \file timing_wheel.hpp
+ *
+ * This file defines timing_wheel type, container for large number of
+ * timers with O(1) insertion and cancellation.
+ */
+
+namespace libwire {
+    /**
+     * Hierarchical timing wheel.
+     *
+     * Time is divided into ticks of fixed resolution. Wheel consists of
+     * several levels of 64 slots each, slot of level N spans 64^N ticks.
+     * Timer is put into slot of lowest level which can hold its expiry
+     * time, so scheduling and cancellation are just list insertion and
+     * removal. When time advances to slot of upper level, its timers are
+     * moved to lower levels ("cascaded"), timers in level 0 slot are
+     * expired. Empty slots are skipped using occupancy bitmaps.
+     *
+     * Timers are never expired earlier than scheduled, but can be expired
+     * up to one tick later.
+     *
+     * Quick usage example:
+     * \code
+     * timing_wheel wheel;
+     * timing_wheel::timer timer{[] { std::cout << "Expired!\n"; }};
+     * wheel.schedule(timer, timing_wheel::clock::now() + 100ms);
+     * // ... later, usually in event loop
+     * wheel.advance(timing_wheel::clock::now());
+     * \endcode
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: unsafe
+     */
+    class timing_wheel {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * Timer scheduled in wheel, stores callback and list links so
+         * wheel doesn't allocate memory.
+         *
+         * Timer is canceled when destroyed. It must not be moved while
+         * armed, so it's not copyable and not movable.
+         */
+        class timer {
+        public:
+            timer() = default;
+
+            explicit timer(std::function<void()> callback) : callback(std::move(callback)) {
+            }
+
+            timer(const timer&) = delete;
+            timer& operator=(const timer&) = delete;
+
+            ~timer() {
+                cancel();
+            }
+
+            /**
+             * Check whether timer is scheduled in some wheel.
+             */
+            bool armed() const noexcept {
+                return wheel_ != nullptr;
+            }
+
+            /**
+             * Remove timer from wheel without calling callback.
+             * Returns false if timer was not armed.
+             */
+            bool cancel() noexcept;
+
+            /**
+             * Called by \ref timing_wheel::advance when timer expires,
+             * timer is disarmed before call so callback can schedule it again.
+             */
+            std::function<void()> callback;
+
+        private:
+            friend class timing_wheel;
+
+            timing_wheel* wheel_ = nullptr;
+            timer* prev_ = nullptr;
+            timer* next_ = nullptr;
+            uint64_t expiry_ = 0;
+            uint8_t level_ = 0;
+            uint8_t slot_ = 0;
+        };
+
+        /**
+         * Create wheel with specified tick length, start is time of
+         * tick 0 (and time of last \ref advance call).
+         */
+        explicit timing_wheel(clock::duration resolution = std::chrono::milliseconds(1),
+                              clock::time_point start = clock::now()) noexcept;
+
+        timing_wheel(const timing_wheel&) = delete;
+        timing_wheel& operator=(const timing_wheel&) = delete;
+
+        /**
+         * Disarm all timers without calling callbacks.
+         */
+        ~timing_wheel();
+
+        /**
+         * Arm timer to expire at specified time, if timer is already
+         * armed it's rescheduled. O(1).
+         *
+         * Timer scheduled for time which already passed expires on
+         * next tick.
+         */
+        void schedule(timer& timer, clock::time_point expiry) noexcept;
+
+        /**
+         * Expire timers scheduled before now, in order of expiry.
+         * Returns count of callbacks called.
+         *
+         * Callbacks can schedule and cancel any timers of this wheel.
+         */
+        size_t advance(clock::time_point now);
+
+        /**
+         * Time not later than expiry of earliest armed timer, nullopt if
+         * there are no timers. Use it as wait timeout in event loop.
+         *
+         * Exact for timers expiring within 64 ticks, for later timers
+         * it's start of slot they are stored in.
+         */
+        std::optional<clock::time_point> next_expiry() const noexcept;
+
+        /**
+         * Time passed to last \ref advance call.
+         */
+        clock::time_point now() const noexcept;
+
+        /**
+         * Count of armed timers.
+         */
+        size_t size() const noexcept {
+            return size_;
+        }
+
+        bool empty() const noexcept {
+            return size_ == 0;
+        }
+
+    private:
+        static constexpr unsigned slot_bits = 6;
+        static constexpr unsigned slots = 1u << slot_bits;
+
+        /// Enough to cover all 64-bit tick values.
+        static constexpr unsigned levels = (64 + slot_bits - 1) / slot_bits;
+
+        /**
+         * Start of earliest non-empty slot, wheel must be not empty.
+         */
+        uint64_t next_tick() const noexcept;
+
+        uint64_t to_tick(clock::time_point time, bool round_up) const noexcept;
+        clock::time_point to_time(uint64_t tick) const noexcept;
+
+        /**
+         * Put timer into slot according to its expiry,
+         * which must be not earlier than current tick.
+         */
+        void link(timer& timer) noexcept;
+
+        /**
+         * Remove timer from its slot.
+         */
+        void unlink(timer& timer) noexcept;
+
+        /**
+         * Move timers of upper level slots starting at current tick to
+         * lower levels.
+         */
+        void cascade() noexcept;
+
+        /**
+         * Expire all timers from level 0 slot of current tick.
+         */
+        size_t expire_current();
+
+        clock::time_point origin_;
+        clock::duration resolution_;
+        uint64_t current_ = 0;
+        size_t size_ = 0;
+
+        std::array<std::array<timer*, slots>, levels> wheel_{};
+        std::array<uint64_t, levels> occupied_{};
+    };
+} // namespace libwire
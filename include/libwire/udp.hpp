@@ -25,4 +25,7 @@
  */
 namespace libwire::udp {} // namespace libwire::udp
 
+#include "udp/datagram_batch.hpp"
 #include "udp/socket.hpp"
+#include "udp/listener.hpp"
+#include "udp/options.hpp"
@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <libwire/address.hpp>
+#include <libwire/endpoint.hpp>
+#include <libwire/memory_view.hpp>
+#include <libwire/internal/socket.hpp>
+
+namespace libwire::udp {
+    class socket;
+
+    /**
+     * Preallocated set of datagram slots for batched UDP I/O, see
+     * \ref socket::read_batch and \ref socket::write_batch.
+     *
+     * All memory is allocated once in constructor: one contiguous arena
+     * with capacity() slots of max_datagram_size() bytes each plus
+     * space for source/destination endpoints. Reading or writing batch
+     * doesn't allocate or zero-fill anything.
+     *
+     * Endpoints are kept in native form (see libwire::endpoint), so
+     * received endpoints and ones added using \ref push_to are passed
+     * to the system without conversion.
+     *
+     * **Example**
+     * \code
+     * udp::datagram_batch batch(64, 1500);
+     * for (;;) {
+     *     socket.read_batch(batch);
+     *     for (size_t i = 0; i < batch.size(); ++i) {
+     *         process(batch[i], batch.endpoint(i));
+     *     }
+     *     // Echo all datagrams back to their sources.
+     *     socket.write_batch(batch);
+     * }
+     * \endcode
+     */
+    class datagram_batch {
+    public:
+        /**
+         * Allocate batch with capacity slots, max_datagram_size bytes each.
+         */
+        explicit datagram_batch(size_t capacity, size_t max_datagram_size = 2048);
+
+        /**
+         * Max count of datagrams in batch.
+         */
+        size_t capacity() const noexcept;
+
+        /**
+         * Max size of one datagram, larger datagrams are truncated
+         * on receive, see \ref truncated.
+         */
+        size_t max_datagram_size() const noexcept;
+
+        /**
+         * Count of datagrams currently in batch.
+         */
+        size_t size() const noexcept;
+
+        bool empty() const noexcept;
+
+        /**
+         * Remove all datagrams, memory is kept.
+         */
+        void clear() noexcept;
+
+        /**
+         * Bytes of i-th datagram.
+         *
+         * Behavior is undefined if i >= \ref size().
+         */
+        memory_view<uint8_t> operator[](size_t i) noexcept;
+        memory_view<const uint8_t> operator[](size_t i) const noexcept;
+
+        /**
+         * Source endpoint of i-th received datagram or destination of
+         * datagram to write, {{0, 0, 0, 0}, 0} if datagram has no
+         * destination.
+         *
+         * Behavior is undefined if i >= \ref size().
+         */
+        std::tuple<address, uint16_t> endpoint(size_t i) const noexcept;
+
+        /**
+         * Same as \ref endpoint but in native form, as filled by system
+         * call. Can be passed to \ref push_to or socket::write_to()
+         * without conversion, empty if datagram has no destination.
+         *
+         * Behavior is undefined if i >= \ref size().
+         */
+        const libwire::endpoint& native_endpoint(size_t i) const noexcept;
+
+        /**
+         * Whether i-th received datagram was larger than
+         * \ref max_datagram_size and only its beginning was kept.
+         * Truncation is detected only on Linux, elsewhere it's always
+         * false.
+         *
+         * Behavior is undefined if i >= \ref size().
+         */
+        bool truncated(size_t i) const noexcept;
+
+        /**
+         * Copy datagram to next free slot. If destination is not specified
+         * datagram will be sent to endpoint set by \ref socket::associate.
+         *
+         * Returns false if batch is full or datagram is larger
+         * than \ref max_datagram_size.
+         */
+        bool push(memory_view<const uint8_t> datagram,
+                  std::optional<std::tuple<address, uint16_t>> destination = {}) noexcept;
+
+        /**
+         * Same as \ref push but destination is already in native form
+         * and is copied as is, no address conversion is done. Empty
+         * destination means endpoint set by \ref socket::associate.
+         */
+        bool push_to(memory_view<const uint8_t> datagram, const libwire::endpoint& destination) noexcept;
+
+    private:
+        friend class socket;
+
+        size_t capacity_;
+        size_t max_datagram_size_;
+        size_t size_ = 0;
+        std::unique_ptr<uint8_t[]> arena_;
+        std::unique_ptr<internal_::datagram_header[]> headers_;
+    };
+} // namespace libwire::udp
@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <unordered_set>
+#include <libwire/endpoint_map.hpp>
+#include <libwire/udp/socket.hpp>
+
+/**
+ * \file udp/listener.hpp
+ *
+ * This file defines udp::listener type which creates connected UDP
+ * socket (session) per remote peer.
+ */
+
+namespace libwire::udp {
+    /**
+     * UDP socket which "accepts" peers: first datagram from new peer
+     * creates session socket for it, bound to the same local endpoint
+     * (using SO_REUSEPORT) and associated with the peer.
+     *
+     * Kernel prefers connected sockets when delivering datagrams, so
+     * all later traffic from peer goes directly to its session socket
+     * and there is no user-space lookup by source endpoint per datagram.
+     * Listener receives only datagrams from peers without session.
+     *
+     * Listener and sessions are usual sockets, they can be used with
+     * any readiness loop (see native_handle() and libwire::non_blocking
+     * option).
+     *
+     * **Example**
+     * \code
+     * udp::listener listener{ipv4::any, 7777};
+     * std::vector<uint8_t> buffer(1500);
+     * for (;;) {
+     *     size_t size;
+     *     udp::socket session = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+     *     // session.remote_endpoint() is the peer, buffer holds its first datagram.
+     *     start_session(std::move(session), memory_view(buffer.data(), size));
+     * }
+     * // ... when session is finished:
+     * listener.close_session(session);
+     * \endcode
+     *
+     * Listener remembers peers it created sessions for, so there is
+     * at most one session socket per peer. Sessions should be closed
+     * using \ref close_session, otherwise peer can't get new session
+     * after its old one is closed.
+     *
+     * **Limitations**
+     * * Datagrams peer sent before its session was created are still
+     *   queued on listener, accept() drops them.
+     * * Datagrams from other peers received in short window between
+     *   bind and association of new session can end up queued on it.
+     * * If listener is bound to wildcard address, sessions reply from
+     *   address chosen by routing, on multi-homed hosts bind listener to
+     *   specific address.
+     * * Creating session takes several system calls and gets slower as
+     *   reuseport group grows (binding is linear in number of sockets
+     *   bound to the same port), so listener suits long-lived peers.
+     *
+     * Supported only on platforms with SO_REUSEPORT (Linux 3.9+, BSD).
+     * Datagrams are reliably delivered to connected sockets of reuseport
+     * group since Linux 5.0.
+     *
+     * #### Thread-safety
+     * * Distinct: safe
+     * * Same: unsafe
+     */
+    class listener {
+    public:
+        listener() noexcept = default;
+
+        listener(const listener&) = delete;
+        listener(listener&&) noexcept = default;
+
+        listener& operator=(const listener&) = delete;
+        listener& operator=(listener&&) noexcept = default;
+
+        /**
+         * Construct listener and bind it to local endpoint.
+         */
+        listener(address local_address, uint16_t port, std::error_code& ec) noexcept {
+            listen(local_address, port, ec);
+        }
+
+#ifdef __cpp_exceptions
+        listener(address local_address, uint16_t port) {
+            listen(local_address, port);
+        }
+#endif
+
+        /**
+         * Open socket with SO_REUSEPORT and bind it to specified local
+         * endpoint, port 0 means any free port.
+         */
+        void listen(address local_address, uint16_t port, std::error_code& ec) noexcept;
+
+        /**
+         * Receive datagram from peer without session into buffer, create
+         * session socket for this peer and return it. Size of datagram is
+         * returned through datagram_size.
+         *
+         * Waits for datagram unless listener is in non-blocking mode, see
+         * libwire::non_blocking. Peer endpoint is available using
+         * socket::remote_endpoint() of returned socket without system call.
+         *
+         * Datagrams from peers which already have session are dropped,
+         * these are sent before session was created.
+         *
+         * \warning Datagram larger than buffer **will be truncated**.
+         */
+        socket accept(memory_view<uint8_t> buffer, size_t& datagram_size, std::error_code& ec) noexcept;
+
+        /**
+         * Close session socket returned by \ref accept, so next datagram
+         * from its peer creates new session.
+         */
+        void close_session(socket& session) noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        void listen(address local_address, uint16_t port);
+
+        /**
+         * Same as overload with error code but throws std::system_error
+         * instead of setting error code argument.
+         */
+        socket accept(memory_view<uint8_t> buffer, size_t& datagram_size);
+#endif // ifdef __cpp_exceptions
+
+        /**
+         * Endpoint listener and all sessions are bound to.
+         */
+        std::tuple<address, uint16_t> local_endpoint() const noexcept;
+
+        internal_::socket::native_handle_t native_handle() const noexcept;
+
+        const internal_::socket& implementation() const noexcept;
+
+        internal_::socket& implementation() noexcept;
+
+        /**
+         * Get option value for listener socket.
+         */
+        template<typename Option>
+        auto option(const Option& tag) const;
+
+        /**
+         * Set option value for listener socket. Options are not inherited
+         * by session sockets.
+         */
+        template<typename Option, typename... Value>
+        void set_option(const Option& tag, Value&&... value);
+
+    private:
+        internal_::socket implementation_;
+
+        /// Peers with open session.
+        std::unordered_set<std::tuple<address, uint16_t>, endpoint_hash> sessions_;
+    };
+
+    template<typename Option>
+    auto listener::option(const Option& /* tag */) const {
+        return Option::get(*this);
+    }
+
+    template<typename Option, typename... Value>
+    void listener::set_option(const Option& /* tag */, Value&&... value) {
+        Option::set(*this, std::forward<Value>(value)...);
+    }
+} // namespace libwire::udp
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * \file udp/options.hpp
+ *
+ * This file defines set of options applicable for use with UDP sockets
+ * using socket.set_option and socket.option.
+ */
+
+namespace libwire::udp {
+    class socket;
+
+    /**
+     * Inline namespace with options applicable for UDP sockets.
+     */
+    inline namespace options {
+        /**
+         * Dummy type for \ref receive_offload option.
+         */
+        struct receive_offload_t {
+            static void set(socket&, bool enabled) noexcept;
+
+            static bool get(const socket&) noexcept;
+        };
+
+        /**
+         * Allow kernel to coalesce datagrams received from same source
+         * into one buffer (UDP_GRO), see \ref socket::read_coalesced.
+         *
+         * Option stays disabled if it's not supported by OS,
+         * read_coalesced returns one datagram at time in this case.
+         */
+        constexpr receive_offload_t receive_offload{};
+    } // namespace options
+} // namespace libwire::udp
@@ -22,12 +22,65 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <system_error>
 #include <optional>
+#include <libwire/byte_buffer.hpp>
+#include <libwire/memory_view.hpp>
 #include <libwire/internal/socket.hpp>
+#include <libwire/udp/datagram_batch.hpp>
 
 namespace libwire::udp {
+    /**
+     * Several datagrams from same source received by one
+     * \ref socket::read_coalesced call.
+     *
+     * All datagrams except last have segment_size bytes, last one
+     * can be shorter. Datagrams are views into caller's buffer,
+     * nothing is copied.
+     *
+     * **Example**
+     * \code
+     * auto datagrams = socket.read_coalesced(buffer);
+     * for (size_t i = 0; i < datagrams.count(); ++i) process(datagrams[i]);
+     * \endcode
+     */
+    struct coalesced_datagrams {
+        /// All received bytes.
+        memory_view<uint8_t> data;
+
+        /// Size of each datagram (except last one).
+        size_t segment_size = 0;
+
+        /// Source endpoint of all datagrams.
+        std::tuple<address, uint16_t> source{{0, 0, 0, 0}, 0};
+
+        /**
+         * Received data didn't fit into buffer and was cut, last
+         * datagram is incomplete. Detected only on Linux.
+         */
+        bool truncated = false;
+
+        /**
+         * Count of datagrams received.
+         */
+        size_t count() const noexcept {
+            if (segment_size == 0) return 1; // Single empty datagram.
+            return (data.size() + segment_size - 1) / segment_size;
+        }
+
+        /**
+         * Bytes of i-th datagram.
+         *
+         * Behavior is undefined if i >= \ref count().
+         */
+        memory_view<uint8_t> operator[](size_t i) const noexcept {
+            size_t offset = i * segment_size;
+            return {const_cast<uint8_t*>(data.data()) + offset, std::min(segment_size, data.size() - offset)};
+        }
+    };
+
     /**
      * Wrapper for UDP socket descriptor.
      *
@@ -39,10 +92,18 @@ namespace libwire::udp {
      * provided by library just allow you to omit destination address in
      * every write call.
      *
-     * **Current restrictions**
+     * IP version is specified in constructor or open() call. Socket
+     * created with \ref libwire::dual_stack tag serves both IPv4 and IPv6
+     * peers: bind it to ipv6::any, IPv4 peers are reported as ip::v4
+     * addresses and ip::v4 destinations can be used for writes.
      *
-     * Current API doesn't supports IP-version agnostic UDP interface. You have
-     * to specify IP version in constructor or open() call.
+     * **Example**
+     * \code
+     * udp::socket sock(dual_stack);
+     * sock.bind(ipv6::any, 7777);
+     * auto [datagram, source] = sock.read(1500); // source can be IPv4 or IPv6.
+     * sock.write(datagram, source);
+     * \endcode
      */
     class socket {
     public:
@@ -52,6 +113,12 @@ namespace libwire::udp {
          */
         explicit socket(ip ip_version) noexcept;
 
+        /**
+         * Create socket handle and allocate dual-stack UDP socket,
+         * see \ref libwire::dual_stack.
+         */
+        explicit socket(dual_stack_t) noexcept;
+
         /**
          * Create socket handle without associated socket.
          */
@@ -96,12 +163,20 @@ namespace libwire::udp {
          */
         void bind(address source, uint16_t port, std::error_code& ec) noexcept;
 
+        void bind(const endpoint& local, std::error_code& ec) noexcept;
+
         /**
          * Same as overload with error code argument but will throw
          * std::system_error.
          */
         void bind(address source, uint16_t port);
 
+        /**
+         * Same as overload with error code argument but will throw
+         * std::system_error.
+         */
+        void bind(const endpoint& local);
+
         /**
          * Get endpoint previously passed to bind() or implicitly
          * assigned to socket after write.
@@ -137,17 +212,31 @@ namespace libwire::udp {
          */
         void associate(address destination, uint16_t port) noexcept;
 
+        void associate(const endpoint& destination) noexcept;
+
         /**
          * Open socket using specified IP protocol version.
          */
         void open(ip ip_version, std::error_code& ec) noexcept;
 
+        /**
+         * Open IPv6 socket which also handles IPv4 traffic, see
+         * \ref libwire::dual_stack.
+         */
+        void open(dual_stack_t, std::error_code& ec) noexcept;
+
 #ifdef __cpp_exceptions
         /**
          * Same as overload with error code argument but will throw
          * std::system_error instead of setting ec argument.
          */
         void open(ip ip_version);
+
+        /**
+         * Same as overload with error code argument but will throw
+         * std::system_error instead of setting ec argument.
+         */
+        void open(dual_stack_t);
 #endif
 
         /**
@@ -161,6 +250,10 @@ namespace libwire::udp {
          * Errors will be reporting using ec argument.
          * Return value is undefined if ec is changed by this function.
          *
+         * Buffer is resized to max_size before receiving, use
+         * libwire::byte_buffer to avoid zero-filling it every time, or
+         * overload with memory_view to read into your own memory.
+         *
          * \warning If you set max_size to smaller value than pending
          * datagram it **will be truncated with no way to receive remaining
          * information**.
@@ -168,6 +261,30 @@ namespace libwire::udp {
         template<typename Buffer = std::vector<uint8_t>>
         std::tuple<address, uint16_t> read(size_t max_size, Buffer& output, std::error_code& ec) noexcept;
 
+        /**
+         * Read datagram directly into memory referenced by output, return
+         * its size and source endpoint.
+         *
+         * Errors will be reporting using ec argument.
+         * Return value is undefined if ec is changed by this function.
+         *
+         * \warning Datagram larger than output **will be truncated with no
+         * way to receive remaining information**.
+         */
+        std::tuple<size_t, std::tuple<address, uint16_t>> read(memory_view<uint8_t> output,
+                                                               std::error_code& ec) noexcept;
+
+        /**
+         * Read datagram directly into memory referenced by output, return
+         * its size. Source endpoint is written to source in native form by
+         * system call, so it can be passed back to write_to() without
+         * conversion.
+         *
+         * \warning Datagram larger than output **will be truncated with no
+         * way to receive remaining information**.
+         */
+        size_t read_from(memory_view<uint8_t> output, endpoint& source, std::error_code& ec) noexcept;
+
 #ifdef __cpp_exceptions
         /**
          * Same as overload with error code but throws std::system_error instead
@@ -175,6 +292,18 @@ namespace libwire::udp {
          */
         template<typename Buffer = std::vector<uint8_t>>
         std::tuple<address, uint16_t> read(size_t max_size, Buffer& output);
+
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        std::tuple<size_t, std::tuple<address, uint16_t>> read(memory_view<uint8_t> output);
+
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        size_t read_from(memory_view<uint8_t> output, endpoint& source);
 #endif
 
         /**
@@ -211,6 +340,107 @@ namespace libwire::udp {
         template<typename Buffer = std::vector<uint8_t>>
         void write(const Buffer& input, std::optional<std::tuple<address, uint16_t>> destination = {});
 #endif
+
+        /**
+         * Send datagram to destination which is already in native form,
+         * unlike write() no address conversion is done. Returns count of
+         * bytes sent.
+         *
+         * Errors will be reported using ec argument.
+         */
+        size_t write_to(memory_view<const uint8_t> datagram, const endpoint& destination,
+                        std::error_code& ec) noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        size_t write_to(memory_view<const uint8_t> datagram, const endpoint& destination);
+#endif
+
+        /**
+         * Receive several datagrams at once replacing contents of batch,
+         * return count of datagrams received (same as batch.size()).
+         *
+         * Waits only for first datagram (if socket is in blocking mode),
+         * rest are taken only if they are already queued, up to
+         * batch.capacity(). On Linux this takes one recvmmsg call per
+         * 64 datagrams, elsewhere only one datagram is received per call.
+         *
+         * Errors will be reported using ec argument.
+         *
+         * \warning Datagrams larger than batch.max_datagram_size() are
+         * truncated, check batch.truncated(i).
+         */
+        size_t read_batch(datagram_batch& batch, std::error_code& ec) noexcept;
+
+        /**
+         * Send all datagrams from batch to their destinations (or to
+         * associated endpoint if datagram has no destination), return
+         * count of datagrams sent.
+         *
+         * Less datagrams can be sent if socket is in non-blocking mode
+         * or error occurred after first datagram, ec is set only if
+         * nothing was sent.
+         */
+        size_t write_batch(const datagram_batch& batch, std::error_code& ec) noexcept;
+
+        /**
+         * Send buffer as several datagrams of segment_size bytes each (last
+         * one can be shorter), return count of bytes sent.
+         *
+         * On Linux kernel splits buffer into datagrams (UDP segmentation
+         * offload), so up to 64 datagrams are sent by one system call.
+         * If it's not supported datagrams are sent one by one.
+         *
+         * Less data can be sent if socket is in non-blocking mode or
+         * error occurred after first datagram, ec is set only if nothing
+         * was sent.
+         */
+        size_t write_segmented(memory_view<const uint8_t> buffer, size_t segment_size, std::error_code& ec,
+                               std::optional<std::tuple<address, uint16_t>> destination = {}) noexcept;
+
+        /**
+         * Receive datagram into buffer. If \ref receive_offload option is
+         * enabled kernel may put several datagrams from same source into
+         * buffer, see \ref coalesced_datagrams.
+         *
+         * Buffer should be large enough to hold coalesced datagrams
+         * (64 KiB), otherwise they are truncated and result.truncated
+         * is set.
+         *
+         * Errors will be reported using ec argument.
+         * Return value is undefined if ec is changed by this function.
+         */
+        coalesced_datagrams read_coalesced(memory_view<uint8_t> buffer, std::error_code& ec) noexcept;
+
+#ifdef __cpp_exceptions
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        size_t read_batch(datagram_batch& batch);
+
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        size_t write_batch(const datagram_batch& batch);
+
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        size_t write_segmented(memory_view<const uint8_t> buffer, size_t segment_size,
+                               std::optional<std::tuple<address, uint16_t>> destination = {});
+
+        /**
+         * Same as overload with error code but throws std::system_error instead
+         * of setting error code argument.
+         */
+        coalesced_datagrams read_coalesced(memory_view<uint8_t> buffer);
+#endif
     private:
         internal_::socket implementation_;
     };
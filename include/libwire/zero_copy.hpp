@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libwire {
+    /**
+     * Writes smaller than this size are always copied even if zero-copy
+     * write requested because pinning pages and delivering completion
+     * costs more than copy itself.
+     */
+    constexpr size_t zero_copy_threshold = 10 * 1024;
+
+    /**
+     * Notification about completion of zero-copy writes.
+     *
+     * Zero-copy writes are numbered sequentially starting from 0, one
+     * notification can cover several writes. Buffers used by writes in
+     * range [first, last] can be reused or freed.
+     *
+     * \note Numbers are 32-bit and wrap around.
+     */
+    struct zero_copy_completion {
+        uint32_t first = 0;
+        uint32_t last = 0;
+
+        /**
+         * Kernel copied data anyway (for example, because packet is
+         * delivered to local socket), so zero-copy write gave no benefit.
+         * Once such notification is received all further zero-copy writes
+         * on this socket are performed as usual writes.
+         */
+        bool copied = false;
+    };
+} // namespace libwire
@@ -1,24 +1,13 @@
 #include <libwire/address.hpp>
+#include <libwire/endpoint_map.hpp>
+#include "libwire/internal/address_text.hpp"
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <algorithm>
 
-#ifdef _WIN32
-#    include <ws2tcpip.h>
-#else
-#    include <arpa/inet.h>
-#endif
-
 namespace libwire {
-    address::address(uint8_t o1, uint8_t o2, uint8_t o3, uint8_t o4) noexcept
-        : version(ip::v4), parts{o1, o2, o3, o4, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0} {
-    }
-
-    address::address(uint8_t o1, uint8_t o2, uint8_t o3, uint8_t o4, uint8_t o5, uint8_t o6, uint8_t o7, uint8_t o8,
-                     uint8_t o9, uint8_t o10, uint8_t o11, uint8_t o12, uint8_t o13, uint8_t o14, uint8_t o15,
-                     uint8_t o16) noexcept
-        : version(ip::v6), parts{o1, o2, o3, o4, o5, o6, o7, o8, o9, o10, o11, o12, o13, o14, o15, o16} {
-    }
-
 #ifdef __cpp_exceptions
     address::address(const std::string_view& text_ip) { // NOLINT(hicpp-member-init)
         bool success = true;
@@ -28,36 +17,34 @@ namespace libwire {
 #endif
 
     address::address(const std::string_view& text_ip, bool& success) noexcept : version(ip::v4), parts{} {
-        int family = AF_INET;
-        for (const char& ch : text_ip) {
-            if (ch == ':') {
-                family = AF_INET6;
-                version = ip::v6;
-            }
+        if (text_ip.find(':') != std::string_view::npos) {
+            version = ip::v6;
+            success = internal_::parse_ipv6(text_ip.data(), text_ip.size(), parts.data());
+        } else {
+            success = internal_::parse_ipv4(text_ip.data(), text_ip.size(), parts.data());
         }
-
-        success = bool(inet_pton(family, text_ip.data(), parts.data()));
-        // ^ returns 1 on success, 0 otherwise.
     }
 
     std::string address::to_string() const noexcept {
-        int family = (version == ip::v4) ? AF_INET : AF_INET6;
-
-        std::array<char, 45> buffer;
-
-        // Cast is required because on Windows this function accepts void*.
-        const char* buf_ptr = inet_ntop(family, (void*)(parts.data()), buffer.data(), buffer.size());
-        assert(buf_ptr != nullptr); // This function generally should not fail.
-
-        return std::string(buffer.data());
+        std::array<char, max_text_size> buffer;
+        return std::string(buffer.data(), to_chars(buffer.data(), buffer.data() + buffer.size()).ptr);
     }
 
-    bool address::operator==(const address& o) const noexcept {
-        return version == o.version && parts == o.parts;
-    }
+    std::to_chars_result address::to_chars(char* first, char* last) const noexcept {
+        size_t max_size = version == ip::v4 ? internal_::ipv4_text_max : internal_::ipv6_text_max;
+        if (size_t(last - first) >= max_size) {
+            char* end = version == ip::v4 ? internal_::format_ipv4(parts.data(), first)
+                                          : internal_::format_ipv6(parts.data(), first);
+            return {end, std::errc{}};
+        }
 
-    bool address::operator!=(const address& o) const noexcept {
-        return version == o.version && parts != o.parts;
+        // Format into temporary buffer if text may not fit.
+        std::array<char, max_text_size> buffer;
+        auto [end, ec] = to_chars(buffer.data(), buffer.data() + buffer.size());
+        auto size = size_t(end - buffer.data());
+        if (size > size_t(last - first)) return {last, std::errc::value_too_large};
+        std::memcpy(first, buffer.data(), size);
+        return {first + size, ec};
     }
 
     address::address(const memory_view<uint8_t>& mv) noexcept : parts{} {
@@ -66,17 +53,20 @@ namespace libwire {
         version = mv.size() == 4 ? ip::v4 : ip::v6;
         std::copy(mv.begin(), mv.end(), parts.begin());
     }
+
+    namespace internal_ {
+        void invalid_address_literal() {
+#ifdef __cpp_exceptions
+            throw std::invalid_argument("Invalid address literal");
+#else
+            std::abort();
+#endif
+        }
+    } // namespace internal_
 } // namespace libwire
 
 namespace std { // NOLINT(cert-dcl58-cpp)
     std::size_t hash<libwire::address>::operator()(const libwire::address& addr) const noexcept {
-        std::hash<uint8_t> hash;
-        auto result = std::size_t(addr.version);
-        for (const uint8_t& i : addr.parts) {
-            // See
-            // https://stackoverflow.com/questions/4948780/magic-number-in-boosthash-combine
-            result ^= hash(i) + 0x9e3779b9u + (result << 6u) + (result >> 2u);
-        }
-        return result;
+        return std::size_t(libwire::endpoint_hash::hash(addr, 0));
     }
 } // namespace std
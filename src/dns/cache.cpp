@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include "libwire/dns/cache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include "libwire/error.hpp"
+
+namespace libwire::dns {
+    namespace {
+        bool negative_answer(const std::error_code& ec) noexcept {
+            return ec == error::host_not_found || ec == error::no_address;
+        }
+    } // namespace
+
+    cache::cache(resolver& upstream) : cache(upstream, config()) {}
+
+    cache::cache(resolver& upstream, config settings) : upstream_(upstream), config_(std::move(settings)) {
+        config_.shards = std::max<size_t>(config_.shards, 1);
+        shard_capacity_ = std::max<size_t>(config_.capacity / config_.shards, 1);
+        shards_ = std::make_unique<shard[]>(config_.shards);
+    }
+
+    void cache::async_resolve(std::string_view name, resolver::handler callback) {
+        resolve(family::any, name, std::move(callback));
+    }
+
+    void cache::async_resolve(ip protocol, std::string_view name, resolver::handler callback) {
+        resolve(protocol == ip::v4 ? family::v4 : family::v6, name, std::move(callback));
+    }
+
+    void cache::resolve(family kind, std::string_view name, resolver::handler callback) {
+        // Numeric addresses are answered by resolver without queries.
+        bool numeric = false;
+        address parsed(name, numeric);
+        if (numeric) {
+            if (kind == family::any) {
+                upstream_.async_resolve(name, std::move(callback));
+            } else {
+                upstream_.async_resolve(kind == family::v4 ? ip::v4 : ip::v6, name, std::move(callback));
+            }
+            return;
+        }
+
+        std::string key = make_key(kind, name);
+        shard& part = shard_of(key);
+        answer result;
+        std::error_code ec;
+        bool hit = false, refresh = false, start = false;
+        {
+            std::lock_guard lock(part.mutex);
+            hit = find(part, key, clock::now(), result, ec, refresh);
+            if (!hit) {
+                ++part.counters.misses;
+                auto it = part.entries.find(key);
+                if (it == part.entries.end()) {
+                    make_room(part, clock::now());
+                    it = part.entries.emplace(key, entry{}).first;
+                }
+                it->second.waiters.push_back(std::move(callback));
+                start = !it->second.updating;
+                it->second.updating = true;
+            }
+        }
+
+        if (start || refresh) query(key);
+        if (hit) {
+            upstream_.context().post([callback = std::move(callback), ec, result = std::move(result)]() mutable {
+                callback(ec, std::move(result));
+            });
+        }
+    }
+
+    bool cache::try_resolve(ip protocol, std::string_view name, answer& result, std::error_code& ec) {
+        std::string key = make_key(protocol == ip::v4 ? family::v4 : family::v6, name);
+        shard& part = shard_of(key);
+        bool refresh = false;
+        {
+            std::lock_guard lock(part.mutex);
+            if (!find(part, key, clock::now(), result, ec, refresh)) return false;
+        }
+        if (refresh) query(key);
+        return true;
+    }
+
+    bool cache::find(shard& part, const std::string& key, clock::time_point now, answer& result,
+                     std::error_code& ec, bool& refresh) {
+        auto it = part.entries.find(key);
+        if (it == part.entries.end()) return false;
+        entry& cached = it->second;
+        if (!cached.valid || now >= cached.expires) return false;
+
+        ++part.counters.hits;
+        ++cached.hits;
+        if (!cached.updating && now >= cached.refresh_at && cached.hits >= config_.refresh_hits) {
+            ++part.counters.refreshes;
+            cached.updating = true;
+            refresh = true;
+        }
+
+        ec = cached.ec;
+        result.addresses = cached.result.addresses;
+        result.ttl = std::chrono::duration_cast<std::chrono::seconds>(cached.expires - now);
+        return true;
+    }
+
+    void cache::query(const std::string& key) {
+        auto callback = [this, key](std::error_code ec, answer result) { store(key, ec, std::move(result)); };
+        std::string_view name = std::string_view(key).substr(1);
+        switch (family(key[0])) {
+        case family::any:
+            upstream_.async_resolve(name, std::move(callback));
+            break;
+        case family::v4:
+            upstream_.async_resolve(ip::v4, name, std::move(callback));
+            break;
+        case family::v6:
+            upstream_.async_resolve(ip::v6, name, std::move(callback));
+            break;
+        }
+    }
+
+    void cache::store(const std::string& key, std::error_code ec, answer result) {
+        std::chrono::seconds ttl{0};
+        if (!ec) {
+            ttl = std::min(result.ttl, config_.max_ttl);
+        } else if (negative_answer(ec)) {
+            ttl = std::min(result.ttl, config_.max_negative_ttl);
+        }
+        // Waiters see the same lifetime as later hits.
+        if (ttl.count() > 0) result.ttl = ttl;
+
+        shard& part = shard_of(key);
+        std::vector<resolver::handler> waiters;
+        {
+            std::lock_guard lock(part.mutex);
+            auto it = part.entries.find(key);
+            if (it == part.entries.end()) return;
+            entry& cached = it->second;
+            waiters = std::move(cached.waiters);
+            cached.waiters.clear();
+            cached.updating = false;
+
+            auto now = clock::now();
+            if (ttl.count() > 0) {
+                cached.valid = true;
+                cached.ec = ec;
+                cached.result = result;
+                cached.hits = 0;
+                cached.expires = now + ttl;
+                cached.refresh_at = now + std::chrono::duration_cast<clock::duration>(ttl * config_.refresh_after);
+            } else if (!cached.valid || now >= cached.expires) {
+                // Failed refresh leaves entry in place until it expires.
+                part.entries.erase(it);
+            }
+        }
+
+        for (auto& callback : waiters) callback(ec, result);
+    }
+
+    void cache::make_room(shard& part, clock::time_point now) {
+        if (part.entries.size() < shard_capacity_) return;
+
+        auto victim = part.entries.end();
+        for (auto it = part.entries.begin(); it != part.entries.end();) {
+            // Entries with lookups in flight are kept, they have waiters.
+            if (it->second.updating) {
+                ++it;
+            } else if (!it->second.valid || now >= it->second.expires) {
+                it = part.entries.erase(it);
+            } else {
+                if (victim == part.entries.end() || it->second.expires < victim->second.expires) victim = it;
+                ++it;
+            }
+        }
+        if (part.entries.size() >= shard_capacity_ && victim != part.entries.end()) part.entries.erase(victim);
+    }
+
+    void cache::clear() {
+        for (size_t i = 0; i < config_.shards; ++i) {
+            std::lock_guard lock(shards_[i].mutex);
+            for (auto it = shards_[i].entries.begin(); it != shards_[i].entries.end();) {
+                if (it->second.updating) {
+                    it->second.valid = false;
+                    ++it;
+                } else {
+                    it = shards_[i].entries.erase(it);
+                }
+            }
+        }
+    }
+
+    cache::statistics cache::stats() const {
+        statistics total;
+        for (size_t i = 0; i < config_.shards; ++i) {
+            std::lock_guard lock(shards_[i].mutex);
+            total.hits += shards_[i].counters.hits;
+            total.misses += shards_[i].counters.misses;
+            total.refreshes += shards_[i].counters.refreshes;
+        }
+        return total;
+    }
+
+    std::string cache::make_key(family kind, std::string_view name) {
+        if (!name.empty() && name.back() == '.') name.remove_suffix(1);
+        std::string key;
+        key.reserve(name.size() + 1);
+        key.push_back(char(kind));
+        for (char c : name) key.push_back(char(std::tolower(static_cast<unsigned char>(c))));
+        return key;
+    }
+
+    cache::shard& cache::shard_of(const std::string& key) const noexcept {
+        return shards_[std::hash<std::string>()(key) % config_.shards];
+    }
+} // namespace libwire::dns
+
+#endif // ifdef __linux__
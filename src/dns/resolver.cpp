@@ -0,0 +1,481 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include "libwire/dns/resolver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <netdb.h>
+#include "libwire/error.hpp"
+#include "libwire/internal/dns_message.hpp"
+#include "libwire/tcp/socket.hpp"
+
+namespace libwire::dns {
+    namespace {
+        constexpr uint16_t default_port = 53;
+
+        // Same limits as glibc resolver uses for resolv.conf options.
+        constexpr unsigned max_timeout_seconds = 30, max_attempts = 5;
+
+#ifdef EAI_NODATA
+        constexpr int no_data_code = EAI_NODATA;
+#else
+        constexpr int no_data_code = EAI_NONAME;
+#endif
+
+        std::error_code dns_error(int code) noexcept {
+            return {code, error::dns_category()};
+        }
+
+        std::error_code system_error(int code) noexcept {
+            return {code, error::system_category()};
+        }
+
+        // Errors which say something about name itself, answer stays
+        // valid for negative caching TTL.
+        bool negative_answer(const std::error_code& ec) noexcept {
+            return ec == dns_error(EAI_NONAME) || ec == dns_error(no_data_code);
+        }
+
+        // Lookup of both families reports most important error: transient
+        // failure means that answer is incomplete, existing name without
+        // addresses of one family is more specific than missing name.
+        int error_rank(const std::error_code& ec) noexcept {
+            if (!ec) return 0;
+            if (ec == dns_error(EAI_NONAME)) return 1;
+            if (ec == dns_error(no_data_code)) return 2;
+            return 3;
+        }
+
+        std::string_view next_token(std::string_view& line) noexcept {
+            constexpr std::string_view blanks = " \t\r";
+            size_t start = std::min(line.find_first_not_of(blanks), line.size());
+            size_t end = std::min(line.find_first_of(blanks, start), line.size());
+            std::string_view token = line.substr(start, end - start);
+            line.remove_prefix(end);
+            return token;
+        }
+
+        bool parse_option(std::string_view option, std::string_view name, unsigned& value) noexcept {
+            if (option.size() <= name.size() || option.substr(0, name.size()) != name) return false;
+            if (option[name.size()] != ':') return false;
+            option.remove_prefix(name.size() + 1);
+            auto [end, ec] = std::from_chars(option.data(), option.data() + option.size(), value);
+            return ec == std::errc() && end == option.data() + option.size();
+        }
+
+        struct tcp_state {
+            tcp::socket socket;
+            endpoint server;
+            unsigned step = 0;
+            uint8_t length[2] = {};
+            std::vector<uint8_t> reply;
+        };
+    } // namespace
+
+    struct resolver::lookup {
+        handler callback;
+        unsigned remaining = 0;
+        std::vector<address> addresses[2];
+        uint32_t ttl = UINT32_MAX;
+        std::error_code ec;
+    };
+
+    struct resolver::query {
+        uint16_t id = 0;
+        uint64_t serial = 0;
+        internal_::dns_type type = internal_::dns_type::a;
+        unsigned family = 0;
+        std::string name;
+        std::shared_ptr<lookup> owner;
+
+        /// Index into sequence of attempts × nameservers.
+        size_t transmission = 0;
+        std::error_code last_error;
+
+        /// Message starts at offset 2, first two bytes are reserved for
+        /// length prefix used over TCP.
+        size_t message_size = 0;
+        std::array<uint8_t, 2 + internal_::dns_max_query_size> packet{};
+
+        timing_wheel::timer timer;
+
+        /// Incremented each time timer is armed, so expiration which
+        /// raced with reply and fail over is recognized as stale. Read by
+        /// timer callback without resolver lock.
+        std::atomic<unsigned> arms{0};
+
+        std::unique_ptr<tcp_state> tcp;
+    };
+
+    /*
+     * Handler is called with resolver lock held and dropped if resolver
+     * is already destroyed.
+     */
+    template<typename Function>
+    auto resolver::guarded(Function function) {
+        return [state = lifetime_, function = std::move(function)](auto&&... args) mutable {
+            std::lock_guard lock(state->mutex);
+            if (state->owner != nullptr) function(*state->owner, std::forward<decltype(args)>(args)...);
+        };
+    }
+
+    resolver::config resolver::config::parse(std::string_view text) {
+        config result;
+        while (!text.empty()) {
+            size_t line_end = std::min(text.find('\n'), text.size());
+            std::string_view line = text.substr(0, line_end);
+            text.remove_prefix(std::min(line_end + 1, text.size()));
+            line = line.substr(0, std::min(line.find_first_of("#;"), line.size()));
+
+            std::string_view keyword = next_token(line);
+            if (keyword == "nameserver") {
+                // Addresses with zone index (fe80::1%eth0) are not supported.
+                bool valid = false;
+                address server(next_token(line), valid);
+                if (valid) result.nameservers.emplace_back(server, default_port);
+            } else if (keyword == "options") {
+                for (std::string_view option = next_token(line); !option.empty(); option = next_token(line)) {
+                    unsigned value = 0;
+                    if (parse_option(option, "timeout", value)) {
+                        result.timeout = std::chrono::seconds(std::clamp(value, 1u, max_timeout_seconds));
+                    } else if (parse_option(option, "attempts", value)) {
+                        result.attempts = std::clamp(value, 1u, max_attempts);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    resolver::config resolver::config::load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) return {};
+        std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return parse(text);
+    }
+
+    resolver::resolver(io_context& context, std::error_code& ec) : resolver(context, config::load(), ec) {
+    }
+
+    resolver::resolver(io_context& context, config settings, std::error_code& ec)
+        : context_(context), config_(std::move(settings)), random_(std::random_device()()) {
+        lifetime_->owner = this;
+        open(ec);
+    }
+
+#ifdef __cpp_exceptions
+    resolver::resolver(io_context& context) : resolver(context, config::load()) {
+    }
+
+    resolver::resolver(io_context& context, config settings)
+        : context_(context), config_(std::move(settings)), random_(std::random_device()()) {
+        lifetime_->owner = this;
+        std::error_code ec;
+        open(ec);
+        if (ec) throw std::system_error(ec);
+    }
+#endif
+
+    void resolver::open(std::error_code& ec) noexcept {
+        if (config_.nameservers.empty()) config_.nameservers.emplace_back(ipv4::loopback, default_port);
+        config_.attempts = std::max(config_.attempts, 1u);
+
+        bool need_ipv6 = std::any_of(config_.nameservers.begin(), config_.nameservers.end(),
+                                     [](const endpoint& server) { return server.version() == ip::v6; });
+        if (need_ipv6) {
+            socket_.open(dual_stack, ec);
+        } else {
+            socket_.open(ip::v4, ec);
+        }
+    }
+
+    resolver::~resolver() {
+        std::lock_guard lock(lifetime_->mutex);
+        lifetime_->owner = nullptr;
+
+        // Canceled operations complete later with guarded handlers,
+        // which see that resolver is gone.
+        for (auto& entry : queries_) {
+            context_.cancel_timer(entry.second->timer);
+            if (entry.second->tcp) context_.cancel(entry.second->tcp->socket);
+        }
+        if (receiving_) context_.cancel(socket_);
+    }
+
+    void resolver::async_resolve(std::string_view name, handler callback) {
+        bool numeric = false;
+        address parsed(name, numeric);
+        if (numeric) {
+            context_.post([callback = std::move(callback), parsed] { callback({}, answer{{parsed}, {}}); });
+            return;
+        }
+
+        auto owner = std::make_shared<lookup>();
+        owner->callback = std::move(callback);
+        owner->remaining = 2;
+
+        std::lock_guard lock(lifetime_->mutex);
+        start_query(owner, name, ip::v4);
+        start_query(owner, name, ip::v6);
+    }
+
+    void resolver::async_resolve(ip protocol, std::string_view name, handler callback) {
+        bool numeric = false;
+        address parsed(name, numeric);
+        if (numeric) {
+            std::error_code ec = parsed.version == protocol ? std::error_code() : dns_error(no_data_code);
+            context_.post([callback = std::move(callback), parsed, ec] {
+                callback(ec, ec ? answer{} : answer{{parsed}, {}});
+            });
+            return;
+        }
+
+        auto owner = std::make_shared<lookup>();
+        owner->callback = std::move(callback);
+        owner->remaining = 1;
+
+        std::lock_guard lock(lifetime_->mutex);
+        start_query(owner, name, protocol);
+    }
+
+    void resolver::start_query(const std::shared_ptr<lookup>& owner, std::string_view name, ip protocol) {
+        unsigned family = protocol == ip::v4 ? 0 : 1;
+        if (queries_.size() > UINT16_MAX) {
+            // All IDs are in use.
+            complete(*owner, system_error(ENOBUFS), family, {}, 0);
+            return;
+        }
+
+        auto q = std::make_unique<query>();
+        q->type = protocol == ip::v4 ? internal_::dns_type::a : internal_::dns_type::aaaa;
+        do {
+            q->id = uint16_t(random_());
+        } while (queries_.count(q->id) != 0);
+        q->message_size = internal_::dns_write_query(q->id, name, q->type, q->packet.data() + 2);
+        if (q->message_size == 0) {
+            complete(*owner, system_error(EINVAL), family, {}, 0);
+            return;
+        }
+        q->serial = next_serial_++;
+        q->family = family;
+        q->name = std::string(name);
+        q->owner = owner;
+
+        // Timer callbacks run with io_context timers lock held, so actual
+        // work is done from posted handler to keep lock order
+        // (resolver, then timers) consistent. Query is not destroyed
+        // until timer is disarmed, which waits for running callback.
+        q->timer.callback = [this, self = q.get()] {
+            context_.post(guarded([id = self->id, serial = self->serial, arm = self->arms.load()](resolver& owner) {
+                owner.on_timeout(id, serial, arm);
+            }));
+        };
+
+        query& started = *q;
+        queries_.emplace(started.id, std::move(q));
+        transmit(started);
+    }
+
+    void resolver::transmit(query& q) {
+        size_t limit = config_.nameservers.size() * config_.attempts;
+        while (q.transmission < limit) {
+            const endpoint& server = config_.nameservers[q.transmission % config_.nameservers.size()];
+            std::error_code ec;
+            socket_.write_to(memory_view<const uint8_t>(q.packet.data() + 2, q.message_size), server, ec);
+            if (!ec) {
+                ++q.arms;
+                context_.schedule(q.timer, config_.timeout);
+                start_receive();
+                return;
+            }
+            q.last_error = ec;
+            ++q.transmission;
+        }
+        finish(q, q.last_error ? q.last_error : system_error(ETIMEDOUT), {}, 0);
+    }
+
+    void resolver::start_receive() {
+        if (receiving_) return;
+        receiving_ = true;
+        context_.async_receive_from(
+            socket_, memory_view<uint8_t>(receive_buffer_.data(), receive_buffer_.size()),
+            guarded([](resolver& owner, std::error_code ec, size_t size, std::tuple<address, uint16_t> source) {
+                owner.on_receive(ec, size, source);
+            }));
+    }
+
+    void resolver::on_receive(const std::error_code& ec, size_t size, const endpoint& source) {
+        receiving_ = false;
+
+        if (!ec && size >= internal_::dns_header_size) {
+            endpoint server = source;
+            server.unmap();
+            auto it = queries_.find(internal_::dns_message_id(receive_buffer_.data()));
+            bool known_server =
+                std::find(config_.nameservers.begin(), config_.nameservers.end(), server) != config_.nameservers.end();
+            if (it != queries_.end() && !it->second->tcp && known_server) {
+                handle_reply(*it->second, receive_buffer_.data(), size, server);
+            }
+        }
+
+        if (!queries_.empty()) start_receive();
+    }
+
+    void resolver::on_timeout(uint16_t id, uint64_t serial, unsigned arm) {
+        query* q = find(id, serial);
+        if (q == nullptr || q->tcp || q->arms != arm) return;
+        ++q->transmission;
+        transmit(*q);
+    }
+
+    bool resolver::handle_reply(query& q, const uint8_t* message, size_t size, const endpoint& server) {
+        internal_::dns_reply reply;
+        if (!internal_::dns_read_reply(message, size, q.name, q.type, reply)) return false;
+
+        if (reply.truncated) {
+            if (q.tcp) return false;
+            context_.cancel_timer(q.timer);
+            start_tcp(q, server);
+            return true;
+        }
+
+        switch (reply.rcode) {
+        case internal_::no_error:
+            if (reply.addresses.empty()) {
+                finish(q, dns_error(no_data_code), {}, reply.ttl);
+            } else {
+                finish(q, {}, std::move(reply.addresses), reply.ttl);
+            }
+            break;
+        case internal_::name_error: finish(q, dns_error(EAI_NONAME), {}, reply.ttl); break;
+        case internal_::server_failure: fail_over(q, dns_error(EAI_AGAIN)); break;
+        default: fail_over(q, dns_error(EAI_FAIL)); break;
+        }
+        return true;
+    }
+
+    void resolver::start_tcp(query& q, const endpoint& server) {
+        q.tcp = std::make_unique<tcp_state>();
+        q.tcp->server = server;
+        q.packet[0] = uint8_t(q.message_size >> 8u);
+        q.packet[1] = uint8_t(q.message_size);
+        context_.async_connect(q.tcp->socket, server.address(), server.port(), config_.timeout,
+                               guarded([id = q.id, serial = q.serial](resolver& owner, std::error_code ec) {
+                                   owner.on_tcp_step(id, serial, ec);
+                               }));
+    }
+
+    void resolver::on_tcp_step(uint16_t id, uint64_t serial, const std::error_code& ec) {
+        query* q = find(id, serial);
+        if (q == nullptr || !q->tcp) return;
+        if (ec) {
+            fail_over(*q, ec);
+            return;
+        }
+
+        tcp_state& tcp = *q->tcp;
+        auto next = guarded([id, serial](resolver& owner, std::error_code ec, auto&&...) {
+            owner.on_tcp_step(id, serial, ec);
+        });
+        switch (tcp.step++) {
+        case 0: // Connected.
+            context_.async_write(tcp.socket, memory_view<const uint8_t>(q->packet.data(), q->message_size + 2),
+                                 config_.timeout, next);
+            break;
+        case 1: // Query sent.
+            context_.async_read(tcp.socket, memory_view<uint8_t>(tcp.length, sizeof(tcp.length)), config_.timeout,
+                                next);
+            break;
+        case 2: // Length of reply received.
+            tcp.reply.resize(size_t(tcp.length[0] << 8u) | tcp.length[1]);
+            if (tcp.reply.size() < internal_::dns_header_size) {
+                fail_over(*q, dns_error(EAI_FAIL));
+                break;
+            }
+            context_.async_read(tcp.socket, memory_view<uint8_t>(tcp.reply.data(), tcp.reply.size()),
+                                config_.timeout, next);
+            break;
+        default:
+            if (internal_::dns_message_id(tcp.reply.data()) != id ||
+                !handle_reply(*q, tcp.reply.data(), tcp.reply.size(), tcp.server)) {
+                fail_over(*q, dns_error(EAI_FAIL));
+            }
+        }
+    }
+
+    void resolver::fail_over(query& q, const std::error_code& ec) {
+        context_.cancel_timer(q.timer);
+        q.tcp.reset();
+        q.last_error = ec;
+        ++q.transmission;
+        transmit(q);
+    }
+
+    void resolver::finish(query& q, const std::error_code& ec, std::vector<address> addresses, uint32_t ttl) {
+        context_.cancel_timer(q.timer);
+        std::shared_ptr<lookup> owner = std::move(q.owner);
+        unsigned family = q.family;
+        queries_.erase(q.id);
+
+        // Pending receive would keep io_context::run() from returning.
+        // Canceled before handler is posted, so it's not running after
+        // handler which may destroy resolver.
+        if (queries_.empty() && receiving_) context_.cancel(socket_);
+
+        complete(*owner, ec, family, std::move(addresses), ttl);
+    }
+
+    void resolver::complete(lookup& owner, const std::error_code& ec, unsigned family,
+                            std::vector<address> addresses, uint32_t ttl) {
+        if (!addresses.empty() || negative_answer(ec)) owner.ttl = std::min(owner.ttl, ttl);
+        owner.addresses[family] = std::move(addresses);
+        if (error_rank(ec) > error_rank(owner.ec)) owner.ec = ec;
+        if (--owner.remaining != 0) return;
+
+        answer result;
+        for (auto& part : owner.addresses) {
+            result.addresses.insert(result.addresses.end(), part.begin(), part.end());
+        }
+        std::error_code result_ec = result.addresses.empty() ? owner.ec : std::error_code();
+        if ((!result_ec || negative_answer(result_ec)) && owner.ttl != UINT32_MAX) {
+            result.ttl = std::chrono::seconds(owner.ttl);
+        }
+
+        context_.post([callback = std::move(owner.callback), result_ec, result = std::move(result)]() mutable {
+            callback(result_ec, std::move(result));
+        });
+    }
+
+    resolver::query* resolver::find(uint16_t id, uint64_t serial) noexcept {
+        auto it = queries_.find(id);
+        if (it == queries_.end() || it->second->serial != serial) return nullptr;
+        return it->second.get();
+    }
+} // namespace libwire::dns
+
+#endif // ifdef __linux__
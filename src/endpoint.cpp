@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/endpoint.hpp"
+
+#include <cstring>
+#include "libwire/internal/endianess.hpp"
+
+namespace libwire {
+    using internal_::host_to_network;
+    using internal_::network_to_host;
+
+    // First 12 bytes of IPv4-mapped IPv6 address.
+    static constexpr uint8_t v4_mapped_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+    endpoint::endpoint(const libwire::address& address, uint16_t port) noexcept : storage_{} {
+        if (address.version == ip::v4) {
+            storage_.v4.sin_family = AF_INET;
+            storage_.v4.sin_port = host_to_network(port);
+            std::memcpy(&storage_.v4.sin_addr, address.parts.data(), 4);
+        } else {
+            storage_.v6.sin6_family = AF_INET6;
+            storage_.v6.sin6_port = host_to_network(port);
+            std::memcpy(&storage_.v6.sin6_addr, address.parts.data(), 16);
+        }
+    }
+
+    endpoint::endpoint(const sockaddr* native, socklen_t length) noexcept : storage_{} {
+        if (native->sa_family == AF_INET && length >= socklen_t(sizeof(sockaddr_in))) {
+            std::memcpy(&storage_.v4, native, sizeof(sockaddr_in));
+        } else if (native->sa_family == AF_INET6 && length >= socklen_t(sizeof(sockaddr_in6))) {
+            std::memcpy(&storage_.v6, native, sizeof(sockaddr_in6));
+        }
+    }
+
+    libwire::address endpoint::address() const noexcept {
+        if (storage_.base.sa_family == AF_INET) {
+            return memory_view((uint8_t*)&storage_.v4.sin_addr, 4);
+        }
+        return memory_view((uint8_t*)&storage_.v6.sin6_addr, 16);
+    }
+
+    uint16_t endpoint::port() const noexcept {
+        // sin_port and sin6_port have the same offset.
+        return network_to_host(storage_.v4.sin_port);
+    }
+
+    endpoint endpoint::v4_mapped() const noexcept {
+        if (storage_.base.sa_family != AF_INET) return *this;
+
+        endpoint result;
+        result.storage_.v6.sin6_family = AF_INET6;
+        result.storage_.v6.sin6_port = storage_.v4.sin_port;
+        auto* bytes = reinterpret_cast<uint8_t*>(&result.storage_.v6.sin6_addr);
+        std::memcpy(bytes, v4_mapped_prefix, sizeof(v4_mapped_prefix));
+        std::memcpy(bytes + sizeof(v4_mapped_prefix), &storage_.v4.sin_addr, 4);
+        return result;
+    }
+
+    void endpoint::unmap() noexcept {
+        if (storage_.base.sa_family != AF_INET6) return;
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&storage_.v6.sin6_addr);
+        if (std::memcmp(bytes, v4_mapped_prefix, sizeof(v4_mapped_prefix)) != 0) return;
+
+        sockaddr_in v4{};
+        v4.sin_family = AF_INET;
+        v4.sin_port = storage_.v6.sin6_port;
+        std::memcpy(&v4.sin_addr, bytes + sizeof(v4_mapped_prefix), 4);
+        storage_ = {};
+        storage_.v4 = v4;
+    }
+
+    std::string endpoint::to_string() const {
+        char buffer[max_text_size];
+        return std::string(buffer, to_chars(buffer, buffer + sizeof(buffer)).ptr);
+    }
+
+    std::to_chars_result endpoint::to_chars(char* first, char* last) const noexcept {
+        if (empty()) return {first, std::errc{}};
+
+        char buffer[max_text_size];
+        char* current = buffer;
+        bool v6 = version() == ip::v6;
+        if (v6) *current++ = '[';
+        current = address().to_chars(current, buffer + sizeof(buffer)).ptr;
+        if (v6) *current++ = ']';
+        *current++ = ':';
+        current = std::to_chars(current, buffer + sizeof(buffer), port()).ptr;
+
+        auto size = size_t(current - buffer);
+        if (size > size_t(last - first)) return {last, std::errc::value_too_large};
+        std::memcpy(first, buffer, size);
+        return {first + size, std::errc{}};
+    }
+
+    bool endpoint::operator==(const endpoint& o) const noexcept {
+        if (storage_.base.sa_family != o.storage_.base.sa_family) return false;
+        if (storage_.base.sa_family == AF_INET) {
+            return storage_.v4.sin_port == o.storage_.v4.sin_port &&
+                   std::memcmp(&storage_.v4.sin_addr, &o.storage_.v4.sin_addr, sizeof(in_addr)) == 0;
+        }
+        if (storage_.base.sa_family == AF_INET6) {
+            return storage_.v6.sin6_port == o.storage_.v6.sin6_port &&
+                   storage_.v6.sin6_scope_id == o.storage_.v6.sin6_scope_id &&
+                   std::memcmp(&storage_.v6.sin6_addr, &o.storage_.v6.sin6_addr, sizeof(in6_addr)) == 0;
+        }
+        return true; // Both empty.
+    }
+
+    bool endpoint::operator!=(const endpoint& o) const noexcept {
+        return !(*this == o);
+    }
+} // namespace libwire
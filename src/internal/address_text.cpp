@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/internal/address_text.hpp"
+
+#include <cstring>
+
+#ifdef LIBWIRE_X86_KERNELS
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    endif
+#    include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define LIBWIRE_TARGET(isa) __attribute__((target(isa)))
+#else
+#    define LIBWIRE_TARGET(isa)
+#endif
+
+namespace libwire::internal_ {
+#ifdef LIBWIRE_X86_KERNELS
+    static inline unsigned count_trailing_zeros(uint32_t mask) {
+#    ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return unsigned(index);
+#    else
+        return unsigned(__builtin_ctz(mask));
+#    endif
+    }
+
+    // Whole text (at most 15 characters) is classified at once: one
+    // comparison finds dots, two more validate that everything else is a
+    // digit. Octet boundaries are then read off dot mask with bit scans
+    // and octets are decoded without branching on their length, as
+    // lengths of real-world addresses are hard to predict.
+    LIBWIRE_TARGET("sse2")
+    bool parse_ipv4_sse2(const char* text, size_t size, uint8_t* output) noexcept {
+        if (size < 7 || size > ipv4_text_max) return false;
+
+        // Copy to avoid reading past end of text. Two overlapping
+        // fixed-size copies are cheaper than memcpy of variable size.
+        alignas(16) char block[16] = {};
+        if (size >= 8) {
+            std::memcpy(block, text, 8);
+            std::memcpy(block + size - 8, text + size - 8, 8);
+        } else {
+            std::memcpy(block, text, 4);
+            std::memcpy(block + size - 4, text + size - 4, 4);
+        }
+
+        __m128i chars = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+        // Unsigned digits < 10 via signed comparison of biased values.
+        __m128i digit_flags = _mm_cmplt_epi8(_mm_xor_si128(digits, _mm_set1_epi8(char(0x80))),
+                                             _mm_set1_epi8(char(0x80 + 10)));
+        __m128i dot_flags = _mm_cmpeq_epi8(chars, _mm_set1_epi8('.'));
+
+        uint32_t used = (1u << size) - 1;
+        auto digit_mask = uint32_t(_mm_movemask_epi8(digit_flags)) & used;
+        auto dot_mask = uint32_t(_mm_movemask_epi8(dot_flags)) & used;
+        if ((digit_mask | dot_mask) != used) return false;
+
+        // Three zero bytes in front, so up to three digits before any dot
+        // can be read unconditionally. Dots become zeros too.
+        alignas(16) uint8_t values[32] = {};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 3), _mm_and_si128(digits, digit_flags));
+
+        // Position of each dot plus one past last character.
+        unsigned ends[4];
+        for (int dot = 0; dot < 3; ++dot) {
+            ends[dot] = dot_mask != 0 ? count_trailing_zeros(dot_mask) : unsigned(size);
+            dot_mask &= dot_mask - 1;
+        }
+        ends[3] = unsigned(size);
+        // Exactly three dots.
+        bool invalid = dot_mask != 0 || ends[2] == size;
+
+        unsigned start = 0;
+        for (int octet = 0; octet < 4; ++octet) {
+            unsigned end = ends[octet];
+            unsigned length = end - start;
+            const uint8_t* last = values + 3 + end - 1;
+            unsigned value = last[0] + 10u * last[-1] * (length >= 2) + 100u * last[-2] * (length >= 3);
+
+            // Empty, too long or with leading zero.
+            invalid |= length - 1 > 2 || (length >= 2 && values[3 + start] == 0) || value > 255;
+            output[octet] = uint8_t(value);
+            start = end + 1;
+        }
+        return !invalid;
+    }
+#endif
+
+    bool parse_ipv4(const char* text, size_t size, uint8_t* output) noexcept {
+#ifdef LIBWIRE_X86_KERNELS
+        return parse_ipv4_sse2(text, size, output);
+#else
+        return parse_ipv4_scalar(text, size, output);
+#endif
+    }
+
+    char* format_ipv4(const uint8_t* input, char* output) noexcept {
+        for (int octet = 0; octet < 4; ++octet) {
+            unsigned value = input[octet];
+            if (value >= 100) {
+                *output++ = char('0' + value / 100);
+                value %= 100;
+                *output++ = char('0' + value / 10);
+            } else if (value >= 10) {
+                *output++ = char('0' + value / 10);
+            }
+            *output++ = char('0' + value % 10);
+            if (octet != 3) *output++ = '.';
+        }
+        return output;
+    }
+
+    char* format_ipv6(const uint8_t* input, char* output) noexcept {
+        static constexpr char hex_digits[] = "0123456789abcdef";
+
+        unsigned words[8];
+        for (int i = 0; i < 8; ++i) words[i] = unsigned(input[i * 2]) << 8 | input[i * 2 + 1];
+
+        // Longest run of zero words (first one if there are several),
+        // replaced with "::" if it's at least two words long.
+        int best_start = -1, best_length = 0;
+        for (int i = 0; i < 8;) {
+            if (words[i] != 0) {
+                ++i;
+                continue;
+            }
+            int start = i;
+            while (i < 8 && words[i] == 0) ++i;
+            if (i - start > best_length) {
+                best_start = start;
+                best_length = i - start;
+            }
+        }
+        if (best_length < 2) best_start = -1;
+
+        for (int i = 0; i < 8; ++i) {
+            if (best_start >= 0 && i >= best_start && i < best_start + best_length) {
+                if (i == best_start) *output++ = ':';
+                continue;
+            }
+            if (i != 0) *output++ = ':';
+
+            // IPv4-compatible and IPv4-mapped addresses end with
+            // dotted-quad, same as inet_ntop does.
+            if (i == 6 && best_start == 0 && (best_length == 6 || (best_length == 5 && words[5] == 0xffff))) {
+                return format_ipv4(input + 12, output);
+            }
+
+            unsigned word = words[i];
+            int shift = word >= 0x1000 ? 12 : word >= 0x100 ? 8 : word >= 0x10 ? 4 : 0;
+            for (; shift >= 0; shift -= 4) *output++ = hex_digits[(word >> unsigned(shift)) & 0xf];
+        }
+        if (best_start >= 0 && best_start + best_length == 8) *output++ = ':';
+        return output;
+    }
+} // namespace libwire::internal_
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/internal/dns_message.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace libwire::internal_ {
+    namespace {
+        constexpr uint16_t class_internet = 1;
+        constexpr size_t max_name_text = 253;
+
+        inline uint16_t load16(const uint8_t* bytes) noexcept {
+            return uint16_t((bytes[0] << 8u) | bytes[1]);
+        }
+
+        inline uint32_t load32(const uint8_t* bytes) noexcept {
+            return (uint32_t(bytes[0]) << 24u) | (uint32_t(bytes[1]) << 16u) | (uint32_t(bytes[2]) << 8u) | bytes[3];
+        }
+
+        inline uint8_t* store16(uint8_t* output, uint16_t value) noexcept {
+            output[0] = uint8_t(value >> 8u);
+            output[1] = uint8_t(value);
+            return output + 2;
+        }
+
+        inline char ascii_lower(char ch) noexcept {
+            return (ch >= 'A' && ch <= 'Z') ? char(ch | 0x20) : ch;
+        }
+
+        // RFC 2181, section 8: values with most significant bit set
+        // should be treated as zero.
+        inline uint32_t sanitize_ttl(uint32_t ttl) noexcept {
+            return (ttl & 0x80000000u) != 0 ? 0 : ttl;
+        }
+
+        /*
+         * Decode possibly compressed name at offset into lowercase dotted
+         * text without trailing dot, offset is moved past name.
+         *
+         * Pointers must point strictly backward, so chain of pointers
+         * can't loop, and every cycle through labels makes name longer
+         * until it hits length limit.
+         */
+        bool read_name(const uint8_t* message, size_t size, size_t& offset, std::string& output) {
+            output.clear();
+            size_t position = offset;
+            bool jumped = false;
+            for (;;) {
+                if (position >= size) return false;
+                uint8_t length = message[position];
+
+                if ((length & 0xc0) == 0xc0) {
+                    if (position + 1 >= size) return false;
+                    size_t target = (size_t(length & 0x3f) << 8u) | message[position + 1];
+                    if (target >= position) return false;
+                    if (!jumped) offset = position + 2;
+                    jumped = true;
+                    position = target;
+                    continue;
+                }
+                if ((length & 0xc0) != 0) return false;
+
+                ++position;
+                if (length == 0) break;
+                if (position + length > size) return false;
+                if (!output.empty()) output.push_back('.');
+                for (size_t i = 0; i < length; ++i) output.push_back(ascii_lower(char(message[position + i])));
+                if (output.size() > max_name_text) return false;
+                position += length;
+            }
+            if (!jumped) offset = position;
+            return true;
+        }
+
+        std::string normalize_name(std::string_view name) {
+            if (!name.empty() && name.back() == '.') name.remove_suffix(1);
+            std::string result(name);
+            std::transform(result.begin(), result.end(), result.begin(), ascii_lower);
+            return result;
+        }
+
+        struct address_record {
+            std::string owner;
+            address value;
+            uint32_t ttl;
+        };
+
+        struct cname_record {
+            std::string owner, target;
+            uint32_t ttl;
+        };
+    } // namespace
+
+    size_t dns_write_query(uint16_t id, std::string_view name, dns_type type, uint8_t* output) noexcept {
+        if (!name.empty() && name.back() == '.') name.remove_suffix(1);
+        if (name.empty() || name.size() > max_name_text) return 0;
+
+        // Recursion desired, one question and one additional record (OPT).
+        const uint8_t header[dns_header_size] = {uint8_t(id >> 8u), uint8_t(id), 0x01, 0, 0, 1, 0, 0, 0, 0, 0, 1};
+        std::memcpy(output, header, sizeof(header));
+        uint8_t* out = output + dns_header_size;
+
+        size_t label_start = 0;
+        for (;;) {
+            size_t label_end = std::min(name.find('.', label_start), name.size());
+            size_t length = label_end - label_start;
+            if (length == 0 || length > 63) return 0;
+            *out++ = uint8_t(length);
+            std::memcpy(out, name.data() + label_start, length);
+            out += length;
+            if (label_end == name.size()) break;
+            label_start = label_end + 1;
+        }
+        *out++ = 0;
+        out = store16(out, uint16_t(type));
+        out = store16(out, class_internet);
+
+        // OPT pseudo-record: root owner, payload size in class field,
+        // zero extended rcode, version and flags, no options.
+        *out++ = 0;
+        out = store16(out, uint16_t(dns_type::opt));
+        out = store16(out, dns_udp_payload_size);
+        const uint8_t opt_tail[6] = {};
+        std::memcpy(out, opt_tail, sizeof(opt_tail));
+        out += sizeof(opt_tail);
+
+        return size_t(out - output);
+    }
+
+    bool dns_read_reply(const uint8_t* message, size_t size, std::string_view name, dns_type type,
+                        dns_reply& reply) {
+        reply = dns_reply();
+        if (size < dns_header_size) return false;
+
+        uint16_t flags = load16(message + 2);
+        // Must be response (QR) to standard query (opcode 0).
+        if ((flags & 0x8000u) == 0 || (flags & 0x7800u) != 0) return false;
+        reply.rcode = uint8_t(flags & 0x0fu);
+        reply.truncated = (flags & 0x0200u) != 0;
+
+        uint16_t question_count = load16(message + 4), answer_count = load16(message + 6),
+                 authority_count = load16(message + 8);
+        if (question_count != 1) return false;
+
+        std::string expected = normalize_name(name), owner;
+        size_t offset = dns_header_size;
+        if (!read_name(message, size, offset, owner) || owner != expected) return false;
+        if (offset + 4 > size) return false;
+        if (load16(message + offset) != uint16_t(type) || load16(message + offset + 2) != class_internet) {
+            return false;
+        }
+        offset += 4;
+
+        if (reply.truncated) return true;
+
+        size_t address_size = type == dns_type::a ? 4 : 16;
+        std::vector<address_record> addresses;
+        std::vector<cname_record> cnames;
+        bool have_soa = false;
+        uint32_t negative_ttl = 0;
+
+        for (size_t i = 0; i < size_t(answer_count) + authority_count; ++i) {
+            if (!read_name(message, size, offset, owner)) return false;
+            if (offset + 10 > size) return false;
+            auto record_type = dns_type(load16(message + offset));
+            uint16_t record_class = load16(message + offset + 2);
+            uint32_t ttl = sanitize_ttl(load32(message + offset + 4));
+            uint16_t data_size = load16(message + offset + 8);
+            offset += 10;
+            if (offset + data_size > size) return false;
+            const uint8_t* data = message + offset;
+
+            if (record_class == class_internet) {
+                if (i < answer_count) {
+                    if (record_type == type && data_size == address_size) {
+                        addresses.push_back({owner, address(memory_view(const_cast<uint8_t*>(data), data_size)), ttl});
+                    } else if (record_type == dns_type::cname) {
+                        size_t target_offset = offset;
+                        cname_record record{owner, {}, ttl};
+                        if (!read_name(message, offset + data_size, target_offset, record.target)) return false;
+                        cnames.push_back(std::move(record));
+                    }
+                } else if (record_type == dns_type::soa && data_size >= 22 && !have_soa) {
+                    // RFC 2308, section 5: minimum of SOA TTL and MINIMUM field.
+                    negative_ttl = std::min(ttl, sanitize_ttl(load32(data + data_size - 4)));
+                    have_soa = true;
+                }
+            }
+            offset += data_size;
+        }
+
+        std::string_view target = expected;
+        uint32_t chain_ttl = UINT32_MAX;
+        for (unsigned hops = 0; hops < dns_max_cname_chain; ++hops) {
+            auto next = std::find_if(cnames.begin(), cnames.end(),
+                                     [&](const cname_record& record) { return record.owner == target; });
+            if (next == cnames.end()) break;
+            chain_ttl = std::min(chain_ttl, next->ttl);
+            target = next->target;
+        }
+
+        reply.ttl = chain_ttl;
+        for (const address_record& record : addresses) {
+            if (record.owner != target) continue;
+            reply.addresses.push_back(record.value);
+            reply.ttl = std::min(reply.ttl, record.ttl);
+        }
+        if (reply.addresses.empty()) reply.ttl = have_soa ? std::min(chain_ttl, negative_ttl) : 0;
+        return true;
+    }
+} // namespace libwire::internal_
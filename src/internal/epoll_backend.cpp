@@ -0,0 +1,264 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include "libwire/internal/io_backend.hpp"
+
+#include <cassert>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "libwire/internal/socket_utils.hpp"
+
+namespace libwire::internal_ {
+    namespace {
+        /**
+         * Operations queued on one file descriptor.
+         *
+         * Descriptor is registered in epoll with EPOLLONESHOT so only one
+         * thread can handle readiness event at a time, it's rearmed after
+         * processing if there are operations left.
+         *
+         * Objects are never freed before backend destruction because
+         * events with pointer to it can be still processed by other threads.
+         */
+        struct descriptor_state {
+            std::mutex mutex;
+            int fd = -1;
+
+            /// Incremented by cancel, multishot operations started before
+            /// it are not restarted.
+            uint32_t generation = 0;
+
+            op_queue read_ops;
+            op_queue write_ops;
+        };
+
+        /**
+         * Perform queued operations in order while they complete.
+         */
+        void perform_queue(op_queue& queue, op_queue& completed) noexcept {
+            while (!queue.empty()) {
+                if (!queue.front()->perform()) return;
+                completed.push(queue.pop());
+            }
+        }
+
+        void fail_queue(op_queue& queue, std::error_code ec, op_queue& completed) noexcept {
+            while (!queue.empty()) {
+                io_operation* op = queue.pop();
+                op->ec = ec;
+                completed.push(op);
+            }
+        }
+
+        void destroy_queue(op_queue& queue) noexcept {
+            while (!queue.empty()) delete queue.pop();
+        }
+
+        class epoll_backend final : public io_backend {
+        public:
+            epoll_backend(io_context& owner, std::error_code& ec) noexcept : io_backend(owner) {
+                epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+                if (epoll_fd_ == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                interrupter_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (interrupter_fd_ == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                // Edge-triggered, so every write wakes up some thread and
+                // we never need to read it.
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLET;
+                event.data.ptr = nullptr;
+                if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, interrupter_fd_, &event) == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                }
+            }
+
+            ~epoll_backend() override {
+                for (auto& descriptor : descriptors_) {
+                    if (!descriptor) continue;
+                    destroy_queue(descriptor->read_ops);
+                    destroy_queue(descriptor->write_ops);
+                }
+                if (interrupter_fd_ != -1) close(interrupter_fd_);
+                if (epoll_fd_ != -1) close(epoll_fd_);
+            }
+
+            void start(socket& socket, io_operation* op, io_direction dir) override {
+                descriptor_state& descriptor = *this->descriptor(socket.handle);
+                std::lock_guard lock(descriptor.mutex);
+
+                if (!op->restarted) {
+                    op->backend_data = descriptor.generation;
+                } else if (op->backend_data != descriptor.generation) {
+                    // Canceled while handler of previous result was running.
+                    op->ec = std::error_code(ECANCELED, error::system_category());
+                    post(op);
+                    return;
+                }
+
+                op_queue& queue = dir == io_direction::read ? descriptor.read_ops : descriptor.write_ops;
+
+                // Try to complete operation right now, usually it saves one epoll round trip.
+                if (queue.empty() && op->perform()) {
+                    post(op);
+                    return;
+                }
+
+                queue.push(op);
+                std::error_code ec;
+                arm(descriptor, ec);
+                if (ec) {
+                    op_queue failed;
+                    fail_queue(descriptor.read_ops, ec, failed);
+                    fail_queue(descriptor.write_ops, ec, failed);
+                    while (!failed.empty()) post(failed.pop());
+                }
+            }
+
+            void cancel(socket::native_handle_t handle) noexcept override {
+                descriptor_state* descriptor = nullptr;
+                {
+                    std::lock_guard lock(registry_mutex_);
+                    if (handle < 0 || size_t(handle) >= descriptors_.size()) return;
+                    descriptor = descriptors_[size_t(handle)].get();
+                }
+                if (descriptor == nullptr) return;
+
+                op_queue canceled;
+                {
+                    std::lock_guard lock(descriptor->mutex);
+                    ++descriptor->generation;
+                    std::error_code ec(ECANCELED, error::system_category());
+                    fail_queue(descriptor->read_ops, ec, canceled);
+                    fail_queue(descriptor->write_ops, ec, canceled);
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, descriptor->fd, nullptr);
+                }
+                while (!canceled.empty()) post(canceled.pop());
+            }
+
+            void cancel_operation(io_operation* op) noexcept override {
+                descriptor_state* descriptor = nullptr;
+                {
+                    std::lock_guard lock(registry_mutex_);
+                    if (op->handle < 0 || size_t(op->handle) >= descriptors_.size()) return;
+                    descriptor = descriptors_[size_t(op->handle)].get();
+                }
+                if (descriptor == nullptr) return;
+
+                {
+                    std::lock_guard lock(descriptor->mutex);
+                    if (!descriptor->read_ops.remove(op) && !descriptor->write_ops.remove(op)) return;
+                }
+                // Descriptor stays armed, event for empty queues is just ignored.
+                op->ec = std::error_code(ECANCELED, error::system_category());
+                post(op);
+            }
+
+            void wait(int timeout, op_queue& completed) override {
+                epoll_event events[128];
+                int count = epoll_wait(epoll_fd_, events, 128, timeout);
+                for (int i = 0; i < count; ++i) {
+                    if (events[i].data.ptr == nullptr) continue; // interrupter
+                    process(*static_cast<descriptor_state*>(events[i].data.ptr), events[i].events, completed);
+                }
+
+                // Other threads sleep in epoll_wait and don't look at shared
+                // queue, each interrupter write is new edge and wakes one.
+                for (size_t woken = share(completed); woken != 0; --woken) interrupt();
+            }
+
+            void interrupt() noexcept override {
+                uint64_t one = 1;
+                [[maybe_unused]] ssize_t status = write(interrupter_fd_, &one, sizeof(one));
+            }
+
+        private:
+            descriptor_state* descriptor(socket::native_handle_t handle) {
+                assert(handle >= 0);
+
+                std::lock_guard lock(registry_mutex_);
+                if (size_t(handle) >= descriptors_.size()) descriptors_.resize(size_t(handle) + 1);
+                auto& descriptor = descriptors_[size_t(handle)];
+                if (!descriptor) {
+                    descriptor = std::make_unique<descriptor_state>();
+                    descriptor->fd = handle;
+                }
+                return descriptor.get();
+            }
+
+            void arm(descriptor_state& descriptor, std::error_code& ec) noexcept {
+                epoll_event event{};
+                event.events = EPOLLONESHOT;
+                if (!descriptor.read_ops.empty()) event.events |= EPOLLIN | EPOLLRDHUP;
+                if (!descriptor.write_ops.empty()) event.events |= EPOLLOUT;
+                event.data.ptr = &descriptor;
+
+                // Descriptor may be not registered yet, or it was closed and
+                // number reused, in both cases kernel forgot about it.
+                if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, descriptor.fd, &event) == -1) {
+                    if (errno != ENOENT || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, descriptor.fd, &event) == -1) {
+                        ec = std::error_code(errno, error::system_category());
+                    }
+                }
+            }
+
+            void process(descriptor_state& descriptor, uint32_t events, op_queue& completed) noexcept {
+                std::lock_guard lock(descriptor.mutex);
+
+                if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) != 0) {
+                    perform_queue(descriptor.read_ops, completed);
+                }
+                if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0) perform_queue(descriptor.write_ops, completed);
+
+                if (descriptor.read_ops.empty() && descriptor.write_ops.empty()) return;
+
+                std::error_code ec;
+                arm(descriptor, ec);
+                if (ec) {
+                    fail_queue(descriptor.read_ops, ec, completed);
+                    fail_queue(descriptor.write_ops, ec, completed);
+                }
+            }
+
+            int epoll_fd_ = -1;
+            int interrupter_fd_ = -1;
+
+            std::mutex registry_mutex_;
+            std::vector<std::unique_ptr<descriptor_state>> descriptors_;
+        };
+    } // namespace
+
+    std::unique_ptr<io_backend> make_epoll_backend(io_context& owner, std::error_code& ec) {
+        return std::make_unique<epoll_backend>(owner, ec);
+    }
+} // namespace libwire::internal_
+
+#endif // ifdef __linux__
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/internal/frame_pool.hpp"
+
+#include <new>
+
+namespace libwire::internal_ {
+    frame_pool::~frame_pool() {
+        for (free_block* block : free_) {
+            while (block != nullptr) {
+                free_block* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+    }
+
+    void* frame_pool::allocate(frame_pool* pool, size_t size) {
+        size_t size_class = (size + sizeof(header) + granularity - 1) / granularity;
+        if (size_class >= size_classes) pool = nullptr;
+
+        void* block = nullptr;
+        if (pool != nullptr) {
+            std::lock_guard lock(pool->mutex_);
+            free_block*& head = pool->free_[size_class];
+            if (head != nullptr) {
+                block = head;
+                head = head->next;
+            }
+        }
+        if (block == nullptr) {
+            // Pooled blocks are allocated with size of whole class, so they
+            // can be reused for any object from it.
+            block = ::operator new(pool != nullptr ? size_class * granularity : size + sizeof(header));
+        }
+
+        static_cast<header*>(block)->pool = pool;
+        static_cast<header*>(block)->size_class = size_class;
+        return static_cast<header*>(block) + 1;
+    }
+
+    void frame_pool::deallocate(void* pointer) noexcept {
+        header* block = static_cast<header*>(pointer) - 1;
+        frame_pool* pool = block->pool;
+        if (pool == nullptr) {
+            ::operator delete(block);
+            return;
+        }
+
+        size_t size_class = block->size_class;
+        auto* freed = reinterpret_cast<free_block*>(block);
+        std::lock_guard lock(pool->mutex_);
+        freed->next = pool->free_[size_class];
+        pool->free_[size_class] = freed;
+    }
+} // namespace libwire::internal_
@@ -0,0 +1,172 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/internal/search.hpp"
+
+#include <cstring>
+
+#ifdef LIBWIRE_X86_KERNELS
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    endif
+#    include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define LIBWIRE_TARGET(isa) __attribute__((target(isa)))
+#else
+#    define LIBWIRE_TARGET(isa)
+#endif
+
+namespace libwire::internal_ {
+    // First and last bytes are already checked by SIMD filter.
+    static inline bool middle_matches(const uint8_t* candidate, const uint8_t* needle, size_t needle_size) {
+        return needle_size <= 2 || std::memcmp(candidate + 1, needle + 1, needle_size - 2) == 0;
+    }
+
+    static inline unsigned count_trailing_zeros(uint32_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return unsigned(index);
+#else
+        return unsigned(__builtin_ctz(mask));
+#endif
+    }
+
+    size_t search_scalar(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                         size_t needle_size) noexcept {
+        if (needle_size > haystack_size) return haystack_size;
+
+        // Last position where needle can start + 1.
+        const uint8_t* end = haystack + haystack_size - needle_size + 1;
+        const uint8_t* current = haystack;
+        while (current < end) {
+            current = static_cast<const uint8_t*>(std::memchr(current, needle[0], size_t(end - current)));
+            if (current == nullptr) return haystack_size;
+            if (std::memcmp(current + 1, needle + 1, needle_size - 1) == 0) return size_t(current - haystack);
+            ++current;
+        }
+        return haystack_size;
+    }
+
+#ifdef LIBWIRE_X86_KERNELS
+    // Both kernels use "generic SIMD" approach described by Wojciech Muła
+    // (http://0x80.pl/articles/simd-strfind.html): block of haystack is
+    // compared against first needle byte, block shifted by needle_size - 1
+    // is compared against last needle byte, full comparison is done
+    // only for positions where both matched.
+
+    LIBWIRE_TARGET("sse2")
+    size_t search_sse2(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                       size_t needle_size) noexcept {
+        if (needle_size > haystack_size) return haystack_size;
+
+        const __m128i first = _mm_set1_epi8(char(needle[0]));
+        const __m128i last = _mm_set1_epi8(char(needle[needle_size - 1]));
+
+        size_t i = 0;
+        for (; i + needle_size - 1 + 16 <= haystack_size; i += 16) {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+            __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needle_size - 1));
+
+            auto mask = uint32_t(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+            while (mask != 0) {
+                unsigned bit = count_trailing_zeros(mask);
+                if (middle_matches(haystack + i + bit, needle, needle_size)) return i + bit;
+                mask &= mask - 1;
+            }
+        }
+
+        return i + search_scalar(haystack + i, haystack_size - i, needle, needle_size);
+    }
+
+    LIBWIRE_TARGET("avx2")
+    size_t search_avx2(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle,
+                       size_t needle_size) noexcept {
+        if (needle_size > haystack_size) return haystack_size;
+
+        const __m256i first = _mm256_set1_epi8(char(needle[0]));
+        const __m256i last = _mm256_set1_epi8(char(needle[needle_size - 1]));
+
+        size_t i = 0;
+        for (; i + needle_size - 1 + 32 <= haystack_size; i += 32) {
+            __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+            __m256i block_last =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needle_size - 1));
+
+            auto mask = uint32_t(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+            while (mask != 0) {
+                unsigned bit = count_trailing_zeros(mask);
+                if (middle_matches(haystack + i + bit, needle, needle_size)) return i + bit;
+                mask &= mask - 1;
+            }
+        }
+
+        return i + search_sse2(haystack + i, haystack_size - i, needle, needle_size);
+    }
+
+    bool search_avx2_supported() noexcept {
+#    ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#    else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#    endif
+    }
+#endif // ifdef LIBWIRE_X86_KERNELS
+
+    namespace {
+        struct search_kernel_info {
+            size_t (*function)(const uint8_t*, size_t, const uint8_t*, size_t) noexcept;
+            const char* name;
+        };
+
+        search_kernel_info pick_search_kernel() noexcept {
+#ifdef LIBWIRE_X86_KERNELS
+            if (search_avx2_supported()) return {search_avx2, "avx2"};
+            return {search_sse2, "sse2"};
+#else
+            return {search_scalar, "scalar"};
+#endif
+        }
+
+        const search_kernel_info& active_search_kernel() noexcept {
+            static const search_kernel_info kernel = pick_search_kernel();
+            return kernel;
+        }
+    } // namespace
+
+    size_t search(const uint8_t* haystack, size_t haystack_size, const uint8_t* needle, size_t needle_size) noexcept {
+        return active_search_kernel().function(haystack, haystack_size, needle, needle_size);
+    }
+
+    const char* search_kernel() noexcept {
+        return active_search_kernel().name;
+    }
+} // namespace libwire::internal_
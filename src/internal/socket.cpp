@@ -1,7 +1,10 @@
 #include "libwire/internal/socket.hpp"
 
 #include <cassert>
+#include <algorithm>
+#include <cstring>
 #include <optional>
+#include <vector>
 #include "libwire/internal/socket_utils.hpp"
 #include "libwire/internal/endianess.hpp"
 #include "libwire/error.hpp"
@@ -14,12 +17,27 @@
 #    define close closesocket
 #    define ssize_t int64_t
 #else
+#    include <climits>
+#    include <csignal>
+#    include <ctime>
+#    include <fcntl.h>
+#    include <poll.h>
 #    include <unistd.h>
 #    include <sys/socket.h>
+#    include <sys/uio.h>
 #    include <netinet/ip.h>
+#    ifdef __linux__
+#        include <sys/sendfile.h>
+#        include <linux/errqueue.h>
+#        include <netinet/udp.h>
+#    endif
 #    define INVALID_SOCKET (-1)
 #endif
 
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#    define LIBWIRE_ZERO_COPY
+#endif
+
 namespace libwire::internal_ {
 #ifdef _WIN32
     struct Initializer {
@@ -71,14 +89,39 @@ namespace libwire::internal_ {
         int one = 1;
         setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
 #endif
+        state.ipv6 = handle != not_initialized && ipver == ip::v6;
+    }
+
+    socket::socket(dual_stack_t, transport transport, std::error_code& ec) noexcept : socket(ip::v6, transport, ec) {
+        if (ec) return;
+
+        // Linux is dual-stack by default (net.ipv6.bindv6only = 0), but
+        // this is system-wide setting and other systems differ.
+        int value = 0;
+        if (setsockopt(handle, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&value), sizeof(value)) != 0) {
+            ec = std::error_code(last_socket_error(), error::system_category());
+            *this = socket();
+        }
+    }
+
+    socket::socket(native_handle_t handle, ip ip_version, transport transport_protocol,
+                   const sockaddr_storage& peer_address) noexcept
+        : ip_version(ip_version), transport_protocol(transport_protocol), peer(sockaddr_to_endpoint(peer_address)),
+          handle(handle) {
     }
 
     socket::socket(socket&& o) noexcept {
         std::swap(o.handle, this->handle);
+        std::swap(o.state, this->state);
+        std::swap(o.zero_copy_next_id, this->zero_copy_next_id);
+        std::swap(o.peer, this->peer);
     }
 
     socket& socket::operator=(socket&& o) noexcept {
         std::swap(o.handle, this->handle);
+        std::swap(o.state, this->state);
+        std::swap(o.zero_copy_next_id, this->zero_copy_next_id);
+        std::swap(o.peer, this->peer);
         return *this;
     }
 
@@ -98,20 +141,39 @@ namespace libwire::internal_ {
         ::shutdown(handle, how);
     }
 
+    /**
+     * IPv6 socket accepts IPv4 endpoint only as IPv4-mapped address,
+     * mapped is used as storage for converted endpoint.
+     */
+    static const endpoint& native_endpoint(const socket& sock, const endpoint& in, endpoint& mapped) noexcept {
+        if (!sock.state.ipv6 || in.version() != ip::v4) return in;
+        mapped = in.v4_mapped();
+        return mapped;
+    }
+
     void socket::connect(address target, uint16_t port, std::error_code& ec) noexcept {
-        assert(handle != not_initialized);
+        connect(endpoint(target, port), ec);
+    }
 
-        sockaddr_storage address = endpoint_to_sockaddr({target, port});
+    void socket::connect(const endpoint& target, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
 
-        error_wrapper(ec, ::connect, handle, reinterpret_cast<sockaddr*>(&address), socklen_t(sizeof(address)));
+        endpoint mapped;
+        const endpoint& native = native_endpoint(*this, target, mapped);
+        error_wrapper(ec, ::connect, handle, native.data(), native.size());
+        if (!ec) peer = target;
     }
 
     void socket::bind(uint16_t port, address interface_address, std::error_code& ec) noexcept {
+        bind(endpoint(interface_address, port), ec);
+    }
+
+    void socket::bind(const endpoint& local, std::error_code& ec) noexcept {
         assert(handle != not_initialized);
 
-        // sockaddr doesn't have enough space to store sockaddr_in6 but we don't care
-        sockaddr_storage address = endpoint_to_sockaddr({interface_address, port});
-        error_wrapper(ec, ::bind, handle, reinterpret_cast<sockaddr*>(&address), socklen_t(sizeof(address)));
+        endpoint mapped;
+        const endpoint& native = native_endpoint(*this, local, mapped);
+        error_wrapper(ec, ::bind, handle, native.data(), native.size());
     }
 
     void socket::listen(int backlog, std::error_code& ec) noexcept {
@@ -120,22 +182,82 @@ namespace libwire::internal_ {
         error_wrapper(ec, ::listen, handle, backlog);
     }
 
-    socket socket::accept(std::error_code& ec) noexcept {
+    socket socket::accept(std::error_code& ec, bool non_blocking, const peer_filter* filter) noexcept {
         assert(handle != not_initialized);
 
-        int accepted_fd = ::accept(handle, nullptr, nullptr);
-        // TODO (PR's welcomed): Allow to get client address.
+        socket accepted = try_accept(ec, non_blocking, filter);
+        // Listener may be non-blocking only internally (e.g. after accept_many),
+        // wait for connection ourselves then.
+        while (ec == error::try_again && state.internal_non_blocking && !state.user_non_blocking) {
+#ifdef _WIN32
+            WSAPOLLFD descriptor{handle, POLLRDNORM, 0};
+            int status = WSAPoll(&descriptor, 1, -1);
+#else
+            pollfd descriptor{handle, POLLIN, 0};
+            int status = poll(&descriptor, 1, -1);
+#endif
+            if (status < 0 && last_socket_error() != EINTR) {
+                ec = std::error_code(last_socket_error(), error::system_category());
+                break;
+            }
+            ec.clear();
+            accepted = try_accept(ec, non_blocking, filter);
+        }
+        return accepted;
+    }
+
+    socket socket::try_accept(std::error_code& ec, bool non_blocking, const peer_filter* filter) noexcept {
+        assert(handle != not_initialized);
+
+        sockaddr_storage peer_address{};
+        native_handle_t accepted_fd = INVALID_SOCKET;
+        for (;;) {
+            socklen_t length = sizeof(peer_address);
+#ifdef __linux__
+            // Flags are set by the same system call so there is no window where
+            // descriptor can leak to exec'ed child or be used in wrong mode.
+            int flags = SOCK_CLOEXEC | (non_blocking ? SOCK_NONBLOCK : 0); // NOLINT(hicpp-signed-bitwise)
+            accepted_fd = ::accept4(handle, reinterpret_cast<sockaddr*>(&peer_address), &length, flags);
+#else
+            accepted_fd = ::accept(handle, reinterpret_cast<sockaddr*>(&peer_address), &length);
+#endif
 
-        if (accepted_fd == INVALID_SOCKET) {
-            if (last_socket_error() == EINTR) {
-                return accept(ec);
+            if (accepted_fd == INVALID_SOCKET) {
+                if (last_socket_error() == EINTR) continue;
+                ec = std::error_code(last_socket_error(), error::system_category());
+                assert(ec != error::unexpected);
+                return socket();
             }
-            ec = std::error_code(last_socket_error(), error::system_category());
-            assert(ec != error::unexpected);
-            return socket();
+
+            if (filter == nullptr) break;
+            endpoint peer(reinterpret_cast<const sockaddr*>(&peer_address), length);
+            if (state.ipv6) peer.unmap();
+            if ((*filter)(peer)) break;
+            // Rejected before anything is set up for connection.
+            close(accepted_fd);
         }
 
-        return socket(accepted_fd, this->ip_version, this->transport_protocol);
+        socket accepted(accepted_fd, this->ip_version, this->transport_protocol, peer_address);
+        accepted.state.ipv6 = state.ipv6;
+
+        if (non_blocking) {
+#if defined(_WIN32)
+            unsigned long mode = 1;
+            if (ioctlsocket(accepted_fd, FIONBIO, &mode) != 0) {
+                ec = std::error_code(last_socket_error(), error::system_category());
+                return socket();
+            }
+#elif !defined(__linux__)
+            int fd_flags = fcntl(accepted_fd, F_GETFL, 0); // NOLINT(hicpp-vararg)
+            if (fd_flags == -1 || fcntl(accepted_fd, F_SETFL, fd_flags | O_NONBLOCK) == -1) { // NOLINT(hicpp-vararg)
+                ec = std::error_code(last_socket_error(), error::system_category());
+                return socket();
+            }
+#endif
+            accepted.state.user_non_blocking = true;
+            accepted.state.internal_non_blocking = true;
+        }
+        return accepted;
     }
 
 #ifdef MSG_NOSIGNAL
@@ -149,7 +271,7 @@ namespace libwire::internal_ {
 
         ssize_t actually_written =
             error_wrapper(ec, ::send, handle, reinterpret_cast<const char*>(input), length_bytes, NO_SIGPIPE);
-        return size_t(actually_written);
+        return actually_written < 0 ? 0 : size_t(actually_written);
     }
 
     size_t socket::read(void* output, size_t length_bytes, std::error_code& ec) noexcept {
@@ -180,6 +302,483 @@ namespace libwire::internal_ {
         return size_t(actually_read);
     }
 
+    size_t socket::read_some(void* output, size_t length_bytes, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+        if (length_bytes == 0) {
+            return 0;
+        }
+
+        ssize_t actually_read =
+            error_wrapper(ec, recv, handle, reinterpret_cast<char*>(output), length_bytes, NO_SIGPIPE);
+
+        if (actually_read == 0) {
+            ec = std::error_code(EOF, error::system_category());
+        }
+
+        if (actually_read == -1) {
+            return 0;
+        }
+
+        return size_t(actually_read);
+    }
+
+    size_t socket::peek(void* output, size_t length_bytes, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+        if (length_bytes == 0) {
+            return 0;
+        }
+
+        ssize_t actually_read =
+            error_wrapper(ec, recv, handle, reinterpret_cast<char*>(output), length_bytes, NO_SIGPIPE | MSG_PEEK);
+
+        if (actually_read == 0) {
+            ec = std::error_code(EOF, error::system_category());
+        }
+
+        if (actually_read == -1) {
+            return 0;
+        }
+
+        return size_t(actually_read);
+    }
+
+    void socket::make_internal_non_blocking(std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+        if (state.internal_non_blocking) return;
+
+#ifdef _WIN32
+        unsigned long mode = 1;
+        if (ioctlsocket(handle, FIONBIO, &mode) != 0) {
+            ec = std::error_code(last_socket_error(), error::system_category());
+            return;
+        }
+#else
+        int flags = fcntl(handle, F_GETFL, 0); // NOLINT(hicpp-vararg)
+        if (flags == -1 || fcntl(handle, F_SETFL, flags | O_NONBLOCK) == -1) { // NOLINT(hicpp-vararg)
+            ec = std::error_code(errno, error::system_category());
+            return;
+        }
+#endif
+        state.internal_non_blocking = true;
+    }
+
+    bool socket::idle_usable() const noexcept {
+        assert(handle != not_initialized);
+#ifdef _WIN32
+        // Readable socket has either data or EOF pending, both mean
+        // that connection can't be reused.
+        WSAPOLLFD descriptor{handle, POLLRDNORM, 0};
+        return WSAPoll(&descriptor, 1, 0) == 0;
+#else
+        char byte;
+        ssize_t status = recv(handle, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        return status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+    }
+
+    namespace {
+#ifdef _WIN32
+        using io_vector = WSABUF;
+
+        constexpr size_t max_io_vectors = 1024;
+
+        void assign(io_vector& vector, const void* data, size_t size) {
+            vector.buf = const_cast<char*>(static_cast<const char*>(data));
+            vector.len = ULONG(size);
+        }
+
+        ssize_t send_vectors(socket::native_handle_t handle, io_vector* vectors, size_t count, std::error_code& ec) {
+            DWORD sent = 0;
+            if (WSASend(handle, vectors, DWORD(count), &sent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+                ec = std::error_code(last_socket_error(), error::system_category());
+                return -1;
+            }
+            return ssize_t(sent);
+        }
+
+        ssize_t receive_vectors(socket::native_handle_t handle, io_vector* vectors, size_t count,
+                                std::error_code& ec) {
+            DWORD received = 0;
+            DWORD flags = MSG_WAITALL;
+            if (WSARecv(handle, vectors, DWORD(count), &received, &flags, nullptr, nullptr) == SOCKET_ERROR) {
+                ec = std::error_code(last_socket_error(), error::system_category());
+                return -1;
+            }
+            return ssize_t(received);
+        }
+#else
+        using io_vector = iovec;
+
+#    ifdef IOV_MAX
+        constexpr size_t max_io_vectors = IOV_MAX;
+#    else
+        constexpr size_t max_io_vectors = 1024;
+#    endif
+
+        void assign(io_vector& vector, const void* data, size_t size) {
+            vector.iov_base = const_cast<void*>(data);
+            vector.iov_len = size;
+        }
+
+        ssize_t send_vectors(socket::native_handle_t handle, io_vector* vectors, size_t count, std::error_code& ec) {
+            msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = count;
+            return error_wrapper(ec, ::sendmsg, handle, &message, NO_SIGPIPE);
+        }
+
+        ssize_t receive_vectors(socket::native_handle_t handle, io_vector* vectors, size_t count,
+                                std::error_code& ec) {
+            msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = count;
+            return error_wrapper(ec, ::recvmsg, handle, &message, NO_SIGPIPE | MSG_WAITALL);
+        }
+#endif
+
+        /**
+         * Position in caller's array of views. Views are copied to
+         * io_vector array in batches of at most max_io_vectors, skipping
+         * empty ones, so only window not yet transferred is kept and no
+         * allocation is needed.
+         */
+        template<typename View>
+        class view_cursor {
+        public:
+            view_cursor(const View* buffers, size_t count) noexcept : buffers_(buffers), count_(count) {}
+
+            /**
+             * Fill vectors starting from current position, return count
+             * of filled entries (0 if everything is transferred) and set
+             * requested to their total length.
+             */
+            size_t fill(io_vector* vectors, size_t& requested) const noexcept {
+                size_t filled = 0;
+                size_t skip = offset_;
+                requested = 0;
+                for (size_t i = index_; i < count_ && filled < max_io_vectors; ++i) {
+                    size_t size = buffers_[i].size() - skip;
+                    if (size != 0) {
+                        assign(vectors[filled++], buffers_[i].data() + skip, size);
+                        requested += size;
+                    }
+                    skip = 0;
+                }
+                return filled;
+            }
+
+            /**
+             * Mark bytes as transferred.
+             */
+            void consume(size_t bytes) noexcept {
+                while (index_ < count_ && bytes >= buffers_[index_].size() - offset_) {
+                    bytes -= buffers_[index_].size() - offset_;
+                    ++index_;
+                    offset_ = 0;
+                }
+                offset_ += bytes;
+            }
+
+        private:
+            const View* buffers_;
+            size_t count_;
+            size_t index_ = 0;
+            size_t offset_ = 0;
+        };
+    } // namespace
+
+    size_t socket::write(const memory_view<const uint8_t>* buffers, size_t buffers_count,
+                         std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        io_vector vectors[max_io_vectors];
+        view_cursor cursor(buffers, buffers_count);
+        size_t written = 0;
+        size_t requested = 0;
+        while (size_t count = cursor.fill(vectors, requested)) {
+            ssize_t actually_written = send_vectors(handle, vectors, count, ec);
+            if (actually_written < 0) break;
+
+            written += size_t(actually_written);
+            cursor.consume(size_t(actually_written));
+
+            // Send buffer is full, let caller retry later.
+            if (state.internal_non_blocking && size_t(actually_written) < requested) break;
+        }
+        return written;
+    }
+
+    size_t socket::read(const memory_view<uint8_t>* buffers, size_t buffers_count, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        io_vector vectors[max_io_vectors];
+        view_cursor cursor(buffers, buffers_count);
+        size_t received = 0;
+        size_t requested = 0;
+        while (size_t count = cursor.fill(vectors, requested)) {
+            ssize_t actually_read = receive_vectors(handle, vectors, count, ec);
+            if (actually_read < 0) break;
+
+            received += size_t(actually_read);
+
+            // Same rules as in read(): short read is EOF in blocking mode
+            // because of MSG_WAITALL, in non-blocking mode only 0 is EOF.
+            if (actually_read == 0 || (!state.internal_non_blocking && size_t(actually_read) < requested)) {
+                ec = std::error_code(EOF, error::system_category());
+                break;
+            }
+            if (size_t(actually_read) < requested) break;
+
+            cursor.consume(size_t(actually_read));
+        }
+        return received;
+    }
+
+    size_t socket::write_zero_copy(const void* input, size_t length_bytes, std::optional<uint32_t>& id,
+                                   std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        id.reset();
+#ifdef LIBWIRE_ZERO_COPY
+        if (state.zero_copy && !state.zero_copy_copied && length_bytes >= zero_copy_threshold) {
+            std::error_code zero_copy_ec;
+            ssize_t actually_written =
+                error_wrapper(zero_copy_ec, ::send, handle, input, length_bytes, NO_SIGPIPE | MSG_ZEROCOPY);
+            if (actually_written > 0) {
+                id = zero_copy_next_id++;
+                return size_t(actually_written);
+            }
+
+            // ENOBUFS means that we hit limit on pinned memory,
+            // usual write will work fine.
+            if (zero_copy_ec.value() != ENOBUFS) {
+                ec = zero_copy_ec;
+                return 0;
+            }
+        }
+#endif
+        return write(input, length_bytes, ec);
+    }
+
+    size_t socket::read_zero_copy_completions(zero_copy_completion* output, size_t max_count,
+                                              std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        size_t count = 0;
+#ifdef LIBWIRE_ZERO_COPY
+        while (count < max_count) {
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err)) * 2];
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+
+            // Reads from error queue never block.
+            std::error_code read_ec;
+            if (error_wrapper(read_ec, ::recvmsg, handle, &message, MSG_ERRQUEUE) < 0) {
+                if (read_ec != error::try_again) ec = read_ec;
+                break;
+            }
+
+            for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+                 header = CMSG_NXTHDR(&message, header)) {
+                bool is_error = (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) ||
+                                (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR);
+                if (!is_error) continue;
+
+                const auto* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+                if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+                zero_copy_completion& completion = output[count++];
+                completion.first = error->ee_info;
+                completion.last = error->ee_data;
+                completion.copied = (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+                if (completion.copied) state.zero_copy_copied = true;
+                break;
+            }
+        }
+#else
+        (void)output;
+        (void)max_count;
+        (void)ec;
+#endif
+        return count;
+    }
+
+#ifndef _WIN32
+    namespace {
+        /**
+         * Block SIGPIPE in calling thread while alive and discard SIGPIPE
+         * generated during this time.
+         *
+         * Used for calls like sendfile() that don't accept MSG_NOSIGNAL.
+         */
+        class sigpipe_guard {
+        public:
+            sigpipe_guard() noexcept {
+#    ifndef SO_NOSIGPIPE
+                sigset_t pending;
+                sigpending(&pending);
+                was_pending = sigismember(&pending, SIGPIPE) == 1;
+
+                sigset_t blocked;
+                sigemptyset(&blocked);
+                sigaddset(&blocked, SIGPIPE);
+                pthread_sigmask(SIG_BLOCK, &blocked, &old_mask);
+#    endif
+            }
+
+            ~sigpipe_guard() {
+#    ifndef SO_NOSIGPIPE
+                sigset_t pending;
+                sigpending(&pending);
+                if (!was_pending && sigismember(&pending, SIGPIPE) == 1) {
+                    sigset_t sigpipe;
+                    sigemptyset(&sigpipe);
+                    sigaddset(&sigpipe, SIGPIPE);
+                    timespec no_wait{0, 0};
+                    while (sigtimedwait(&sigpipe, nullptr, &no_wait) == -1 && errno == EINTR) {
+                    }
+                }
+                pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+#    endif
+            }
+
+        private:
+#    ifndef SO_NOSIGPIPE
+            sigset_t old_mask;
+            bool was_pending = false;
+#    endif
+        };
+
+#    ifdef __linux__
+        /**
+         * Pipe used by receive_to_file as intermediate kernel buffer
+         * for splice(), one per thread and always empty between calls.
+         */
+        struct splice_pipe {
+            ~splice_pipe() {
+                reset();
+            }
+
+            bool open(std::error_code& ec) noexcept {
+                if (fds[0] != -1) return true;
+                if (pipe2(fds, O_CLOEXEC) == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return false;
+                }
+                // Bigger pipe means less splice() calls, failure is harmless.
+                fcntl(fds[1], F_SETPIPE_SZ, 1024 * 1024);
+                int size = fcntl(fds[1], F_GETPIPE_SZ);
+                capacity = size > 0 ? size_t(size) : 64 * 1024;
+                return true;
+            }
+
+            void reset() noexcept {
+                if (fds[0] == -1) return;
+                ::close(fds[0]);
+                ::close(fds[1]);
+                fds[0] = fds[1] = -1;
+            }
+
+            int fds[2] = {-1, -1};
+            size_t capacity = 0;
+        };
+
+        thread_local splice_pipe splice_buffer;
+#    else
+        constexpr size_t file_chunk_size = 64 * 1024;
+#    endif
+    } // namespace
+
+    size_t socket::send_file(int file, uint64_t offset, size_t length, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        sigpipe_guard guard;
+        size_t sent = 0;
+        while (sent < length) {
+            size_t requested = length - sent;
+#    ifdef __linux__
+            off_t file_offset = off_t(offset + sent);
+            ssize_t actually_sent = error_wrapper(ec, ::sendfile, handle, file, &file_offset, requested);
+#    else
+            uint8_t chunk[file_chunk_size];
+            requested = std::min(requested, file_chunk_size);
+            ssize_t available = error_wrapper(ec, ::pread, file, chunk, requested, off_t(offset + sent));
+            if (available <= 0) break;
+            requested = size_t(available);
+            ssize_t actually_sent = error_wrapper(ec, ::send, handle, chunk, requested, NO_SIGPIPE);
+#    endif
+            // 0 means that file ended earlier than expected.
+            if (actually_sent <= 0) break;
+            sent += size_t(actually_sent);
+
+            // Send buffer is full, let caller retry later.
+            if (state.internal_non_blocking && size_t(actually_sent) < requested) break;
+        }
+
+        // Report progress, caller will get try_again on next call.
+        if (sent != 0 && ec == error::try_again) ec.clear();
+        return sent;
+    }
+
+    size_t socket::receive_to_file(int file, uint64_t offset, size_t length, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        size_t received = 0;
+#    ifdef __linux__
+        if (!splice_buffer.open(ec)) return 0;
+#    endif
+        while (received < length) {
+            size_t requested = length - received;
+#    ifdef __linux__
+            // Pipe is empty so it can't block us if we request no more
+            // than its capacity.
+            requested = std::min(requested, splice_buffer.capacity);
+            ssize_t actually_read = error_wrapper(ec, ::splice, handle, nullptr, splice_buffer.fds[1], nullptr,
+                                                  requested, SPLICE_F_MOVE);
+#    else
+            uint8_t chunk[file_chunk_size];
+            requested = std::min(requested, file_chunk_size);
+            ssize_t actually_read = error_wrapper(ec, ::recv, handle, chunk, requested, NO_SIGPIPE);
+#    endif
+            if (actually_read < 0) break;
+            if (actually_read == 0) {
+                ec = std::error_code(EOF, error::system_category());
+                break;
+            }
+
+            size_t left = size_t(actually_read);
+            while (left != 0) {
+#    ifdef __linux__
+                loff_t file_offset = loff_t(offset + received);
+                ssize_t written = error_wrapper(ec, ::splice, splice_buffer.fds[0], nullptr, file, &file_offset, left,
+                                                SPLICE_F_MOVE);
+#    else
+                ssize_t written = error_wrapper(ec, ::pwrite, file, chunk + (size_t(actually_read) - left), left,
+                                                off_t(offset + received));
+#    endif
+                if (written <= 0) {
+                    if (!ec) ec = std::make_error_code(std::errc::io_error);
+#    ifdef __linux__
+                    // Data already taken from socket is lost anyway, but
+                    // pipe must be empty for next call.
+                    splice_buffer.reset();
+#    endif
+                    return received;
+                }
+                left -= size_t(written);
+                received += size_t(written);
+            }
+
+            // Nothing more to read now, let caller retry later.
+            if (state.internal_non_blocking && size_t(actually_read) < requested) break;
+        }
+
+        if (received != 0 && ec == error::try_again) ec.clear();
+        return received;
+    }
+#endif // ifndef _WIN32
+
     socket::operator bool() const noexcept {
         return handle != not_initialized;
     }
@@ -196,6 +795,7 @@ namespace libwire::internal_ {
 
     std::tuple<address, uint16_t> socket::remote_endpoint() const noexcept {
         assert(handle != not_initialized);
+        if (peer) return *peer;
 
         sockaddr_storage sock_address{};
         socklen_t length = sizeof(sock_address);
@@ -208,16 +808,21 @@ namespace libwire::internal_ {
                            std::optional<std::tuple<address, uint16_t>> destination) noexcept {
         assert(handle != not_initialized);
 
-        ssize_t actually_written;
-        if (destination) {
-            sockaddr_storage addr = endpoint_to_sockaddr(*destination);
-            actually_written =
-                error_wrapper(ec, sendto, handle, reinterpret_cast<const char*>(input), length_bytes, NO_SIGPIPE,
-                              reinterpret_cast<sockaddr*>(&addr), uint32_t(sizeof(sockaddr_in6)));
-        } else {
-            actually_written = error_wrapper(ec, sendto, handle, reinterpret_cast<const char*>(input), length_bytes,
-                                             NO_SIGPIPE, nullptr, 0u);
-        }
+        if (destination) return send_to(input, length_bytes, ec, endpoint(*destination));
+
+        ssize_t actually_written = error_wrapper(ec, sendto, handle, reinterpret_cast<const char*>(input),
+                                                 length_bytes, NO_SIGPIPE, nullptr, 0u);
+        return actually_written < 0 ? 0 : size_t(actually_written);
+    }
+
+    size_t socket::send_to(const void* input, size_t length_bytes, std::error_code& ec,
+                           const endpoint& destination) noexcept {
+        assert(handle != not_initialized);
+
+        endpoint mapped;
+        const endpoint& native = native_endpoint(*this, destination, mapped);
+        ssize_t actually_written = error_wrapper(ec, sendto, handle, reinterpret_cast<const char*>(input),
+                                                 length_bytes, NO_SIGPIPE, native.data(), native.size());
         return actually_written < 0 ? 0 : size_t(actually_written);
     }
 
@@ -230,8 +835,270 @@ namespace libwire::internal_ {
 
         ssize_t received_bytes = error_wrapper(ec, ::recvfrom, handle, reinterpret_cast<char*>(output), length_bytes,
                                                NO_SIGPIPE, reinterpret_cast<sockaddr*>(&sock_address), &socklen);
+        if (received_bytes < 0) return {address{0, 0, 0, 0}, 0, 0};
 
         std::tuple<address, uint16_t> endpoint = sockaddr_to_endpoint(sock_address);
         return {std::get<0>(endpoint), std::get<1>(endpoint), received_bytes};
     }
+
+    size_t socket::receive_from(void* output, size_t length_bytes, endpoint& source, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        socklen_t length = endpoint::capacity();
+        ssize_t received_bytes = error_wrapper(ec, ::recvfrom, handle, reinterpret_cast<char*>(output), length_bytes,
+                                               NO_SIGPIPE, source.data(), &length);
+        if (received_bytes < 0) return 0;
+        if (state.ipv6) source.unmap();
+        return size_t(received_bytes);
+    }
+
+#ifdef __linux__
+    namespace {
+        /// Count of datagrams passed to one recvmmsg/sendmmsg call.
+        constexpr size_t max_messages = 64;
+
+        void assign(mmsghdr& message, iovec& vector, const datagram_header& header, size_t length) {
+            vector.iov_base = header.data;
+            vector.iov_len = length;
+            message.msg_hdr.msg_name = const_cast<sockaddr*>(header.address.data());
+            message.msg_hdr.msg_namelen = header.address.size();
+            message.msg_hdr.msg_iov = &vector;
+            message.msg_hdr.msg_iovlen = 1;
+            message.msg_hdr.msg_control = nullptr;
+            message.msg_hdr.msg_controllen = 0;
+            message.msg_hdr.msg_flags = 0;
+            message.msg_len = 0;
+        }
+    } // namespace
+
+    size_t socket::receive_many(datagram_header* headers, size_t count, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        mmsghdr messages[max_messages];
+        iovec vectors[max_messages];
+        size_t received = 0;
+        while (received < count) {
+            size_t chunk = std::min(count - received, max_messages);
+            for (size_t i = 0; i < chunk; ++i) {
+                assign(messages[i], vectors[i], headers[received + i], headers[received + i].capacity);
+                messages[i].msg_hdr.msg_namelen = endpoint::capacity();
+            }
+
+            // Only first chunk is allowed to wait for data.
+            int flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+            std::error_code chunk_ec;
+            int status = error_wrapper(chunk_ec, ::recvmmsg, handle, messages, unsigned(chunk), flags, nullptr);
+            if (status < 0) {
+                if (received == 0) ec = chunk_ec;
+                break;
+            }
+
+            for (size_t i = 0; i < size_t(status); ++i) {
+                headers[received + i].size = messages[i].msg_len;
+                headers[received + i].truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+                if (state.ipv6) headers[received + i].address.unmap();
+            }
+            received += size_t(status);
+            if (size_t(status) < chunk) break;
+        }
+        return received;
+    }
+
+    size_t socket::send_many(const datagram_header* headers, size_t count, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        mmsghdr messages[max_messages];
+        iovec vectors[max_messages];
+        // Batch doesn't know socket it will be sent with, so IPv4 destinations
+        // are mapped here for IPv6 sockets.
+        endpoint mapped[max_messages];
+        size_t sent = 0;
+        while (sent < count) {
+            size_t chunk = std::min(count - sent, max_messages);
+            for (size_t i = 0; i < chunk; ++i) {
+                const datagram_header& header = headers[sent + i];
+                assign(messages[i], vectors[i], header, header.size);
+                if (header.address.empty()) {
+                    messages[i].msg_hdr.msg_name = nullptr;
+                    messages[i].msg_hdr.msg_namelen = 0;
+                } else {
+                    const endpoint& native = native_endpoint(*this, header.address, mapped[i]);
+                    messages[i].msg_hdr.msg_name = const_cast<sockaddr*>(native.data());
+                    messages[i].msg_hdr.msg_namelen = native.size();
+                }
+            }
+
+            std::error_code chunk_ec;
+            int status = error_wrapper(chunk_ec, ::sendmmsg, handle, messages, unsigned(chunk), NO_SIGPIPE);
+            if (status < 0) {
+                if (sent == 0) ec = chunk_ec;
+                break;
+            }
+            sent += size_t(status);
+            if (size_t(status) < chunk) break;
+        }
+        return sent;
+    }
+#else
+    size_t socket::receive_many(datagram_header* headers, size_t count, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+        if (count == 0) return 0;
+
+        // No batched receive here, and there is no portable way to check
+        // whether more datagrams are queued without blocking.
+        socklen_t length = endpoint::capacity();
+        ssize_t received_bytes =
+            error_wrapper(ec, ::recvfrom, handle, reinterpret_cast<char*>(headers->data), headers->capacity,
+                          NO_SIGPIPE, headers->address.data(), &length);
+        if (received_bytes < 0) return 0;
+        if (state.ipv6) headers->address.unmap();
+        headers->size = size_t(received_bytes);
+        headers->truncated = false;
+        return 1;
+    }
+
+    size_t socket::send_many(const datagram_header* headers, size_t count, std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        size_t sent = 0;
+        for (; sent < count; ++sent) {
+            const datagram_header& header = headers[sent];
+            std::error_code datagram_ec;
+            endpoint mapped;
+            const sockaddr* destination = nullptr;
+            socklen_t destination_length = 0;
+            if (!header.address.empty()) {
+                const endpoint& native = native_endpoint(*this, header.address, mapped);
+                destination = native.data();
+                destination_length = native.size();
+            }
+            ssize_t status = error_wrapper(datagram_ec, ::sendto, handle, reinterpret_cast<const char*>(header.data),
+                                           header.size, NO_SIGPIPE, destination, destination_length);
+            if (status < 0) {
+                if (sent == 0) ec = datagram_ec;
+                break;
+            }
+        }
+        return sent;
+    }
+#endif
+
+    size_t socket::send_segmented(const void* input, size_t length_bytes, size_t segment_size, std::error_code& ec,
+                                  std::optional<std::tuple<address, uint16_t>> destination) noexcept {
+        assert(handle != not_initialized);
+
+        if (segment_size == 0 || segment_size > UINT16_MAX) {
+            ec = std::error_code(EINVAL, error::system_category());
+            return 0;
+        }
+
+        const auto* bytes = static_cast<const uint8_t*>(input);
+        size_t sent = 0;
+        std::optional<sockaddr_storage> address;
+        if (destination) address = endpoint_to_sockaddr(*destination, state.ipv6);
+        socklen_t address_length = address ? sockaddr_length(*address) : 0;
+
+#if defined(__linux__) && defined(UDP_SEGMENT)
+        // Kernel accepts at most 64 segments and one IP packet worth of
+        // payload in one call.
+        constexpr size_t max_segments = 64;
+        constexpr size_t max_payload = UINT16_MAX - 8 /* UDP header */ - 40 /* IPv6 header */;
+        size_t segments_per_call = std::min(max_segments, max_payload / segment_size);
+
+        while (!state.segmentation_offload_unsupported && segments_per_call > 1 && sent < length_bytes) {
+            size_t chunk = std::min(length_bytes - sent, segments_per_call * segment_size);
+
+            iovec vector{const_cast<uint8_t*>(bytes + sent), chunk};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+            msghdr message{};
+            message.msg_name = address ? &*address : nullptr;
+            message.msg_namelen = address_length;
+            message.msg_iov = &vector;
+            message.msg_iovlen = 1;
+            if (chunk > segment_size) {
+                message.msg_control = control;
+                message.msg_controllen = sizeof(control);
+                cmsghdr* header = CMSG_FIRSTHDR(&message);
+                header->cmsg_level = SOL_UDP;
+                header->cmsg_type = UDP_SEGMENT;
+                header->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                auto size = uint16_t(segment_size);
+                std::memcpy(CMSG_DATA(header), &size, sizeof(size));
+            }
+
+            std::error_code chunk_ec;
+            ssize_t status = error_wrapper(chunk_ec, ::sendmsg, handle, &message, NO_SIGPIPE);
+            if (status < 0) {
+                int code = chunk_ec.value();
+                if (chunk > segment_size && (code == EINVAL || code == ENOPROTOOPT || code == EIO)) {
+                    // No GSO support in kernel or in output device.
+                    state.segmentation_offload_unsupported = true;
+                    break;
+                }
+                if (sent == 0) ec = chunk_ec;
+                return sent;
+            }
+            sent += size_t(status);
+        }
+#endif
+
+        auto* name = address ? reinterpret_cast<sockaddr*>(&*address) : nullptr;
+        while (sent < length_bytes) {
+            size_t chunk = std::min(length_bytes - sent, segment_size);
+            std::error_code chunk_ec;
+            ssize_t status = error_wrapper(chunk_ec, ::sendto, handle, reinterpret_cast<const char*>(bytes + sent),
+                                           chunk, NO_SIGPIPE, name, address_length);
+            if (status < 0) {
+                if (sent == 0) ec = chunk_ec;
+                break;
+            }
+            sent += size_t(status);
+        }
+        return sent;
+    }
+
+    std::tuple<address, uint16_t, size_t> socket::receive_coalesced(void* output, size_t length_bytes,
+                                                                    size_t& segment_size, bool& truncated,
+                                                                    std::error_code& ec) noexcept {
+        assert(handle != not_initialized);
+
+        truncated = false;
+#ifdef __linux__
+        // recvmsg is used even without offload, only it reports truncation.
+        sockaddr_storage sock_address;
+        iovec vector{output, length_bytes};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr message{};
+        message.msg_name = &sock_address;
+        message.msg_namelen = sizeof(sock_address);
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t received_bytes = error_wrapper(ec, ::recvmsg, handle, &message, NO_SIGPIPE);
+        if (received_bytes < 0) return {address{0, 0, 0, 0}, 0, 0};
+        truncated = (message.msg_flags & MSG_TRUNC) != 0;
+
+        // No control message if datagram wasn't coalesced.
+        segment_size = size_t(received_bytes);
+#    ifdef UDP_GRO
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+             header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_UDP && header->cmsg_type == UDP_GRO) {
+                int size;
+                std::memcpy(&size, CMSG_DATA(header), sizeof(size));
+                segment_size = size_t(size);
+            }
+        }
+#    endif
+
+        std::tuple<address, uint16_t> endpoint = sockaddr_to_endpoint(sock_address);
+        return {std::get<0>(endpoint), std::get<1>(endpoint), size_t(received_bytes)};
+#else
+        auto result = receive_from(output, length_bytes, ec);
+        segment_size = std::get<2>(result);
+        return result;
+#endif
+    }
 } // namespace libwire::internal_
@@ -23,6 +23,7 @@
 #include "libwire/internal/socket_utils.hpp"
 
 #include <cassert>
+#include <cstring>
 #include "libwire/internal/endianess.hpp"
 
 #ifdef _WIN32
@@ -41,14 +42,30 @@ std::tuple<libwire::address, uint16_t> libwire::internal_::sockaddr_to_endpoint(
     }
     if (in.ss_family == AF_INET6) {
         auto& sock_address_v6 = reinterpret_cast<sockaddr_in6&>(in);
+        if (IN6_IS_ADDR_V4MAPPED(&sock_address_v6.sin6_addr)) {
+            // Last 4 bytes are IPv4 address.
+            return {memory_view((uint8_t*)&sock_address_v6.sin6_addr + 12, 4),
+                    network_to_host(sock_address_v6.sin6_port)};
+        }
         return {memory_view((uint8_t*)&sock_address_v6.sin6_addr, sizeof(sock_address_v6.sin6_addr)),
                 network_to_host(sock_address_v6.sin6_port)};
     }
     assert(false);
 }
 
-sockaddr_storage libwire::internal_::endpoint_to_sockaddr(std::tuple<libwire::address, uint16_t> in) {
+sockaddr_storage libwire::internal_::endpoint_to_sockaddr(std::tuple<libwire::address, uint16_t> in,
+                                                          bool v4_mapped) {
     sockaddr_storage addr{};
+    if (std::get<0>(in).version == ip::v4 && v4_mapped) {
+        auto& addr_v6 = reinterpret_cast<sockaddr_in6&>(addr);
+        addr_v6.sin6_family = AF_INET6;
+        auto* bytes = reinterpret_cast<uint8_t*>(&addr_v6.sin6_addr);
+        bytes[10] = 0xff;
+        bytes[11] = 0xff;
+        std::memcpy(bytes + 12, std::get<0>(in).parts.data(), 4);
+        addr_v6.sin6_port = host_to_network(std::get<1>(in));
+        return addr;
+    }
     if (std::get<0>(in).version == ip::v4) {
         auto& addr_v4 = reinterpret_cast<sockaddr_in&>(addr);
         addr_v4.sin_family = AF_INET;
@@ -65,6 +82,10 @@ sockaddr_storage libwire::internal_::endpoint_to_sockaddr(std::tuple<libwire::ad
     assert(false);
 }
 
+socklen_t libwire::internal_::sockaddr_length(const sockaddr_storage& in) noexcept {
+    return in.ss_family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+}
+
 int libwire::internal_::last_socket_error() {
 #ifdef _WIN32
     return WSAGetLastError();
@@ -0,0 +1,835 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if defined(__linux__) && defined(LIBWIRE_IO_URING)
+
+#include "libwire/internal/io_backend.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <vector>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "libwire/internal/socket_utils.hpp"
+
+/*
+ * io_uring is used through raw system calls, so liburing is not required.
+ *
+ * Structure of rings is described in io_uring(7): kernel consumes
+ * submission queue entries (SQE) between head and tail of SQ ring,
+ * and posts completion queue entries (CQE) to CQ ring. Both rings are
+ * mapped into our memory, so request submission and completion reaping
+ * is done without system calls, io_uring_enter is needed only to notify
+ * kernel about new SQEs and to sleep waiting for CQEs.
+ */
+
+namespace libwire::internal_ {
+    namespace {
+        int io_uring_setup(unsigned entries, io_uring_params* params) noexcept {
+            return int(syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int io_uring_enter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags,
+                           const void* argument = nullptr, size_t argument_size = 0) noexcept {
+            return int(syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, argument, argument_size));
+        }
+
+        int io_uring_register(int ring, unsigned opcode, const void* argument, unsigned count) noexcept {
+            return int(syscall(__NR_io_uring_register, ring, opcode, argument, count));
+        }
+
+        template<typename T>
+        T load_acquire(const T* pointer) noexcept {
+            return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+        }
+
+        template<typename T>
+        void store_release(T* pointer, T value) noexcept {
+            __atomic_store_n(pointer, value, __ATOMIC_RELEASE);
+        }
+
+        constexpr unsigned submission_entries = 256;
+        constexpr unsigned completion_entries = submission_entries * 8;
+
+        /// Count of buffers provided to kernel for multishot receive, power of two.
+        constexpr unsigned provided_buffers = 256;
+        constexpr uint16_t provided_buffers_group = 0;
+
+        constexpr unsigned registered_files = 1024;
+
+        /// user_data values not pointing to operation.
+        constexpr uint64_t interrupter_token = 0;
+        constexpr uint64_t ignored_token = 1;
+
+        /// Operation::backend_data is descriptor with these flags.
+        constexpr uint32_t multishot_flag = 1u << 31;
+        constexpr uint32_t write_flag = 1u << 30;
+        constexpr uint32_t descriptor_mask = write_flag - 1;
+
+        class uring_backend final : public io_backend, public buffer_pool {
+        public:
+            uring_backend(io_context& owner, std::error_code& ec) noexcept : io_backend(owner) {
+                setup_ring(ec);
+                if (!ec) check_features(ec);
+                if (!ec) setup_files(ec);
+                if (!ec) setup_buffers(ec);
+                if (!ec) setup_interrupter(ec);
+                ready_ = !ec;
+            }
+
+            ~uring_backend() override {
+                if (ready_) cancel_all();
+                while (!starving_.empty()) delete starving_.pop();
+
+                if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+                if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+                if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+                if (ring_ != -1) close(ring_);
+                if (interrupter_fd_ != -1) close(interrupter_fd_);
+            }
+
+            void start(socket& socket, io_operation* op, io_direction dir) override {
+                assert(socket.handle >= 0 && uint32_t(socket.handle) <= descriptor_mask);
+
+                native_request request = op->native();
+                op->backend_data = uint32_t(socket.handle);
+                if (request.multishot) op->backend_data |= multishot_flag;
+                if (dir == io_direction::write) op->backend_data |= write_flag;
+
+                if (request.kind == native_request::none) {
+                    // Try to complete operation right now, usually it saves one round trip.
+                    if (op->perform()) {
+                        post(op);
+                        return;
+                    }
+                    if (int error = submit_poll(op); error != 0 && fail_submission(op, error)) post(op);
+                    return;
+                }
+
+                op->native_mode = true;
+                if (int error = submit_native(op, request); error != 0 && fail_submission(op, error)) post(op);
+            }
+
+            void cancel(socket::native_handle_t handle) noexcept override {
+                {
+                    std::lock_guard lock(sq_mutex_);
+                    int error = 0;
+                    if (io_uring_sqe* sqe = acquire_sqe(error)) {
+                        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+                        int slot = registered_slot(handle);
+                        if (slot != -1) {
+                            sqe->fd = slot;
+                            sqe->cancel_flags |= IORING_ASYNC_CANCEL_FD_FIXED;
+                        } else {
+                            sqe->fd = handle;
+                        }
+                        sqe->user_data = ignored_token;
+                        commit_sqe();
+
+                        // Descriptor is resolved during submission, so we can't defer
+                        // it, socket may be closed right after cancel().
+                        submit_locked();
+                    }
+                }
+
+                // Operations waiting for provided buffers are not known to kernel.
+                op_queue canceled;
+                {
+                    std::lock_guard lock(buffers_mutex_);
+                    op_queue rest;
+                    while (!starving_.empty()) {
+                        io_operation* op = starving_.pop();
+                        if (int(op->backend_data & descriptor_mask) == handle) {
+                            canceled.push(op);
+                        } else {
+                            rest.push(op);
+                        }
+                    }
+                    starving_.splice(rest);
+                }
+                while (!canceled.empty()) {
+                    io_operation* op = canceled.pop();
+                    provided_buffer no_buffer;
+                    op->on_native_result(-ECANCELED, false, no_buffer);
+                    if (op->schedule()) {
+                        post(op);
+                    } else {
+                        work_finished();
+                    }
+                }
+            }
+
+            void cancel_operation(io_operation* op) noexcept override {
+                // Request is matched by user_data. If operation is between
+                // submissions, submit_native and submit_poll notice timed_out.
+                std::lock_guard lock(sq_mutex_);
+                int error = 0;
+                io_uring_sqe* sqe = acquire_sqe(error);
+                if (sqe == nullptr) return;
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = reinterpret_cast<uintptr_t>(op);
+                sqe->user_data = ignored_token;
+                commit_sqe();
+                submit_or_defer();
+            }
+
+            void register_descriptor(socket::native_handle_t handle, std::error_code& ec) noexcept override {
+                std::lock_guard lock(files_mutex_);
+                if (handle < 0) {
+                    ec = std::error_code(EBADF, error::system_category());
+                    return;
+                }
+                if (size_t(handle) < slots_.size() && slots_[size_t(handle)] != -1) return;
+                if (free_slots_.empty()) {
+                    ec = std::error_code(ENFILE, error::system_category());
+                    return;
+                }
+
+                int slot = free_slots_.back();
+                if (!update_slot(slot, handle, ec)) return;
+                free_slots_.pop_back();
+                if (size_t(handle) >= slots_.size()) slots_.resize(size_t(handle) + 1, -1);
+                slots_[size_t(handle)] = slot;
+            }
+
+            void unregister_descriptor(socket::native_handle_t handle) noexcept override {
+                std::lock_guard lock(files_mutex_);
+                if (handle < 0 || size_t(handle) >= slots_.size() || slots_[size_t(handle)] == -1) return;
+
+                int slot = slots_[size_t(handle)];
+                std::error_code ec;
+                update_slot(slot, -1, ec);
+                slots_[size_t(handle)] = -1;
+                free_slots_.push_back(slot);
+            }
+
+            /*
+             * Leader/followers: only one thread at a time sleeps in io_uring_enter
+             * and reaps completions, it shares them with other threads which wait
+             * on condition variable meanwhile.
+             */
+            void wait(int timeout, op_queue& completed) override {
+                uint64_t seen = generation_.load();
+                std::unique_lock reap_lock(reap_mutex_, std::try_to_lock);
+                if (!reap_lock.owns_lock()) {
+                    flush();
+                    if (timeout == 0) return;
+                    std::unique_lock lock(wait_mutex_);
+                    auto changed = [&] { return generation_.load() != seen; };
+                    if (timeout < 0) {
+                        wait_cv_.wait(lock, changed);
+                    } else {
+                        wait_cv_.wait_for(lock, std::chrono::milliseconds(timeout), changed);
+                    }
+                    return;
+                }
+
+                unsigned to_submit = 0;
+                {
+                    std::lock_guard lock(sq_mutex_);
+                    std::swap(to_submit, pending_);
+                }
+
+                bool have_completions = load_acquire(cq_tail_) != *cq_head_;
+                unsigned min_complete = timeout != 0 && !have_completions ? 1 : 0;
+                if (to_submit != 0 || min_complete != 0) {
+                    __kernel_timespec limit{timeout / 1000, (timeout % 1000) * 1000000LL};
+                    io_uring_getevents_arg argument{};
+                    if (timeout > 0) argument.ts = reinterpret_cast<uintptr_t>(&limit);
+
+                    // Returns count of submitted SQEs even if wait timed out.
+                    int submitted = io_uring_enter(ring_, to_submit, min_complete,
+                                                   IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument,
+                                                   sizeof(argument));
+                    if (submitted < 0 && to_submit != 0) {
+                        std::lock_guard lock(sq_mutex_);
+                        pending_ += to_submit;
+                    }
+                }
+
+                reap(completed);
+                share(completed);
+                reap_lock.unlock();
+                wake_followers();
+            }
+
+            void flush() noexcept override {
+                std::lock_guard lock(sq_mutex_);
+                if (pending_ != 0) submit_locked();
+            }
+
+            void interrupt() noexcept override {
+                uint64_t one = 1;
+                [[maybe_unused]] ssize_t status = write(interrupter_fd_, &one, sizeof(one));
+                wake_followers();
+            }
+
+            void recycle(uint16_t id) noexcept override {
+                op_queue waiting;
+                {
+                    std::lock_guard lock(buffers_mutex_);
+                    {
+                        std::lock_guard sq_lock(sq_mutex_);
+                        provide_buffers(id, 1);
+                        submit_or_defer();
+                    }
+                    --buffers_in_use_;
+                    waiting.splice(starving_);
+                }
+                while (!waiting.empty()) {
+                    io_operation* op = waiting.pop();
+                    if (int error = submit_native(op, op->native()); error != 0 && fail_submission(op, error)) post(op);
+                }
+            }
+
+        private:
+            void setup_ring(std::error_code& ec) noexcept {
+                io_uring_params params{};
+                params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+                params.cq_entries = completion_entries;
+                ring_ = io_uring_setup(submission_entries, &params);
+                if (ring_ == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_NODROP) == 0 ||
+                    (params.features & IORING_FEAT_EXT_ARG) == 0) {
+                    ec = std::error_code(ENOSYS, error::system_category());
+                    return;
+                }
+
+                sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_,
+                                IORING_OFF_SQ_RING);
+                if (sq_ring_ == MAP_FAILED) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+                cq_ring_ = sq_ring_;
+
+                sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+                sqes_ = static_cast<io_uring_sqe*>(
+                    mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES));
+                if (sqes_ == MAP_FAILED) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                auto* sq = static_cast<char*>(sq_ring_);
+                sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                sq_entries_ = params.sq_entries;
+
+                auto* cq = static_cast<char*>(cq_ring_);
+                cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            }
+
+            void check_features(std::error_code& ec) noexcept {
+                constexpr unsigned max_ops = 256;
+                std::vector<uint8_t> storage(sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op));
+                auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+                if (io_uring_register(ring_, IORING_REGISTER_PROBE, probe, max_ops) == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                // SEND_ZC is not used, but it appeared in the same kernel release
+                // (6.0) as multishot receive which can't be probed directly.
+                for (unsigned opcode : {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_RECVMSG,
+                                        IORING_OP_SENDMSG, IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL,
+                                        IORING_OP_PROVIDE_BUFFERS, IORING_OP_SEND_ZC}) {
+                    if (opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0) {
+                        ec = std::error_code(ENOSYS, error::system_category());
+                        return;
+                    }
+                }
+            }
+
+            void setup_files(std::error_code& ec) noexcept {
+                io_uring_rsrc_register files{};
+                files.nr = registered_files;
+                files.flags = IORING_RSRC_REGISTER_SPARSE;
+                if (io_uring_register(ring_, IORING_REGISTER_FILES2, &files, sizeof(files)) == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                free_slots_.reserve(registered_files);
+                for (unsigned i = registered_files; i != 0; --i) free_slots_.push_back(int(i - 1));
+            }
+
+            void setup_buffers(std::error_code& ec) noexcept {
+                // Pages are allocated by kernel on first use, so unused buffers cost nothing.
+                buffer_memory_.reset(new (std::nothrow) uint8_t[provided_buffers * multishot_buffer_size]);
+                if (!buffer_memory_) {
+                    ec = std::make_error_code(std::errc::not_enough_memory);
+                    return;
+                }
+
+                std::lock_guard lock(sq_mutex_);
+                provide_buffers(0, provided_buffers);
+                submit_locked();
+            }
+
+            void setup_interrupter(std::error_code& ec) noexcept {
+                interrupter_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (interrupter_fd_ == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return;
+                }
+
+                std::lock_guard lock(sq_mutex_);
+                arm_interrupter();
+                submit_locked();
+            }
+
+            /**
+             * Multishot poll on eventfd, every write produces completion, so
+             * we never need to read it.
+             */
+            void arm_interrupter() noexcept {
+                int error = 0;
+                io_uring_sqe* sqe = acquire_sqe(error);
+                if (sqe == nullptr) return;
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = interrupter_fd_;
+                sqe->poll32_events = POLLIN;
+                sqe->len = IORING_POLL_ADD_MULTI;
+                sqe->user_data = interrupter_token;
+                commit_sqe();
+            }
+
+            /**
+             * Get free SQE, must be called with sq_mutex_ held and
+             * followed by commit_sqe(). If ring is full and kernel
+             * fails to consume it, returns nullptr and sets error to
+             * errno value.
+             */
+            io_uring_sqe* acquire_sqe(int& error) noexcept {
+                for (;;) {
+                    unsigned tail = *sq_tail_;
+                    if (tail - load_acquire(sq_head_) < sq_entries_) {
+                        unsigned index = tail & sq_mask_;
+                        io_uring_sqe* sqe = &sqes_[index];
+                        std::memset(sqe, 0, sizeof(*sqe));
+                        sq_array_[index] = index;
+                        return sqe;
+                    }
+                    // Ring is full, let kernel consume it.
+                    error = submit_locked();
+                    if (error != 0) return nullptr;
+                }
+            }
+
+            void commit_sqe() noexcept {
+                store_release(sq_tail_, *sq_tail_ + 1);
+                ++pending_;
+            }
+
+            /**
+             * Returns errno value if io_uring_enter failed, 0 otherwise.
+             */
+            int submit_locked() noexcept {
+                int submitted;
+                do {
+                    submitted = io_uring_enter(ring_, pending_, 0, 0);
+                } while (submitted == -1 && errno == EINTR);
+                if (submitted == -1) return errno;
+                pending_ -= std::min(pending_, unsigned(submitted));
+                return 0;
+            }
+
+            /**
+             * Submit SQEs added by other threads right away, threads executing
+             * run() submit them in batch before waiting for completions.
+             */
+            void submit_or_defer() noexcept {
+                if (!running_in_this_thread()) submit_locked();
+            }
+
+            void set_descriptor(io_uring_sqe* sqe, uint32_t backend_data) noexcept {
+                int handle = int(backend_data & descriptor_mask);
+                int slot = registered_slot(handle);
+                if (slot != -1) {
+                    sqe->fd = slot;
+                    sqe->flags |= IOSQE_FIXED_FILE;
+                } else {
+                    sqe->fd = handle;
+                }
+            }
+
+            int registered_slot(int handle) noexcept {
+                std::lock_guard lock(files_mutex_);
+                if (handle < 0 || size_t(handle) >= slots_.size()) return -1;
+                return slots_[size_t(handle)];
+            }
+
+            bool update_slot(int slot, int handle, std::error_code& ec) noexcept {
+                io_uring_rsrc_update2 update{};
+                update.offset = unsigned(slot);
+                update.data = reinterpret_cast<uintptr_t>(&handle);
+                update.nr = 1;
+                if (io_uring_register(ring_, IORING_REGISTER_FILES_UPDATE2, &update, sizeof(update)) == -1) {
+                    ec = std::error_code(errno, error::system_category());
+                    return false;
+                }
+                return true;
+            }
+
+            /**
+             * Returns ECANCELED without submitting request if operation
+             * deadline expired, cancel request sent for it may be already
+             * processed by kernel. Returns errno value if there is no room
+             * for request, 0 on success.
+             */
+            int submit_native(io_operation* op, const native_request& request) noexcept {
+                std::lock_guard lock(sq_mutex_);
+                if (op->timed_out) return ECANCELED;
+                int error = 0;
+                io_uring_sqe* sqe = acquire_sqe(error);
+                if (sqe == nullptr) return error;
+                set_descriptor(sqe, op->backend_data);
+
+                switch (request.kind) {
+                case native_request::accept:
+                    sqe->opcode = IORING_OP_ACCEPT;
+                    sqe->accept_flags = SOCK_CLOEXEC;
+                    sqe->addr = reinterpret_cast<uintptr_t>(request.buffer);
+                    sqe->addr2 = reinterpret_cast<uintptr_t>(request.address_length);
+                    if (request.multishot) sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+                    break;
+                case native_request::recv:
+                    sqe->opcode = IORING_OP_RECV;
+                    if (request.provided_buffer) {
+                        sqe->flags |= IOSQE_BUFFER_SELECT;
+                        sqe->buf_group = provided_buffers_group;
+                    } else {
+                        sqe->addr = reinterpret_cast<uintptr_t>(request.buffer);
+                        sqe->len = unsigned(std::min<size_t>(request.length, UINT32_MAX));
+                    }
+                    if (request.multishot) sqe->ioprio |= IORING_RECV_MULTISHOT;
+                    break;
+                case native_request::send:
+                    sqe->opcode = IORING_OP_SEND;
+                    sqe->addr = reinterpret_cast<uintptr_t>(request.buffer);
+                    sqe->len = unsigned(std::min<size_t>(request.length, UINT32_MAX));
+                    sqe->msg_flags = MSG_NOSIGNAL;
+                    break;
+                case native_request::recvmsg:
+                    sqe->opcode = IORING_OP_RECVMSG;
+                    sqe->addr = reinterpret_cast<uintptr_t>(request.message);
+                    sqe->len = 1;
+                    break;
+                case native_request::sendmsg:
+                    sqe->opcode = IORING_OP_SENDMSG;
+                    sqe->addr = reinterpret_cast<uintptr_t>(request.message);
+                    sqe->len = 1;
+                    sqe->msg_flags = MSG_NOSIGNAL;
+                    break;
+                case native_request::none:
+                    assert(false);
+                }
+
+                sqe->user_data = reinterpret_cast<uintptr_t>(op);
+                commit_sqe();
+                ++in_flight_;
+                submit_or_defer();
+                return 0;
+            }
+
+            /**
+             * Same as \ref submit_native but waits for readiness.
+             */
+            int submit_poll(io_operation* op) noexcept {
+                std::lock_guard lock(sq_mutex_);
+                if (op->timed_out) return ECANCELED;
+                int error = 0;
+                io_uring_sqe* sqe = acquire_sqe(error);
+                if (sqe == nullptr) return error;
+                set_descriptor(sqe, op->backend_data);
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->poll32_events = (op->backend_data & write_flag) != 0 ? POLLOUT : POLLIN | POLLRDHUP;
+                sqe->user_data = reinterpret_cast<uintptr_t>(op);
+                commit_sqe();
+                ++in_flight_;
+                submit_or_defer();
+                return 0;
+            }
+
+            /**
+             * Store error of operation which wasn't submitted, returns
+             * true if caller should deliver it. Multishot operation
+             * already queued to deliver earlier results delivers error
+             * with them.
+             */
+            bool fail_submission(io_operation* op, int code) noexcept {
+                if (!op->native_mode) {
+                    op->ec = std::error_code(code, error::system_category());
+                    return true;
+                }
+                provided_buffer no_buffer;
+                op->on_native_result(-code, false, no_buffer);
+                if (op->schedule()) return true;
+                work_finished();
+                return false;
+            }
+
+            /**
+             * Give count buffers starting from first back to kernel, must be
+             * called with sq_mutex_ held.
+             *
+             * PROVIDE_BUFFERS request is used instead of buffer ring because
+             * it is processed in submission order, so receive submitted after
+             * it always sees these buffers.
+             */
+            void provide_buffers(uint16_t first, unsigned count) noexcept {
+                int error = 0;
+                io_uring_sqe* sqe = acquire_sqe(error);
+                if (sqe == nullptr) return;
+                sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+                sqe->fd = int(count);
+                sqe->addr = reinterpret_cast<uintptr_t>(buffer_memory_.get() + size_t(first) * multishot_buffer_size);
+                sqe->len = multishot_buffer_size;
+                sqe->off = first;
+                sqe->buf_group = provided_buffers_group;
+                sqe->user_data = ignored_token;
+                commit_sqe();
+            }
+
+            void reap(op_queue& completed) noexcept {
+                unsigned head = *cq_head_;
+                unsigned tail = load_acquire(cq_tail_);
+                for (; head != tail; ++head) {
+                    io_uring_cqe cqe = cqes_[head & cq_mask_];
+                    process(cqe, completed);
+                }
+                store_release(cq_head_, head);
+            }
+
+            void process(const io_uring_cqe& cqe, op_queue& completed) noexcept {
+                bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+                if (cqe.user_data == interrupter_token) {
+                    if (!more) {
+                        std::lock_guard lock(sq_mutex_);
+                        arm_interrupter();
+                    }
+                    return;
+                }
+                if (cqe.user_data == ignored_token) return;
+
+                auto* op = reinterpret_cast<io_operation*>(uintptr_t(cqe.user_data));
+                if (!more) --in_flight_;
+
+                if (!op->native_mode) {
+                    if (cqe.res < 0) {
+                        op->ec = native_error(cqe.res);
+                        completed.push(op);
+                    } else if (op->perform()) {
+                        completed.push(op);
+                    } else if (int error = submit_poll(op); error != 0 && fail_submission(op, error)) {
+                        completed.push(op);
+                    }
+                    return;
+                }
+
+                provided_buffer buffer;
+                if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+                    buffer.id = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                    buffer.pool = this;
+                    buffer.data = memory_view<uint8_t>(buffer_memory_.get() + size_t(buffer.id) * multishot_buffer_size,
+                                                       multishot_buffer_size);
+                    std::lock_guard lock(buffers_mutex_);
+                    ++buffers_in_use_;
+                }
+                native_status status = op->on_native_result(cqe.res, more, buffer);
+                buffer.release(); // if not taken by operation
+
+                bool multishot = (op->backend_data & multishot_flag) != 0;
+                switch (status) {
+                case native_status::finished:
+                    if (!multishot || op->schedule()) {
+                        completed.push(op);
+                    } else {
+                        // Already queued to deliver previous results, that
+                        // invocation will deliver final result too.
+                        work_finished();
+                    }
+                    break;
+                case native_status::more:
+                    if (op->schedule()) {
+                        work_started();
+                        completed.push(op);
+                    }
+                    break;
+                case native_status::resubmit:
+                    if (multishot && op->schedule()) {
+                        work_started();
+                        completed.push(op);
+                    }
+                    if (cqe.res == -ENOBUFS) {
+                        wait_for_buffers(op);
+                    } else if (int error = submit_native(op, op->native()); error != 0 && fail_submission(op, error)) {
+                        completed.push(op);
+                    }
+                    break;
+                }
+            }
+
+            void wait_for_buffers(io_operation* op) noexcept {
+                {
+                    std::lock_guard lock(buffers_mutex_);
+                    // Some buffers may be recycled after kernel reported error.
+                    if (buffers_in_use_ == provided_buffers) {
+                        starving_.push(op);
+                        return;
+                    }
+                }
+                if (int error = submit_native(op, op->native()); error != 0 && fail_submission(op, error)) post(op);
+            }
+
+            void wake_followers() noexcept {
+                {
+                    std::lock_guard lock(wait_mutex_);
+                    ++generation_;
+                }
+                wait_cv_.notify_all();
+            }
+
+            /**
+             * Cancel all requests and destroy operations as kernel
+             * reports their completion.
+             */
+            void cancel_all() noexcept {
+                {
+                    std::lock_guard lock(sq_mutex_);
+                    int error = 0;
+                    if (io_uring_sqe* sqe = acquire_sqe(error)) {
+                        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+                        sqe->user_data = ignored_token;
+                        commit_sqe();
+                        submit_locked();
+                    }
+                }
+
+                while (in_flight_ != 0) {
+                    __kernel_timespec timeout{1, 0};
+                    io_uring_getevents_arg argument{};
+                    argument.ts = reinterpret_cast<uintptr_t>(&timeout);
+                    int status = io_uring_enter(ring_, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &argument,
+                                                sizeof(argument));
+                    if (status == -1 && errno == ETIME) break;
+
+                    unsigned head = *cq_head_;
+                    unsigned tail = load_acquire(cq_tail_);
+                    for (; head != tail; ++head) {
+                        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                        if (cqe.user_data == interrupter_token || cqe.user_data == ignored_token) continue;
+                        if ((cqe.flags & IORING_CQE_F_MORE) != 0) continue;
+
+                        --in_flight_;
+                        auto* op = reinterpret_cast<io_operation*>(uintptr_t(cqe.user_data));
+                        if (op->native_mode && (op->backend_data & multishot_flag) != 0) {
+                            // Operation may be queued for handler invocation, then
+                            // it's destroyed by io_context.
+                            provided_buffer no_buffer;
+                            op->on_native_result(-ECANCELED, false, no_buffer);
+                            if (!op->schedule()) continue;
+                        }
+                        delete op;
+                    }
+                    store_release(cq_head_, head);
+                }
+            }
+
+            bool ready_ = false;
+            int ring_ = -1;
+            int interrupter_fd_ = -1;
+
+            void* sq_ring_ = MAP_FAILED;
+            size_t sq_ring_size_ = 0;
+            void* cq_ring_ = MAP_FAILED;
+            size_t cq_ring_size_ = 0;
+            io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+            size_t sqes_size_ = 0;
+
+            unsigned* sq_head_ = nullptr;
+            unsigned* sq_tail_ = nullptr;
+            unsigned* sq_array_ = nullptr;
+            unsigned sq_mask_ = 0;
+            unsigned sq_entries_ = 0;
+
+            unsigned* cq_head_ = nullptr;
+            unsigned* cq_tail_ = nullptr;
+            unsigned cq_mask_ = 0;
+            io_uring_cqe* cqes_ = nullptr;
+
+            /// Protects SQ ring and pending_.
+            std::mutex sq_mutex_;
+
+            /// SQEs not yet passed to kernel.
+            unsigned pending_ = 0;
+
+            /// Requests submitted and not finished yet.
+            std::atomic<size_t> in_flight_{0};
+
+            /// Held by leader thread.
+            std::mutex reap_mutex_;
+
+            std::mutex wait_mutex_;
+            std::condition_variable wait_cv_;
+            std::atomic<uint64_t> generation_{0};
+
+            std::mutex buffers_mutex_;
+            std::unique_ptr<uint8_t[]> buffer_memory_;
+            unsigned buffers_in_use_ = 0;
+
+            /// Multishot receives stopped because all buffers were in use.
+            op_queue starving_;
+
+            std::mutex files_mutex_;
+            std::vector<int> slots_;
+            std::vector<int> free_slots_;
+        };
+    } // namespace
+
+    std::unique_ptr<io_backend> make_uring_backend(io_context& owner, std::error_code& ec) {
+        return std::make_unique<uring_backend>(owner, ec);
+    }
+} // namespace libwire::internal_
+
+#endif // if defined(__linux__) && defined(LIBWIRE_IO_URING)
@@ -0,0 +1,440 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include "libwire/io_context.hpp"
+
+#include <climits>
+#include <cstring>
+#include "libwire/internal/io_backend.hpp"
+#include "libwire/internal/socket_utils.hpp"
+
+namespace libwire {
+    /**
+     * Per-thread data of thread executing run().
+     */
+    struct io_context::thread_state {
+        explicit thread_state(io_context* owner) : owner(owner), previous(current) {
+            current = this;
+            ++owner->running_threads_;
+        }
+
+        ~thread_state() {
+            current = previous;
+            --owner->running_threads_;
+            owner->backend_->flush();
+
+            // Don't leave completed operations to thread which is going away.
+            if (private_queue.empty()) return;
+            {
+                std::lock_guard lock(owner->queue_mutex_);
+                owner->queue_.splice(private_queue);
+            }
+            owner->interrupt();
+        }
+
+        thread_state(const thread_state&) = delete;
+        thread_state& operator=(const thread_state&) = delete;
+
+        /// Handlers completed by this thread, executed without locking.
+        internal_::op_queue private_queue;
+
+        io_context* owner;
+        thread_state* previous;
+
+        static thread_local thread_state* current;
+    };
+
+    thread_local io_context::thread_state* io_context::thread_state::current = nullptr;
+
+    namespace {
+        void destroy_queue(internal_::op_queue& queue) noexcept {
+            while (!queue.empty()) delete queue.pop();
+        }
+
+        bool is_canceled(const std::error_code& ec) noexcept {
+            return ec == std::error_code(ECANCELED, error::system_category());
+        }
+    } // namespace
+
+    io_context::io_context(std::error_code& ec, backend_type preferred) noexcept {
+        open(preferred, ec);
+    }
+
+#ifdef __cpp_exceptions
+    io_context::io_context(backend_type preferred) {
+        std::error_code ec;
+        open(preferred, ec);
+        if (ec) throw std::system_error(ec);
+    }
+#endif
+
+    void io_context::open(backend_type preferred, std::error_code& ec) noexcept {
+#ifdef LIBWIRE_IO_URING
+        if (preferred != backend_type::epoll) {
+            // Any error here means that kernel is too old or io_uring is
+            // disabled (e.g. by seccomp policy), so just use epoll.
+            std::error_code uring_ec;
+            backend_ = internal_::make_uring_backend(*this, uring_ec);
+            if (!uring_ec) {
+                backend_type_ = backend_type::io_uring;
+                return;
+            }
+            backend_.reset();
+        }
+#else
+        (void)preferred;
+#endif
+        backend_ = internal_::make_epoll_backend(*this, ec);
+        backend_type_ = backend_type::epoll;
+    }
+
+    io_context::~io_context() {
+        // Backend first, because it may need to check whether
+        // operation is still queued for handler invocation.
+        backend_.reset();
+        destroy_queue(queue_);
+
+        // Operations they were waiting for are gone, so they will never resume.
+        for (;;) {
+            internal_::spawned_frame* frame;
+            {
+                std::lock_guard lock(spawned_mutex_);
+                frame = spawned_;
+                if (frame == nullptr) break;
+                spawned_ = frame->next;
+                if (spawned_ != nullptr) spawned_->prev = nullptr;
+            }
+            frame->destroy(frame);
+        }
+    }
+
+    size_t io_context::run() {
+        thread_state thread{this};
+        size_t handled = 0;
+        while (run_one_impl(thread, true)) ++handled;
+        return handled;
+    }
+
+    size_t io_context::run_one() {
+        thread_state thread{this};
+        return run_one_impl(thread, true) ? 1 : 0;
+    }
+
+    size_t io_context::poll() {
+        thread_state thread{this};
+        size_t handled = 0;
+        while (run_one_impl(thread, false)) ++handled;
+        return handled;
+    }
+
+    void io_context::stop() noexcept {
+        stopped_ = true;
+        interrupt();
+    }
+
+    bool io_context::stopped() const noexcept {
+        return stopped_;
+    }
+
+    void io_context::restart() noexcept {
+        stopped_ = false;
+    }
+
+    io_context::backend_type io_context::backend() const noexcept {
+        return backend_type_;
+    }
+
+    void io_context::enqueue_post(internal_::io_operation* op) {
+        ++outstanding_;
+        post_completion(op);
+    }
+
+    void io_context::post_completion(internal_::io_operation* op) {
+        if (running_in_this_thread()) {
+            thread_state::current->private_queue.push(op);
+            return;
+        }
+
+        {
+            std::lock_guard lock(queue_mutex_);
+            queue_.push(op);
+        }
+        interrupt();
+    }
+
+    size_t io_context::share_completions(internal_::op_queue& completed) {
+        unsigned threads = running_threads_;
+        if (threads < 2 || completed.empty()) return 0;
+
+        // Keep first operation, so calling thread has work to do.
+        internal_::op_queue rest;
+        internal_::io_operation* first = completed.pop();
+        rest.splice(completed);
+        completed.push(first);
+        if (rest.empty()) return 0;
+
+        size_t shared = 0;
+        for (internal_::io_operation* op = rest.front(); op != nullptr && shared < threads - 1; op = op->next) ++shared;
+
+        std::lock_guard lock(queue_mutex_);
+        queue_.splice(rest);
+        return shared;
+    }
+
+    bool io_context::running_in_this_thread() const noexcept {
+        thread_state* thread = thread_state::current;
+        return thread != nullptr && thread->owner == this;
+    }
+
+    void io_context::start(internal_::socket& socket, internal_::io_operation* op, internal_::io_direction dir) {
+        ++outstanding_;
+        op->handle = socket.handle;
+
+        std::error_code ec;
+        socket.make_internal_non_blocking(ec);
+        if (ec) {
+            op->ec = ec;
+            post_completion(op);
+            return;
+        }
+
+        backend_->start(socket, op, dir);
+    }
+
+    void io_context::start(internal_::socket& socket, internal_::io_operation* op, internal_::io_direction dir,
+                           std::chrono::milliseconds timeout) {
+        op->deadline.callback = [this, op] { expire_deadline(op); };
+
+        // Deadline can't expire until operation is passed to backend,
+        // because callbacks are executed with this lock held.
+        std::lock_guard lock(timers_mutex_);
+        arm_timer(op->deadline, timeout);
+        start(socket, op, dir);
+    }
+
+    void io_context::schedule(timing_wheel::timer& timer, std::chrono::milliseconds timeout) {
+        std::lock_guard lock(timers_mutex_);
+        arm_timer(timer, timeout);
+    }
+
+    bool io_context::cancel_timer(timing_wheel::timer& timer) noexcept {
+        std::lock_guard lock(timers_mutex_);
+        if (!timer.cancel()) return false;
+        update_timers_state();
+
+        // Let threads waiting only for timers return from run().
+        if (armed_timers_ == 0 && outstanding_ == 0) interrupt();
+        return true;
+    }
+
+    void io_context::arm_timer(timing_wheel::timer& timer, std::chrono::milliseconds timeout) {
+        timing_wheel::clock::rep previous = next_timer_;
+        bool was_empty = timers_.empty();
+        timers_.schedule(timer, timing_wheel::clock::now() + timeout);
+        update_timers_state();
+
+        // Threads may be waiting with timeout for later timer or without it.
+        if (was_empty || next_timer_ < previous) interrupt();
+    }
+
+    void io_context::update_timers_state() noexcept {
+        armed_timers_ = timers_.size();
+        std::optional<timing_wheel::clock::time_point> next = timers_.next_expiry();
+        if (next) next_timer_ = next->time_since_epoch().count();
+    }
+
+    int io_context::expire_timers() {
+        if (armed_timers_ == 0) return -1;
+
+        timing_wheel::clock::time_point now = timing_wheel::clock::now();
+        timing_wheel::clock::time_point next{timing_wheel::clock::duration(next_timer_.load())};
+        if (now >= next) {
+            std::lock_guard lock(timers_mutex_);
+            struct state_guard {
+                io_context& context;
+                ~state_guard() {
+                    context.update_timers_state();
+                }
+            } guard{*this};
+            timers_.advance(now);
+            if (timers_.empty()) return -1;
+            next = *timers_.next_expiry();
+        }
+
+        auto timeout = std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+        return int(std::min<decltype(timeout)>(timeout, INT_MAX));
+    }
+
+    void io_context::expire_deadline(internal_::io_operation* op) noexcept {
+        op->timed_out = true;
+        backend_->cancel_operation(op);
+    }
+
+    void io_context::disarm_deadline(internal_::io_operation* op) noexcept {
+        {
+            std::lock_guard lock(timers_mutex_);
+            if (op->deadline.cancel()) update_timers_state();
+        }
+        if (op->timed_out && is_canceled(op->ec)) op->ec = std::error_code(ETIMEDOUT, error::system_category());
+    }
+
+    void io_context::cancel_descriptor(internal_::socket::native_handle_t handle) noexcept {
+        backend_->cancel(handle);
+    }
+
+    void io_context::register_descriptor(internal_::socket::native_handle_t handle, std::error_code& ec) noexcept {
+        backend_->register_descriptor(handle, ec);
+    }
+
+    void io_context::unregister_descriptor(internal_::socket::native_handle_t handle) noexcept {
+        backend_->unregister_descriptor(handle);
+    }
+
+    void io_context::interrupt() noexcept {
+        backend_->interrupt();
+    }
+
+    void io_context::work_finished() noexcept {
+        if (--outstanding_ == 0) interrupt();
+    }
+
+    bool io_context::run_one_impl(thread_state& thread, bool block) {
+        for (;;) {
+            if (stopped_) {
+                // Wake up next thread so it can notice stop too.
+                interrupt();
+                break;
+            }
+
+            int timeout = expire_timers();
+
+            internal_::io_operation* op = thread.private_queue.pop();
+            if (op == nullptr) {
+                std::lock_guard lock(queue_mutex_);
+                op = queue_.pop();
+            }
+            if (op != nullptr) {
+                struct work_guard {
+                    io_context& context;
+                    ~work_guard() {
+                        context.work_finished();
+                    }
+                } guard{*this};
+                if (op->deadline.callback) disarm_deadline(op);
+                op->complete();
+                return true;
+            }
+
+            if (outstanding_ == 0 && armed_timers_ == 0) {
+                interrupt();
+                break;
+            }
+
+            backend_->wait(block ? timeout : 0, thread.private_queue);
+
+            if (!block && thread.private_queue.empty()) {
+                std::lock_guard lock(queue_mutex_);
+                if (queue_.empty()) break;
+            }
+        }
+        return false;
+    }
+} // namespace libwire
+
+namespace libwire::internal_ {
+    void io_backend::post(io_operation* op) {
+        owner_.post_completion(op);
+    }
+
+    void io_backend::work_started() noexcept {
+        ++owner_.outstanding_;
+    }
+
+    void io_backend::work_finished() noexcept {
+        owner_.work_finished();
+    }
+
+    size_t io_backend::share(op_queue& completed) {
+        return owner_.share_completions(completed);
+    }
+
+    bool io_backend::running_in_this_thread() const noexcept {
+        return owner_.running_in_this_thread();
+    }
+
+    frame_pool* current_frame_pool() noexcept {
+        io_context::thread_state* thread = io_context::thread_state::current;
+        return thread != nullptr ? &thread->owner->frames_ : nullptr;
+    }
+
+    frame_pool& coroutine_access::pool(io_context& context) noexcept {
+        return context.frames_;
+    }
+
+    void coroutine_access::attach(io_context& context, spawned_frame* frame) noexcept {
+        std::lock_guard lock(context.spawned_mutex_);
+        frame->prev = nullptr;
+        frame->next = context.spawned_;
+        if (context.spawned_ != nullptr) context.spawned_->prev = frame;
+        context.spawned_ = frame;
+    }
+
+    void coroutine_access::detach(io_context& context, spawned_frame* frame) noexcept {
+        std::lock_guard lock(context.spawned_mutex_);
+        if (frame->prev != nullptr) {
+            frame->prev->next = frame->next;
+        } else {
+            context.spawned_ = frame->next;
+        }
+        if (frame->next != nullptr) frame->next->prev = frame->prev;
+        frame->prev = frame->next = nullptr;
+    }
+
+    void restart_operation(io_context& context, socket& socket, io_operation* op, io_direction dir) {
+        op->restarted = true;
+        context.start(socket, op, dir);
+    }
+
+    void native_message::prepare(void* data, size_t size, const endpoint* destination, bool v4_mapped) noexcept {
+        vector.iov_base = data;
+        vector.iov_len = size;
+        header = msghdr{};
+        header.msg_iov = &vector;
+        header.msg_iovlen = 1;
+        header.msg_name = &address_storage;
+        if (destination != nullptr) {
+            endpoint native = v4_mapped ? destination->v4_mapped() : *destination;
+            std::memcpy(&address_storage, native.data(), native.size());
+            header.msg_namelen = native.size();
+        } else {
+            header.msg_namelen = sizeof(address_storage);
+        }
+    }
+
+    std::tuple<address, uint16_t> native_message::source() const noexcept {
+        return sockaddr_to_endpoint(address_storage);
+    }
+} // namespace libwire::internal_
+
+#endif // ifdef __linux__
@@ -23,4 +23,5 @@
 #include "libwire/memory_view.hpp"
 
 template class libwire::memory_view<uint8_t>;
+template class libwire::memory_view<const uint8_t>;
 template class libwire::memory_view<int8_t>;
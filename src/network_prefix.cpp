@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/network_prefix.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace libwire {
+#ifdef __cpp_exceptions
+    network_prefix::network_prefix(std::string_view text) : network_prefix(ipv4::any, 0) {
+        bool success = true;
+        *this = network_prefix(text, success);
+        if (!success) throw std::invalid_argument("Invalid network prefix string");
+    }
+#endif
+
+    network_prefix::network_prefix(std::string_view text, bool& success) noexcept : network_prefix(ipv4::any, 0) {
+        bool ipv6 = false;
+        uint8_t parsed_length = 0;
+        success = internal_::parse_prefix(text.data(), text.size(), base.parts.data(), ipv6, parsed_length);
+        if (!success) return;
+        if (ipv6) base.version = ip::v6;
+        *this = network_prefix(base, parsed_length);
+    }
+
+    std::string network_prefix::to_string() const {
+        char buffer[max_text_size];
+        return std::string(buffer, to_chars(buffer, buffer + sizeof(buffer)).ptr);
+    }
+
+    std::to_chars_result network_prefix::to_chars(char* first, char* last) const noexcept {
+        char buffer[max_text_size];
+        char* current = base.to_chars(buffer, buffer + sizeof(buffer)).ptr;
+        *current++ = '/';
+        current = std::to_chars(current, buffer + sizeof(buffer), unsigned(length)).ptr;
+
+        auto size = size_t(current - buffer);
+        if (size > size_t(last - first)) return {last, std::errc::value_too_large};
+        std::memcpy(first, buffer, size);
+        return {first + size, std::errc{}};
+    }
+} // namespace libwire
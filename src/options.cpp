@@ -27,6 +27,7 @@
 #ifdef _WIN32
 #    include <ws2tcpip.h>
 #else
+#    include <netinet/in.h>
 #    include <sys/socket.h>
 #    include <fcntl.h>
 #endif
@@ -125,4 +126,37 @@ namespace libwire {
 
         setsockopt(socket.handle, SOL_SOCKET, SO_SNDBUF, (const char*)&size, sizeof(size));
     }
+
+    bool zero_copy_t::get_impl(const internal_::socket& socket) noexcept {
+        return socket.state.zero_copy;
+    }
+
+    void zero_copy_t::set_impl(internal_::socket& socket, bool enable) noexcept {
+        assert(socket);
+
+#ifdef SO_ZEROCOPY
+        int value = enable;
+        if (setsockopt(socket.handle, SOL_SOCKET, SO_ZEROCOPY, (const char*)&value, sizeof(value)) == 0) {
+            socket.state.zero_copy = enable;
+        }
+#else
+        (void)enable;
+#endif
+    }
+
+    bool ipv6_only_t::get_impl(const internal_::socket& socket) noexcept {
+        assert(socket);
+
+        int value = 0;
+        socklen_t size = sizeof(value);
+        if (getsockopt(socket.handle, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&value, &size) != 0) return false;
+        return value != 0;
+    }
+
+    void ipv6_only_t::set_impl(internal_::socket& socket, bool enable) noexcept {
+        assert(socket);
+
+        int value = enable;
+        setsockopt(socket.handle, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&value, sizeof(value));
+    }
 } // namespace libwire
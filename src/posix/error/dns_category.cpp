@@ -32,6 +32,8 @@ std::string libwire::internal_::dns_category::message(int code) const noexcept {
     switch (code) {
     case 0: return "Success";
     case EAI_AGAIN: return "Host not found (try again)";
+    case EAI_NONAME: return "Host not found";
+    case EAI_FAIL: return "Non-recoverable name server failure";
 #ifdef EAI_NODATA
     case EAI_NODATA: return "No address";
 #endif
@@ -51,6 +53,10 @@ std::error_condition libwire::internal_::dns_category::default_error_condition(i
         return std::error_condition(error::host_not_found_try_again, error::dns_category());
     }
 
+    if (code == EAI_NONAME) {
+        return std::error_condition(error::host_not_found, error::dns_category());
+    }
+
     // We can safetly define then to 0 because first branch cuts away
     // real success value.
 #ifndef EAI_NODATA
@@ -80,6 +86,12 @@ bool libwire::internal_::dns_category::equivalent(int code, const std::error_con
         return condition.value() == error::host_not_found_try_again;
     }
 
+    // host_not_found has same value as error::success, so category
+    // must be compared too.
+    if (code == EAI_NONAME) {
+        return condition == std::error_condition(error::host_not_found, error::dns_category());
+    }
+
     // We can safetly define then to 0 because first branch cuts away
     // real success value.
 #ifndef EAI_NODATA
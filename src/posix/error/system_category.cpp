@@ -49,9 +49,11 @@
     MAP_CODE_3(ESHUTDOWN,       error::shutdown, error::generic::disconnected); \
     MAP_CODE_3(EHOSTDOWN,       error::host_down, error::generic::no_destination); \
     MAP_CODE_3(EHOSTUNREACH,    error::host_unreachable, error::generic::no_destination); \
+    MAP_CODE  (ETIMEDOUT,       error::timeout); \
     \
     /* Our custom code. */ \
     MAP_CODE_3(EOF,             error::end_of_file, error::generic::disconnected); \
+    MAP_CODE  (ECANCELED,       error::operation_aborted); \
     \
     MAP_CODE(EFAULT,       error::unexpected); \
     MAP_CODE(EISCONN,      error::unexpected); \
@@ -94,6 +96,8 @@ std::string libwire::internal_::system_category::message(int code) const noexcep
     case ESHUTDOWN:          return "Endpoint shutdown";
     case EHOSTDOWN:          return "Host is down";
     case EHOSTUNREACH:       return "Host is unreachable";
+    case ETIMEDOUT:          return "Operation timed out";
+    case ECANCELED:          return "Operation canceled";
     default:                 return strerror(code);
     }
     // clang-format on
@@ -0,0 +1,465 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/prefix_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <tuple>
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define LIBWIRE_TARGET(isa) __attribute__((target(isa)))
+#else
+#    define LIBWIRE_TARGET(isa)
+#endif
+
+namespace libwire {
+    namespace {
+        constexpr unsigned direct_bits = 16, stride = 6;
+        constexpr uint32_t node_flag = 0x80000000;
+
+        // Prefix with address as 128-bit big-endian number, IPv4
+        // addresses occupy top 32 bits. Bits past length are zero.
+        struct prefix_entry {
+            uint64_t high, low;
+            uint8_t length;
+            uint32_t value;
+
+            bool operator<(const prefix_entry& o) const noexcept {
+                return std::tie(high, low, length) < std::tie(o.high, o.low, o.length);
+            }
+
+            bool same_prefix(const prefix_entry& o) const noexcept {
+                return high == o.high && low == o.low && length == o.length;
+            }
+        };
+
+        struct poptrie_node {
+            uint64_t vector;  // Bit per child, set if child is a node.
+            uint64_t leafvec; // Bit per child, set if child starts run of equal leaves.
+            uint32_t base0;   // Index of first leaf.
+            uint32_t base1;   // Index of first child node.
+        };
+
+        inline uint64_t load_big_endian(const uint8_t* bytes) noexcept {
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+            uint64_t result;
+            std::memcpy(&result, bytes, sizeof(result));
+#    ifdef _MSC_VER
+            return _byteswap_uint64(result);
+#    else
+            return __builtin_bswap64(result);
+#    endif
+#else
+            uint64_t result = 0;
+            for (int i = 0; i < 8; ++i) result = (result << 8u) | bytes[i];
+            return result;
+#endif
+        }
+
+        inline unsigned family_index(ip version) noexcept {
+            return version == ip::v4 ? 0 : 1;
+        }
+
+        inline void address_key(const address& addr, uint64_t& high, uint64_t& low) noexcept {
+            if (addr.version == ip::v4) {
+                high = load_big_endian(addr.parts.data()) & 0xffffffff00000000ull;
+                low = 0;
+            } else {
+                high = load_big_endian(addr.parts.data());
+                low = load_big_endian(addr.parts.data() + 8);
+            }
+        }
+
+        // Bits [offset, offset + stride) of 128-bit key, bits past end
+        // of key are zero.
+        inline unsigned chunk(uint64_t high, uint64_t low, unsigned offset) noexcept {
+            if (offset <= 64 - stride) return unsigned(high >> (64 - stride - offset)) & 0x3f;
+            if (offset >= 64) {
+                offset -= 64;
+                if (offset <= 64 - stride) return unsigned(low >> (64 - stride - offset)) & 0x3f;
+                return unsigned(low << (offset - (64 - stride))) & 0x3f;
+            }
+            return unsigned((high << (offset - (64 - stride))) | (low >> (128 - stride - offset))) & 0x3f;
+        }
+
+        // Without -mpopcnt compilers turn __builtin_popcountll into
+        // library call, which is slower than this.
+        inline unsigned popcount_portable(uint64_t value) noexcept {
+            value -= (value >> 1u) & 0x5555555555555555ull;
+            value = (value & 0x3333333333333333ull) + ((value >> 2u) & 0x3333333333333333ull);
+            value = (value + (value >> 4u)) & 0x0f0f0f0f0f0f0f0full;
+            return unsigned((value * 0x0101010101010101ull) >> 56u);
+        }
+
+#ifdef LIBWIRE_X86_KERNELS
+        // Compiles to single instruction only inside
+        // LIBWIRE_TARGET("popcnt") functions.
+        inline unsigned popcount_hardware(uint64_t value) noexcept {
+#    ifdef _MSC_VER
+#        ifdef _M_X64
+            return unsigned(__popcnt64(value));
+#        else
+            return unsigned(__popcnt(uint32_t(value)) + __popcnt(uint32_t(value >> 32u)));
+#        endif
+#    else
+            return unsigned(__builtin_popcountll(value));
+#    endif
+        }
+#endif
+
+        class poptrie {
+        public:
+            void build(const std::vector<prefix_entry>& entries) {
+                if (entries.empty()) return;
+
+                std::vector<uint32_t> defaults(size_t(1) << direct_bits, prefix_table::no_match);
+                for (const prefix_entry& entry : entries) {
+                    if (entry.length > direct_bits) continue;
+                    // Entries are sorted by address, so prefix always
+                    // comes before more specific ones it contains and
+                    // gets overwritten.
+                    auto first = ptrdiff_t(entry.high >> (64 - direct_bits));
+                    std::fill_n(defaults.begin() + first, size_t(1) << (direct_bits - entry.length), entry.value);
+                }
+
+                direct_.assign(defaults.size(), 0);
+                uint32_t last_leaf = 0;
+                bool have_leaf = false;
+                size_t next = 0; // First unprocessed entry.
+                for (size_t slot = 0; slot < direct_.size(); ++slot) {
+                    // Entries longer than direct_bits of this slot are
+                    // contiguous (see build_node).
+                    size_t group_begin = entries.size(), group_end = entries.size();
+                    while (next < entries.size() && (entries[next].high >> (64 - direct_bits)) == slot) {
+                        if (entries[next].length > direct_bits) {
+                            if (group_begin == entries.size()) group_begin = next;
+                            group_end = next + 1;
+                        }
+                        ++next;
+                    }
+
+                    if (group_begin != entries.size()) {
+                        uint32_t node_index = allocate_nodes(1);
+                        poptrie_node node = build_node(entries, direct_bits, group_begin, group_end, defaults[slot]);
+                        nodes_[node_index] = node;
+                        direct_[slot] = node_flag | node_index;
+                        continue;
+                    }
+
+                    if (!have_leaf || leaves_[last_leaf] != defaults[slot]) {
+                        last_leaf = uint32_t(leaves_.size());
+                        leaves_.push_back(defaults[slot]);
+                        have_leaf = true;
+                    }
+                    direct_[slot] = last_leaf;
+                }
+            }
+
+            template <unsigned (*Popcount)(uint64_t) noexcept>
+            uint32_t lookup(uint64_t high, uint64_t low) const noexcept {
+                if (direct_.empty()) return prefix_table::no_match;
+
+                uint32_t entry = direct_[high >> (64 - direct_bits)];
+                if ((entry & node_flag) == 0) return leaves_[entry];
+
+                const poptrie_node* node = &nodes_[entry & ~node_flag];
+                for (unsigned offset = direct_bits;; offset += stride) {
+                    unsigned index = chunk(high, low, offset);
+                    // All bits up to index (inclusive), wraps to all ones for 63.
+                    uint64_t up_to = (uint64_t(2) << index) - 1;
+                    if (((node->vector >> index) & 1u) == 0) {
+                        return leaves_[node->base0 + Popcount(node->leafvec & up_to) - 1];
+                    }
+                    node = &nodes_[node->base1 + Popcount(node->vector & up_to) - 1];
+                }
+            }
+
+            size_t memory_usage() const noexcept {
+                return direct_.size() * sizeof(uint32_t) + nodes_.size() * sizeof(poptrie_node) +
+                       leaves_.size() * sizeof(uint32_t);
+            }
+
+        private:
+            uint32_t allocate_nodes(size_t count) {
+                auto first = uint32_t(nodes_.size());
+                nodes_.resize(nodes_.size() + count);
+                return first;
+            }
+
+            // Build node for bits [depth, depth + stride) from entries
+            // [begin, end), all longer than depth and under this node.
+            // Addresses without more specific prefix get inherited value.
+            poptrie_node build_node(const std::vector<prefix_entry>& entries, unsigned depth, size_t begin,
+                                    size_t end, uint32_t inherited) {
+                uint32_t values[64];
+                std::fill_n(values, 64, inherited);
+                size_t child_begin[64], child_end[64];
+                poptrie_node node{0, 0, 0, 0};
+
+                for (size_t i = begin; i < end; ++i) {
+                    const prefix_entry& entry = entries[i];
+                    unsigned index = chunk(entry.high, entry.low, depth);
+                    if (entry.length <= depth + stride) {
+                        // Covers several children, see painting in build().
+                        std::fill_n(values + index, size_t(1) << (depth + stride - entry.length), entry.value);
+                        continue;
+                    }
+                    // Entries of one child are contiguous: shorter prefix
+                    // can't be placed between them by sorting order.
+                    if ((node.vector & (uint64_t(1) << index)) == 0) child_begin[index] = i;
+                    child_end[index] = i + 1;
+                    node.vector |= uint64_t(1) << index;
+                }
+
+                node.base0 = uint32_t(leaves_.size());
+                for (unsigned index = 0; index < 64; ++index) {
+                    if ((node.vector >> index) & 1u) continue;
+                    if (leaves_.size() == node.base0 || leaves_.back() != values[index]) {
+                        node.leafvec |= uint64_t(1) << index;
+                        leaves_.push_back(values[index]);
+                    }
+                }
+
+                node.base1 = allocate_nodes(popcount_portable(node.vector));
+                uint32_t child = node.base1;
+                for (unsigned index = 0; index < 64; ++index) {
+                    if (((node.vector >> index) & 1u) == 0) continue;
+                    poptrie_node built =
+                        build_node(entries, depth + stride, child_begin[index], child_end[index], values[index]);
+                    nodes_[child++] = built;
+                }
+                return node;
+            }
+
+            std::vector<uint32_t> direct_;
+            std::vector<poptrie_node> nodes_;
+            std::vector<uint32_t> leaves_;
+        };
+
+        struct family_table {
+            std::vector<prefix_entry> entries; // Sorted, unique.
+            poptrie trie;
+        };
+
+        prefix_entry make_entry(const network_prefix& prefix, uint32_t value) noexcept {
+            prefix_entry entry{0, 0, prefix.length, value};
+            address_key(prefix.base, entry.high, entry.low);
+            return entry;
+        }
+
+        std::shared_ptr<const family_table> build_family(std::vector<prefix_entry> entries) {
+            auto table = std::make_shared<family_table>();
+            table->entries = std::move(entries);
+            table->trie.build(table->entries);
+            return table;
+        }
+
+        size_t reader_shard() noexcept {
+            static std::atomic<size_t> next_shard{0};
+            thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed);
+            return shard;
+        }
+
+        uint32_t lookup_portable(const poptrie& trie, uint64_t high, uint64_t low) noexcept {
+            return trie.lookup<popcount_portable>(high, low);
+        }
+
+#ifdef LIBWIRE_X86_KERNELS
+        LIBWIRE_TARGET("popcnt")
+        uint32_t lookup_popcnt(const poptrie& trie, uint64_t high, uint64_t low) noexcept {
+            return trie.lookup<popcount_hardware>(high, low);
+        }
+
+        bool popcnt_supported() noexcept {
+#    ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 23)) != 0;
+#    else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("popcnt");
+#    endif
+        }
+#endif
+
+        using lookup_kernel = uint32_t (*)(const poptrie&, uint64_t, uint64_t) noexcept;
+
+        lookup_kernel pick_lookup_kernel() noexcept {
+#ifdef LIBWIRE_X86_KERNELS
+            if (popcnt_supported()) return lookup_popcnt;
+#endif
+            return lookup_portable;
+        }
+
+        lookup_kernel active_lookup_kernel() noexcept {
+            static const lookup_kernel kernel = pick_lookup_kernel();
+            return kernel;
+        }
+    } // namespace
+
+    struct prefix_table::snapshot {
+        std::shared_ptr<const family_table> families[2];
+    };
+
+    class prefix_table::read_guard {
+    public:
+        explicit read_guard(const prefix_table& table) noexcept {
+            size_t shard = reader_shard() % reader_shards;
+            for (;;) {
+                unsigned epoch = table.epoch_.load();
+                counter_ = &table.readers_[epoch & 1u][shard].active;
+                counter_->fetch_add(1);
+                // Recheck: if update switched epoch in between it may not
+                // wait for this counter, try again with new one.
+                if (table.epoch_.load() == epoch) break;
+                counter_->fetch_sub(1);
+            }
+        }
+
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+
+        ~read_guard() {
+            counter_->fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<size_t>* counter_;
+    };
+
+    prefix_table::prefix_table() {
+        auto* initial = new snapshot;
+        initial->families[0] = build_family({});
+        initial->families[1] = build_family({});
+        current_.store(initial);
+    }
+
+    prefix_table::~prefix_table() {
+        delete current_.load();
+    }
+
+    uint32_t prefix_table::lookup(const address& addr) const noexcept {
+        uint64_t high, low;
+        address_key(addr, high, low);
+
+        lookup_kernel kernel = active_lookup_kernel();
+        read_guard guard(*this);
+        const snapshot* table = current_.load();
+        return kernel(table->families[family_index(addr.version)]->trie, high, low);
+    }
+
+    void prefix_table::insert(const network_prefix& prefix, uint32_t value) {
+        std::lock_guard lock(update_mutex_);
+        const snapshot* previous = current_.load();
+        unsigned family = family_index(prefix.base.version);
+
+        std::vector<prefix_entry> entries = previous->families[family]->entries;
+        prefix_entry entry = make_entry(prefix, value);
+        auto position = std::lower_bound(entries.begin(), entries.end(), entry);
+        if (position != entries.end() && position->same_prefix(entry)) {
+            if (position->value == value) return;
+            position->value = value;
+        } else {
+            entries.insert(position, entry);
+        }
+
+        auto* next = new snapshot(*previous);
+        next->families[family] = build_family(std::move(entries));
+        publish(next);
+    }
+
+    bool prefix_table::erase(const network_prefix& prefix) {
+        std::lock_guard lock(update_mutex_);
+        const snapshot* previous = current_.load();
+        unsigned family = family_index(prefix.base.version);
+
+        std::vector<prefix_entry> entries = previous->families[family]->entries;
+        prefix_entry entry = make_entry(prefix, 0);
+        auto position = std::lower_bound(entries.begin(), entries.end(), entry);
+        if (position == entries.end() || !position->same_prefix(entry)) return false;
+        entries.erase(position);
+
+        auto* next = new snapshot(*previous);
+        next->families[family] = build_family(std::move(entries));
+        publish(next);
+        return true;
+    }
+
+    void prefix_table::assign(const std::vector<std::pair<network_prefix, uint32_t>>& entries) {
+        std::vector<prefix_entry> families[2];
+        for (const auto& [prefix, value] : entries) {
+            families[family_index(prefix.base.version)].push_back(make_entry(prefix, value));
+        }
+
+        auto* next = new snapshot;
+        for (unsigned family = 0; family < 2; ++family) {
+            auto& list = families[family];
+            // Keep last value of duplicates: stable sort keeps input
+            // order of equal prefixes, then take last of each run.
+            std::stable_sort(list.begin(), list.end());
+            auto out = list.begin();
+            for (auto it = list.begin(); it != list.end(); ++it) {
+                if (std::next(it) != list.end() && std::next(it)->same_prefix(*it)) continue;
+                *out++ = *it;
+            }
+            list.erase(out, list.end());
+            next->families[family] = build_family(std::move(list));
+        }
+
+        std::lock_guard lock(update_mutex_);
+        publish(next);
+    }
+
+    void prefix_table::clear() {
+        assign({});
+    }
+
+    size_t prefix_table::size() const noexcept {
+        read_guard guard(*this);
+        const snapshot* table = current_.load();
+        return table->families[0]->entries.size() + table->families[1]->entries.size();
+    }
+
+    size_t prefix_table::memory_usage() const noexcept {
+        read_guard guard(*this);
+        const snapshot* table = current_.load();
+        return table->families[0]->trie.memory_usage() + table->families[1]->trie.memory_usage();
+    }
+
+    void prefix_table::publish(snapshot* next) {
+        const snapshot* previous = current_.exchange(next);
+        unsigned epoch = epoch_.fetch_add(1);
+        // Lookups counted with old epoch may still use previous table,
+        // new ones will see only next table.
+        for (auto& counter : readers_[epoch & 1u]) {
+            while (counter.active.load() != 0) std::this_thread::yield();
+        }
+        delete previous;
+    }
+} // namespace libwire
@@ -0,0 +1,137 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/tcp/buffered_stream.hpp"
+
+#include <cassert>
+#include <cstring>
+
+namespace libwire::tcp {
+    template std::vector<uint8_t>& buffered_stream::read(size_t, std::vector<uint8_t>&, std::error_code&);
+    template std::string& buffered_stream::read(size_t, std::string&, std::error_code&);
+
+    template std::vector<uint8_t> buffered_stream::read(size_t, std::error_code&);
+    template std::string buffered_stream::read(size_t, std::error_code&);
+
+    template std::vector<uint8_t>& buffered_stream::peek(size_t, std::vector<uint8_t>&, std::error_code&);
+    template std::string& buffered_stream::peek(size_t, std::string&, std::error_code&);
+
+    template std::vector<uint8_t> buffered_stream::peek(size_t, std::error_code&);
+    template std::string buffered_stream::peek(size_t, std::error_code&);
+
+    template std::vector<uint8_t> buffered_stream::read_until(uint8_t, std::error_code&, size_t);
+    template std::string buffered_stream::read_until(uint8_t, std::error_code&, size_t);
+
+    template std::vector<uint8_t>& buffered_stream::read_until(uint8_t, std::vector<uint8_t>&, std::error_code&,
+                                                               size_t);
+    template std::string& buffered_stream::read_until(uint8_t, std::string&, std::error_code&, size_t);
+
+    template std::vector<uint8_t> buffered_stream::read_until(std::string_view, std::error_code&, size_t);
+    template std::string buffered_stream::read_until(std::string_view, std::error_code&, size_t);
+
+    template std::vector<uint8_t>& buffered_stream::read_until(std::string_view, std::vector<uint8_t>&,
+                                                               std::error_code&, size_t);
+    template std::string& buffered_stream::read_until(std::string_view, std::string&, std::error_code&, size_t);
+
+    buffered_stream::buffered_stream(size_t buffer_size) : buffer_size_(buffer_size), buffer_(buffer_size) {
+        assert(buffer_size != 0);
+    }
+
+    buffered_stream::buffered_stream(socket&& sock, size_t buffer_size)
+        : next_layer_(std::move(sock)), buffer_size_(buffer_size), buffer_(buffer_size) {
+        assert(buffer_size != 0);
+    }
+
+    socket& buffered_stream::next_layer() noexcept {
+        return next_layer_;
+    }
+
+    const socket& buffered_stream::next_layer() const noexcept {
+        return next_layer_;
+    }
+
+    size_t buffered_stream::buffer_size() const noexcept {
+        return buffer_size_;
+    }
+
+    size_t buffered_stream::available() const noexcept {
+        return end_ - begin_;
+    }
+
+    size_t buffered_stream::fill(std::error_code& ec) noexcept {
+        if (begin_ == end_) {
+            discard();
+        } else if (end_ == buffer_.size() && begin_ != 0) {
+            // Move remaining data to front to make space for new data.
+            std::memmove(buffer_.data(), buffer_.data() + begin_, available());
+            end_ -= begin_;
+            begin_ = 0;
+        }
+
+        if (end_ == buffer_.size()) return 0;
+
+        memory_view<uint8_t> free_space{buffer_.data() + end_, buffer_.size() - end_};
+        next_layer_.read_some(free_space.size(), free_space, ec);
+        end_ += free_space.size();
+        return free_space.size();
+    }
+
+    void buffered_stream::discard() noexcept {
+        begin_ = end_ = 0;
+
+        // Drop growth caused by long line, capacity is kept for next one.
+        if (buffer_.size() > buffer_size_) buffer_.resize(buffer_size_);
+    }
+
+    size_t buffered_stream::take(void* output, size_t max_bytes) noexcept {
+        size_t count = std::min(max_bytes, available());
+        std::memcpy(output, buffer_.data() + begin_, count);
+        begin_ += count;
+        return count;
+    }
+
+#ifdef __cpp_exceptions
+    template std::vector<uint8_t>& buffered_stream::read(size_t, std::vector<uint8_t>&);
+    template std::string& buffered_stream::read(size_t, std::string&);
+
+    template std::vector<uint8_t> buffered_stream::read(size_t);
+    template std::string buffered_stream::read(size_t);
+
+    template std::vector<uint8_t>& buffered_stream::peek(size_t, std::vector<uint8_t>&);
+    template std::string& buffered_stream::peek(size_t, std::string&);
+
+    template std::vector<uint8_t> buffered_stream::peek(size_t);
+    template std::string buffered_stream::peek(size_t);
+
+    template std::vector<uint8_t>& buffered_stream::read_until(uint8_t, std::vector<uint8_t>&, size_t);
+    template std::string& buffered_stream::read_until(uint8_t, std::string&, size_t);
+
+    template std::vector<uint8_t> buffered_stream::read_until(uint8_t, size_t);
+    template std::string buffered_stream::read_until(uint8_t, size_t);
+
+    template std::vector<uint8_t>& buffered_stream::read_until(std::string_view, std::vector<uint8_t>&, size_t);
+    template std::string& buffered_stream::read_until(std::string_view, std::string&, size_t);
+
+    template std::vector<uint8_t> buffered_stream::read_until(std::string_view, size_t);
+    template std::string buffered_stream::read_until(std::string_view, size_t);
+#endif // ifdef __cpp_exceptions
+} // namespace libwire::tcp
@@ -0,0 +1,321 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/tcp/connection_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace libwire::tcp {
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        constexpr size_t shards_count = 16;
+        constexpr size_t stripes_count = 8;
+
+        struct endpoint_key {
+            address target;
+            uint16_t port;
+
+            bool operator==(const endpoint_key& other) const noexcept {
+                return port == other.port && target == other.target;
+            }
+        };
+
+        struct endpoint_hash {
+            size_t operator()(const endpoint_key& key) const noexcept {
+                return std::hash<address>()(key.target) * 31 + key.port;
+            }
+        };
+
+        struct idle_connection {
+            socket connection;
+            clock::time_point since;
+        };
+
+        /**
+         * Stripe used by calling thread, threads are assigned round-robin
+         * so they spread evenly.
+         */
+        size_t this_thread_stripe() noexcept {
+            static std::atomic<size_t> next_stripe{0};
+            thread_local size_t stripe = next_stripe++ % stripes_count;
+            return stripe;
+        }
+
+        /**
+         * Make room for one more entry, so following push_back can't
+         * throw. Returns false if memory can't be allocated.
+         */
+        bool reserve_slot(std::vector<idle_connection>& stack) noexcept {
+            if (stack.size() < stack.capacity()) return true;
+            size_t capacity = std::max<size_t>(stack.capacity() * 2, 4);
+#ifdef __cpp_exceptions
+            try {
+                stack.reserve(capacity);
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+#else
+            stack.reserve(capacity);
+#endif
+            return true;
+        }
+    } // namespace
+
+    /**
+     * Connections to one endpoint. Never freed before pool destruction,
+     * so connection handles can keep pointer to it.
+     */
+    struct connection_pool::endpoint_state {
+        struct alignas(64) stripe {
+            std::mutex mutex;
+
+            /// Used as stack, so most recently used connection is reused first.
+            std::vector<idle_connection> idle;
+        };
+
+        endpoint_state(address target, uint16_t port) : target(target), port(port) {
+        }
+
+        const address target;
+        const uint16_t port;
+
+        std::atomic<size_t> open{0};
+        std::atomic<size_t> idle{0};
+        std::array<stripe, stripes_count> stripes;
+    };
+
+    struct connection_pool::shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<endpoint_key, std::unique_ptr<endpoint_state>, endpoint_hash> endpoints;
+    };
+
+    namespace {
+        size_t shard_index(address target, uint16_t port) noexcept {
+            return endpoint_hash()({target, port}) % shards_count;
+        }
+    } // namespace
+
+    connection_pool::connection_pool() : connection_pool(limits{}) {
+    }
+
+    connection_pool::connection_pool(limits pool_limits)
+        : limits_(pool_limits), shards_(new shard[shards_count]) {
+    }
+
+    connection_pool::~connection_pool() = default;
+
+    connection_pool::connection connection_pool::checkout(address target, uint16_t port, std::error_code& ec) {
+        endpoint_state& endpoint = find_or_create(target, port);
+
+        socket result;
+        if (take_idle(endpoint, result)) return connection(*this, endpoint, std::move(result));
+
+        if (!reserve(endpoint)) {
+            ec = std::error_code(EAGAIN, error::system_category());
+            return {};
+        }
+        result.connect(target, port, ec);
+        if (ec) {
+            --endpoint.open;
+            return {};
+        }
+        return connection(*this, endpoint, std::move(result));
+    }
+
+#ifdef __cpp_exceptions
+    connection_pool::connection connection_pool::checkout(address target, uint16_t port) {
+        std::error_code ec;
+        connection result = checkout(target, port, ec);
+        if (ec) throw std::system_error(ec);
+        return result;
+    }
+#endif
+
+    size_t connection_pool::prewarm(address target, uint16_t port, size_t count, std::error_code& ec) {
+        endpoint_state& endpoint = find_or_create(target, port);
+
+        size_t added = 0;
+        for (; added < count && endpoint.idle < limits_.max_idle; ++added) {
+            if (!reserve(endpoint)) break;
+
+            socket result;
+            result.connect(target, port, ec);
+            if (ec) {
+                --endpoint.open;
+                break;
+            }
+            give_back(endpoint, std::move(result), true);
+        }
+        return added;
+    }
+
+    size_t connection_pool::reap_idle() {
+        clock::time_point now = clock::now();
+        size_t closed = 0;
+        for (size_t i = 0; i < shards_count; ++i) {
+            std::shared_lock shard_lock(shards_[i].mutex);
+            for (auto& [key, endpoint] : shards_[i].endpoints) {
+                for (auto& stripe : endpoint->stripes) {
+                    std::vector<idle_connection> expired;
+                    {
+                        // Entries are pushed with current time, so stack is ordered
+                        // by since and expired ones are at the bottom. Order of
+                        // the rest is kept, most recently used is still on top.
+                        std::lock_guard lock(stripe.mutex);
+                        auto fresh = std::find_if(stripe.idle.begin(), stripe.idle.end(), [&](const auto& entry) {
+                            return now - entry.since <= limits_.idle_timeout;
+                        });
+                        expired.assign(std::make_move_iterator(stripe.idle.begin()), std::make_move_iterator(fresh));
+                        stripe.idle.erase(stripe.idle.begin(), fresh);
+                    }
+                    endpoint->idle -= expired.size();
+                    endpoint->open -= expired.size();
+                    closed += expired.size();
+                    // Sockets are closed here, outside of lock.
+                }
+            }
+        }
+        return closed;
+    }
+
+    size_t connection_pool::idle_count(address target, uint16_t port) const {
+        endpoint_state* endpoint = find(target, port);
+        return endpoint != nullptr ? endpoint->idle.load() : 0;
+    }
+
+    size_t connection_pool::open_count(address target, uint16_t port) const {
+        endpoint_state* endpoint = find(target, port);
+        return endpoint != nullptr ? endpoint->open.load() : 0;
+    }
+
+    connection_pool::endpoint_state* connection_pool::find(address target, uint16_t port) const {
+        shard& owner = shards_[shard_index(target, port)];
+        std::shared_lock lock(owner.mutex);
+        auto it = owner.endpoints.find({target, port});
+        return it != owner.endpoints.end() ? it->second.get() : nullptr;
+    }
+
+    connection_pool::endpoint_state& connection_pool::find_or_create(address target, uint16_t port) {
+        if (endpoint_state* existing = find(target, port)) return *existing;
+
+        shard& owner = shards_[shard_index(target, port)];
+        std::unique_lock lock(owner.mutex);
+        auto& endpoint = owner.endpoints[{target, port}];
+        if (!endpoint) endpoint = std::make_unique<endpoint_state>(target, port);
+        return *endpoint;
+    }
+
+    /*
+     * Own stripe is checked first, others only if it's empty, so
+     * threads usually don't touch each other's locks.
+     */
+    bool connection_pool::take_idle(endpoint_state& endpoint, socket& result) {
+        size_t first = this_thread_stripe();
+        for (size_t i = 0; i < stripes_count && endpoint.idle != 0; ++i) {
+            auto& stripe = endpoint.stripes[(first + i) % stripes_count];
+            for (;;) {
+                idle_connection candidate;
+                {
+                    std::lock_guard lock(stripe.mutex);
+                    if (stripe.idle.empty()) break;
+                    candidate = std::move(stripe.idle.back());
+                    stripe.idle.pop_back();
+                }
+                --endpoint.idle;
+
+                bool usable = clock::now() - candidate.since <= limits_.idle_timeout &&
+                              (!limits_.check_health || candidate.connection.implementation().idle_usable());
+                if (usable) {
+                    result = std::move(candidate.connection);
+                    return true;
+                }
+                --endpoint.open;
+            }
+        }
+        return false;
+    }
+
+    bool connection_pool::reserve(endpoint_state& endpoint) noexcept {
+        size_t open = endpoint.open.load();
+        do {
+            if (limits_.max_total != 0 && open >= limits_.max_total) return false;
+        } while (!endpoint.open.compare_exchange_weak(open, open + 1));
+        return true;
+    }
+
+    void connection_pool::give_back(endpoint_state& endpoint, socket&& returned, bool reusable) noexcept {
+        if (reusable && returned.is_open() && ++endpoint.idle <= limits_.max_idle) {
+            auto& stripe = endpoint.stripes[this_thread_stripe()];
+            std::lock_guard lock(stripe.mutex);
+            // Connection is closed instead of pooling if stack can't grow.
+            if (reserve_slot(stripe.idle)) {
+                stripe.idle.push_back({std::move(returned), clock::now()});
+                return;
+            }
+        }
+        if (reusable && returned.is_open()) --endpoint.idle;
+
+        --endpoint.open;
+        returned.close();
+    }
+
+    connection_pool::connection::connection(connection&& other) noexcept
+        : pool_(other.pool_), endpoint_(other.endpoint_), socket_(std::move(other.socket_)) {
+        other.pool_ = nullptr;
+        other.endpoint_ = nullptr;
+    }
+
+    connection_pool::connection& connection_pool::connection::operator=(connection&& other) noexcept {
+        if (this == &other) return *this;
+        release();
+        pool_ = other.pool_;
+        endpoint_ = other.endpoint_;
+        socket_ = std::move(other.socket_);
+        other.pool_ = nullptr;
+        other.endpoint_ = nullptr;
+        return *this;
+    }
+
+    void connection_pool::connection::release() noexcept {
+        if (endpoint_ == nullptr) return;
+        pool_->give_back(*endpoint_, std::move(socket_), true);
+        pool_ = nullptr;
+        endpoint_ = nullptr;
+    }
+
+    void connection_pool::connection::discard() noexcept {
+        if (endpoint_ == nullptr) return;
+        pool_->give_back(*endpoint_, std::move(socket_), false);
+        pool_ = nullptr;
+        endpoint_ = nullptr;
+    }
+} // namespace libwire::tcp
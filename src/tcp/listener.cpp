@@ -9,20 +9,75 @@ namespace libwire::tcp {
         implementation_.listen(int(max_backlog), ec);
     }
 
-    socket listener::accept(std::error_code& ec) noexcept {
-        return {implementation_.accept(ec)};
+    void listener::listen(dual_stack_t, uint16_t port, std::error_code& ec, unsigned max_backlog) noexcept {
+        implementation_ = internal_::socket(dual_stack, transport::tcp, ec);
+        if (ec) return;
+        implementation_.bind(port, ipv6::any, ec);
+        if (ec) return;
+        implementation_.listen(int(max_backlog), ec);
+    }
+
+    void listener::set_peer_filter(peer_filter filter) {
+        filter_ = std::move(filter);
+    }
+
+    const listener::peer_filter* listener::filter() const noexcept {
+        return filter_ ? &filter_ : nullptr;
+    }
+
+    socket listener::accept(std::error_code& ec, bool non_blocking) noexcept {
+        return {implementation_.accept(ec, non_blocking, filter())};
+    }
+
+    size_t listener::accept_many(size_t max, std::vector<socket>& output, std::error_code& ec,
+                                 bool non_blocking) noexcept {
+        if (max == 0) return 0;
+
+        implementation_.make_internal_non_blocking(ec);
+        if (ec) return 0;
+
+        socket first = accept(ec, non_blocking);
+        if (ec) return 0;
+        output.push_back(std::move(first));
+
+        size_t accepted = 1;
+        while (accepted < max) {
+            std::error_code accept_ec;
+            socket next{implementation_.try_accept(accept_ec, non_blocking, filter())};
+            if (accept_ec) {
+                // Connection reset while it was in queue, just skip it.
+                if (accept_ec == error::connection_aborted) continue;
+                break;
+            }
+            output.push_back(std::move(next));
+            ++accepted;
+        }
+        return accepted;
     }
 
 #ifdef __cpp_exceptions
+    size_t listener::accept_many(size_t max, std::vector<socket>& output, bool non_blocking) {
+        std::error_code ec;
+        size_t accepted = accept_many(max, output, ec, non_blocking);
+        if (ec) throw std::system_error(ec);
+        return accepted;
+    }
+
     void listener::listen(address local_address, uint16_t port, unsigned max_backlog) {
         std::error_code ec;
         listen(local_address, port, ec, max_backlog);
         if (ec) throw std::system_error(ec);
     }
 
-    socket listener::accept() {
+    void listener::listen(dual_stack_t, uint16_t port, unsigned max_backlog) {
+        std::error_code ec;
+        listen(dual_stack, port, ec, max_backlog);
+        if (ec) throw std::system_error(ec);
+    }
+
+    socket listener::accept(bool non_blocking) {
         std::error_code ec;
-        auto sock = accept(ec);
+        auto sock = accept(ec, non_blocking);
         if (ec) throw std::system_error(ec);
         return sock;
     }
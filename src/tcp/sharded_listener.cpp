@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/tcp/sharded_listener.hpp"
+
+#ifdef __linux__
+#    include <cerrno>
+#    include <sched.h>
+#    include <unistd.h>
+#    include <sys/socket.h>
+#    include <linux/filter.h>
+#endif
+
+namespace libwire::tcp {
+#ifdef __linux__
+    namespace {
+        void set_int_option(internal_::socket& socket, int name, int value, std::error_code& ec) noexcept {
+            if (setsockopt(socket.handle, SOL_SOCKET, name, &value, sizeof(value)) == -1) {
+                ec = std::error_code(errno, error::system_category());
+            }
+        }
+    } // namespace
+
+    void sharded_listener::listen(address local_address, uint16_t port, size_t shards_count, std::error_code& ec,
+                                  unsigned backlog) noexcept {
+        shards_.clear();
+        if (shards_count == 0) {
+            ec = std::error_code(EINVAL, error::system_category());
+            return;
+        }
+
+        std::vector<listener> shards(shards_count);
+        for (listener& shard : shards) {
+            internal_::socket& socket = shard.implementation();
+            socket = internal_::socket(local_address.version, transport::tcp, ec);
+            if (ec) return;
+
+            // Sockets join reuseport group in bind order, so shard index is
+            // also index in group used by steering program.
+            set_int_option(socket, SO_REUSEPORT, 1, ec);
+            if (ec) return;
+            socket.bind(port, local_address, ec);
+            if (ec) return;
+            socket.listen(int(backlog), ec);
+            if (ec) return;
+
+            if (port == 0) port = std::get<1>(socket.local_endpoint());
+        }
+        shards_ = std::move(shards);
+    }
+
+    void sharded_listener::steer_by_cpu(std::error_code& ec) noexcept {
+        if (shards_.empty()) {
+            ec = std::error_code(EBADF, error::system_category());
+            return;
+        }
+
+        // A = current CPU; A %= shards count; return A.
+        sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU)},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, uint32_t(shards_.size())},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        sock_fprog program{sizeof(code) / sizeof(code[0]), code};
+
+        // Program is shared by whole group.
+        internal_::socket& first = shards_.front().implementation();
+        if (setsockopt(first.handle, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1) {
+            ec = std::error_code(errno, error::system_category());
+        }
+    }
+
+    void sharded_listener::pin_current_thread(size_t shard_index, std::error_code& ec) const noexcept {
+        if (shard_index >= shards_.size()) {
+            ec = std::error_code(EINVAL, error::system_category());
+            return;
+        }
+
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t cpu = shard_index; cpu < size_t(cpus) && cpu < CPU_SETSIZE; cpu += shards_.size()) {
+            CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) == 0 || sched_setaffinity(0, sizeof(set), &set) == -1) {
+            ec = std::error_code(CPU_COUNT(&set) == 0 ? EINVAL : errno, error::system_category());
+        }
+    }
+#else
+    void sharded_listener::listen(address, uint16_t, size_t, std::error_code& ec, unsigned) noexcept {
+        shards_.clear();
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    void sharded_listener::steer_by_cpu(std::error_code& ec) noexcept {
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    void sharded_listener::pin_current_thread(size_t, std::error_code& ec) const noexcept {
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+#endif
+
+    uint16_t sharded_listener::port() const noexcept {
+        if (shards_.empty()) return 0;
+        return std::get<1>(shards_.front().implementation().local_endpoint());
+    }
+
+#ifdef __cpp_exceptions
+    void sharded_listener::listen(address local_address, uint16_t port, size_t shards_count, unsigned backlog) {
+        std::error_code ec;
+        listen(local_address, port, shards_count, ec, backlog);
+        if (ec) throw std::system_error(ec);
+    }
+
+    void sharded_listener::steer_by_cpu() {
+        std::error_code ec;
+        steer_by_cpu(ec);
+        if (ec) throw std::system_error(ec);
+    }
+
+    void sharded_listener::pin_current_thread(size_t shard_index) const {
+        std::error_code ec;
+        pin_current_thread(shard_index, ec);
+        if (ec) throw std::system_error(ec);
+    }
+#endif
+} // namespace libwire::tcp
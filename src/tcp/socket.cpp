@@ -3,12 +3,19 @@
 namespace libwire::tcp {
     template std::vector<uint8_t>& socket::read(size_t, std::vector<uint8_t>&, std::error_code&);
     template std::string& socket::read(size_t, std::string&, std::error_code&);
+    template byte_buffer& socket::read(size_t, byte_buffer&, std::error_code&);
 
     template std::vector<uint8_t> socket::read(size_t, std::error_code&);
     template std::string socket::read(size_t, std::error_code&);
+    template byte_buffer socket::read(size_t, std::error_code&);
+
+    template std::vector<uint8_t>& socket::read_some(size_t, std::vector<uint8_t>&, std::error_code&);
+    template std::string& socket::read_some(size_t, std::string&, std::error_code&);
+    template byte_buffer& socket::read_some(size_t, byte_buffer&, std::error_code&);
 
     template size_t socket::write(const std::vector<uint8_t>&, std::error_code&);
     template size_t socket::write(const std::string&, std::error_code&);
+    template size_t socket::write(const byte_buffer&, std::error_code&);
 
     template std::vector<uint8_t> socket::read_until(uint8_t, std::error_code&, size_t);
     template std::string socket::read_until(uint8_t, std::error_code&, size_t);
@@ -41,6 +48,13 @@ namespace libwire::tcp {
         open = !ec;
     }
 
+    void socket::connect(const endpoint& target, std::error_code& ec) noexcept {
+        implementation_ = internal_::socket(target.version(), transport::tcp, ec);
+        if (ec) return;
+        implementation_.connect(target, ec);
+        open = !ec;
+    }
+
     void socket::close() noexcept {
         // Reassignment to null socket will call destructor and
         // close destroyed socket.
@@ -52,6 +66,51 @@ namespace libwire::tcp {
         implementation_.shutdown(read, write);
     }
 
+    size_t socket::write(std::initializer_list<memory_view<const uint8_t>> buffers, std::error_code& ec) noexcept {
+        size_t written = implementation_.write(buffers.begin(), buffers.size(), ec);
+        open = (ec != error::generic::disconnected);
+        return written;
+    }
+
+    size_t socket::write(const std::vector<memory_view<const uint8_t>>& buffers, std::error_code& ec) noexcept {
+        size_t written = implementation_.write(buffers.data(), buffers.size(), ec);
+        open = (ec != error::generic::disconnected);
+        return written;
+    }
+
+    size_t socket::read(std::initializer_list<memory_view<uint8_t>> buffers, std::error_code& ec) noexcept {
+        size_t received = implementation_.read(buffers.begin(), buffers.size(), ec);
+        open = (ec != error::generic::disconnected);
+        return received;
+    }
+
+    size_t socket::read(const std::vector<memory_view<uint8_t>>& buffers, std::error_code& ec) noexcept {
+        size_t received = implementation_.read(buffers.data(), buffers.size(), ec);
+        open = (ec != error::generic::disconnected);
+        return received;
+    }
+
+    size_t socket::write_zero_copy(memory_view<const uint8_t> buffer, std::optional<uint32_t>& id,
+                                   std::error_code& ec) noexcept {
+        size_t written = implementation_.write_zero_copy(buffer.data(), buffer.size(), id, ec);
+        open = (ec != error::generic::disconnected);
+        return written;
+    }
+
+#ifndef _WIN32
+    size_t socket::send_file(int file_descriptor, uint64_t offset, size_t length, std::error_code& ec) noexcept {
+        size_t sent = implementation_.send_file(file_descriptor, offset, length, ec);
+        open = (ec != error::generic::disconnected);
+        return sent;
+    }
+
+    size_t socket::receive_to_file(int file_descriptor, uint64_t offset, size_t length, std::error_code& ec) noexcept {
+        size_t received = implementation_.receive_to_file(file_descriptor, offset, length, ec);
+        open = (ec != error::generic::disconnected);
+        return received;
+    }
+#endif
+
     std::tuple<address, uint16_t> socket::local_endpoint() const noexcept {
         if (!implementation_) return {{0, 0, 0, 0}, 0};
         return implementation_.local_endpoint();
@@ -77,14 +136,78 @@ namespace libwire::tcp {
         if (ec) throw std::system_error(ec);
     }
 
+    void socket::connect(const endpoint& target) {
+        std::error_code ec;
+        connect(target, ec);
+        if (ec) throw std::system_error(ec);
+    }
+
     template std::vector<uint8_t>& socket::read(size_t, std::vector<uint8_t>&);
     template std::string& socket::read(size_t, std::string&);
+    template byte_buffer& socket::read(size_t, byte_buffer&);
 
     template std::vector<uint8_t> socket::read(size_t);
     template std::string socket::read(size_t);
+    template byte_buffer socket::read(size_t);
+
+    template std::vector<uint8_t>& socket::read_some(size_t, std::vector<uint8_t>&);
+    template std::string& socket::read_some(size_t, std::string&);
+    template byte_buffer& socket::read_some(size_t, byte_buffer&);
 
     template size_t socket::write(const std::vector<uint8_t>&);
     template size_t socket::write(const std::string&);
+    template size_t socket::write(const byte_buffer&);
+
+    size_t socket::write(std::initializer_list<memory_view<const uint8_t>> buffers) {
+        std::error_code ec;
+        size_t written = write(buffers, ec);
+        if (ec) throw std::system_error(ec);
+        return written;
+    }
+
+    size_t socket::write(const std::vector<memory_view<const uint8_t>>& buffers) {
+        std::error_code ec;
+        size_t written = write(buffers, ec);
+        if (ec) throw std::system_error(ec);
+        return written;
+    }
+
+    size_t socket::read(std::initializer_list<memory_view<uint8_t>> buffers) {
+        std::error_code ec;
+        size_t received = read(buffers, ec);
+        if (ec) throw std::system_error(ec);
+        return received;
+    }
+
+    size_t socket::read(const std::vector<memory_view<uint8_t>>& buffers) {
+        std::error_code ec;
+        size_t received = read(buffers, ec);
+        if (ec) throw std::system_error(ec);
+        return received;
+    }
+
+    size_t socket::write_zero_copy(memory_view<const uint8_t> buffer, std::optional<uint32_t>& id) {
+        std::error_code ec;
+        size_t written = write_zero_copy(buffer, id, ec);
+        if (ec) throw std::system_error(ec);
+        return written;
+    }
+
+#    ifndef _WIN32
+    size_t socket::send_file(int file_descriptor, uint64_t offset, size_t length) {
+        std::error_code ec;
+        size_t sent = send_file(file_descriptor, offset, length, ec);
+        if (ec) throw std::system_error(ec);
+        return sent;
+    }
+
+    size_t socket::receive_to_file(int file_descriptor, uint64_t offset, size_t length) {
+        std::error_code ec;
+        size_t received = receive_to_file(file_descriptor, offset, length, ec);
+        if (ec) throw std::system_error(ec);
+        return received;
+    }
+#    endif
 
     template std::vector<uint8_t>& socket::read_until(uint8_t, std::vector<uint8_t>&, size_t);
     template std::string& socket::read_until(uint8_t, std::string&, size_t);
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/timing_wheel.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif
+
+namespace libwire {
+    namespace {
+        unsigned lowest_bit(uint64_t value) noexcept {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return unsigned(index);
+#else
+            return unsigned(__builtin_ctzll(value));
+#endif
+        }
+
+        unsigned highest_bit(uint64_t value) noexcept {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return unsigned(index);
+#else
+            return 63u - unsigned(__builtin_clzll(value));
+#endif
+        }
+    } // namespace
+
+    bool timing_wheel::timer::cancel() noexcept {
+        if (wheel_ == nullptr) return false;
+        wheel_->unlink(*this);
+        --wheel_->size_;
+        wheel_ = nullptr;
+        return true;
+    }
+
+    timing_wheel::timing_wheel(clock::duration resolution, clock::time_point start) noexcept
+        : origin_(start), resolution_(resolution) {
+        assert(resolution.count() > 0);
+    }
+
+    timing_wheel::~timing_wheel() {
+        for (auto& level : wheel_) {
+            for (timer* head : level) {
+                for (timer* current = head; current != nullptr; current = current->next_) {
+                    current->wheel_ = nullptr;
+                }
+            }
+        }
+    }
+
+    void timing_wheel::schedule(timer& timer, clock::time_point expiry) noexcept {
+        if (timer.wheel_ == this) {
+            unlink(timer);
+        } else {
+            timer.cancel();
+            timer.wheel_ = this;
+            ++size_;
+        }
+
+        // Current tick slot is already expired.
+        timer.expiry_ = std::max(to_tick(expiry, true), current_ + 1);
+        link(timer);
+    }
+
+    size_t timing_wheel::advance(clock::time_point now) {
+        uint64_t target = to_tick(now, false);
+        size_t expired = 0;
+
+        while (current_ < target) {
+            if (size_ == 0) {
+                current_ = target;
+                break;
+            }
+
+            // Timers of lowest non-empty level are the earliest ones and
+            // no other slots need processing until the start of their slot.
+            uint64_t next = next_tick();
+            if (next > target) {
+                current_ = target;
+                break;
+            }
+
+            current_ = next;
+            if ((current_ & (slots - 1)) == 0) cascade();
+            expired += expire_current();
+        }
+        return expired;
+    }
+
+    std::optional<timing_wheel::clock::time_point> timing_wheel::next_expiry() const noexcept {
+        if (size_ == 0) return std::nullopt;
+        return to_time(next_tick());
+    }
+
+    timing_wheel::clock::time_point timing_wheel::now() const noexcept {
+        return to_time(current_);
+    }
+
+    /*
+     * Timers are always stored in slots after current one on their
+     * level, and all slots of lower level start before next slot of upper
+     * level, so first occupied slot of lowest non-empty level is the
+     * earliest.
+     */
+    uint64_t timing_wheel::next_tick() const noexcept {
+        assert(size_ != 0);
+        unsigned level = 0;
+        while (occupied_[level] == 0) ++level;
+
+        unsigned shift = level * slot_bits;
+        unsigned upper_shift = shift + slot_bits;
+        uint64_t base = upper_shift < 64 ? current_ >> upper_shift << upper_shift : 0;
+        return base + (uint64_t(lowest_bit(occupied_[level])) << shift);
+    }
+
+    uint64_t timing_wheel::to_tick(clock::time_point time, bool round_up) const noexcept {
+        if (time <= origin_) return 0;
+        clock::duration since_origin = time - origin_;
+        auto ticks = uint64_t(since_origin / resolution_);
+        if (round_up && since_origin % resolution_ != clock::duration::zero()) ++ticks;
+        return ticks;
+    }
+
+    timing_wheel::clock::time_point timing_wheel::to_time(uint64_t tick) const noexcept {
+        return origin_ + resolution_ * int64_t(tick);
+    }
+
+    /*
+     * Level is chosen by highest bit which differs in expiry and current
+     * tick, so expiry is in future slot of that level and all digits
+     * below it are processed when that slot is cascaded.
+     */
+    void timing_wheel::link(timer& timer) noexcept {
+        assert(timer.expiry_ >= current_);
+
+        uint64_t differs = timer.expiry_ ^ current_;
+        unsigned level = differs != 0 ? highest_bit(differs) / slot_bits : 0;
+        unsigned slot = unsigned(timer.expiry_ >> (level * slot_bits)) & (slots - 1);
+
+        timer.level_ = uint8_t(level);
+        timer.slot_ = uint8_t(slot);
+        timer.prev_ = nullptr;
+        timer.next_ = wheel_[level][slot];
+        if (timer.next_ != nullptr) timer.next_->prev_ = &timer;
+        wheel_[level][slot] = &timer;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void timing_wheel::unlink(timer& timer) noexcept {
+        if (timer.prev_ != nullptr) {
+            timer.prev_->next_ = timer.next_;
+        } else {
+            wheel_[timer.level_][timer.slot_] = timer.next_;
+            if (timer.next_ == nullptr) occupied_[timer.level_] &= ~(uint64_t(1) << timer.slot_);
+        }
+        if (timer.next_ != nullptr) timer.next_->prev_ = timer.prev_;
+        timer.prev_ = timer.next_ = nullptr;
+    }
+
+    void timing_wheel::cascade() noexcept {
+        // Find highest level whose slot boundary is crossed, upper levels
+        // are processed first because their timers can go into slots of
+        // lower levels which are cascaded right now too.
+        unsigned top = 1;
+        while (top + 1 < levels && (current_ & ((uint64_t(1) << ((top + 1) * slot_bits)) - 1)) == 0) ++top;
+
+        for (unsigned level = top; level != 0; --level) {
+            unsigned slot = unsigned(current_ >> (level * slot_bits)) & (slots - 1);
+            timer*& head = wheel_[level][slot];
+            while (head != nullptr) {
+                timer* current = head;
+                unlink(*current);
+                link(*current);
+            }
+        }
+    }
+
+    size_t timing_wheel::expire_current() {
+        timer*& head = wheel_[0][current_ & (slots - 1)];
+        size_t expired = 0;
+        while (head != nullptr) {
+            timer* current = head;
+            unlink(*current);
+            --size_;
+            current->wheel_ = nullptr;
+            ++expired;
+            if (current->callback) current->callback();
+        }
+        return expired;
+    }
+} // namespace libwire
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/udp/datagram_batch.hpp"
+#include <cassert>
+#include <cstring>
+
+namespace libwire::udp {
+    datagram_batch::datagram_batch(size_t capacity, size_t max_datagram_size)
+        : capacity_(capacity), max_datagram_size_(max_datagram_size),
+          // Default-initialized on purpose, slots are always written before read.
+          arena_(new uint8_t[capacity * max_datagram_size]),
+          headers_(new internal_::datagram_header[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) {
+            headers_[i].data = arena_.get() + i * max_datagram_size;
+            headers_[i].capacity = max_datagram_size;
+        }
+    }
+
+    size_t datagram_batch::capacity() const noexcept {
+        return capacity_;
+    }
+
+    size_t datagram_batch::max_datagram_size() const noexcept {
+        return max_datagram_size_;
+    }
+
+    size_t datagram_batch::size() const noexcept {
+        return size_;
+    }
+
+    bool datagram_batch::empty() const noexcept {
+        return size_ == 0;
+    }
+
+    void datagram_batch::clear() noexcept {
+        size_ = 0;
+    }
+
+    memory_view<uint8_t> datagram_batch::operator[](size_t i) noexcept {
+        assert(i < size_);
+        return {headers_[i].data, headers_[i].size};
+    }
+
+    memory_view<const uint8_t> datagram_batch::operator[](size_t i) const noexcept {
+        assert(i < size_);
+        return {headers_[i].data, headers_[i].size};
+    }
+
+    std::tuple<address, uint16_t> datagram_batch::endpoint(size_t i) const noexcept {
+        assert(i < size_);
+        if (headers_[i].address.empty()) return {{0, 0, 0, 0}, 0};
+        return headers_[i].address;
+    }
+
+    const libwire::endpoint& datagram_batch::native_endpoint(size_t i) const noexcept {
+        assert(i < size_);
+        return headers_[i].address;
+    }
+
+    bool datagram_batch::truncated(size_t i) const noexcept {
+        assert(i < size_);
+        return headers_[i].truncated;
+    }
+
+    bool datagram_batch::push(memory_view<const uint8_t> datagram,
+                              std::optional<std::tuple<address, uint16_t>> destination) noexcept {
+        return push_to(datagram, destination ? libwire::endpoint(*destination) : libwire::endpoint());
+    }
+
+    bool datagram_batch::push_to(memory_view<const uint8_t> datagram, const libwire::endpoint& destination) noexcept {
+        if (size_ == capacity_ || datagram.size() > max_datagram_size_) return false;
+
+        internal_::datagram_header& header = headers_[size_++];
+        std::memcpy(header.data, datagram.data(), datagram.size());
+        header.size = datagram.size();
+        header.truncated = false;
+        header.address = destination;
+        return true;
+    }
+} // namespace libwire::udp
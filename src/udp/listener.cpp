@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/udp/listener.hpp"
+#include "libwire/error.hpp"
+
+#ifndef _WIN32
+#    include <cerrno>
+#    include <sys/socket.h>
+#endif
+
+namespace libwire::udp {
+#ifdef SO_REUSEPORT
+    namespace {
+        void enable_reuse_port(internal_::socket& socket, std::error_code& ec) noexcept {
+            int value = 1;
+            if (setsockopt(socket.handle, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) == -1) {
+                ec = std::error_code(errno, error::system_category());
+            }
+        }
+    } // namespace
+
+    void listener::listen(address local_address, uint16_t port, std::error_code& ec) noexcept {
+        implementation_ = internal_::socket(local_address.version, transport::udp, ec);
+        if (ec) return;
+        enable_reuse_port(implementation_, ec);
+        if (ec) return;
+        implementation_.bind(port, local_address, ec);
+    }
+
+    socket listener::accept(memory_view<uint8_t> buffer, size_t& datagram_size, std::error_code& ec) noexcept {
+        auto [peer_address, peer_port, size] = implementation_.receive_from(buffer.data(), buffer.size(), ec);
+        if (ec) return {};
+        while (sessions_.count({peer_address, peer_port}) != 0) {
+            std::tie(peer_address, peer_port, size) = implementation_.receive_from(buffer.data(), buffer.size(), ec);
+            if (ec) return {};
+        }
+
+        auto [local_address, local_port] = local_endpoint();
+        socket session;
+        internal_::socket& session_socket = session.implementation();
+        session_socket = internal_::socket(local_address.version, transport::udp, ec);
+        if (ec) return {};
+        enable_reuse_port(session_socket, ec);
+        if (ec) return {};
+        session_socket.bind(local_port, local_address, ec);
+        if (ec) return {};
+        session_socket.connect(peer_address, peer_port, ec);
+        if (ec) return {};
+
+#    ifdef __cpp_exceptions
+        try {
+            sessions_.emplace(peer_address, peer_port);
+        } catch (const std::bad_alloc&) {
+            ec = std::make_error_code(std::errc::not_enough_memory);
+            return {};
+        }
+#    else
+        sessions_.emplace(peer_address, peer_port);
+#    endif
+
+        datagram_size = size;
+        return session;
+    }
+
+    void listener::close_session(socket& session) noexcept {
+        if (session.implementation()) sessions_.erase(session.remote_endpoint());
+        session.close();
+    }
+#else
+    void listener::listen(address, uint16_t, std::error_code& ec) noexcept {
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    socket listener::accept(memory_view<uint8_t>, size_t&, std::error_code& ec) noexcept {
+        ec = std::make_error_code(std::errc::operation_not_supported);
+        return {};
+    }
+
+    void listener::close_session(socket& session) noexcept {
+        session.close();
+    }
+#endif
+
+    std::tuple<address, uint16_t> listener::local_endpoint() const noexcept {
+        if (!implementation_) return {{0, 0, 0, 0}, 0};
+        return implementation_.local_endpoint();
+    }
+
+    internal_::socket::native_handle_t listener::native_handle() const noexcept {
+        return implementation_.handle;
+    }
+
+    const internal_::socket& listener::implementation() const noexcept {
+        return implementation_;
+    }
+
+    internal_::socket& listener::implementation() noexcept {
+        return implementation_;
+    }
+
+#ifdef __cpp_exceptions
+    void listener::listen(address local_address, uint16_t port) {
+        std::error_code ec;
+        listen(local_address, port, ec);
+        if (ec) throw std::system_error(ec);
+    }
+
+    socket listener::accept(memory_view<uint8_t> buffer, size_t& datagram_size) {
+        std::error_code ec;
+        socket session = accept(buffer, datagram_size, ec);
+        if (ec) throw std::system_error(ec);
+        return session;
+    }
+#endif
+} // namespace libwire::udp
@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libwire/udp/options.hpp"
+#include "libwire/udp/socket.hpp"
+#include <cassert>
+
+#ifdef __linux__
+#    include <sys/socket.h>
+#    include <netinet/udp.h>
+#endif
+
+namespace libwire::udp {
+    inline namespace options {
+        void receive_offload_t::set(socket& sock, bool enabled) noexcept {
+            assert(sock.native_handle() != internal_::socket::not_initialized);
+
+#if defined(__linux__) && defined(UDP_GRO)
+            int value = enabled;
+            if (setsockopt(sock.native_handle(), SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0) {
+                sock.implementation().state.receive_offload = enabled;
+            }
+#else
+            (void)enabled;
+#endif
+        }
+
+        bool receive_offload_t::get(const socket& sock) noexcept {
+            return sock.implementation().state.receive_offload;
+        }
+    } // namespace options
+} // namespace libwire::udp
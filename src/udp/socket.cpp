@@ -29,6 +29,11 @@ namespace libwire::udp {
         open(ip_version, ec);
     }
 
+    socket::socket(dual_stack_t) noexcept {
+        std::error_code ec; // ignored
+        open(dual_stack, ec);
+    }
+
     socket::~socket() {
         close();
     };
@@ -41,12 +46,22 @@ namespace libwire::udp {
         implementation_.bind(port, source, ec);
     }
 
+    void socket::bind(const endpoint& local, std::error_code& ec) noexcept {
+        implementation_.bind(local, ec);
+    }
+
 #ifdef __cpp_exceptions
     void socket::bind(address source, uint16_t port) {
         std::error_code ec;
         bind(source, port, ec);
         if (ec) throw std::system_error(ec);
     }
+
+    void socket::bind(const endpoint& local) {
+        std::error_code ec;
+        bind(local, ec);
+        if (ec) throw std::system_error(ec);
+    }
 #endif
 
     void socket::associate(address destination, uint16_t port) noexcept {
@@ -55,16 +70,32 @@ namespace libwire::udp {
         assert(!ec);
     }
 
+    void socket::associate(const endpoint& destination) noexcept {
+        std::error_code ec;
+        implementation_.connect(destination, ec);
+        assert(!ec);
+    }
+
     void socket::open(ip ip_version, std::error_code& ec) noexcept {
         implementation_ = internal_::socket(ip_version, transport::udp, ec);
     }
 
+    void socket::open(dual_stack_t, std::error_code& ec) noexcept {
+        implementation_ = internal_::socket(dual_stack, transport::udp, ec);
+    }
+
 #ifdef __cpp_exceptions
     void socket::open(ip ip_version) {
         std::error_code ec;
         open(ip_version, ec);
         if (ec) throw std::system_error(ec);
     }
+
+    void socket::open(dual_stack_t) {
+        std::error_code ec;
+        open(dual_stack, ec);
+        if (ec) throw std::system_error(ec);
+    }
 #endif
 
     void socket::close() noexcept {
@@ -86,4 +117,94 @@ namespace libwire::udp {
     std::tuple<address, uint16_t> socket::remote_endpoint() noexcept {
         return implementation_.remote_endpoint();
     }
+
+    std::tuple<size_t, std::tuple<address, uint16_t>> socket::read(memory_view<uint8_t> output,
+                                                                   std::error_code& ec) noexcept {
+        auto [address, port, size] = implementation_.receive_from(output.data(), output.size(), ec);
+        return {size, {address, port}};
+    }
+
+    size_t socket::read_from(memory_view<uint8_t> output, endpoint& source, std::error_code& ec) noexcept {
+        return implementation_.receive_from(output.data(), output.size(), source, ec);
+    }
+
+    size_t socket::write_to(memory_view<const uint8_t> datagram, const endpoint& destination,
+                            std::error_code& ec) noexcept {
+        return implementation_.send_to(datagram.data(), datagram.size(), ec, destination);
+    }
+
+    size_t socket::read_batch(datagram_batch& batch, std::error_code& ec) noexcept {
+        batch.size_ = implementation_.receive_many(batch.headers_.get(), batch.capacity_, ec);
+        return batch.size_;
+    }
+
+    size_t socket::write_batch(const datagram_batch& batch, std::error_code& ec) noexcept {
+        return implementation_.send_many(batch.headers_.get(), batch.size_, ec);
+    }
+
+    size_t socket::write_segmented(memory_view<const uint8_t> buffer, size_t segment_size, std::error_code& ec,
+                                   std::optional<std::tuple<address, uint16_t>> destination) noexcept {
+        return implementation_.send_segmented(buffer.data(), buffer.size(), segment_size, ec, destination);
+    }
+
+    coalesced_datagrams socket::read_coalesced(memory_view<uint8_t> buffer, std::error_code& ec) noexcept {
+        coalesced_datagrams result;
+        auto [address, port, size] =
+            implementation_.receive_coalesced(buffer.data(), buffer.size(), result.segment_size, result.truncated, ec);
+        result.data = memory_view<uint8_t>(buffer.data(), size);
+        result.source = {address, port};
+        return result;
+    }
+
+#ifdef __cpp_exceptions
+    std::tuple<size_t, std::tuple<address, uint16_t>> socket::read(memory_view<uint8_t> output) {
+        std::error_code ec;
+        auto result = read(output, ec);
+        if (ec) throw std::system_error(ec);
+        return result;
+    }
+
+    size_t socket::read_from(memory_view<uint8_t> output, endpoint& source) {
+        std::error_code ec;
+        size_t size = read_from(output, source, ec);
+        if (ec) throw std::system_error(ec);
+        return size;
+    }
+
+    size_t socket::write_to(memory_view<const uint8_t> datagram, const endpoint& destination) {
+        std::error_code ec;
+        size_t size = write_to(datagram, destination, ec);
+        if (ec) throw std::system_error(ec);
+        return size;
+    }
+
+    size_t socket::read_batch(datagram_batch& batch) {
+        std::error_code ec;
+        size_t received = read_batch(batch, ec);
+        if (ec) throw std::system_error(ec);
+        return received;
+    }
+
+    size_t socket::write_batch(const datagram_batch& batch) {
+        std::error_code ec;
+        size_t sent = write_batch(batch, ec);
+        if (ec) throw std::system_error(ec);
+        return sent;
+    }
+
+    size_t socket::write_segmented(memory_view<const uint8_t> buffer, size_t segment_size,
+                                   std::optional<std::tuple<address, uint16_t>> destination) {
+        std::error_code ec;
+        size_t sent = write_segmented(buffer, segment_size, ec, destination);
+        if (ec) throw std::system_error(ec);
+        return sent;
+    }
+
+    coalesced_datagrams socket::read_coalesced(memory_view<uint8_t> buffer) {
+        std::error_code ec;
+        coalesced_datagrams result = read_coalesced(buffer, ec);
+        if (ec) throw std::system_error(ec);
+        return result;
+    }
+#endif
 } // namespace libwire::udp
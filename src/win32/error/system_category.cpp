@@ -46,9 +46,11 @@
     MAP_CODE_3(WSAESHUTDOWN,            error::shutdown, error::generic::disconnected); \
     MAP_CODE_3(WSAEHOSTDOWN,            error::host_down, error::generic::no_destination); \
     MAP_CODE_3(WSAEHOSTUNREACH,         error::host_unreachable, error::generic::no_destination); \
+    MAP_CODE  (WSAETIMEDOUT,            error::timeout); \
     \
     /* Our custom code. */ \
     MAP_CODE_3(EOF,                     error::end_of_file, error::generic::disconnected); \
+    MAP_CODE  (WSA_OPERATION_ABORTED,   error::operation_aborted); \
     \
     MAP_CODE(WSAEFAULT,             error::unexpected); \
     MAP_CODE(WSAEISCONN,            error::unexpected); \
@@ -88,6 +90,8 @@ std::string libwire::internal_::system_category::message(int code) const noexcep
     case WSAESHUTDOWN:          return "Endpoint shutdown";
     case WSAEHOSTDOWN:          return "Host is down";
     case WSAEHOSTUNREACH:       return "Host is unreachable";
+    case WSAETIMEDOUT:          return "Operation timed out";
+    case WSA_OPERATION_ABORTED: return "Operation canceled";
     default:                    return "Unknown error";
     }
     // clang-format on
@@ -50,3 +50,84 @@ TEST(Ipv6Address, FromString) {
     // Incorrectly folded.
     ASSERT_THROW(address(":00::000:1"), std::invalid_argument);
 }
+
+TEST(Ipv6Address, ToString) {
+    using namespace libwire;
+
+    ASSERT_EQ(ipv6::loopback.to_string(), "::1");
+    ASSERT_EQ(ipv6::any.to_string(), "::");
+    ASSERT_EQ(address("2001:DB8:0:0:1:0:0:1").to_string(), "2001:db8::1:0:0:1");
+    ASSERT_EQ(address("::ffff:192.168.0.1").to_string(), "::ffff:192.168.0.1");
+}
+
+TEST(Address, NotNulTerminated) {
+    using namespace libwire;
+
+    std::string_view text = "10.0.0.1234";
+    ASSERT_EQ(address(text.substr(0, 8)), address(10, 0, 0, 1));
+    ASSERT_THROW(address(text.substr(0, 7)), std::invalid_argument);
+
+    std::string_view text_v6 = "fe80::1:2";
+    ASSERT_EQ(address(text_v6.substr(0, 7)), address("fe80::1"));
+}
+
+TEST(Address, ToChars) {
+    using namespace libwire;
+
+    char buffer[address::max_text_size];
+    address ipv4{192, 168, 100, 200};
+    auto [end, ec] = ipv4.to_chars(buffer, buffer + sizeof(buffer));
+    ASSERT_EQ(ec, std::errc{});
+    ASSERT_EQ(std::string_view(buffer, size_t(end - buffer)), "192.168.100.200");
+
+    // Exact fit into small buffer.
+    auto [exact_end, exact_ec] = ipv4.to_chars(buffer, buffer + 15);
+    ASSERT_EQ(exact_ec, std::errc{});
+    ASSERT_EQ(exact_end, buffer + 15);
+
+    auto [short_end, short_ec] = ipv4.to_chars(buffer, buffer + 14);
+    ASSERT_EQ(short_ec, std::errc::value_too_large);
+    ASSERT_EQ(short_end, buffer + 14);
+
+    auto [v6_end, v6_ec] = ipv6::loopback.to_chars(buffer, buffer + 3);
+    ASSERT_EQ(v6_ec, std::errc{});
+    ASSERT_EQ(std::string_view(buffer, size_t(v6_end - buffer)), "::1");
+}
+
+TEST(Address, Literals) {
+    using namespace libwire;
+
+    constexpr address ipv4 = "10.0.0.1"_ipv4;
+    static_assert(ipv4 == address(10, 0, 0, 1));
+    static_assert(ipv4.version == ip::v4);
+
+    constexpr address ipv6 = "fe80::1"_ipv6;
+    static_assert(ipv6 == address(0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1));
+    static_assert(ipv6 != ipv4);
+    static_assert("::ffff:1.2.3.4"_ipv6.parts[15] == 4);
+
+    constexpr std::tuple<address, uint16_t> ep = "127.0.0.1:8080"_ep;
+    static_assert(std::get<0>(ep) == ipv4::loopback && std::get<1>(ep) == 8080);
+
+    constexpr std::tuple<address, uint16_t> ep6 = "[::1]:53"_ep;
+    static_assert(std::get<0>(ep6) == ipv6::loopback && std::get<1>(ep6) == 53);
+
+    // Outside of constant expressions invalid text throws.
+    ASSERT_THROW("10.0.0.256"_ipv4, std::invalid_argument);
+    ASSERT_THROW("10.0.0.1"_ipv6, std::invalid_argument);
+    ASSERT_THROW("fe80::1"_ipv4, std::invalid_argument);
+    ASSERT_THROW("127.0.0.1"_ep, std::invalid_argument);
+    ASSERT_THROW("127.0.0.1:65536"_ep, std::invalid_argument);
+    ASSERT_THROW("::1:80"_ep, std::invalid_argument);
+    ASSERT_THROW("[::1:80"_ep, std::invalid_argument);
+    ASSERT_THROW("[::1]:"_ep, std::invalid_argument);
+    ASSERT_EQ(std::get<1>("[::1]:0"_ep), 0);
+}
+
+TEST(Address, Comparison) {
+    using namespace libwire;
+
+    // Same bytes, different versions.
+    ASSERT_NE(ipv4::any, ipv6::any);
+    ASSERT_FALSE(ipv4::any == ipv6::any);
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Coroutines require C++20, tests are skipped if compiler doesn't support it.
+#if defined(__linux__) && defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest.hpp"
+#include <libwire/coroutine.hpp>
+
+using namespace libwire;
+using namespace std::literals;
+
+static uint16_t local_port(const tcp::listener& listener) {
+    return std::get<1>(listener.implementation().local_endpoint());
+}
+
+class Coroutine : public testing::TestWithParam<io_context::backend_type> {};
+
+INSTANTIATE_TEST_SUITE_P(Backends, Coroutine,
+                         testing::Values(io_context::backend_type::epoll, io_context::backend_type::io_uring));
+
+namespace {
+    coro::task<> echo_once(io_context& context, tcp::listener& listener) {
+        auto [ec, socket] = co_await coro::accept(context, listener);
+        EXPECT_FALSE(ec) << ec.message();
+
+        std::string line;
+        auto read = co_await coro::read_until(context, socket, '\n', line);
+        EXPECT_FALSE(read.ec) << read.ec.message();
+        EXPECT_EQ(read.value, line.size());
+
+        auto written = co_await coro::write(context, socket, make_view(std::as_const(line)));
+        EXPECT_FALSE(written.ec) << written.ec.message();
+    }
+
+    coro::task<std::string> request(io_context& context, uint16_t port, std::string line) {
+        tcp::socket socket;
+        std::error_code ec = co_await coro::connect(context, socket, ipv4::loopback, port);
+        EXPECT_FALSE(ec) << ec.message();
+        EXPECT_TRUE(socket.is_open());
+
+        line.push_back('\n');
+        co_await coro::write(context, socket, make_view(std::as_const(line)));
+
+        std::vector<uint8_t> buffer(line.size() - 1);
+        auto read = co_await coro::read(context, socket, make_view(buffer));
+        EXPECT_FALSE(read.ec) << read.ec.message();
+        co_return std::string(buffer.begin(), buffer.begin() + read.value);
+    }
+} // namespace
+
+TEST_P(Coroutine, Echo) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    std::string response;
+
+    coro::spawn(context, echo_once(context, listener));
+    coro::spawn(context, [&]() -> coro::task<> {
+        response = co_await request(context, local_port(listener), "hello");
+    }());
+    context.run();
+
+    ASSERT_EQ(response, "hello");
+}
+
+TEST_P(Coroutine, ConnectRefused) {
+    io_context context{GetParam()};
+    uint16_t port;
+    {
+        tcp::listener listener{ipv4::loopback, 0};
+        port = local_port(listener);
+    }
+
+    tcp::socket socket;
+    std::error_code ec;
+    coro::spawn(context, [&]() -> coro::task<> { ec = co_await coro::connect(context, socket, ipv4::loopback, port); }());
+    context.run();
+
+    ASSERT_EQ(ec, error::connection_refused);
+    ASSERT_FALSE(socket.is_open());
+}
+
+TEST_P(Coroutine, ReadTimeout) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client;
+    client.connect(ipv4::loopback, local_port(listener));
+    tcp::socket server = listener.accept();
+
+    coro::result<size_t> result;
+    coro::spawn(context, [&]() -> coro::task<> {
+        std::vector<uint8_t> buffer(16);
+        result = co_await coro::read_some(context, server, make_view(buffer), 20ms);
+    }());
+    context.run();
+
+    ASSERT_EQ(result.ec, error::timeout);
+}
+
+TEST_P(Coroutine, Datagrams) {
+    io_context context{GetParam()};
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    uint16_t port = std::get<1>(receiver.implementation().local_endpoint());
+
+    std::string received;
+    coro::spawn(context, [&]() -> coro::task<> {
+        std::vector<uint8_t> buffer(64);
+        auto result = co_await coro::receive_from(context, receiver, make_view(buffer));
+        EXPECT_FALSE(result.ec) << result.ec.message();
+        received.assign(buffer.begin(), buffer.begin() + std::get<0>(result.value));
+    }());
+    coro::spawn(context, [&]() -> coro::task<> {
+        std::string message = "ping";
+        auto result = co_await coro::send_to(context, sender, make_view(message), {ipv4::loopback, port});
+        EXPECT_EQ(result.value, 4u);
+    }());
+    context.run();
+
+    ASSERT_EQ(received, "ping");
+}
+
+TEST_P(Coroutine, MultiThreaded) {
+    constexpr unsigned clients_count = 32, threads_count = 4;
+
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    std::atomic<unsigned> answered{0};
+
+    coro::spawn(context, [&]() -> coro::task<> {
+        for (unsigned i = 0; i < clients_count; ++i) coro::spawn(context, echo_once(context, listener));
+        co_return;
+    }());
+    for (unsigned i = 0; i < clients_count; ++i) {
+        coro::spawn(context, [&, i]() -> coro::task<> {
+            std::string line = "client " + std::to_string(i);
+            if (co_await request(context, local_port(listener), line) == line) ++answered;
+        }());
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threads_count; ++i) threads.emplace_back([&] { context.run(); });
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_EQ(answered, clients_count);
+}
+
+TEST(Coroutine, DestroyedWithContext) {
+    struct guard {
+        bool& destroyed;
+        ~guard() {
+            destroyed = true;
+        }
+    };
+
+    bool destroyed = false;
+    tcp::listener listener{ipv4::loopback, 0};
+    {
+        io_context context;
+        coro::spawn(context, [&]() -> coro::task<> {
+            guard local{destroyed};
+            co_await coro::accept(context, listener);
+            ADD_FAILURE() << "No connections expected";
+        }());
+        context.poll();
+        ASSERT_FALSE(destroyed);
+    }
+    ASSERT_TRUE(destroyed);
+}
+
+#ifdef __cpp_exceptions
+TEST(Coroutine, ExceptionPropagation) {
+    io_context context;
+    bool caught = false;
+
+    auto failing = []() -> coro::task<int> {
+        throw std::runtime_error("failed");
+        co_return 1;
+    };
+    coro::spawn(context, [&]() -> coro::task<> {
+        try {
+            co_await failing();
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        // Escapes spawned coroutine.
+        throw std::logic_error("escaped");
+    }());
+
+    ASSERT_THROW(context.run(), std::logic_error);
+    ASSERT_TRUE(caught);
+}
+#endif
+
+#endif // if defined(__linux__) && defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
@@ -0,0 +1,290 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include <thread>
+#include "../gtest.hpp"
+#include "fake_server.hpp"
+#include <libwire/dns/cache.hpp>
+
+using namespace libwire;
+using namespace libwire::test;
+
+namespace {
+    // Short lifetime so tests can wait for expiration.
+    dns::cache::config short_lived() {
+        dns::cache::config settings;
+        settings.max_ttl = 1s;
+        settings.max_negative_ttl = 1s;
+        settings.refresh_after = 0.5;
+        return settings;
+    }
+} // namespace
+
+TEST(DnsCache, AnswersFromCache) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1), address("2001:db8::1")};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver};
+
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "a.test", cached, ec));
+
+    outcome first, second, both;
+    cache.async_resolve(ip::v4, "a.test", record(first));
+    context.run();
+    ASSERT_FALSE(first.ec) << first.ec.message();
+    ASSERT_EQ(first.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+
+    cache.async_resolve(ip::v4, "A.TEST.", record(second));
+    context.run();
+    ASSERT_TRUE(second.done);
+    ASSERT_FALSE(second.ec);
+    ASSERT_EQ(second.answer.addresses, first.answer.addresses);
+    ASSERT_LE(second.answer.ttl, std::chrono::seconds(fake_server::ttl));
+    ASSERT_GE(second.answer.ttl, std::chrono::seconds(fake_server::ttl - 5));
+
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "a.test", cached, ec));
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(cached.addresses, first.answer.addresses);
+    ASSERT_EQ(server.udp_queries, 1u);
+
+    // Families are cached separately.
+    ASSERT_FALSE(cache.try_resolve(ip::v6, "a.test", cached, ec));
+    cache.async_resolve("a.test", record(both));
+    context.run();
+    ASSERT_EQ(both.answer.addresses, (std::vector<address>{{192, 0, 2, 1}, address("2001:db8::1")}));
+    ASSERT_EQ(server.udp_queries, 3u);
+
+    dns::cache::statistics stats = cache.stats();
+    ASSERT_EQ(stats.hits, 2u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.refreshes, 0u);
+}
+
+TEST(DnsCache, CoalescesMisses) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1)};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver};
+
+    std::vector<outcome> results(3);
+    for (auto& result : results) cache.async_resolve(ip::v4, "a.test", record(result));
+    context.run();
+
+    for (auto& result : results) {
+        ASSERT_TRUE(result.done);
+        ASSERT_EQ(result.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+    }
+    ASSERT_EQ(server.udp_queries, 1u);
+    ASSERT_EQ(cache.stats().misses, 3u);
+}
+
+TEST(DnsCache, NegativeAnswers) {
+    fake_server server;
+    server.hosts["v4only.test"] = {address(192, 0, 2, 1)};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver, short_lived()};
+
+    outcome missing, no_address;
+    cache.async_resolve(ip::v4, "missing.test", record(missing));
+    cache.async_resolve(ip::v6, "v4only.test", record(no_address));
+    context.run();
+    ASSERT_EQ(missing.ec, error::host_not_found);
+    ASSERT_EQ(no_address.ec, error::no_address);
+    ASSERT_EQ(server.udp_queries, 2u);
+
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "missing.test", cached, ec));
+    ASSERT_EQ(ec, error::host_not_found);
+    ASSERT_TRUE(cached.addresses.empty());
+    ASSERT_TRUE(cache.try_resolve(ip::v6, "v4only.test", cached, ec));
+    ASSERT_EQ(ec, error::no_address);
+
+    // Limited by max_negative_ttl.
+    std::this_thread::sleep_for(1100ms);
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "missing.test", cached, ec));
+}
+
+TEST(DnsCache, TransientErrorsNotCached) {
+    fake_server server;
+    server.failure = 2; // SERVFAIL
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server, 2s, 1)};
+    dns::cache cache{resolver};
+
+    outcome first, second;
+    cache.async_resolve(ip::v4, "a.test", record(first));
+    context.run();
+    ASSERT_EQ(first.ec, error::host_not_found_try_again);
+
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "a.test", cached, ec));
+    cache.async_resolve(ip::v4, "a.test", record(second));
+    context.run();
+    ASSERT_EQ(second.ec, error::host_not_found_try_again);
+    ASSERT_EQ(server.udp_queries, 2u);
+}
+
+TEST(DnsCache, Expiration) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1)};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver, short_lived()};
+
+    outcome first, second;
+    cache.async_resolve(ip::v4, "a.test", record(first));
+    context.run();
+    ASSERT_EQ(first.answer.ttl, 1s);
+
+    std::this_thread::sleep_for(1100ms);
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "a.test", cached, ec));
+    cache.async_resolve(ip::v4, "a.test", record(second));
+    context.run();
+    ASSERT_FALSE(second.ec);
+    ASSERT_EQ(server.udp_queries, 2u);
+    ASSERT_EQ(cache.stats().misses, 2u);
+}
+
+TEST(DnsCache, RefreshesPopularEntries) {
+    fake_server server;
+    server.hosts["popular.test"] = {address(192, 0, 2, 1)};
+    server.hosts["rare.test"] = {address(192, 0, 2, 2)};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver, short_lived()};
+
+    outcome popular, rare;
+    cache.async_resolve(ip::v4, "popular.test", record(popular));
+    cache.async_resolve(ip::v4, "rare.test", record(rare));
+    context.run();
+    ASSERT_EQ(server.udp_queries, 2u);
+
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "popular.test", cached, ec));
+
+    // Past refresh_after, hit returns cached answer and starts refresh.
+    std::this_thread::sleep_for(600ms);
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "popular.test", cached, ec));
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "popular.test", cached, ec));
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "rare.test", cached, ec));
+    ASSERT_EQ(cache.stats().refreshes, 1u);
+    context.run();
+    ASSERT_EQ(server.udp_queries, 3u);
+
+    // Original entries would be expired by now.
+    std::this_thread::sleep_for(600ms);
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "popular.test", cached, ec));
+    ASSERT_EQ(cached.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "rare.test", cached, ec));
+}
+
+TEST(DnsCache, Capacity) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1)};
+    server.hosts["b.test"] = {address(192, 0, 2, 2)};
+    server.hosts["c.test"] = {address(192, 0, 2, 3)};
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache::config settings;
+    settings.capacity = 2;
+    settings.shards = 1;
+    dns::cache cache{resolver, settings};
+
+    for (const char* name : {"a.test", "b.test", "c.test"}) {
+        outcome result;
+        cache.async_resolve(ip::v4, name, record(result));
+        context.run();
+        ASSERT_FALSE(result.ec);
+    }
+
+    // Entry which expires first is dropped.
+    dns::answer cached;
+    std::error_code ec;
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "a.test", cached, ec));
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "b.test", cached, ec));
+    ASSERT_TRUE(cache.try_resolve(ip::v4, "c.test", cached, ec));
+
+    cache.clear();
+    ASSERT_FALSE(cache.try_resolve(ip::v4, "c.test", cached, ec));
+}
+
+TEST(DnsCache, ConcurrentHits) {
+    fake_server server;
+    std::vector<std::string> names;
+    for (uint8_t i = 0; i < 8; ++i) {
+        names.push_back("host" + std::to_string(i) + ".test");
+        server.hosts[names.back()] = {address(192, 0, 2, i)};
+    }
+    server.start();
+
+    io_context context;
+    dns::resolver resolver{context, local_config(server)};
+    dns::cache cache{resolver};
+    for (const auto& name : names) cache.async_resolve(ip::v4, name, [](std::error_code, dns::answer) {});
+    context.run();
+
+    constexpr size_t rounds = 1000;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> failures{0};
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            dns::answer cached;
+            std::error_code ec;
+            for (size_t i = 0; i < rounds; ++i) {
+                if (!cache.try_resolve(ip::v4, names[i % names.size()], cached, ec)) ++failures;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_EQ(failures, 0u);
+    ASSERT_EQ(cache.stats().hits, 4 * rounds);
+    ASSERT_EQ(server.udp_queries, names.size());
+}
+
+#endif // ifdef __linux__
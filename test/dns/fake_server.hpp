@@ -0,0 +1,281 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <libwire/dns/resolver.hpp>
+#include <libwire/options.hpp>
+#include <libwire/tcp/listener.hpp>
+
+/*
+ * DNS server for resolver and cache tests, POSIX only.
+ */
+
+namespace libwire::test {
+    using namespace std::literals;
+
+    /**
+     * DNS server on loopback answering from static zone, both over UDP
+     * and TCP (on the same port). Runs in own thread, behavior should be
+     * set up before start().
+     */
+    class fake_server {
+    public:
+        static constexpr uint32_t ttl = 300, alias_ttl = 120, negative_ttl = 60;
+
+        ~fake_server() {
+            stop_ = true;
+            if (thread_.joinable()) thread_.join();
+        }
+
+        void start() {
+            // TCP port can be taken by someone else, pick another one then.
+            for (;;) {
+                udp_ = udp::socket(ip::v4);
+                udp_.bind(ipv4::loopback, 0);
+                port_ = std::get<1>(udp_.local_endpoint());
+                std::error_code ec;
+                listener_.listen(ipv4::loopback, port_, ec);
+                if (!ec) break;
+            }
+            udp_.set_option(receive_timeout, 10ms);
+            listener_.implementation().make_internal_non_blocking(error_);
+            thread_ = std::thread([this] { run(); });
+        }
+
+        endpoint local_endpoint() const {
+            return {ipv4::loopback, port_};
+        }
+
+        std::unordered_map<std::string, std::vector<address>> hosts;
+        std::unordered_map<std::string, std::string> aliases;
+
+        /// Names answered with TC flag over UDP.
+        std::set<std::string> truncated;
+
+        /// Count of datagrams ignored before server starts to reply.
+        unsigned drop_first = 0;
+
+        /// Answer every query with this rcode if set.
+        uint8_t failure = 0;
+
+        /// Send reply with wrong ID and reply to other question before real reply.
+        bool forge = false;
+
+        /// Collect this many queries and reply to them in reverse order.
+        size_t reverse_batch = 0;
+
+        std::atomic<unsigned> udp_queries{0}, tcp_queries{0};
+
+    private:
+        void run() {
+            std::vector<std::pair<std::vector<uint8_t>, endpoint>> batch;
+            std::array<uint8_t, 512> buffer{};
+            while (!stop_) {
+                std::error_code ec;
+                endpoint source;
+                size_t size = udp_.read_from(memory_view(buffer.data(), buffer.size()), source, ec);
+                if (!ec) {
+                    ++udp_queries;
+                    if (drop_first > 0) {
+                        --drop_first;
+                    } else if (reverse_batch != 0) {
+                        batch.emplace_back(std::vector<uint8_t>(buffer.begin(), buffer.begin() + ptrdiff_t(size)),
+                                           source);
+                        if (batch.size() == reverse_batch) {
+                            for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+                                udp_.write_to(make_view(reply(it->first.data(), it->first.size(), false)),
+                                              it->second);
+                            }
+                            batch.clear();
+                        }
+                    } else {
+                        std::vector<uint8_t> message = reply(buffer.data(), size, false);
+                        if (forge) send_forged(message, source);
+                        udp_.write_to(make_view(message), source);
+                    }
+                }
+
+                ec.clear();
+                tcp::socket connection(listener_.implementation().try_accept(ec));
+                if (!ec) serve(connection);
+            }
+        }
+
+        void serve(tcp::socket& connection) {
+            ++tcp_queries;
+            connection.set_option(receive_timeout, 1s);
+            std::error_code ec;
+            auto length = connection.read<std::vector<uint8_t>>(2, ec);
+            if (ec) return;
+            auto query = connection.read<std::vector<uint8_t>>(size_t(length[0] << 8u) | length[1], ec);
+            if (ec) return;
+            std::vector<uint8_t> message = reply(query.data(), query.size(), true);
+            std::vector<uint8_t> prefix = {uint8_t(message.size() >> 8u), uint8_t(message.size())};
+            connection.write(prefix, ec);
+            connection.write(message, ec);
+        }
+
+        void send_forged(const std::vector<uint8_t>& message, const endpoint& target) {
+            std::vector<uint8_t> wrong_id = message;
+            wrong_id[0] ^= 0x55;
+            udp_.write_to(make_view(wrong_id), target);
+
+            // Same ID, but question is for other name.
+            std::vector<uint8_t> wrong_question = message;
+            wrong_question[13] ^= 0x20;
+            wrong_question[14] = '!';
+            udp_.write_to(make_view(wrong_question), target);
+        }
+
+        static void put16(std::vector<uint8_t>& out, uint16_t value) {
+            out.push_back(uint8_t(value >> 8u));
+            out.push_back(uint8_t(value));
+        }
+
+        static void put_name(std::vector<uint8_t>& out, const std::string& name) {
+            size_t start = 0;
+            while (start < name.size()) {
+                size_t dot = std::min(name.find('.', start), name.size());
+                out.push_back(uint8_t(dot - start));
+                out.insert(out.end(), name.begin() + ptrdiff_t(start), name.begin() + ptrdiff_t(dot));
+                start = dot + 1;
+            }
+            out.push_back(0);
+        }
+
+        static void put_record(std::vector<uint8_t>& out, uint16_t owner, uint16_t type, uint32_t record_ttl,
+                               const std::vector<uint8_t>& data) {
+            put16(out, uint16_t(0xc000u | owner));
+            put16(out, type);
+            put16(out, 1);
+            put16(out, uint16_t(record_ttl >> 16u));
+            put16(out, uint16_t(record_ttl));
+            put16(out, uint16_t(data.size()));
+            out.insert(out.end(), data.begin(), data.end());
+        }
+
+        std::vector<uint8_t> reply(const uint8_t* query, size_t size, bool over_tcp) {
+            // Queries from resolver are not compressed.
+            std::string name;
+            size_t offset = 12;
+            while (offset < size && query[offset] != 0) {
+                if (!name.empty()) name.push_back('.');
+                for (size_t i = 1; i <= query[offset]; ++i) name.push_back(char(std::tolower(query[offset + i])));
+                offset += query[offset] + 1u;
+            }
+            size_t question_end = offset + 5;
+            uint16_t type = uint16_t((query[offset + 1] << 8u) | query[offset + 2]);
+            ip version = type == 1 ? ip::v4 : ip::v6;
+
+            std::vector<uint8_t> out(query, query + 4);
+            out[2] = 0x81;
+            out[3] = 0x80;
+            put16(out, 1);
+            out.resize(12, 0);
+            out.insert(out.end(), query + 12, query + question_end);
+
+            if (failure != 0) {
+                out[3] |= failure;
+                return out;
+            }
+            if (!over_tcp && truncated.count(name) != 0) {
+                out[2] |= 0x02;
+                return out;
+            }
+
+            uint16_t answers = 0, owner = 12;
+            std::string target = name;
+            if (auto alias = aliases.find(name); alias != aliases.end()) {
+                std::vector<uint8_t> data;
+                put_name(data, alias->second);
+                owner = uint16_t(out.size() + 12);
+                put_record(out, 12, 5, alias_ttl, data);
+                ++answers;
+                target = alias->second;
+            }
+
+            auto host = hosts.find(target);
+            if (host != hosts.end()) {
+                for (const address& entry : host->second) {
+                    if (entry.version != version) continue;
+                    size_t address_size = version == ip::v4 ? 4 : 16;
+                    put_record(out, owner, type, ttl,
+                               std::vector<uint8_t>(entry.parts.begin(), entry.parts.begin() + ptrdiff_t(address_size)));
+                    ++answers;
+                }
+            }
+            out[7] = uint8_t(answers);
+
+            if (answers == 0 || (host == hosts.end())) {
+                if (host == hosts.end()) out[3] |= 3; // NXDOMAIN
+                std::vector<uint8_t> soa;
+                put_name(soa, "ns.test");
+                put_name(soa, "admin.test");
+                for (uint32_t field : {1u, 7200u, 3600u, 86400u, negative_ttl}) {
+                    put16(soa, uint16_t(field >> 16u));
+                    put16(soa, uint16_t(field));
+                }
+                put_record(out, 12, 6, 3600, soa);
+                out[9] = 1;
+            }
+            return out;
+        }
+
+        udp::socket udp_;
+        tcp::listener listener_;
+        uint16_t port_ = 0;
+        std::error_code error_;
+        std::atomic<bool> stop_{false};
+        std::thread thread_;
+    };
+
+    inline dns::resolver::config local_config(const fake_server& server, std::chrono::milliseconds timeout = 2s,
+                                              unsigned attempts = 2) {
+        dns::resolver::config settings;
+        settings.nameservers = {server.local_endpoint()};
+        settings.timeout = timeout;
+        settings.attempts = attempts;
+        return settings;
+    }
+
+    struct outcome {
+        bool done = false;
+        std::error_code ec;
+        dns::answer answer;
+    };
+
+    inline dns::resolver::handler record(outcome& result) {
+        return [&result](std::error_code ec, dns::answer answer) {
+            result.done = true;
+            result.ec = ec;
+            result.answer = std::move(answer);
+        };
+    }
+} // namespace libwire::test
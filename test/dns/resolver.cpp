@@ -0,0 +1,322 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include <set>
+#include <thread>
+#include "../gtest.hpp"
+#include "fake_server.hpp"
+
+using namespace libwire;
+using namespace libwire::test;
+
+class DnsResolver : public testing::TestWithParam<io_context::backend_type> {};
+
+INSTANTIATE_TEST_SUITE_P(Backends, DnsResolver,
+                         testing::Values(io_context::backend_type::epoll, io_context::backend_type::io_uring));
+
+TEST_P(DnsResolver, BothFamilies) {
+    fake_server server;
+    server.hosts["a.test"] = {address("2001:db8::1"), address(192, 0, 2, 1), address(192, 0, 2, 2)};
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve("a.test", record(result));
+    context.run();
+
+    ASSERT_TRUE(result.done);
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses,
+              (std::vector<address>{{192, 0, 2, 1}, {192, 0, 2, 2}, address("2001:db8::1")}));
+    ASSERT_EQ(result.answer.ttl, std::chrono::seconds(fake_server::ttl));
+    ASSERT_EQ(server.udp_queries, 2u);
+}
+
+TEST_P(DnsResolver, SingleFamily) {
+    fake_server server;
+    server.hosts["a.test"] = {address("2001:db8::1"), address(192, 0, 2, 1)};
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve(ip::v6, "A.Test.", record(result));
+    context.run();
+
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses, (std::vector<address>{address("2001:db8::1")}));
+    ASSERT_EQ(server.udp_queries, 1u);
+}
+
+TEST_P(DnsResolver, NegativeAnswers) {
+    fake_server server;
+    server.hosts["v4only.test"] = {address(192, 0, 2, 1)};
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome missing, no_address, partial;
+    resolver.async_resolve("missing.test", record(missing));
+    resolver.async_resolve(ip::v6, "v4only.test", record(no_address));
+    resolver.async_resolve("v4only.test", record(partial));
+    context.run();
+
+    ASSERT_EQ(missing.ec, error::host_not_found) << missing.ec.message();
+    ASSERT_EQ(missing.answer.ttl, std::chrono::seconds(fake_server::negative_ttl));
+
+    ASSERT_EQ(no_address.ec, error::no_address) << no_address.ec.message();
+    ASSERT_EQ(no_address.answer.ttl, std::chrono::seconds(fake_server::negative_ttl));
+
+    // Missing AAAA records limit TTL of answer.
+    ASSERT_FALSE(partial.ec) << partial.ec.message();
+    ASSERT_EQ(partial.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+    ASSERT_EQ(partial.answer.ttl, std::chrono::seconds(fake_server::negative_ttl));
+}
+
+TEST_P(DnsResolver, FollowsCname) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1)};
+    server.aliases["www.test"] = "a.test";
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve(ip::v4, "www.test", record(result));
+    context.run();
+
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+    ASSERT_EQ(result.answer.ttl, std::chrono::seconds(fake_server::alias_ttl));
+}
+
+TEST_P(DnsResolver, TruncatedFallsBackToTcp) {
+    fake_server server;
+    std::vector<address> many;
+    for (uint8_t i = 1; i <= 100; ++i) many.emplace_back(10, 0, 0, i);
+    server.hosts["big.test"] = many;
+    server.truncated.insert("big.test");
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve(ip::v4, "big.test", record(result));
+    context.run();
+
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses, many);
+    ASSERT_EQ(server.udp_queries, 1u);
+    ASSERT_EQ(server.tcp_queries, 1u);
+}
+
+TEST_P(DnsResolver, RetriesAfterTimeout) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1), address("2001:db8::1")};
+    server.drop_first = 2;
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server, 100ms)};
+    outcome result;
+    resolver.async_resolve("a.test", record(result));
+    context.run();
+
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses.size(), 2u);
+    ASSERT_EQ(server.udp_queries, 4u);
+}
+
+TEST_P(DnsResolver, Timeout) {
+    fake_server server;
+    server.drop_first = 1000;
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server, 50ms, 2)};
+    outcome result;
+    auto started = std::chrono::steady_clock::now();
+    resolver.async_resolve("a.test", record(result));
+    context.run();
+
+    ASSERT_EQ(result.ec, error::timeout) << result.ec.message();
+    ASSERT_GE(std::chrono::steady_clock::now() - started, 100ms);
+    ASSERT_EQ(server.udp_queries, 4u);
+}
+
+TEST_P(DnsResolver, ServerFailureTriesNextServer) {
+    fake_server broken, working;
+    broken.failure = 2; // SERVFAIL
+    working.hosts["a.test"] = {address(192, 0, 2, 1)};
+    broken.start();
+    working.start();
+
+    io_context context{GetParam()};
+    dns::resolver::config settings = local_config(broken);
+    settings.nameservers.push_back(working.local_endpoint());
+    dns::resolver resolver{context, settings};
+
+    outcome result;
+    resolver.async_resolve(ip::v4, "a.test", record(result));
+    context.run();
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+    ASSERT_EQ(broken.udp_queries, 1u);
+    ASSERT_EQ(working.udp_queries, 1u);
+}
+
+TEST_P(DnsResolver, AllServersFail) {
+    fake_server server;
+    server.failure = 2; // SERVFAIL
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve(ip::v4, "a.test", record(result));
+    context.run();
+    ASSERT_EQ(result.ec, error::host_not_found_try_again) << result.ec.message();
+    ASSERT_EQ(server.udp_queries, 2u);
+}
+
+TEST_P(DnsResolver, IgnoresForgedReplies) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1)};
+    server.forge = true;
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome result;
+    resolver.async_resolve(ip::v4, "a.test", record(result));
+    context.run();
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses, (std::vector<address>{{192, 0, 2, 1}}));
+}
+
+TEST_P(DnsResolver, ManyInFlight) {
+    constexpr unsigned names_count = 256;
+
+    fake_server server;
+    for (unsigned i = 0; i < names_count; ++i) {
+        server.hosts["host-" + std::to_string(i) + ".test"] = {address(10, 1, uint8_t(i / 256), uint8_t(i))};
+    }
+    server.reverse_batch = 16;
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    std::vector<outcome> results(names_count);
+    for (unsigned i = 0; i < names_count; ++i) {
+        resolver.async_resolve(ip::v4, "host-" + std::to_string(i) + ".test", record(results[i]));
+    }
+
+    std::thread helper([&] { context.run(); });
+    context.run();
+    helper.join();
+
+    for (unsigned i = 0; i < names_count; ++i) {
+        ASSERT_FALSE(results[i].ec) << i << ": " << results[i].ec.message();
+        ASSERT_EQ(results[i].answer.addresses, (std::vector<address>{{10, 1, uint8_t(i / 256), uint8_t(i)}}));
+    }
+    ASSERT_EQ(server.udp_queries, names_count);
+}
+
+TEST_P(DnsResolver, NumericAndInvalidNames) {
+    fake_server server;
+    server.start();
+
+    io_context context{GetParam()};
+    dns::resolver resolver{context, local_config(server)};
+    outcome numeric, wrong_version, invalid;
+    resolver.async_resolve("192.0.2.7", record(numeric));
+    resolver.async_resolve(ip::v6, "192.0.2.7", record(wrong_version));
+    resolver.async_resolve("bad..name", record(invalid));
+    ASSERT_EQ(context.run(), 3u);
+
+    ASSERT_FALSE(numeric.ec);
+    ASSERT_EQ(numeric.answer.addresses, (std::vector<address>{{192, 0, 2, 7}}));
+    ASSERT_EQ(wrong_version.ec, error::no_address);
+    ASSERT_EQ(invalid.ec, error::invalid_argument);
+    ASSERT_EQ(server.udp_queries, 0u);
+}
+
+TEST_P(DnsResolver, DestroyedFromHandler) {
+    fake_server server;
+    server.hosts["a.test"] = {address(192, 0, 2, 1), address("2001:db8::1")};
+    server.start();
+
+    io_context context{GetParam()};
+    auto resolver = std::make_unique<dns::resolver>(context, local_config(server));
+    outcome result;
+    resolver->async_resolve("a.test", [&](std::error_code ec, dns::answer answer) {
+        record(result)(ec, std::move(answer));
+        resolver.reset();
+    });
+    context.run();
+    ASSERT_TRUE(result.done);
+    ASSERT_FALSE(result.ec) << result.ec.message();
+    ASSERT_EQ(result.answer.addresses.size(), 2u);
+}
+
+TEST_P(DnsResolver, DestroyedInFlight) {
+    fake_server server;
+    server.drop_first = 1000;
+    server.start();
+
+    io_context context{GetParam()};
+    bool called = false;
+    {
+        dns::resolver resolver{context, local_config(server)};
+        resolver.async_resolve("a.test", [&](std::error_code, dns::answer) { called = true; });
+    }
+    context.run();
+    ASSERT_FALSE(called);
+}
+
+TEST(DnsResolverConfig, Parse) {
+    auto settings = dns::resolver::config::parse("# Generated\n"
+                                                 "search example.com\n"
+                                                 "nameserver 192.0.2.53 ; primary\n"
+                                                 "nameserver\t2001:db8::53\r\n"
+                                                 "nameserver fe80::1%eth0\n"
+                                                 "nameserver not-an-address\n"
+                                                 "options ndots:2 timeout:3 attempts:9 rotate\n"
+                                                 "nameserver 192.0.2.54");
+    ASSERT_EQ(settings.nameservers, (std::vector<endpoint>{{address(192, 0, 2, 53), 53},
+                                                           {address("2001:db8::53"), 53},
+                                                           {address(192, 0, 2, 54), 53}}));
+    ASSERT_EQ(settings.timeout, 3s);
+    ASSERT_EQ(settings.attempts, 5u);
+}
+
+TEST(DnsResolverConfig, MissingFile) {
+    auto settings = dns::resolver::config::load("/nonexistent/resolv.conf");
+    ASSERT_TRUE(settings.nameservers.empty());
+    ASSERT_EQ(settings.timeout, 5s);
+    ASSERT_EQ(settings.attempts, 2u);
+}
+
+#endif // ifdef __linux__
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "gtest.hpp"
+#include <libwire/endpoint.hpp>
+
+using namespace libwire;
+
+TEST(Endpoint, IPv4) {
+    endpoint ep{ipv4::loopback, 7777};
+    ASSERT_FALSE(ep.empty());
+    ASSERT_EQ(ep.version(), ip::v4);
+    ASSERT_EQ(ep.address(), ipv4::loopback);
+    ASSERT_EQ(ep.port(), 7777);
+    ASSERT_EQ(ep.size(), sizeof(sockaddr_in));
+    ASSERT_EQ(ep.data()->sa_family, AF_INET);
+    ASSERT_EQ(ep.to_string(), "127.0.0.1:7777");
+}
+
+TEST(Endpoint, IPv6) {
+    endpoint ep{ipv6::loopback, 443};
+    ASSERT_EQ(ep.version(), ip::v6);
+    ASSERT_EQ(ep.address(), ipv6::loopback);
+    ASSERT_EQ(ep.port(), 443);
+    ASSERT_EQ(ep.size(), sizeof(sockaddr_in6));
+    ASSERT_EQ(ep.to_string(), "[::1]:443");
+}
+
+TEST(Endpoint, TupleConversion) {
+    std::tuple<address, uint16_t> tuple{address{10, 0, 0, 1}, 53};
+    endpoint ep = tuple;
+    ASSERT_TRUE((std::tuple<address, uint16_t>(ep) == tuple));
+    ASSERT_EQ(ep, endpoint(address{10, 0, 0, 1}, 53));
+    ASSERT_NE(ep, endpoint(address{10, 0, 0, 1}, 54));
+    ASSERT_NE(ep, endpoint(address{10, 0, 0, 2}, 53));
+}
+
+TEST(Endpoint, Empty) {
+    endpoint ep;
+    ASSERT_TRUE(ep.empty());
+    ASSERT_EQ(ep, endpoint());
+    ASSERT_GE(endpoint::capacity(), sizeof(sockaddr_in6));
+}
+
+TEST(Endpoint, V4Mapped) {
+    endpoint ep{address{192, 168, 1, 2}, 8080};
+    endpoint mapped = ep.v4_mapped();
+    ASSERT_EQ(mapped.version(), ip::v6);
+    ASSERT_EQ(mapped.port(), 8080);
+    ASSERT_EQ(mapped.address(), (address{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 192, 168, 1, 2}));
+
+    mapped.unmap();
+    ASSERT_EQ(mapped, ep);
+
+    endpoint v6{ipv6::loopback, 1};
+    ASSERT_EQ(v6.v4_mapped(), v6);
+    v6.unmap();
+    ASSERT_EQ(v6, endpoint(ipv6::loopback, 1));
+}
+
+TEST(Endpoint, FromNative) {
+    endpoint ep{ipv6::loopback, 9};
+    endpoint copy(ep.data(), ep.size());
+    ASSERT_EQ(copy, ep);
+
+    // Too short for address family.
+    endpoint truncated(ep.data(), sizeof(sockaddr_in));
+    ASSERT_TRUE(truncated.empty());
+}
+
+TEST(Endpoint, ToChars) {
+    char buffer[endpoint::max_text_size];
+    endpoint ep{ipv6::broadcast, 65535};
+    auto [end, ec] = ep.to_chars(buffer, buffer + sizeof(buffer));
+    ASSERT_EQ(ec, std::errc{});
+    ASSERT_EQ(std::string_view(buffer, size_t(end - buffer)), "[ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff]:65535");
+
+    ASSERT_EQ(ep.to_chars(buffer, buffer + 10).ec, std::errc::value_too_large);
+    ASSERT_EQ(endpoint().to_chars(buffer, buffer).ec, std::errc{});
+}
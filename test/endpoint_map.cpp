@@ -0,0 +1,148 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <map>
+#include <memory>
+#include <random>
+#include "gtest.hpp"
+#include <libwire/endpoint_map.hpp>
+
+using namespace libwire;
+
+namespace {
+    std::tuple<address, uint16_t> v4_endpoint(uint32_t host, uint16_t port) {
+        return {address{10, uint8_t(host >> 16u), uint8_t(host >> 8u), uint8_t(host)}, port};
+    }
+} // namespace
+
+TEST(EndpointMap, InsertFindErase) {
+    endpoint_map<int> map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.find({ipv4::loopback, 80}), nullptr);
+    ASSERT_FALSE(map.erase({ipv4::loopback, 80}));
+
+    auto [value, inserted] = map.try_emplace({ipv4::loopback, 80}, 1);
+    ASSERT_TRUE(inserted);
+    ASSERT_EQ(*value, 1);
+    auto [same, inserted_again] = map.try_emplace({ipv4::loopback, 80}, 2);
+    ASSERT_FALSE(inserted_again);
+    ASSERT_EQ(same, value);
+    ASSERT_EQ(*same, 1);
+
+    map[{ipv4::loopback, 81}] = 3;
+    ASSERT_EQ(map.size(), 2u);
+    ASSERT_EQ(*map.find({ipv4::loopback, 81}), 3);
+    ASSERT_TRUE(map.contains({ipv4::loopback, 80}));
+    ASSERT_FALSE(map.contains({ipv4::any, 80}));
+
+    ASSERT_TRUE(map.erase({ipv4::loopback, 80}));
+    ASSERT_FALSE(map.contains({ipv4::loopback, 80}));
+    ASSERT_EQ(map.size(), 1u);
+}
+
+TEST(EndpointMap, DistinguishesVersionAndPort) {
+    endpoint_map<int> map;
+    // Same bytes in parts array, different version.
+    address v6{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    map[{ipv4::any, 53}] = 1;
+    map[{v6, 53}] = 2;
+    map[{ipv4::any, 54}] = 3;
+    ASSERT_EQ(map.size(), 3u);
+    ASSERT_EQ(*map.find({ipv4::any, 53}), 1);
+    ASSERT_EQ(*map.find({v6, 53}), 2);
+    ASSERT_EQ(*map.find({ipv4::any, 54}), 3);
+}
+
+TEST(EndpointMap, MatchesReferenceUnderRandomOperations) {
+    endpoint_map<uint32_t> map;
+    std::map<std::pair<uint32_t, uint16_t>, uint32_t> reference;
+    std::mt19937 rng(42);
+
+    for (uint32_t i = 0; i < 200000; ++i) {
+        uint32_t host = rng() % 5000;
+        auto port = uint16_t(rng() % 8);
+        auto key = v4_endpoint(host, port);
+        switch (rng() % 3) {
+        case 0:
+        case 1:
+            map[key] = i;
+            reference[{host, port}] = i;
+            break;
+        case 2:
+            ASSERT_EQ(map.erase(key), reference.erase({host, port}) == 1);
+            break;
+        }
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    for (auto& [key, value] : reference) {
+        const uint32_t* found = map.find(v4_endpoint(key.first, key.second));
+        ASSERT_NE(found, nullptr);
+        ASSERT_EQ(*found, value);
+    }
+
+    size_t visited = 0;
+    map.for_each([&](const std::tuple<address, uint16_t>&, uint32_t&) { ++visited; });
+    ASSERT_EQ(visited, reference.size());
+}
+
+TEST(EndpointMap, ReserveAvoidsGrowth) {
+    endpoint_map<int> map(100000);
+    size_t capacity = map.capacity();
+    ASSERT_GE(capacity - capacity / 8, 100000u);
+    for (uint32_t i = 0; i < 100000; ++i) map[v4_endpoint(i, 1)] = int(i);
+    ASSERT_EQ(map.capacity(), capacity);
+    ASSERT_EQ(*map.find(v4_endpoint(99999, 1)), 99999);
+}
+
+TEST(EndpointMap, ChurnDoesNotGrow) {
+    endpoint_map<int> map(1000);
+    size_t capacity = map.capacity();
+    // Erased slots must be reused or purged, not accumulate until growth.
+    for (uint32_t i = 0; i < 100000; ++i) {
+        map[v4_endpoint(i, 1)] = 1;
+        if (i >= 500) {
+            ASSERT_TRUE(map.erase(v4_endpoint(i - 500, 1)));
+        }
+    }
+    ASSERT_EQ(map.size(), 500u);
+    ASSERT_EQ(map.capacity(), capacity);
+}
+
+TEST(EndpointMap, OwnsValues) {
+    auto counter = std::make_shared<int>(0);
+    {
+        endpoint_map<std::shared_ptr<int>> map;
+        for (uint32_t i = 0; i < 1000; ++i) map[v4_endpoint(i, 1)] = counter;
+        ASSERT_EQ(counter.use_count(), 1001);
+        map.erase(v4_endpoint(0, 1));
+        ASSERT_EQ(counter.use_count(), 1000);
+
+        endpoint_map<std::shared_ptr<int>> moved = std::move(map);
+        ASSERT_EQ(counter.use_count(), 1000);
+        ASSERT_TRUE(map.empty());
+        moved.clear();
+        ASSERT_EQ(counter.use_count(), 1);
+        moved[v4_endpoint(1, 1)] = counter;
+    }
+    ASSERT_EQ(counter.use_count(), 1);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../gtest.hpp"
+#include "libwire/internal/address_text.hpp"
+
+#ifdef _WIN32
+#    include <ws2tcpip.h>
+#else
+#    include <arpa/inet.h>
+#endif
+
+using namespace libwire::internal_;
+
+using parse_function = bool (*)(const char*, size_t, uint8_t*) noexcept;
+
+static const std::vector<std::string> ipv4_samples = {
+    "0.0.0.0", "127.0.0.1", "255.255.255.255", "1.22.133.244", "10.0.0.10", "192.168.100.1",
+    "", "1", "1.2.3", "1.2.3.4.", ".1.2.3.4", "1..2.3", "1.2.3.4.5", "256.1.1.1", "1.1.1.256",
+    "01.1.1.1", "1.00.1.1", "1.1.1.01", "1.1.1.1000", "1.1.1.1 ", " 1.1.1.1", "1.1.1.a", "1,1.1.1",
+    "0.0.0.0.", "999.999.999.999", "1.2.3.4/", "1.2.3.-4", "0000.0.0.0", "1.2.3.4\n"};
+
+static void check_ipv4_kernel(parse_function kernel) {
+    for (const std::string& text : ipv4_samples) {
+        uint8_t expected[4], actual[4];
+        bool valid = inet_pton(AF_INET, text.c_str(), expected) == 1;
+        ASSERT_EQ(kernel(text.data(), text.size(), actual), valid) << "text = '" << text << "'";
+        if (valid) {
+            ASSERT_EQ(std::memcmp(actual, expected, 4), 0) << "text = '" << text << "'";
+        }
+    }
+
+    std::mt19937 random(42);
+    // Random strings of digits and dots, mostly invalid.
+    std::uniform_int_distribution<int> character(0, 11), length(0, 17);
+    for (int i = 0; i < 100000; ++i) {
+        std::string text(size_t(length(random)), '0');
+        for (char& ch : text) ch = "0123456789.."[character(random)];
+
+        uint8_t expected[4], actual[4];
+        bool valid = inet_pton(AF_INET, text.c_str(), expected) == 1;
+        ASSERT_EQ(kernel(text.data(), text.size(), actual), valid) << "text = '" << text << "'";
+        if (valid) {
+            ASSERT_EQ(std::memcmp(actual, expected, 4), 0) << "text = '" << text << "'";
+        }
+    }
+
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int i = 0; i < 10000; ++i) {
+        uint8_t input[4] = {uint8_t(byte(random)), uint8_t(byte(random)), uint8_t(byte(random)),
+                            uint8_t(byte(random))};
+        char text[ipv4_text_max];
+        char* end = format_ipv4(input, text);
+
+        uint8_t output[4];
+        ASSERT_TRUE(kernel(text, size_t(end - text), output)) << std::string(text, end);
+        ASSERT_EQ(std::memcmp(input, output, 4), 0);
+
+        // Characters past given bounds must be ignored.
+        std::string prefix(text, end - 1);
+        uint8_t expected[4];
+        ASSERT_EQ(kernel(text, prefix.size(), output), inet_pton(AF_INET, prefix.c_str(), expected) == 1) << prefix;
+    }
+}
+
+TEST(ImplAddressText, ParseIPv4Scalar) {
+    check_ipv4_kernel(parse_ipv4_scalar);
+}
+
+#ifdef LIBWIRE_X86_KERNELS
+TEST(ImplAddressText, ParseIPv4Sse2) {
+    check_ipv4_kernel(parse_ipv4_sse2);
+}
+#endif
+
+TEST(ImplAddressText, ParseIPv4Dispatch) {
+    check_ipv4_kernel(parse_ipv4);
+}
+
+TEST(ImplAddressText, ParseIPv6) {
+    for (std::string text :
+         {"::", "::1", "1::", "1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7::", "::2:3:4:5:6:7:8", "fe80::1", "FE80::A:b",
+          "2001:db8::ff00:42:8329", "::ffff:10.0.0.1", "::1.2.3.4", "1:2:3:4:5:6:1.2.3.4", "0:0:0:0:0:0:0:0",
+          "0001:02:003:0004::", "", ":", ":::", "1:::2", "1::2::3", ":1::", "1:2:3:4:5:6:7:8:9", "1:2:3:4:5:6:7",
+          "1:2:3:4::5:6:7:8", "12345::", "1:", ":1", "g::", "::1.2.3", "::1.2.3.4:5", "1:2:3:4:5:6:7:1.2.3.4",
+          "::256.1.1.1", "::01.2.3.4", "1::2:3:4:5:6:1.2.3.4", "::ffff:1.2.3.4.", "fe80::1%eth0", "[::1]"}) {
+        uint8_t expected[16], actual[16];
+        bool valid = inet_pton(AF_INET6, text.c_str(), expected) == 1;
+        ASSERT_EQ(parse_ipv6(text.data(), text.size(), actual), valid) << "text = '" << text << "'";
+        if (valid) {
+            ASSERT_EQ(std::memcmp(actual, expected, 16), 0) << "text = '" << text << "'";
+        }
+    }
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> character(0, 15), length(0, 24);
+    for (int i = 0; i < 100000; ++i) {
+        std::string text(size_t(length(random)), '0');
+        for (char& ch : text) ch = "0120af:::::.1.2F"[character(random)];
+
+        uint8_t expected[16], actual[16];
+        bool valid = inet_pton(AF_INET6, text.c_str(), expected) == 1;
+        ASSERT_EQ(parse_ipv6(text.data(), text.size(), actual), valid) << "text = '" << text << "'";
+        if (valid) {
+            ASSERT_EQ(std::memcmp(actual, expected, 16), 0) << "text = '" << text << "'";
+        }
+    }
+}
+
+TEST(ImplAddressText, FormatIPv6) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> byte(0, 255), zero_word(0, 2);
+    for (int i = 0; i < 20000; ++i) {
+        // Mostly zero words to get a lot of "::" runs.
+        uint8_t input[16];
+        for (int word = 0; word < 8; ++word) {
+            bool zero = zero_word(random) != 0;
+            input[word * 2] = zero ? 0 : uint8_t(byte(random));
+            input[word * 2 + 1] = zero ? 0 : uint8_t(byte(random));
+        }
+        if (i % 10 == 0) {
+            std::memset(input, 0, 10);
+            input[10] = input[11] = 0xff;
+        }
+
+        char expected[INET6_ADDRSTRLEN];
+        ASSERT_NE(inet_ntop(AF_INET6, input, expected, sizeof(expected)), nullptr);
+
+        char text[ipv6_text_max];
+        char* end = format_ipv6(input, text);
+        ASSERT_EQ(std::string(text, end), expected);
+
+        uint8_t output[16];
+        ASSERT_TRUE(parse_ipv6(text, size_t(end - text), output)) << expected;
+        ASSERT_EQ(std::memcmp(input, output, 16), 0) << expected;
+    }
+}
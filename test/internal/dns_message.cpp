@@ -0,0 +1,244 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../gtest.hpp"
+#include "libwire/internal/dns_message.hpp"
+
+using namespace libwire;
+using namespace libwire::internal_;
+
+namespace {
+    struct message_builder {
+        void u16(uint16_t value) {
+            bytes.push_back(uint8_t(value >> 8u));
+            bytes.push_back(uint8_t(value));
+        }
+
+        void u32(uint32_t value) {
+            u16(uint16_t(value >> 16u));
+            u16(uint16_t(value));
+        }
+
+        void name(std::string_view text) {
+            while (!text.empty()) {
+                size_t dot = std::min(text.find('.'), text.size());
+                bytes.push_back(uint8_t(dot));
+                bytes.insert(bytes.end(), text.begin(), text.begin() + ptrdiff_t(dot));
+                text.remove_prefix(std::min(dot + 1, text.size()));
+            }
+            bytes.push_back(0);
+        }
+
+        void pointer(uint16_t offset) {
+            u16(uint16_t(0xc000u | offset));
+        }
+
+        void header(uint16_t flags, uint16_t answers, uint16_t authority = 0) {
+            u16(0x1234);
+            u16(flags);
+            u16(1);
+            u16(answers);
+            u16(authority);
+            u16(0);
+        }
+
+        void question(std::string_view qname, dns_type type) {
+            name(qname);
+            u16(uint16_t(type));
+            u16(1);
+        }
+
+        // Owner is pointer to question name.
+        void record(dns_type type, uint32_t ttl, const std::vector<uint8_t>& data, uint16_t owner = 12) {
+            pointer(owner);
+            u16(uint16_t(type));
+            u16(1);
+            u32(ttl);
+            u16(uint16_t(data.size()));
+            bytes.insert(bytes.end(), data.begin(), data.end());
+        }
+
+        std::vector<uint8_t> bytes;
+    };
+
+    constexpr uint16_t reply_flags = 0x8180;
+
+    dns_reply read(const message_builder& message, std::string_view name, dns_type type, bool expect_valid = true) {
+        dns_reply reply;
+        EXPECT_EQ(dns_read_reply(message.bytes.data(), message.bytes.size(), name, type, reply), expect_valid);
+        return reply;
+    }
+} // namespace
+
+TEST(DnsMessage, WriteQuery) {
+    uint8_t output[dns_max_query_size];
+    size_t size = dns_write_query(0xabcd, "Example.COM.", dns_type::aaaa, output);
+
+    const std::vector<uint8_t> expected = {
+        0xab, 0xcd, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 1,                           // Header
+        7, 'E', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'C', 'O', 'M', 0, 0, 28, 0, 1, // Question
+        0, 0, 41, 0x04, 0xd0, 0, 0, 0, 0, 0, 0};                                // OPT
+    ASSERT_EQ(std::vector<uint8_t>(output, output + size), expected);
+    ASSERT_EQ(dns_message_id(output), 0xabcd);
+}
+
+TEST(DnsMessage, WriteQueryInvalidNames) {
+    uint8_t output[dns_max_query_size];
+    std::string long_label(64, 'a'), max_label(63, 'a');
+
+    for (const std::string& name : std::vector<std::string>{"", ".", "a..b", ".a", "a.b..", long_label}) {
+        ASSERT_EQ(dns_write_query(1, name, dns_type::a, output), 0u) << "name = '" << name << "'";
+    }
+    ASSERT_NE(dns_write_query(1, max_label, dns_type::a, output), 0u);
+
+    // 4 labels of 63 bytes and separating dots: 255 bytes in text, 257 in wire format.
+    std::string too_long = max_label + "." + max_label + "." + max_label + "." + max_label;
+    ASSERT_EQ(dns_write_query(1, too_long, dns_type::a, output), 0u);
+
+    std::string longest = max_label + "." + max_label + "." + max_label + "." + std::string(61, 'b');
+    size_t size = dns_write_query(1, longest, dns_type::a, output);
+    ASSERT_EQ(size, dns_max_query_size);
+}
+
+TEST(DnsMessage, ReadAddresses) {
+    message_builder message;
+    message.header(reply_flags, 3);
+    message.question("example.com", dns_type::a);
+    message.record(dns_type::a, 300, {192, 0, 2, 1});
+    message.record(dns_type::a, 100, {192, 0, 2, 2});
+    // Wrong size, ignored.
+    message.record(dns_type::a, 10, {192, 0, 2});
+
+    dns_reply reply = read(message, "EXAMPLE.com.", dns_type::a);
+    ASSERT_EQ(reply.rcode, no_error);
+    ASSERT_FALSE(reply.truncated);
+    ASSERT_EQ(reply.addresses, (std::vector<address>{{192, 0, 2, 1}, {192, 0, 2, 2}}));
+    ASSERT_EQ(reply.ttl, 100u);
+}
+
+TEST(DnsMessage, ReadCnameChain) {
+    message_builder message;
+    message.header(reply_flags, 4);
+    message.question("www.example.com", dns_type::aaaa);
+
+    // www.example.com CNAME cdn.example.com, "example.com" is compressed.
+    size_t first_target = message.bytes.size() + 12;
+    message.record(dns_type::cname, 600, {3, 'c', 'd', 'n', 0xc0, 16});
+    // cdn.example.com CNAME edge.example.net
+    size_t second_target = message.bytes.size() + 12;
+    message.record(dns_type::cname, 50, {4, 'e', 'd', 'g', 'e', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'n', 'e', 't', 0},
+                   uint16_t(first_target));
+    message.record(dns_type::aaaa, 300, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1},
+                   uint16_t(second_target));
+    // Not part of chain.
+    message.record(dns_type::aaaa, 300, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2});
+
+    dns_reply reply = read(message, "www.example.com", dns_type::aaaa);
+    ASSERT_EQ(reply.addresses, (std::vector<address>{address("2001:db8::1")}));
+    ASSERT_EQ(reply.ttl, 50u);
+}
+
+TEST(DnsMessage, ReadNegativeAnswer) {
+    message_builder message;
+    message.header(reply_flags | name_error, 0, 1);
+    message.question("missing.example.com", dns_type::a);
+
+    // SOA: mname, rname, serial, refresh, retry, expire, minimum.
+    message_builder soa;
+    soa.name("ns.example.com");
+    soa.name("admin.example.com");
+    for (uint32_t field : {1u, 7200u, 3600u, 86400u, 60u}) soa.u32(field);
+    message.record(dns_type::soa, 900, soa.bytes, 20);
+
+    dns_reply reply = read(message, "missing.example.com", dns_type::a);
+    ASSERT_EQ(reply.rcode, name_error);
+    ASSERT_TRUE(reply.addresses.empty());
+    ASSERT_EQ(reply.ttl, 60u);
+}
+
+TEST(DnsMessage, ReadTruncated) {
+    message_builder message;
+    message.header(reply_flags | 0x0200, 1);
+    message.question("example.com", dns_type::a);
+    // Record cut in the middle, not parsed.
+    message.bytes.insert(message.bytes.end(), {0xc0, 12, 0, 1});
+
+    dns_reply reply = read(message, "example.com", dns_type::a);
+    ASSERT_TRUE(reply.truncated);
+    ASSERT_TRUE(reply.addresses.empty());
+}
+
+TEST(DnsMessage, RejectsMismatch) {
+    message_builder message;
+    message.header(reply_flags, 0);
+    message.question("example.com", dns_type::a);
+
+    read(message, "example.org", dns_type::a, false);
+    read(message, "example.com", dns_type::aaaa, false);
+
+    // Query instead of reply.
+    message.bytes[2] &= 0x7f;
+    read(message, "example.com", dns_type::a, false);
+}
+
+TEST(DnsMessage, RejectsPointerLoops) {
+    message_builder message;
+    message.header(reply_flags, 1);
+    message.question("example.com", dns_type::a);
+    // Owner points to itself.
+    size_t owner = message.bytes.size();
+    message.pointer(uint16_t(owner));
+    message.bytes.insert(message.bytes.end(), {0, 1, 0, 1, 0, 0, 0, 1, 0, 4, 1, 2, 3, 4});
+    read(message, "example.com", dns_type::a, false);
+
+    // Label followed by pointer back to it.
+    message.bytes.resize(owner);
+    message.bytes.insert(message.bytes.end(), {1, 'a'});
+    message.pointer(uint16_t(owner));
+    read(message, "example.com", dns_type::a, false);
+}
+
+TEST(DnsMessage, MalformedInput) {
+    message_builder message;
+    message.header(reply_flags, 2);
+    message.question("example.com", dns_type::a);
+    message.record(dns_type::cname, 300, {1, 'x', 0xc0, 12});
+    message.record(dns_type::a, 300, {192, 0, 2, 1}, 41);
+    ASSERT_EQ(read(message, "example.com", dns_type::a).addresses, (std::vector<address>{{192, 0, 2, 1}}));
+
+    // Every prefix of message is invalid.
+    dns_reply reply;
+    for (size_t size = 0; size < message.bytes.size(); ++size) {
+        ASSERT_FALSE(dns_read_reply(message.bytes.data(), size, "example.com", dns_type::a, reply)) << size;
+    }
+
+    // Random corruption must not crash or read out of bounds.
+    std::mt19937 random(42);
+    for (int i = 0; i < 100000; ++i) {
+        std::vector<uint8_t> corrupted = message.bytes;
+        for (int j = 0; j < 3; ++j) corrupted[random() % corrupted.size()] = uint8_t(random());
+        dns_read_reply(corrupted.data(), corrupted.size(), "example.com", dns_type::a, reply);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdint>
+#include "../gtest.hpp"
+#include "libwire/internal/frame_pool.hpp"
+
+using namespace libwire::internal_;
+
+TEST(ImplFramePool, ReusesFreedBlocks) {
+    frame_pool pool;
+    void* first = frame_pool::allocate(&pool, 100);
+    frame_pool::deallocate(first);
+
+    // Same size class.
+    void* second = frame_pool::allocate(&pool, 110);
+    ASSERT_EQ(first, second);
+    frame_pool::deallocate(second);
+}
+
+TEST(ImplFramePool, Alignment) {
+    frame_pool pool;
+    for (size_t size : {1, 63, 64, 1000, 100000}) {
+        void* block = frame_pool::allocate(&pool, size);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t), 0u);
+        frame_pool::deallocate(block);
+    }
+}
+
+TEST(ImplFramePool, WithoutPool) {
+    void* block = frame_pool::allocate(nullptr, 100);
+    ASSERT_NE(block, nullptr);
+    frame_pool::deallocate(block);
+}
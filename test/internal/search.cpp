@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <random>
+#include <string_view>
+#include <vector>
+#include "../gtest.hpp"
+#include "libwire/internal/search.hpp"
+
+using namespace libwire::internal_;
+
+using search_function = size_t (*)(const uint8_t*, size_t, const uint8_t*, size_t) noexcept;
+
+static size_t reference_search(const std::vector<uint8_t>& haystack, std::string_view needle) {
+    auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+                          [](uint8_t a, char b) { return a == uint8_t(b); });
+    return size_t(it - haystack.begin());
+}
+
+static void check_kernel(search_function kernel) {
+    std::mt19937 random(42);
+    // Small alphabet to get a lot of partial matches.
+    std::uniform_int_distribution<int> byte('\n', '\r');
+
+    for (std::string_view needle : {"\n", "\r\n", "\r\n\r\n", "\r\r\n\n\r"}) {
+        for (size_t size = 0; size < 200; ++size) {
+            std::vector<uint8_t> haystack(size);
+            for (auto& i : haystack) i = uint8_t(byte(random));
+
+            ASSERT_EQ(kernel(haystack.data(), haystack.size(), reinterpret_cast<const uint8_t*>(needle.data()),
+                             needle.size()),
+                      reference_search(haystack, needle))
+                << "size = " << size << ", needle size = " << needle.size();
+        }
+    }
+}
+
+TEST(ImplSearch, Scalar) {
+    check_kernel(search_scalar);
+}
+
+#ifdef LIBWIRE_X86_KERNELS
+TEST(ImplSearch, Sse2) {
+    check_kernel(search_sse2);
+}
+
+TEST(ImplSearch, Avx2) {
+    if (!search_avx2_supported()) return;
+    check_kernel(search_avx2);
+}
+#endif
+
+TEST(ImplSearch, Dispatch) {
+    check_kernel(search);
+}
+
+TEST(ImplSearch, MatchAtEnd) {
+    std::vector<uint8_t> haystack(100, 'x');
+    haystack[98] = '\r';
+    haystack[99] = '\n';
+    ASSERT_EQ(search(haystack.data(), haystack.size(), reinterpret_cast<const uint8_t*>("\r\n"), 2), 98);
+}
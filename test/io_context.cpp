@@ -0,0 +1,665 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "gtest.hpp"
+#include <libwire/io_context.hpp>
+#include <libwire/options.hpp>
+
+using namespace libwire;
+using namespace std::literals;
+
+static uint16_t local_port(const tcp::listener& listener) {
+    return std::get<1>(listener.implementation().local_endpoint());
+}
+
+static tcp::socket connect_to(const tcp::listener& listener) {
+    tcp::socket client;
+    client.connect(ipv4::loopback, local_port(listener));
+    client.set_option(receive_timeout, 10s);
+    return client;
+}
+
+class IoContext : public testing::TestWithParam<io_context::backend_type> {};
+
+INSTANTIATE_TEST_SUITE_P(Backends, IoContext,
+                         testing::Values(io_context::backend_type::epoll, io_context::backend_type::io_uring));
+
+TEST(IoContextBackend, Selection) {
+    io_context epoll_context{io_context::backend_type::epoll};
+    ASSERT_EQ(epoll_context.backend(), io_context::backend_type::epoll);
+
+    // Falls back to epoll if io_uring is unavailable, but never reports automatic.
+    io_context automatic_context;
+    ASSERT_NE(automatic_context.backend(), io_context::backend_type::automatic);
+}
+
+TEST_P(IoContext, RunWithoutWork) {
+    io_context context{GetParam()};
+    ASSERT_EQ(context.run(), 0u);
+}
+
+TEST_P(IoContext, Post) {
+    io_context context{GetParam()};
+    int calls = 0;
+    for (int i = 0; i < 3; ++i) {
+        context.post([&] { ++calls; });
+    }
+    ASSERT_EQ(context.run(), 3u);
+    ASSERT_EQ(calls, 3);
+}
+
+TEST_P(IoContext, Stop) {
+    io_context context{GetParam()};
+    bool second_called = false;
+    context.post([&] { context.stop(); });
+    context.post([&] { second_called = true; });
+
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_TRUE(context.stopped());
+    ASSERT_FALSE(second_called);
+
+    context.restart();
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_TRUE(second_called);
+}
+
+TEST_P(IoContext, AcceptReadWrite) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket server;
+    std::vector<uint8_t> buffer(5);
+
+    context.async_accept(listener, [&](std::error_code ec, tcp::socket accepted) {
+        ASSERT_FALSE(ec) << ec.message();
+        server = std::move(accepted);
+        context.async_read(server, make_view(buffer), [&](std::error_code ec, size_t read) {
+            ASSERT_FALSE(ec) << ec.message();
+            ASSERT_EQ(read, 5u);
+            context.async_write(server, make_view(std::as_const(buffer)), [&](std::error_code ec, size_t written) {
+                ASSERT_FALSE(ec) << ec.message();
+                ASSERT_EQ(written, 5u);
+            });
+        });
+    });
+
+    std::thread client_thread([&] {
+        tcp::socket client = connect_to(listener);
+        client.write("hello"s);
+        ASSERT_EQ(client.read<std::string>(5), "hello");
+    });
+
+    ASSERT_EQ(context.run(), 3u);
+    client_thread.join();
+}
+
+TEST_P(IoContext, AcceptReportsPeer) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+
+    context.async_accept(listener, [&](std::error_code ec, tcp::socket accepted) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_TRUE(accepted.implementation().peer);
+        ASSERT_EQ(*accepted.implementation().peer, client.local_endpoint());
+    });
+
+    ASSERT_EQ(context.run(), 1u);
+}
+
+TEST_P(IoContext, AcceptPeerFilter) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket rejected = connect_to(listener);
+    tcp::socket client = connect_to(listener);
+
+    uint16_t rejected_port = std::get<1>(rejected.local_endpoint());
+    listener.set_peer_filter([&](const endpoint& peer) { return peer.port() != rejected_port; });
+    context.async_accept(listener, [&](std::error_code ec, tcp::socket accepted) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(accepted.remote_endpoint(), client.local_endpoint());
+    });
+
+    ASSERT_EQ(context.run(), 1u);
+}
+
+TEST_P(IoContext, AcceptDualStack) {
+    io_context context{GetParam()};
+    tcp::listener listener{dual_stack, 0};
+    tcp::socket single = connect_to(listener);
+    tcp::socket first = connect_to(listener);
+    tcp::socket second = connect_to(listener);
+
+    // Accepted sockets and filter see IPv4 peers, as with blocking accept.
+    listener.set_peer_filter([&](const endpoint& peer) {
+        EXPECT_EQ(peer.address(), ipv4::loopback);
+        return true;
+    });
+    std::vector<tcp::socket> accepted;
+    context.async_accept(listener, [&](std::error_code ec, tcp::socket socket) {
+        ASSERT_FALSE(ec) << ec.message();
+        accepted.push_back(std::move(socket));
+        context.async_accept_multishot(listener, [&](std::error_code ec, tcp::socket socket) {
+            if (ec) return;
+            accepted.push_back(std::move(socket));
+            if (accepted.size() == 3) context.cancel(listener);
+        });
+    });
+    context.run();
+
+    ASSERT_EQ(accepted.size(), 3u);
+    ASSERT_EQ(accepted[0].remote_endpoint(), single.local_endpoint());
+    ASSERT_EQ(accepted[1].remote_endpoint(), first.local_endpoint());
+    ASSERT_EQ(accepted[2].remote_endpoint(), second.local_endpoint());
+    for (const auto& socket : accepted) ASSERT_EQ(socket.implementation().state.ipv6, true);
+}
+
+TEST_P(IoContext, AcceptMultishotPeerFilter) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> accepted;
+
+    std::vector<uint16_t> rejected_ports;
+    listener.set_peer_filter([&](const endpoint& peer) {
+        return std::find(rejected_ports.begin(), rejected_ports.end(), peer.port()) == rejected_ports.end();
+    });
+    context.async_accept_multishot(listener, [&](std::error_code ec, tcp::socket socket) {
+        if (ec) return;
+        accepted.push_back(std::move(socket));
+        if (accepted.size() == 3) context.cancel(listener);
+    });
+
+    std::vector<tcp::socket> clients;
+    for (unsigned i = 0; i < 6; ++i) {
+        clients.push_back(connect_to(listener));
+        if (i % 2 == 0) rejected_ports.push_back(std::get<1>(clients.back().local_endpoint()));
+    }
+
+    context.run();
+    ASSERT_EQ(accepted.size(), 3u);
+    for (size_t i = 0; i < accepted.size(); ++i) {
+        ASSERT_EQ(accepted[i].remote_endpoint(), clients[i * 2 + 1].local_endpoint());
+    }
+}
+
+TEST_P(IoContext, ReadEof) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    client.write("abc"s);
+    client.shutdown(false, true);
+
+    std::vector<uint8_t> buffer(10);
+    context.async_read(server, make_view(buffer), [&](std::error_code ec, size_t read) {
+        ASSERT_EQ(ec, error::generic::disconnected);
+        ASSERT_EQ(read, 3u);
+    });
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_FALSE(server.is_open());
+}
+
+TEST_P(IoContext, ReadUntil) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    std::string first, second, rest;
+    context.async_read_until(server, '\n', first, [&](std::error_code ec, size_t size) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(size, 5u);
+        context.async_read_until(server, '\n', second, [&](std::error_code ec, size_t) {
+            ASSERT_FALSE(ec) << ec.message();
+            // max_size reached, delimiter right after it is consumed too.
+            context.async_read_until(server, '\n', rest, [&](std::error_code ec, size_t) {
+                ASSERT_FALSE(ec) << ec.message();
+            }, 3);
+        }, 3);
+    });
+
+    std::thread writer([&] {
+        client.write("line1\nlo"s);
+        std::this_thread::sleep_for(50ms);
+        client.write("ng\nabc\n"s);
+    });
+    ASSERT_EQ(context.run(), 3u);
+    writer.join();
+
+    ASSERT_EQ(first, "line1");
+    ASSERT_EQ(second, "lon");
+    ASSERT_EQ(rest, "g");
+}
+
+TEST_P(IoContext, ReceiveFrom) {
+    io_context context{GetParam()};
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    uint16_t port = std::get<1>(receiver.implementation().local_endpoint());
+
+    std::vector<uint8_t> buffer(64);
+    context.async_receive_from(receiver, make_view(buffer), [&](std::error_code ec, size_t size,
+                                                                std::tuple<address, uint16_t> source) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(size, 4u);
+        ASSERT_EQ(std::get<0>(source), ipv4::loopback);
+    });
+
+    context.post([&] { sender.write("ping"s, {{ipv4::loopback, port}}); });
+    ASSERT_EQ(context.run(), 2u);
+    ASSERT_EQ(std::string(buffer.begin(), buffer.begin() + 4), "ping");
+}
+
+TEST_P(IoContext, Cancel) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    std::vector<uint8_t> buffer(10);
+    bool canceled = false;
+    context.async_read(server, make_view(buffer), [&](std::error_code ec, size_t) {
+        ASSERT_EQ(ec, error::operation_aborted);
+        canceled = true;
+    });
+    context.post([&] { context.cancel(server); });
+
+    ASSERT_EQ(context.run(), 2u);
+    ASSERT_TRUE(canceled);
+}
+
+TEST_P(IoContext, SendTo) {
+    io_context context{GetParam()};
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.bind(ipv4::loopback, 0);
+    uint16_t port = std::get<1>(receiver.implementation().local_endpoint());
+
+    std::string message = "ping";
+    context.async_send_to(sender, make_view(message), {ipv4::loopback, port}, [&](std::error_code ec, size_t size) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(size, 4u);
+    });
+    ASSERT_EQ(context.run(), 1u);
+
+    std::vector<uint8_t> buffer(64);
+    receiver.read(64, buffer);
+    ASSERT_EQ(std::string(buffer.begin(), buffer.end()), "ping");
+}
+
+TEST_P(IoContext, AcceptMultishot) {
+    constexpr unsigned clients_count = 10;
+
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> accepted;
+    std::error_code final_ec;
+
+    context.async_accept_multishot(listener, [&](std::error_code ec, tcp::socket socket) {
+        if (ec) {
+            final_ec = ec;
+            return;
+        }
+        accepted.push_back(std::move(socket));
+        if (accepted.size() == clients_count) context.cancel(listener);
+    });
+
+    std::vector<tcp::socket> clients;
+    for (unsigned i = 0; i < clients_count; ++i) clients.push_back(connect_to(listener));
+
+    // Several results can be delivered by one handler execution.
+    context.run();
+    ASSERT_EQ(accepted.size(), clients_count);
+    ASSERT_EQ(final_ec, error::operation_aborted);
+    for (auto& socket : accepted) ASSERT_TRUE(socket.is_open());
+}
+
+TEST_P(IoContext, ReceiveMultishot) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    std::string received;
+    std::error_code final_ec;
+    context.async_receive_multishot(server, [&](std::error_code ec, memory_view<const uint8_t> data) {
+        if (ec) {
+            final_ec = ec;
+            ASSERT_EQ(data.size(), 0u);
+            return;
+        }
+        received.append(data.begin(), data.end());
+    });
+
+    std::string expected;
+    for (int i = 0; i < 1000; ++i) expected += std::to_string(i) + ",";
+    std::thread writer([&] {
+        for (size_t offset = 0; offset < expected.size(); offset += 100) {
+            client.write(expected.substr(offset, 100));
+            std::this_thread::sleep_for(1ms);
+        }
+        client.shutdown(false, true);
+    });
+
+    context.run();
+    writer.join();
+    ASSERT_EQ(received, expected);
+    ASSERT_EQ(final_ec, error::end_of_file);
+    ASSERT_FALSE(server.is_open());
+}
+
+TEST_P(IoContext, ReceiveMultishotCancel) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    unsigned chunks = 0;
+    std::error_code final_ec;
+    context.async_receive_multishot(server, [&](std::error_code ec, memory_view<const uint8_t>) {
+        if (ec) {
+            final_ec = ec;
+            return;
+        }
+        // Canceled from handler, no more data should be delivered.
+        if (++chunks == 1) context.cancel(server);
+    });
+    client.write("data"s);
+
+    context.run();
+    ASSERT_EQ(chunks, 1u);
+    ASSERT_EQ(final_ec, error::operation_aborted);
+}
+
+TEST_P(IoContext, RegisteredSocket) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    std::error_code ec;
+    context.register_socket(server, ec);
+    ASSERT_FALSE(ec) << ec.message();
+
+    std::vector<uint8_t> buffer(4);
+    context.async_read(server, make_view(buffer), [&](std::error_code ec, size_t read) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(read, 4u);
+        context.async_write(server, make_view(std::as_const(buffer)), [&](std::error_code ec, size_t) {
+            ASSERT_FALSE(ec) << ec.message();
+        });
+    });
+    client.write("ping"s);
+
+    ASSERT_EQ(context.run(), 2u);
+    ASSERT_EQ(client.read<std::string>(4), "ping");
+    context.unregister_socket(server);
+}
+
+TEST_P(IoContext, ReadTimeout) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    client.write("abc"s);
+
+    std::vector<uint8_t> buffer(10);
+    auto started = std::chrono::steady_clock::now();
+    context.async_read(server, make_view(buffer), 50ms, [&](std::error_code ec, size_t read) {
+        ASSERT_EQ(ec, error::timeout);
+        ASSERT_EQ(read, 3u);
+    });
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_GE(std::chrono::steady_clock::now() - started, 50ms);
+}
+
+TEST_P(IoContext, ReadBeforeTimeout) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    std::vector<uint8_t> buffer(10);
+    auto started = std::chrono::steady_clock::now();
+    context.async_read_some(server, make_view(buffer), 10s, [&](std::error_code ec, size_t read) {
+        ASSERT_FALSE(ec) << ec.message();
+        ASSERT_EQ(read, 4u);
+    });
+    client.write("data"s);
+
+    // Deadline is disarmed on completion, so run() doesn't wait for it.
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_LT(std::chrono::steady_clock::now() - started, 5s);
+}
+
+TEST_P(IoContext, WriteTimeout) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    // Peer doesn't read, so socket buffers fill up.
+    std::vector<uint8_t> buffer(64 * 1024 * 1024);
+    context.async_write(server, make_view(std::as_const(buffer)), 100ms, [&](std::error_code ec, size_t written) {
+        ASSERT_EQ(ec, error::timeout);
+        ASSERT_LT(written, buffer.size());
+    });
+    ASSERT_EQ(context.run(), 1u);
+}
+
+TEST_P(IoContext, ConnectWithTimeout) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client;
+
+    context.async_connect(client, ipv4::loopback, local_port(listener), 10s, [&](std::error_code ec) {
+        ASSERT_FALSE(ec) << ec.message();
+    });
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_TRUE(client.is_open());
+}
+
+TEST_P(IoContext, Timer) {
+    io_context context{GetParam()};
+    int fired = 0;
+    timing_wheel::timer timer{[&] { ++fired; }};
+
+    auto started = std::chrono::steady_clock::now();
+    context.schedule(timer, 30ms);
+    context.run();
+    ASSERT_EQ(fired, 1);
+    ASSERT_GE(std::chrono::steady_clock::now() - started, 30ms);
+}
+
+TEST_P(IoContext, CancelTimer) {
+    io_context context{GetParam()};
+    timing_wheel::timer timer{[] { FAIL(); }};
+
+    auto started = std::chrono::steady_clock::now();
+    context.schedule(timer, 10s);
+    context.post([&] { ASSERT_TRUE(context.cancel_timer(timer)); });
+    ASSERT_EQ(context.run(), 1u);
+    ASSERT_FALSE(context.cancel_timer(timer));
+    ASSERT_LT(std::chrono::steady_clock::now() - started, 5s);
+}
+
+TEST_P(IoContext, IdleReaping) {
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    tcp::socket client = connect_to(listener);
+    tcp::socket server = listener.accept();
+
+    // Connection is closed after 50ms without incoming data.
+    std::vector<uint8_t> buffer(16);
+    size_t received = 0;
+    std::error_code final_ec;
+    timing_wheel::timer idle{[&] { context.cancel(server); }};
+    std::function<void(std::error_code, size_t)> on_read = [&](std::error_code ec, size_t read) {
+        if (ec) {
+            final_ec = ec;
+            return;
+        }
+        received += read;
+        context.schedule(idle, 50ms);
+        context.async_read_some(server, make_view(buffer), on_read);
+    };
+    context.schedule(idle, 50ms);
+    context.async_read_some(server, make_view(buffer), on_read);
+
+    std::thread client_thread([&] {
+        for (int i = 0; i < 5; ++i) {
+            client.write("ping"s);
+            std::this_thread::sleep_for(10ms);
+        }
+    });
+
+    context.run();
+    client_thread.join();
+    ASSERT_EQ(received, 20u);
+    ASSERT_EQ(final_ec, error::operation_aborted);
+}
+
+namespace {
+    struct echo_session : std::enable_shared_from_this<echo_session> {
+        echo_session(io_context& context, tcp::socket socket) : context(context), socket(std::move(socket)) {
+        }
+
+        void read() {
+            auto self = shared_from_this();
+            line.clear();
+            context.async_read_until(socket, '\n', line, [self](std::error_code ec, size_t) {
+                if (ec) return;
+                self->line.push_back('\n');
+                self->write();
+            });
+        }
+
+        void write() {
+            auto self = shared_from_this();
+            context.async_write(socket, make_view(std::as_const(line)), [self](std::error_code ec, size_t) {
+                if (!ec) self->read();
+            });
+        }
+
+        io_context& context;
+        tcp::socket socket;
+        std::string line;
+    };
+} // namespace
+
+TEST_P(IoContext, MultiThreadedEcho) {
+    constexpr unsigned clients_count = 64, messages = 20, threads_count = 4;
+
+    io_context context{GetParam()};
+    tcp::listener listener{ipv4::loopback, 0};
+    std::atomic<unsigned> accepted{0};
+
+    std::function<void(std::error_code, tcp::socket)> on_accept = [&](std::error_code ec, tcp::socket socket) {
+        ASSERT_FALSE(ec) << ec.message();
+        std::make_shared<echo_session>(context, std::move(socket))->read();
+        if (++accepted < clients_count) context.async_accept(listener, on_accept);
+    };
+    context.async_accept(listener, on_accept);
+
+    std::vector<std::thread> clients;
+    std::atomic<unsigned> echoed{0};
+    for (unsigned i = 0; i < clients_count; ++i) {
+        clients.emplace_back([&, i] {
+            tcp::socket client = connect_to(listener);
+            for (unsigned j = 0; j < messages; ++j) {
+                std::string message = std::to_string(i) + ":" + std::to_string(j);
+                client.write(message + "\n");
+                if (client.read_until<std::string>('\n') == message) ++echoed;
+            }
+        });
+    }
+
+    std::vector<std::thread> runners;
+    for (unsigned i = 0; i < threads_count; ++i) {
+        runners.emplace_back([&] { context.run(); });
+    }
+
+    for (auto& client : clients) client.join();
+    for (auto& runner : runners) runner.join();
+    ASSERT_EQ(echoed, clients_count * messages);
+}
+
+TEST_P(IoContext, CompletionsSpreadBetweenThreads) {
+    constexpr unsigned sockets_count = 8, threads_count = 4;
+
+    io_context context{GetParam()};
+    std::vector<udp::socket> receivers;
+    receivers.reserve(sockets_count);
+    std::vector<std::vector<uint8_t>> buffers(sockets_count, std::vector<uint8_t>(16));
+    std::mutex mutex;
+    std::set<std::thread::id> handled_by;
+    for (unsigned i = 0; i < sockets_count; ++i) {
+        receivers.emplace_back(ip::v4);
+        receivers.back().bind(ipv4::loopback, 0);
+        context.async_receive_from(receivers.back(), make_view(buffers[i]),
+                                   [&](std::error_code ec, size_t, std::tuple<address, uint16_t>) {
+                                       ASSERT_FALSE(ec) << ec.message();
+                                       {
+                                           std::lock_guard lock(mutex);
+                                           handled_by.insert(std::this_thread::get_id());
+                                       }
+                                       // Slow handler, other threads should take the rest.
+                                       std::this_thread::sleep_for(20ms);
+                                   });
+    }
+
+    // Keep every thread busy while datagrams arrive, so first thread
+    // which gets back to waiting collects all of them at once.
+    std::atomic<unsigned> blocked{0};
+    std::atomic<bool> release{false};
+    for (unsigned i = 0; i < threads_count; ++i) {
+        context.post([&] {
+            ++blocked;
+            while (!release) std::this_thread::sleep_for(1ms);
+        });
+    }
+
+    std::vector<std::thread> runners;
+    for (unsigned i = 0; i < threads_count; ++i) {
+        runners.emplace_back([&] { context.run(); });
+    }
+    while (blocked != threads_count) std::this_thread::sleep_for(1ms);
+
+    udp::socket sender(ip::v4);
+    for (auto& receiver : receivers) sender.write("ping"s, receiver.implementation().local_endpoint());
+    std::this_thread::sleep_for(50ms);
+    release = true;
+
+    for (auto& runner : runners) runner.join();
+    ASSERT_GT(handled_by.size(), 1u);
+}
+
+#endif // ifdef __linux__
@@ -21,6 +21,8 @@
  */
 
 #include "gtest.hpp"
+#include <string>
+#include <vector>
 #include <libwire/memory_view.hpp>
 
 TEST(MemoryView, NullState) {
@@ -105,3 +107,29 @@ TEST(MemoryView, Resize) {
     ASSERT_THROW(view.resize(view.capacity() + 5), std::out_of_range);
 #endif
 }
+
+TEST(MemoryView, ConvertToConst) {
+    uint8_t test[15] = "Hello, libwire";
+    libwire::memory_view view(test, 15);
+    view.resize(5);
+
+    libwire::memory_view<const uint8_t> const_view = view;
+    ASSERT_EQ(const_view.data(), test);
+    ASSERT_EQ(const_view.size(), 5);
+    ASSERT_EQ(const_view.capacity(), 15);
+}
+
+TEST(MemoryView, MakeView) {
+    std::string str = "Hello, libwire";
+    const std::vector<uint8_t> vec(15, 0xFF);
+
+    auto str_view = libwire::make_view(str);
+    static_assert(std::is_same_v<decltype(str_view), libwire::memory_view<uint8_t>>);
+    ASSERT_EQ(str_view.data(), reinterpret_cast<uint8_t*>(str.data()));
+    ASSERT_EQ(str_view.size(), str.size());
+
+    auto vec_view = libwire::make_view(vec);
+    static_assert(std::is_same_v<decltype(vec_view), libwire::memory_view<const uint8_t>>);
+    ASSERT_EQ(vec_view.data(), vec.data());
+    ASSERT_EQ(vec_view.size(), vec.size());
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "gtest.hpp"
+#include <libwire/network_prefix.hpp>
+
+using namespace libwire;
+
+TEST(NetworkPrefix, Parse) {
+    network_prefix ipv4("10.0.0.0/8");
+    ASSERT_EQ(ipv4.base, address(10, 0, 0, 0));
+    ASSERT_EQ(ipv4.length, 8);
+
+    network_prefix ipv6("2001:db8::/32");
+    ASSERT_EQ(ipv6.base, "2001:db8::"_ipv6);
+    ASSERT_EQ(ipv6.length, 32);
+
+    ASSERT_EQ(network_prefix("0.0.0.0/0"), network_prefix(ipv4::any, 0));
+    ASSERT_EQ(network_prefix("::1/128"), network_prefix(ipv6::loopback, 128));
+
+    for (const char* invalid : {"", "/8", "10.0.0.0", "10.0.0.0/", "10.0.0.0/33", "10.0.0.0/08", "10.0.0/8",
+                                "::/129", "10.0.0.0/-1", "10.0.0.0/8/8", "10.0.0.0/1000"}) {
+        bool success = true;
+        network_prefix prefix(invalid, success);
+        ASSERT_FALSE(success) << invalid;
+        ASSERT_THROW(network_prefix{invalid}, std::invalid_argument) << invalid;
+    }
+}
+
+TEST(NetworkPrefix, HostBitsCleared) {
+    ASSERT_EQ(network_prefix("10.1.2.3/8").base, address(10, 0, 0, 0));
+    ASSERT_EQ(network_prefix("192.168.255.255/17").base, address(192, 168, 128, 0));
+    ASSERT_EQ(network_prefix("2001:db8:ffff::1/36").base, "2001:db8:f000::"_ipv6);
+    ASSERT_EQ(network_prefix(ipv4::broadcast, 0).base, ipv4::any);
+
+    // Length is clamped.
+    ASSERT_EQ(network_prefix(ipv4::loopback, 64).length, 32);
+}
+
+TEST(NetworkPrefix, Contains) {
+    constexpr network_prefix prefix = "172.16.0.0/12"_net;
+    static_assert(prefix.contains("172.31.255.255"_ipv4));
+    static_assert(!prefix.contains("172.32.0.0"_ipv4));
+    static_assert(!prefix.contains("::ffff:172.16.0.1"_ipv6));
+
+    constexpr network_prefix ipv6 = "fe80::/10"_net;
+    static_assert(ipv6.contains("febf::1"_ipv6));
+    static_assert(!ipv6.contains("fec0::1"_ipv6));
+
+    ASSERT_TRUE(network_prefix(ipv4::any, 0).contains(ipv4::broadcast));
+    ASSERT_FALSE(network_prefix(ipv4::any, 0).contains(ipv6::any));
+}
+
+TEST(NetworkPrefix, ToString) {
+    ASSERT_EQ("10.0.0.0/8"_net.to_string(), "10.0.0.0/8");
+    ASSERT_EQ("2001:db8::/32"_net.to_string(), "2001:db8::/32");
+
+    char buffer[network_prefix::max_text_size];
+    auto [end, ec] = "::/0"_net.to_chars(buffer, buffer + sizeof(buffer));
+    ASSERT_EQ(ec, std::errc{});
+    ASSERT_EQ(std::string_view(buffer, size_t(end - buffer)), "::/0");
+    ASSERT_EQ("::/0"_net.to_chars(buffer, buffer + 3).ec, std::errc::value_too_large);
+}
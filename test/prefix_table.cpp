@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include "gtest.hpp"
+#include <libwire/prefix_table.hpp>
+
+using namespace libwire;
+
+using entry_list = std::vector<std::pair<network_prefix, uint32_t>>;
+
+static uint32_t reference_lookup(const entry_list& entries, const address& addr) {
+    uint32_t result = prefix_table::no_match;
+    int best_length = -1;
+    for (const auto& [prefix, value] : entries) {
+        if (prefix.contains(addr) && int(prefix.length) >= best_length) {
+            best_length = prefix.length;
+            result = value;
+        }
+    }
+    return result;
+}
+
+static address random_address(std::mt19937& random, ip version) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    address result{0, 0, 0, 0};
+    result.version = version;
+    for (size_t i = 0; i < (version == ip::v4 ? 4u : 16u); ++i) result.parts[i] = uint8_t(byte(random));
+    return result;
+}
+
+// Addresses near prefix: base itself, base with some host bits set and
+// base with one bit of prefix flipped.
+static std::vector<address> probes(std::mt19937& random, const network_prefix& prefix) {
+    address inside = random_address(random, prefix.base.version);
+    for (size_t i = 0; i < inside.parts.size(); ++i) {
+        unsigned keep = prefix.length >= (i + 1) * 8 ? 8 : prefix.length <= i * 8 ? 0 : prefix.length - i * 8;
+        auto mask = uint8_t(0xff00 >> keep);
+        inside.parts[i] = uint8_t((prefix.base.parts[i] & mask) | (inside.parts[i] & ~mask));
+    }
+    address outside = prefix.base;
+    if (prefix.length != 0) {
+        unsigned bit = prefix.length - 1;
+        outside.parts[bit / 8] ^= uint8_t(0x80 >> (bit % 8));
+    }
+    return {prefix.base, inside, outside};
+}
+
+static entry_list random_entries(std::mt19937& random, size_t count, ip version, unsigned min_length) {
+    unsigned max_length = version == ip::v4 ? 32 : 128;
+    std::uniform_int_distribution<unsigned> length(min_length, max_length), value(0, 1000);
+    entry_list entries;
+    for (size_t i = 0; i < count; ++i) {
+        // Nest part of prefixes into previous ones.
+        address base = random_address(random, version);
+        if (!entries.empty() && i % 3 == 0) base = probes(random, entries.back().first)[1];
+        entries.emplace_back(network_prefix(base, uint8_t(length(random))), value(random));
+    }
+    return entries;
+}
+
+static void check_table(std::mt19937& random, const prefix_table& table, const entry_list& entries) {
+    for (const auto& [prefix, value] : entries) {
+        for (const address& probe : probes(random, prefix)) {
+            ASSERT_EQ(table.lookup(probe), reference_lookup(entries, probe)) << prefix.to_string() << " "
+                                                                             << probe.to_string();
+        }
+    }
+    for (int i = 0; i < 1000; ++i) {
+        address probe = random_address(random, i % 2 == 0 ? ip::v4 : ip::v6);
+        ASSERT_EQ(table.lookup(probe), reference_lookup(entries, probe)) << probe.to_string();
+    }
+}
+
+TEST(PrefixTable, Empty) {
+    prefix_table table;
+    ASSERT_EQ(table.size(), 0u);
+    ASSERT_EQ(table.lookup(ipv4::loopback), prefix_table::no_match);
+    ASSERT_EQ(table.lookup(ipv6::loopback), prefix_table::no_match);
+}
+
+TEST(PrefixTable, LongestMatch) {
+    enum : uint32_t { allow, deny, special };
+    prefix_table table;
+    table.assign({{"10.0.0.0/8"_net, allow},
+                  {"10.66.0.0/16"_net, deny},
+                  {"10.66.1.128/25"_net, special},
+                  {"2001:db8::/32"_net, deny},
+                  {"2001:db8:1::/48"_net, allow}});
+    ASSERT_EQ(table.size(), 5u);
+
+    ASSERT_EQ(table.lookup("10.1.1.1"_ipv4), allow);
+    ASSERT_EQ(table.lookup("10.66.1.1"_ipv4), deny);
+    ASSERT_EQ(table.lookup("10.66.1.200"_ipv4), special);
+    ASSERT_EQ(table.lookup("11.0.0.0"_ipv4), prefix_table::no_match);
+    ASSERT_EQ(table.lookup("2001:db8::1"_ipv6), deny);
+    ASSERT_EQ(table.lookup("2001:db8:1:ffff::1"_ipv6), allow);
+    ASSERT_EQ(table.lookup("2001:db9::"_ipv6), prefix_table::no_match);
+    // Families are separate.
+    ASSERT_EQ(table.lookup("::ffff:10.1.1.1"_ipv6), prefix_table::no_match);
+}
+
+TEST(PrefixTable, DefaultRouteAndHosts) {
+    prefix_table table;
+    table.insert("0.0.0.0/0"_net, 1);
+    table.insert("::/0"_net, 2);
+    table.insert("1.2.3.4/32"_net, 3);
+    table.insert("::1/128"_net, 4);
+
+    ASSERT_EQ(table.lookup(ipv4::broadcast), 1u);
+    ASSERT_EQ(table.lookup("1.2.3.4"_ipv4), 3u);
+    ASSERT_EQ(table.lookup("1.2.3.5"_ipv4), 1u);
+    ASSERT_EQ(table.lookup(ipv6::loopback), 4u);
+    ASSERT_EQ(table.lookup("::2"_ipv6), 2u);
+}
+
+TEST(PrefixTable, RandomIPv4) {
+    std::mt19937 random(42);
+    for (unsigned min_length : {0u, 8u, 16u, 20u}) {
+        entry_list entries = random_entries(random, 500, ip::v4, min_length);
+        prefix_table table;
+        table.assign(entries);
+        check_table(random, table, entries);
+    }
+}
+
+TEST(PrefixTable, RandomIPv6) {
+    std::mt19937 random(42);
+    for (unsigned min_length : {0u, 16u, 48u, 100u}) {
+        entry_list entries = random_entries(random, 500, ip::v6, min_length);
+        prefix_table table;
+        table.assign(entries);
+        check_table(random, table, entries);
+    }
+}
+
+TEST(PrefixTable, Updates) {
+    std::mt19937 random(7);
+    entry_list entries = random_entries(random, 100, ip::v4, 4);
+    entry_list ipv6 = random_entries(random, 100, ip::v6, 8);
+    entries.insert(entries.end(), ipv6.begin(), ipv6.end());
+
+    prefix_table table;
+    for (const auto& [prefix, value] : entries) table.insert(prefix, value);
+    check_table(random, table, entries);
+
+    // Replace values and erase half of prefixes.
+    entry_list remaining;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i % 2 == 0) {
+            table.erase(entries[i].first);
+        } else {
+            table.insert(entries[i].first, uint32_t(i));
+            remaining.emplace_back(entries[i].first, uint32_t(i));
+        }
+    }
+    // Duplicates may have been erased by earlier iteration.
+    entry_list expected;
+    for (const auto& entry : remaining) {
+        bool erased = false;
+        for (size_t i = 0; i < entries.size(); i += 2) erased |= entries[i].first == entry.first;
+        if (!erased) expected.push_back(entry);
+    }
+    table.assign(expected);
+    check_table(random, table, expected);
+
+    ASSERT_FALSE(table.erase("203.0.113.0/24"_net));
+    table.clear();
+    ASSERT_EQ(table.size(), 0u);
+    ASSERT_EQ(table.lookup(expected[0].first.base), prefix_table::no_match);
+}
+
+TEST(PrefixTable, AssignKeepsLastDuplicate) {
+    prefix_table table;
+    table.assign({{"10.0.0.0/8"_net, 1}, {"10.1.0.0/8"_net, 2}, {"10.0.0.0/8"_net, 3}});
+    ASSERT_EQ(table.size(), 1u);
+    ASSERT_EQ(table.lookup("10.5.5.5"_ipv4), 3u);
+}
+
+TEST(PrefixTable, ConcurrentLookups) {
+    prefix_table table;
+    entry_list first = {{"10.0.0.0/8"_net, 1}, {"10.1.0.0/16"_net, 1}, {"::/0"_net, 1}};
+    entry_list second = {{"10.0.0.0/8"_net, 2}, {"10.1.2.0/24"_net, 2}, {"::/0"_net, 2}};
+    table.assign(first);
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> invalid{0}, lookups{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                uint32_t value = table.lookup("10.1.2.3"_ipv4);
+                uint32_t value6 = table.lookup(ipv6::loopback);
+                if ((value != 1 && value != 2) || (value6 != 1 && value6 != 2)) ++invalid;
+                ++lookups;
+            }
+        });
+    }
+
+    for (int i = 0; i < 50; ++i) table.assign(i % 2 == 0 ? second : first);
+    stop = true;
+    for (auto& reader : readers) reader.join();
+    ASSERT_EQ(invalid.load(), 0u);
+}
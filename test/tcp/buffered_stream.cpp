@@ -0,0 +1,177 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <thread>
+#include <chrono>
+#include "../gtest.hpp"
+#include <libwire/tcp/buffered_stream.hpp>
+#include <libwire/tcp/listener.hpp>
+#include <libwire/tcp/options.hpp>
+#include <libwire/options.hpp>
+
+using namespace std::literals::chrono_literals;
+using namespace std::literals::string_literals;
+
+static uint16_t port_to_use = 7778;
+
+using namespace libwire;
+
+struct TcpBufferedStream : testing::Test {
+    void SetUp() override {
+        listener.listen(ipv4::loopback, port_to_use);
+
+        std::thread connect_thr([&]() {
+            std::this_thread::sleep_for(100ms);
+            client.connect(ipv4::loopback, port_to_use);
+        });
+
+        stream = tcp::buffered_stream(listener.accept(), 16);
+        if (connect_thr.joinable()) connect_thr.join();
+
+        stream.next_layer().set_option(tcp::linger, true, 0s);
+        client.set_option(tcp::linger, true, 0s);
+
+        stream.next_layer().set_option(libwire::receive_timeout, 10s);
+        client.set_option(libwire::send_timeout, 10s);
+    }
+
+    void TearDown() override {
+        if (client.is_open()) client.shutdown();
+        if (stream.next_layer().is_open()) stream.next_layer().shutdown();
+    }
+
+    tcp::listener listener;
+    tcp::buffered_stream stream;
+    tcp::socket client;
+};
+
+TEST_F(TcpBufferedStream, ReadUntilKeepsTrailingData) {
+    client.write("first\nsecond\nthird"s);
+
+    ASSERT_EQ(stream.read_until<std::string>('\n'), "first");
+    ASSERT_EQ(stream.read_until<std::string>('\n'), "second");
+    ASSERT_EQ(stream.read<std::string>(5), "third");
+    ASSERT_EQ(stream.available(), 0);
+}
+
+TEST_F(TcpBufferedStream, ReadUntilMaxSize) {
+    client.write("0123456789\n"s);
+
+    ASSERT_EQ(stream.read_until<std::string>('\n', 4), "0123");
+    ASSERT_EQ(stream.read_until<std::string>('\n'), "456789");
+}
+
+TEST_F(TcpBufferedStream, ReadUntilLongerThanBuffer) {
+    auto vec = std::vector<uint8_t>(1024, 0x00);
+    vec.push_back(0xFF);
+
+    client.write(vec);
+    vec.pop_back();
+    ASSERT_EQ(stream.read_until(0xFF), vec);
+}
+
+TEST_F(TcpBufferedStream, ReadUntilMultiByteDelimiter) {
+    // Buffer size is 16 so delimiters will be split between buffer refills.
+    client.write("GET / HTTP/1.1\r\nHost: example.com\r\n\r\nbody\r"s);
+
+    ASSERT_EQ(stream.read_until<std::string>("\r\n"), "GET / HTTP/1.1");
+    ASSERT_EQ(stream.read_until<std::string>("\r\n\r\n"), "Host: example.com");
+    ASSERT_EQ(stream.read<std::string>(5), "body\r");
+}
+
+TEST_F(TcpBufferedStream, ReadUntilMultiByteDelimiterMaxSize) {
+    client.write("0123456789\r\n0123\r\n"s);
+
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", 4), "0123");
+    ASSERT_EQ(stream.read_until<std::string>("\r\n"), "456789");
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", 4), "0123");
+    ASSERT_EQ(stream.available(), 0);
+}
+
+TEST_F(TcpBufferedStream, ReadUntilNonBlockingSplitLine) {
+    stream.next_layer().set_option(non_blocking, true);
+    std::error_code ec;
+
+    // Second line is longer than buffer (16 bytes).
+    client.write("hel"s);
+    std::this_thread::sleep_for(50ms);
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", ec), "");
+    ASSERT_EQ(ec, error::try_again);
+
+    client.write("lo\r"s);
+    std::this_thread::sleep_for(50ms);
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", ec), "");
+    ASSERT_EQ(ec, error::try_again);
+
+    client.write("\nsecond line, longer"s);
+    std::this_thread::sleep_for(50ms);
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", ec), "hello");
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", ec), "");
+    ASSERT_EQ(ec, error::try_again);
+
+    client.write(" than buffer\r\n"s);
+    std::this_thread::sleep_for(50ms);
+    ec.clear();
+    ASSERT_EQ(stream.read_until<std::string>("\r\n", ec), "second line, longer than buffer");
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(stream.available(), 0);
+    ASSERT_EQ(stream.buffer_size(), 16);
+}
+
+TEST_F(TcpBufferedStream, PeekDoesntConsume) {
+    client.write("abcdef"s);
+
+    ASSERT_EQ(stream.peek<std::string>(3), "abc");
+    ASSERT_EQ(stream.peek<std::string>(6), "abcdef");
+    ASSERT_EQ(stream.read<std::string>(6), "abcdef");
+}
+
+TEST_F(TcpBufferedStream, ReadBiggerThanBuffer) {
+    std::vector<uint8_t> vec(4096);
+    for (size_t i = 0; i < vec.size(); ++i) vec[i] = uint8_t(i);
+
+    client.write(vec);
+    ASSERT_EQ(stream.peek(2), std::vector<uint8_t>({0, 1}));
+    ASSERT_EQ(stream.read(vec.size()), vec);
+}
+
+TEST_F(TcpBufferedStream, ReadUntilEndOfFile) {
+    std::error_code ec;
+
+    client.write("abc"s);
+    client.shutdown(false, true);
+
+    auto str = stream.read_until<std::string>('\n', ec);
+    ASSERT_EQ(ec, error::end_of_file);
+    ASSERT_EQ(str, "abc");
+}
+
+TEST_F(TcpBufferedStream, ReadUntilMultiByteDelimiterEndOfFile) {
+    std::error_code ec;
+
+    client.write("abc\r"s);
+    client.shutdown(false, true);
+
+    auto str = stream.read_until<std::string>("\r\n", ec);
+    ASSERT_EQ(ec, error::end_of_file);
+    ASSERT_EQ(str, "abc\r");
+}
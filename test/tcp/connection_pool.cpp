@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <thread>
+#include <vector>
+#include "../gtest.hpp"
+#include <libwire/tcp/connection_pool.hpp>
+#include <libwire/tcp/listener.hpp>
+
+using namespace libwire;
+using namespace std::literals::chrono_literals;
+
+struct ConnectionPool : testing::Test {
+    uint16_t port() const {
+        return std::get<1>(listener.implementation().local_endpoint());
+    }
+
+    // Kernel completes handshake for queued connections, so most tests
+    // don't need to accept them.
+    tcp::listener listener{ipv4::loopback, 0};
+};
+
+TEST_F(ConnectionPool, Reuse) {
+    tcp::connection_pool pool;
+    uint16_t local_port;
+    {
+        auto connection = pool.checkout(ipv4::loopback, port());
+        ASSERT_TRUE(connection);
+        ASSERT_TRUE(connection->is_open());
+        local_port = std::get<1>(connection->local_endpoint());
+    }
+    ASSERT_EQ(pool.idle_count(ipv4::loopback, port()), 1u);
+
+    auto connection = pool.checkout(ipv4::loopback, port());
+    ASSERT_EQ(std::get<1>(connection->local_endpoint()), local_port);
+    ASSERT_EQ(pool.idle_count(ipv4::loopback, port()), 0u);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 1u);
+}
+
+TEST_F(ConnectionPool, MaxIdle) {
+    tcp::connection_pool::limits limits;
+    limits.max_idle = 1;
+    tcp::connection_pool pool{limits};
+
+    auto first = pool.checkout(ipv4::loopback, port());
+    auto second = pool.checkout(ipv4::loopback, port());
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 2u);
+
+    first.release();
+    second.release();
+    ASSERT_FALSE(first);
+    ASSERT_EQ(pool.idle_count(ipv4::loopback, port()), 1u);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 1u);
+}
+
+TEST_F(ConnectionPool, MaxTotal) {
+    tcp::connection_pool::limits limits;
+    limits.max_total = 1;
+    tcp::connection_pool pool{limits};
+
+    auto first = pool.checkout(ipv4::loopback, port());
+    std::error_code ec;
+    auto second = pool.checkout(ipv4::loopback, port(), ec);
+    ASSERT_EQ(ec, error::try_again);
+    ASSERT_FALSE(second);
+
+    first.discard();
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 0u);
+    ASSERT_TRUE(pool.checkout(ipv4::loopback, port()));
+}
+
+TEST_F(ConnectionPool, PeerClosed) {
+    tcp::connection_pool pool;
+    uint16_t local_port;
+    {
+        auto connection = pool.checkout(ipv4::loopback, port());
+        local_port = std::get<1>(connection->local_endpoint());
+        tcp::socket server = listener.accept();
+        // Closed by server while connection is idle.
+    }
+    std::this_thread::sleep_for(10ms);
+
+    auto connection = pool.checkout(ipv4::loopback, port());
+    ASSERT_NE(std::get<1>(connection->local_endpoint()), local_port);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 1u);
+}
+
+TEST_F(ConnectionPool, IdleTimeout) {
+    tcp::connection_pool::limits limits;
+    limits.idle_timeout = 20ms;
+    tcp::connection_pool pool{limits};
+
+    pool.checkout(ipv4::loopback, port());
+    ASSERT_EQ(pool.reap_idle(), 0u);
+    std::this_thread::sleep_for(40ms);
+    ASSERT_EQ(pool.reap_idle(), 1u);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), 0u);
+}
+
+TEST_F(ConnectionPool, ReapKeepsMostRecentFirst) {
+    tcp::connection_pool::limits limits;
+    limits.idle_timeout = 100ms;
+    tcp::connection_pool pool{limits};
+
+    std::vector<tcp::connection_pool::connection> connections;
+    std::vector<uint16_t> ports;
+    for (int i = 0; i < 5; ++i) {
+        connections.push_back(pool.checkout(ipv4::loopback, port()));
+        ports.push_back(std::get<1>(connections.back()->local_endpoint()));
+    }
+
+    // First two expire, rest are returned later in order.
+    connections[0].release();
+    connections[1].release();
+    std::this_thread::sleep_for(150ms);
+    for (size_t i = 2; i < connections.size(); ++i) connections[i].release();
+
+    ASSERT_EQ(pool.reap_idle(), 2u);
+    for (size_t i = connections.size(); i-- > 2;) {
+        connections[i] = pool.checkout(ipv4::loopback, port());
+        ASSERT_EQ(std::get<1>(connections[i]->local_endpoint()), ports[i]);
+    }
+}
+
+TEST_F(ConnectionPool, Prewarm) {
+    tcp::connection_pool::limits limits;
+    limits.max_idle = 3;
+    tcp::connection_pool pool{limits};
+
+    std::error_code ec;
+    ASSERT_EQ(pool.prewarm(ipv4::loopback, port(), 5, ec), 3u);
+    ASSERT_FALSE(ec) << ec.message();
+    ASSERT_EQ(pool.idle_count(ipv4::loopback, port()), 3u);
+}
+
+TEST_F(ConnectionPool, ConnectError) {
+    uint16_t closed_port;
+    {
+        tcp::listener temporary{ipv4::loopback, 0};
+        closed_port = std::get<1>(temporary.implementation().local_endpoint());
+    }
+
+    tcp::connection_pool pool;
+    std::error_code ec;
+    ASSERT_FALSE(pool.checkout(ipv4::loopback, closed_port, ec));
+    ASSERT_EQ(ec, error::connection_refused);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, closed_port), 0u);
+}
+
+TEST_F(ConnectionPool, Concurrent) {
+    constexpr unsigned threads_count = 8, iterations = 2000;
+    tcp::connection_pool pool;
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threads_count; ++i) {
+        threads.emplace_back([&] {
+            for (unsigned j = 0; j < iterations; ++j) {
+                auto connection = pool.checkout(ipv4::loopback, port());
+                ASSERT_TRUE(connection->is_open());
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_LE(pool.open_count(ipv4::loopback, port()), threads_count);
+    ASSERT_EQ(pool.open_count(ipv4::loopback, port()), pool.idle_count(ipv4::loopback, port()));
+}
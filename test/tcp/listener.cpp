@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../gtest.hpp"
+#include <libwire/options.hpp>
+#include <libwire/tcp/listener.hpp>
+#include <libwire/tcp/options.hpp>
+
+using namespace libwire;
+using namespace std::literals::chrono_literals;
+
+static uint16_t port_of(const tcp::listener& listener) {
+    return std::get<1>(listener.implementation().local_endpoint());
+}
+
+static std::vector<tcp::socket> connect_many(const tcp::listener& listener, size_t count) {
+    std::vector<tcp::socket> clients(count);
+    for (auto& client : clients) {
+        client.connect(ipv4::loopback, port_of(listener));
+        client.set_option(tcp::linger, true, 0s);
+    }
+    return clients;
+}
+
+TEST(TcpListener, AcceptManyDrainsQueue) {
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> clients = connect_many(listener, 5);
+
+    std::vector<tcp::socket> accepted;
+    std::error_code ec;
+    ASSERT_EQ(listener.accept_many(16, accepted, ec), 5u);
+    ASSERT_FALSE(ec) << ec.message();
+    ASSERT_EQ(accepted.size(), 5u);
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        ASSERT_TRUE(accepted[i].is_open());
+        ASSERT_EQ(accepted[i].remote_endpoint(), clients[i].local_endpoint());
+    }
+}
+
+TEST(TcpListener, AcceptManyRespectsMax) {
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> clients = connect_many(listener, 5);
+
+    std::vector<tcp::socket> accepted;
+    ASSERT_EQ(listener.accept_many(3, accepted), 3u);
+    ASSERT_EQ(listener.accept_many(3, accepted), 2u);
+    ASSERT_EQ(accepted.size(), 5u);
+    ASSERT_EQ(listener.accept_many(0, accepted), 0u);
+}
+
+TEST(TcpListener, AcceptManyNonBlocking) {
+    tcp::listener listener{ipv4::loopback, 0};
+    listener.set_option(non_blocking, true);
+
+    std::vector<tcp::socket> accepted;
+    std::error_code ec;
+    ASSERT_EQ(listener.accept_many(16, accepted, ec), 0u);
+    ASSERT_EQ(ec, error::try_again);
+    ASSERT_TRUE(accepted.empty());
+
+    std::vector<tcp::socket> clients = connect_many(listener, 2);
+    ec.clear();
+    ASSERT_EQ(listener.accept_many(16, accepted, ec, /* non_blocking = */ true), 2u);
+    ASSERT_FALSE(ec) << ec.message();
+    for (auto& socket : accepted) ASSERT_TRUE(socket.option(non_blocking));
+}
+
+TEST(TcpListener, AcceptWaitsAfterAcceptMany) {
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> clients = connect_many(listener, 1);
+
+    std::vector<tcp::socket> accepted;
+    ASSERT_EQ(listener.accept_many(16, accepted), 1u);
+    ASSERT_FALSE(listener.option(non_blocking));
+
+    // Listener is non-blocking only internally, so both calls below
+    // should wait for connection instead of reporting try_again.
+    tcp::socket late_client;
+    std::thread connect_thread([&] {
+        std::this_thread::sleep_for(50ms);
+        late_client.connect(ipv4::loopback, port_of(listener));
+        late_client.set_option(tcp::linger, true, 0s);
+    });
+    tcp::socket server = listener.accept();
+    connect_thread.join();
+    ASSERT_EQ(server.remote_endpoint(), late_client.local_endpoint());
+
+    connect_thread = std::thread([&] {
+        std::this_thread::sleep_for(50ms);
+        clients = connect_many(listener, 1);
+    });
+    ASSERT_EQ(listener.accept_many(16, accepted), 1u);
+    connect_thread.join();
+}
+
+TEST(TcpListener, DualStack) {
+    tcp::listener listener{dual_stack, 0};
+    ASSERT_FALSE(listener.option(libwire::ipv6_only));
+    uint16_t port = port_of(listener);
+
+    tcp::socket client4, client6;
+    client4.connect(ipv4::loopback, port);
+    client6.connect(ipv6::loopback, port);
+
+    tcp::socket server4 = listener.accept();
+    ASSERT_EQ(server4.remote_endpoint(), client4.local_endpoint());
+    ASSERT_EQ(std::get<0>(server4.remote_endpoint()).version, ip::v4);
+    ASSERT_EQ(server4.local_endpoint(), std::tuple(ipv4::loopback, port));
+
+    tcp::socket server6 = listener.accept();
+    ASSERT_EQ(server6.remote_endpoint(), client6.local_endpoint());
+    ASSERT_EQ(std::get<0>(server6.remote_endpoint()).version, ip::v6);
+}
+
+TEST(TcpListener, PeerFilter) {
+    tcp::listener listener{ipv4::loopback, 0};
+    std::vector<tcp::socket> clients = connect_many(listener, 4);
+
+    // Reject every other client.
+    auto rejected_port = std::get<1>(clients[0].local_endpoint());
+    auto rejected_port2 = std::get<1>(clients[2].local_endpoint());
+    size_t calls = 0;
+    listener.set_peer_filter([&](const endpoint& peer) {
+        ++calls;
+        EXPECT_EQ(peer.address(), ipv4::loopback);
+        return peer.port() != rejected_port && peer.port() != rejected_port2;
+    });
+    ASSERT_NE(listener.filter(), nullptr);
+
+    tcp::socket first = listener.accept();
+    ASSERT_EQ(first.remote_endpoint(), clients[1].local_endpoint());
+
+    std::vector<tcp::socket> accepted;
+    ASSERT_EQ(listener.accept_many(16, accepted), 1u);
+    ASSERT_EQ(accepted[0].remote_endpoint(), clients[3].local_endpoint());
+    ASSERT_EQ(calls, 4u);
+
+    // Rejected connections are closed.
+    std::error_code ec;
+    clients[0].set_option(receive_timeout, 10s);
+    clients[0].read<std::vector<uint8_t>>(1, ec);
+    ASSERT_TRUE(ec);
+
+    listener.set_peer_filter({});
+    ASSERT_EQ(listener.filter(), nullptr);
+}
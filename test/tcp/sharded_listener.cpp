@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+
+#include <thread>
+#include <vector>
+#include "../gtest.hpp"
+#include <libwire/options.hpp>
+#include <libwire/tcp/sharded_listener.hpp>
+
+using namespace libwire;
+
+// Accepts all queued connections from every shard.
+static std::vector<size_t> drain(tcp::sharded_listener& listener) {
+    std::vector<size_t> accepted(listener.size());
+    for (size_t i = 0; i < listener.size(); ++i) {
+        listener.shard(i).set_option(non_blocking, true);
+        std::error_code ec;
+        while (listener.shard(i).accept(ec).is_open()) ++accepted[i];
+        EXPECT_EQ(ec, error::try_again);
+    }
+    return accepted;
+}
+
+TEST(ShardedListener, SharedPort) {
+    tcp::sharded_listener listener{ipv4::loopback, 0, 4};
+    ASSERT_EQ(listener.size(), 4u);
+    ASSERT_NE(listener.port(), 0);
+    for (size_t i = 0; i < listener.size(); ++i) {
+        ASSERT_EQ(std::get<1>(listener.shard(i).implementation().local_endpoint()), listener.port());
+    }
+}
+
+TEST(ShardedListener, Distribution) {
+    constexpr size_t clients_count = 64;
+    tcp::sharded_listener listener{ipv4::loopback, 0, 4};
+
+    std::vector<tcp::socket> clients(clients_count);
+    for (auto& client : clients) client.connect(ipv4::loopback, listener.port());
+
+    auto accepted = drain(listener);
+    size_t total = 0, used_shards = 0;
+    for (size_t count : accepted) {
+        total += count;
+        if (count != 0) ++used_shards;
+    }
+    ASSERT_EQ(total, clients_count);
+    // Connections are spread by hash of source port, so at least two
+    // shards get something.
+    ASSERT_GE(used_shards, 2u);
+}
+
+TEST(ShardedListener, SteerByCpu) {
+    tcp::sharded_listener listener{ipv4::loopback, 0, 2};
+    listener.steer_by_cpu();
+
+    // Loopback SYN is processed by sender CPU, so connections initiated
+    // from thread pinned to CPUs of one shard are all queued there.
+    std::thread client_thread([&] {
+        size_t expected_shard = 1;
+        std::error_code ec;
+        listener.pin_current_thread(expected_shard, ec);
+        if (ec) {
+            // Single CPU machine.
+            expected_shard = 0;
+            listener.pin_current_thread(expected_shard);
+        }
+
+        std::vector<tcp::socket> clients(8);
+        for (auto& client : clients) client.connect(ipv4::loopback, listener.port());
+        auto accepted = drain(listener);
+        EXPECT_EQ(accepted[expected_shard], clients.size());
+    });
+    client_thread.join();
+}
+
+TEST(ShardedListener, InvalidArguments) {
+    tcp::sharded_listener listener;
+    std::error_code ec;
+    listener.listen(ipv4::loopback, 0, 0, ec);
+    ASSERT_EQ(ec, error::invalid_argument);
+    ASSERT_EQ(listener.size(), 0u);
+
+    ec.clear();
+    listener.steer_by_cpu(ec);
+    ASSERT_TRUE(ec);
+}
+
+#endif // ifdef __linux__
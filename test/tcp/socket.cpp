@@ -20,8 +20,13 @@
  * SOFTWARE.
  */
 
+#include <array>
 #include <thread>
 #include <chrono>
+#include <cstdio>
+#ifndef _WIN32
+#    include <unistd.h>
+#endif
 #include "../gtest.hpp"
 #include <libwire/tcp/socket.hpp>
 #include <libwire/tcp/listener.hpp>
@@ -84,6 +89,16 @@ TEST_P(TcpSocketPair, EndpointsConsistency) {
     ASSERT_EQ(server.remote_endpoint(), client.local_endpoint());
 }
 
+TEST_P(TcpSocketPair, AcceptCachesPeerEndpoint) {
+    ASSERT_TRUE(server.implementation().peer);
+    ASSERT_EQ(*server.implementation().peer, client.local_endpoint());
+    ASSERT_TRUE(client.implementation().peer);
+    ASSERT_EQ(*client.implementation().peer, std::tuple(GetParam(), 7777));
+
+    server.close();
+    ASSERT_FALSE(server.implementation().peer);
+}
+
 TEST_P(TcpSocketPair, BasicIntegrityCheck) {
     for (unsigned i = 0; i < 10; ++i) {
         auto vec = std::vector<uint8_t>(1024 * (i + 1), 0x00);
@@ -94,6 +109,23 @@ TEST_P(TcpSocketPair, BasicIntegrityCheck) {
     }
 }
 
+TEST_P(TcpSocketPair, ByteBufferIntegrityCheck) {
+    byte_buffer input;
+    for (unsigned i = 0; i < 10; ++i) {
+        byte_buffer output(1024 * (i + 1), uint8_t(i));
+
+        client.write(output);
+        server.read(output.size(), input);
+        ASSERT_EQ(input, output);
+
+        client.write(output);
+        server.read_some(output.size(), input);
+        ASSERT_EQ(std::vector<uint8_t>(input.begin(), input.end()),
+                  std::vector<uint8_t>(output.begin(), output.begin() + input.size()));
+        server.read(output.size() - input.size(), input);
+    }
+}
+
 TEST_P(TcpSocketPair, ReadUntilIntegrityCheck) {
     for (unsigned i = 0; i < 10; ++i) {
         auto vec = std::vector<uint8_t>(1024 * (i + 1), 0x00);
@@ -105,6 +137,213 @@ TEST_P(TcpSocketPair, ReadUntilIntegrityCheck) {
     }
 }
 
+TEST_P(TcpSocketPair, VectoredIntegrityCheck) {
+    std::string header = "header:";
+    auto body = std::vector<uint8_t>(1024, 0xAA);
+
+    ASSERT_EQ(client.write({make_view(header), memory_view<const uint8_t>(), make_view(body)}),
+              header.size() + body.size());
+
+    std::string header2(header.size(), '\0');
+    auto body2 = std::vector<uint8_t>(body.size(), 0x00);
+    ASSERT_EQ(server.read({make_view(header2), make_view(body2)}), header.size() + body.size());
+    ASSERT_EQ(header, header2);
+    ASSERT_EQ(body, body2);
+}
+
+TEST_P(TcpSocketPair, LargeVectoredWrite) {
+    // Bigger than socket buffers so sendmsg is guaranteed to return short
+    // write in the middle of some buffer.
+    std::vector<std::vector<uint8_t>> chunks;
+    std::vector<memory_view<const uint8_t>> views;
+    size_t total = 0;
+    for (unsigned i = 0; i < 64; ++i) {
+        chunks.emplace_back(64 * 1024 + i * 3, uint8_t(i));
+        total += chunks.back().size();
+    }
+    for (const auto& chunk : chunks) views.push_back(make_view(chunk));
+
+    std::thread writer([&]() { ASSERT_EQ(client.write(views), total); });
+
+    auto received = server.read(total);
+    if (writer.joinable()) writer.join();
+
+    ASSERT_EQ(received.size(), total);
+    size_t offset = 0;
+    for (const auto& chunk : chunks) {
+        ASSERT_TRUE(std::equal(chunk.begin(), chunk.end(), received.begin() + offset));
+        offset += chunk.size();
+    }
+}
+
+TEST_P(TcpSocketPair, VectoredManyBuffers) {
+    // More views than fit into one sendmsg/recvmsg call, with empty ones
+    // in between.
+    constexpr size_t count = 3000;
+    std::vector<std::array<uint8_t, 3>> chunks(count);
+    std::vector<memory_view<const uint8_t>> views;
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].fill(uint8_t(i));
+        views.push_back(make_view(chunks[i]));
+        if (i % 7 == 0) views.emplace_back();
+    }
+    ASSERT_EQ(client.write(views), count * 3);
+
+    std::vector<std::array<uint8_t, 2>> halves(count * 3 / 2);
+    std::vector<memory_view<uint8_t>> targets;
+    for (auto& half : halves) targets.push_back(make_view(half));
+    ASSERT_EQ(server.read(targets), count * 3);
+
+    for (size_t i = 0; i < count * 3; ++i) ASSERT_EQ(halves[i / 2][i % 2], uint8_t(i / 3));
+}
+
+TEST_P(TcpSocketPair, VectoredReadEof) {
+    std::string data = "abc";
+    client.write(data);
+    client.shutdown(false, true);
+
+    std::string first(2, '\0'), second(5, '\0');
+    std::error_code ec;
+    ASSERT_EQ(server.read({make_view(first), make_view(second)}, ec), 3);
+    ASSERT_EQ(ec, error::generic::disconnected);
+    ASSERT_EQ(first, "ab");
+    ASSERT_EQ(second[0], 'c');
+}
+
+TEST_P(TcpSocketPair, ZeroCopyWrite) {
+    auto data = std::vector<uint8_t>(zero_copy_threshold * 4, 0xAB);
+    std::optional<uint32_t> id;
+
+    // Without option zero-copy write is usual write.
+    ASSERT_EQ(client.write_zero_copy(make_view(data), id), data.size());
+    ASSERT_FALSE(id);
+    ASSERT_EQ(server.read(data.size()), data);
+
+    client.set_option(zero_copy, true);
+    if (!client.option(zero_copy)) return; // Not supported by OS.
+
+    // Too small to bother.
+    ASSERT_EQ(client.write_zero_copy(memory_view<const uint8_t>(data.data(), 100), id), 100);
+    ASSERT_FALSE(id);
+    ASSERT_EQ(server.read(100).size(), 100);
+
+    ASSERT_EQ(client.write_zero_copy(make_view(data), id), data.size());
+    ASSERT_EQ(id, 0u);
+    ASSERT_EQ(server.read(data.size()), data);
+
+    bool completed = false, copied = false;
+    for (unsigned i = 0; i < 100 && !completed; ++i) {
+        client.poll_zero_copy_completions([&](const zero_copy_completion& completion) {
+            ASSERT_EQ(completion.first, 0u);
+            ASSERT_EQ(completion.last, 0u);
+            completed = true;
+            copied = completion.copied;
+        });
+        if (!completed) std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_TRUE(completed);
+
+    // Kernel said that it copies data anyway, so don't try again.
+    if (copied) {
+        ASSERT_EQ(client.write_zero_copy(make_view(data), id), data.size());
+        ASSERT_FALSE(id);
+        ASSERT_EQ(server.read(data.size()), data);
+    }
+}
+
+#ifndef _WIN32
+static std::vector<uint8_t> make_pattern(size_t size) {
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; ++i) result[i] = uint8_t(i * 7 + i / 251);
+    return result;
+}
+
+static FILE* make_file(const std::vector<uint8_t>& contents) {
+    FILE* file = std::tmpfile();
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fflush(file);
+    return file;
+}
+
+TEST_P(TcpSocketPair, SendFile) {
+    auto pattern = make_pattern(4 * 1024 * 1024);
+    FILE* file = make_file(pattern);
+
+    std::thread sender([&]() {
+        ASSERT_EQ(client.send_file(fileno(file), 1000, pattern.size() - 1000), pattern.size() - 1000);
+    });
+    auto received = server.read(pattern.size() - 1000);
+    if (sender.joinable()) sender.join();
+
+    ASSERT_TRUE(std::equal(pattern.begin() + 1000, pattern.end(), received.begin(), received.end()));
+    std::fclose(file);
+}
+
+TEST_P(TcpSocketPair, SendFilePastEnd) {
+    auto pattern = make_pattern(1000);
+    FILE* file = make_file(pattern);
+
+    ASSERT_EQ(client.send_file(fileno(file), 500, 1000), 500);
+    auto received = server.read(500);
+    ASSERT_TRUE(std::equal(pattern.begin() + 500, pattern.end(), received.begin(), received.end()));
+    std::fclose(file);
+}
+
+TEST_P(TcpSocketPair, NonBlockingSendFileResume) {
+    auto pattern = make_pattern(4 * 1024 * 1024);
+    FILE* file = make_file(pattern);
+    client.set_option(non_blocking, true);
+
+    std::vector<uint8_t> received;
+    std::thread receiver([&]() { received = server.read(pattern.size()); });
+
+    size_t sent = 0;
+    unsigned partial_sends = 0;
+    while (sent < pattern.size()) {
+        std::error_code ec;
+        size_t just_sent = client.send_file(fileno(file), sent, pattern.size() - sent, ec);
+        if (ec == error::try_again) {
+            ASSERT_EQ(just_sent, 0);
+            std::this_thread::sleep_for(1ms);
+            continue;
+        }
+        ASSERT_FALSE(ec) << ec.message();
+        sent += just_sent;
+        ++partial_sends;
+    }
+    if (receiver.joinable()) receiver.join();
+
+    ASSERT_GT(partial_sends, 1u);
+    ASSERT_EQ(pattern, received);
+    std::fclose(file);
+}
+
+TEST_P(TcpSocketPair, ReceiveToFile) {
+    auto pattern = make_pattern(4 * 1024 * 1024);
+    FILE* file = std::tmpfile();
+
+    std::thread sender([&]() { client.write(pattern); });
+    ASSERT_EQ(server.receive_to_file(fileno(file), 10, pattern.size()), pattern.size());
+    if (sender.joinable()) sender.join();
+
+    std::vector<uint8_t> written(pattern.size());
+    ASSERT_EQ(pread(fileno(file), written.data(), written.size(), 10), ssize_t(written.size()));
+    ASSERT_EQ(pattern, written);
+    std::fclose(file);
+}
+
+TEST_P(TcpSocketPair, ReceiveToFileEof) {
+    FILE* file = std::tmpfile();
+    client.write(std::string("abc"));
+    client.shutdown(false, true);
+
+    std::error_code ec;
+    ASSERT_EQ(server.receive_to_file(fileno(file), 0, 10, ec), 3);
+    ASSERT_EQ(ec, error::generic::disconnected);
+    std::fclose(file);
+}
+#endif // ifndef _WIN32
+
 TEST_P(TcpSocketPair, CloseOnReadAfterRemoteClose) {
     auto vec = std::vector<uint8_t>(512, 0x00);
     server.close();
@@ -129,3 +368,23 @@ TEST(TcpSocket, Errors) {
         ASSERT_EQ(ec, error::connection_refused);
     }
 }
+
+TEST(TcpSocket, NonBlockingAccept) {
+    tcp::listener listener;
+    listener.listen(ipv4::loopback, 0);
+    uint16_t port = std::get<1>(listener.implementation().local_endpoint());
+
+    tcp::socket client;
+    client.connect(ipv4::loopback, port);
+
+    tcp::socket server = listener.accept(/* non_blocking = */ true);
+    ASSERT_TRUE(server.option(non_blocking));
+    ASSERT_EQ(server.remote_endpoint(), client.local_endpoint());
+
+    std::error_code ec;
+    std::vector<uint8_t> buffer;
+    server.read_some(1, buffer, ec);
+    ASSERT_EQ(ec, error::try_again);
+
+    client.set_option(tcp::linger, true, 0s);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <random>
+#include <vector>
+#include "gtest.hpp"
+#include <libwire/timing_wheel.hpp>
+
+using namespace libwire;
+using namespace std::literals;
+
+using clock_type = timing_wheel::clock;
+
+TEST(TimingWheel, ExpiresInOrder) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+
+    std::vector<int> order;
+    timing_wheel::timer first{[&] { order.push_back(1); }};
+    timing_wheel::timer second{[&] { order.push_back(2); }};
+    timing_wheel::timer third{[&] { order.push_back(3); }};
+    wheel.schedule(third, start + 5s);
+    wheel.schedule(first, start + 10ms);
+    wheel.schedule(second, start + 100ms);
+    ASSERT_EQ(wheel.size(), 3u);
+
+    ASSERT_EQ(wheel.advance(start + 9ms), 0u);
+    ASSERT_EQ(wheel.advance(start + 10ms), 1u);
+    ASSERT_EQ(wheel.advance(start + 1h), 2u);
+    ASSERT_EQ(order, (std::vector<int>{1, 2, 3}));
+    ASSERT_TRUE(wheel.empty());
+    ASSERT_FALSE(first.armed());
+}
+
+TEST(TimingWheel, CancelAndReschedule) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+
+    int calls = 0;
+    timing_wheel::timer timer{[&] { ++calls; }};
+    wheel.schedule(timer, start + 10ms);
+    ASSERT_TRUE(timer.cancel());
+    ASSERT_FALSE(timer.cancel());
+    ASSERT_EQ(wheel.advance(start + 20ms), 0u);
+
+    wheel.schedule(timer, start + 30ms);
+    wheel.schedule(timer, start + 50ms);
+    ASSERT_EQ(wheel.size(), 1u);
+    wheel.advance(start + 49ms);
+    ASSERT_EQ(calls, 0);
+    wheel.advance(start + 50ms);
+    ASSERT_EQ(calls, 1);
+}
+
+TEST(TimingWheel, DestroyedTimerIsCanceled) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+    {
+        timing_wheel::timer timer{[] { FAIL(); }};
+        wheel.schedule(timer, start + 10ms);
+    }
+    ASSERT_TRUE(wheel.empty());
+    ASSERT_EQ(wheel.advance(start + 1s), 0u);
+}
+
+TEST(TimingWheel, PastExpiry) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+    wheel.advance(start + 100ms);
+
+    bool expired = false;
+    timing_wheel::timer timer{[&] { expired = true; }};
+    wheel.schedule(timer, start);
+    ASSERT_EQ(wheel.next_expiry(), start + 101ms);
+    wheel.advance(start + 101ms);
+    ASSERT_TRUE(expired);
+}
+
+TEST(TimingWheel, RescheduleFromCallback) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+
+    int calls = 0;
+    timing_wheel::timer timer;
+    timer.callback = [&] {
+        if (++calls < 10) wheel.schedule(timer, wheel.now() + 100ms);
+    };
+    wheel.schedule(timer, start + 100ms);
+    wheel.advance(start + 1h);
+    ASSERT_EQ(calls, 10);
+}
+
+TEST(TimingWheel, NextExpiry) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+    ASSERT_FALSE(wheel.next_expiry());
+
+    timing_wheel::timer near, far;
+    wheel.schedule(far, start + 10s);
+    ASSERT_LE(*wheel.next_expiry(), start + 10s);
+    wheel.schedule(near, start + 20ms);
+    ASSERT_EQ(*wheel.next_expiry(), start + 20ms);
+}
+
+TEST(TimingWheel, MatchesReference) {
+    auto start = clock_type::now();
+    timing_wheel wheel{1ms, start};
+    std::mt19937 random(42);
+
+    constexpr size_t count = 5000;
+    std::vector<int64_t> deadlines(count), fired_at(count, -1);
+    std::vector<timing_wheel::timer> timers(count);
+    int64_t now = 0;
+
+    // Mix of near and very far deadlines to exercise all levels.
+    std::uniform_int_distribution<int> exponent(0, 34);
+    for (size_t i = 0; i < count; ++i) {
+        deadlines[i] = int64_t(random() % (uint64_t(1) << exponent(random)));
+        timers[i].callback = [&, i] { fired_at[i] = now; };
+        wheel.schedule(timers[i], start + std::chrono::milliseconds(deadlines[i]));
+    }
+
+    // Cancel some of them.
+    for (size_t i = 0; i < count; i += 7) timers[i].cancel();
+
+    while (!wheel.empty()) {
+        auto next = wheel.next_expiry();
+        ASSERT_TRUE(next);
+        now = std::chrono::duration_cast<std::chrono::milliseconds>(*next - start).count();
+        wheel.advance(*next);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 7 == 0) {
+            ASSERT_EQ(fired_at[i], -1);
+        } else {
+            ASSERT_EQ(fired_at[i], std::max<int64_t>(deadlines[i], 1)) << "timer " << i;
+        }
+    }
+}
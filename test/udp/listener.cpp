@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2018 Maks Mazurov (fox.cpp) <foxcpp [at] yandex [dot] ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../gtest.hpp"
+#include <libwire/udp.hpp>
+#include <libwire/options.hpp>
+
+using namespace libwire;
+using namespace std::literals;
+
+TEST(UdpListener, AcceptCreatesSession) {
+    udp::listener listener(ipv4::loopback, 0);
+    listener.set_option(libwire::receive_timeout, 10s);
+    udp::socket client(ip::v4);
+    client.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> hello(16, 0xAF), buffer(64);
+    client.write(hello, {listener.local_endpoint()});
+
+    size_t size = 0;
+    udp::socket session = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    ASSERT_EQ(size, hello.size());
+    ASSERT_TRUE(std::equal(hello.begin(), hello.end(), buffer.begin()));
+    ASSERT_EQ(session.local_endpoint(), listener.local_endpoint());
+    ASSERT_EQ(session.remote_endpoint(), client.local_endpoint());
+}
+
+TEST(UdpListener, SessionReceivesFollowingDatagrams) {
+    udp::listener listener(ipv4::loopback, 0);
+    listener.set_option(libwire::receive_timeout, 10s);
+    udp::socket client(ip::v4);
+    client.set_option(libwire::receive_timeout, 10s);
+    client.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> first(8, 0x01), second(8, 0x02), reply(8, 0x03), buffer(64), in_buffer;
+    client.write(first, {listener.local_endpoint()});
+    size_t size = 0;
+    udp::socket session = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    session.set_option(libwire::receive_timeout, 10s);
+
+    client.write(second, {listener.local_endpoint()});
+    auto source = session.read(64, in_buffer);
+    ASSERT_EQ(in_buffer, second);
+    ASSERT_EQ(source, client.local_endpoint());
+
+    // Nothing should be left for the listener.
+    listener.set_option(libwire::non_blocking, true);
+    std::error_code ec;
+    listener.accept(memory_view(buffer.data(), buffer.size()), size, ec);
+    ASSERT_EQ(ec, error::try_again);
+
+    session.write(reply);
+    auto [reply_buffer, reply_source] = client.read(64);
+    ASSERT_EQ(reply_buffer, reply);
+    ASSERT_EQ(reply_source, listener.local_endpoint());
+}
+
+TEST(UdpListener, SessionsAreIsolated) {
+    udp::listener listener(ipv4::loopback, 0);
+    listener.set_option(libwire::receive_timeout, 10s);
+    udp::socket client1(ip::v4), client2(ip::v4);
+    client1.bind(ipv4::loopback, 0);
+    client2.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> buffer(64), in_buffer;
+    size_t size = 0;
+    client1.write(std::vector<uint8_t>(4, 0x01), {listener.local_endpoint()});
+    udp::socket session1 = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    client2.write(std::vector<uint8_t>(4, 0x02), {listener.local_endpoint()});
+    udp::socket session2 = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    ASSERT_EQ(session2.remote_endpoint(), client2.local_endpoint());
+
+    session1.set_option(libwire::receive_timeout, 10s);
+    session2.set_option(libwire::receive_timeout, 10s);
+    client2.write(std::vector<uint8_t>(4, 0x22), {listener.local_endpoint()});
+    client1.write(std::vector<uint8_t>(4, 0x11), {listener.local_endpoint()});
+
+    session1.read(64, in_buffer);
+    ASSERT_EQ(in_buffer, std::vector<uint8_t>(4, 0x11));
+    session2.read(64, in_buffer);
+    ASSERT_EQ(in_buffer, std::vector<uint8_t>(4, 0x22));
+}
+
+TEST(UdpListener, OneSessionPerPeer) {
+    udp::listener listener(ipv4::loopback, 0);
+    listener.set_option(libwire::receive_timeout, 10s);
+    udp::socket client(ip::v4);
+    client.bind(ipv4::loopback, 0);
+
+    // Both are queued on listener before session exists.
+    client.write(std::vector<uint8_t>(4, 0x01), {listener.local_endpoint()});
+    client.write(std::vector<uint8_t>(4, 0x02), {listener.local_endpoint()});
+
+    std::vector<uint8_t> buffer(64);
+    size_t size = 0;
+    udp::socket session = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    ASSERT_EQ(buffer[0], 0x01);
+
+    listener.set_option(libwire::non_blocking, true);
+    std::error_code ec;
+    udp::socket duplicate = listener.accept(memory_view(buffer.data(), buffer.size()), size, ec);
+    ASSERT_EQ(ec, error::try_again);
+    ASSERT_FALSE(duplicate.implementation());
+
+    listener.close_session(session);
+    ASSERT_FALSE(session.implementation());
+    listener.set_option(libwire::non_blocking, false);
+    client.write(std::vector<uint8_t>(4, 0x03), {listener.local_endpoint()});
+    udp::socket renewed = listener.accept(memory_view(buffer.data(), buffer.size()), size);
+    ASSERT_EQ(buffer[0], 0x03);
+    ASSERT_EQ(renewed.remote_endpoint(), client.local_endpoint());
+}
+
+TEST(UdpListener, NonBlockingAccept) {
+    udp::listener listener(ipv4::loopback, 0);
+    listener.set_option(libwire::non_blocking, true);
+    std::vector<uint8_t> buffer(64);
+    size_t size = 0;
+    std::error_code ec;
+    udp::socket session = listener.accept(memory_view(buffer.data(), buffer.size()), size, ec);
+    ASSERT_EQ(ec, error::try_again);
+    ASSERT_FALSE(session.implementation());
+}
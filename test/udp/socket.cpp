@@ -65,3 +65,333 @@ TEST(UdpSocket, Associate) {
     ASSERT_EQ(out_buffer, in_buffer);
 }
 
+
+TEST(UdpSocket, BatchTransmission) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(ipv4::loopback, 0);
+    sender.bind(ipv4::loopback, 0);
+    auto destination = receiver.local_endpoint();
+
+    udp::datagram_batch out(16, 64);
+    for (uint8_t i = 0; i < 10; ++i) {
+        std::vector<uint8_t> datagram(i + 1u, i);
+        ASSERT_TRUE(out.push(memory_view(datagram.data(), datagram.size()), destination));
+    }
+    ASSERT_EQ(sender.write_batch(out), 10u);
+
+    udp::datagram_batch in(16, 64);
+    size_t received = 0;
+    while (received < 10) {
+        ASSERT_GT(receiver.read_batch(in), 0u);
+        for (size_t i = 0; i < in.size(); ++i, ++received) {
+            ASSERT_EQ(in[i].size(), received + 1);
+            ASSERT_EQ(in[i][0], received);
+            ASSERT_EQ(in.endpoint(i), sender.local_endpoint());
+        }
+    }
+}
+
+TEST(UdpSocket, BatchEcho) {
+    udp::socket server(ip::v4), client(ip::v4);
+    server.set_option(libwire::receive_timeout, 10s);
+    client.set_option(libwire::receive_timeout, 10s);
+    server.bind(ipv4::loopback, 0);
+    client.associate(ipv4::loopback, std::get<1>(server.local_endpoint()));
+
+    udp::datagram_batch batch(4, 16);
+    ASSERT_TRUE(batch.push(memory_view<const uint8_t>(reinterpret_cast<const uint8_t*>("ping"), 4)));
+    ASSERT_EQ(client.write_batch(batch), 1u);
+
+    ASSERT_EQ(server.read_batch(batch), 1u);
+    ASSERT_EQ(batch.endpoint(0), client.local_endpoint());
+    ASSERT_EQ(server.write_batch(batch), 1u);
+
+    std::vector<uint8_t> reply;
+    client.read(16, reply);
+    ASSERT_EQ(std::string(reply.begin(), reply.end()), "ping");
+}
+
+TEST(UdpSocket, BatchNativeEndpoints) {
+    udp::socket server(ip::v4), client1(ip::v4), client2(ip::v4);
+    server.set_option(libwire::receive_timeout, 10s);
+    client1.set_option(libwire::receive_timeout, 10s);
+    client2.set_option(libwire::receive_timeout, 10s);
+    server.bind(ipv4::loopback, 0);
+    client1.bind(ipv4::loopback, 0);
+    client2.bind(ipv4::loopback, 0);
+
+    endpoint destination = server.local_endpoint();
+    udp::datagram_batch out(2, 16);
+    ASSERT_TRUE(out.push_to(memory_view<const uint8_t>(reinterpret_cast<const uint8_t*>("one"), 3), destination));
+    ASSERT_EQ(client1.write_batch(out), 1u);
+    ASSERT_EQ(client2.write_batch(out), 1u);
+
+    udp::datagram_batch in(2, 16), replies(2, 16);
+    size_t received = 0;
+    while (received < 2) {
+        ASSERT_GT(server.read_batch(in), 0u);
+        for (size_t i = 0; i < in.size(); ++i, ++received) {
+            ASSERT_EQ(in.native_endpoint(i), endpoint(in.endpoint(i)));
+            ASSERT_TRUE(replies.push_to(in[i], in.native_endpoint(i)));
+        }
+    }
+    ASSERT_EQ(server.write_batch(replies), 2u);
+
+    for (udp::socket* client : {&client1, &client2}) {
+        std::vector<uint8_t> reply;
+        auto source = client->read(16, reply);
+        ASSERT_EQ(std::string(reply.begin(), reply.end()), "one");
+        ASSERT_EQ(source, server.local_endpoint());
+    }
+}
+
+TEST(UdpSocket, BatchLimits) {
+    udp::datagram_batch batch(2, 4);
+    std::vector<uint8_t> small(4), large(5);
+    ASSERT_FALSE(batch.push(memory_view(large.data(), large.size())));
+    ASSERT_TRUE(batch.push(memory_view(small.data(), small.size())));
+    ASSERT_TRUE(batch.push(memory_view(small.data(), small.size())));
+    ASSERT_FALSE(batch.push(memory_view(small.data(), small.size())));
+    ASSERT_EQ(batch.size(), 2u);
+    ASSERT_EQ(batch.endpoint(0), std::tuple(address{0, 0, 0, 0}, 0u));
+    ASSERT_TRUE(batch.native_endpoint(0).empty());
+
+    batch.clear();
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQ(batch.capacity(), 2u);
+}
+
+TEST(UdpSocket, BatchNonBlockingEmpty) {
+    udp::socket sock(ip::v4);
+    sock.bind(ipv4::loopback, 0);
+    sock.set_option(libwire::non_blocking, true);
+
+    udp::datagram_batch batch(4);
+    std::error_code ec;
+    ASSERT_EQ(sock.read_batch(batch, ec), 0u);
+    ASSERT_EQ(ec, error::try_again);
+    ASSERT_TRUE(batch.empty());
+}
+
+TEST(UdpSocket, SegmentedWrite) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> buffer(3500);
+    for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = uint8_t(i / 1000);
+    ASSERT_EQ(sender.write_segmented(memory_view(buffer.data(), buffer.size()), 1000, receiver.local_endpoint()),
+              buffer.size());
+
+    std::vector<uint8_t> datagram;
+    for (uint8_t i = 0; i < 4; ++i) {
+        receiver.read(2000, datagram);
+        ASSERT_EQ(datagram.size(), i == 3 ? 500u : 1000u);
+        ASSERT_EQ(datagram.front(), i);
+        ASSERT_EQ(datagram.back(), i);
+    }
+}
+
+TEST(UdpSocket, SegmentedWriteInvalidSize) {
+    udp::socket sock(ip::v4);
+    std::vector<uint8_t> buffer(10);
+    std::error_code ec;
+    ASSERT_EQ(sock.write_segmented(memory_view(buffer.data(), buffer.size()), 0, ec, {{ipv4::loopback, 7}}), 0u);
+    ASSERT_EQ(ec, error::invalid_argument);
+}
+
+TEST(UdpSocket, CoalescedRead) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.set_option(udp::receive_offload, true);
+    receiver.bind(ipv4::loopback, 0);
+    sender.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> buffer(10 * 1000);
+    for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = uint8_t(i / 1000);
+    sender.write_segmented(memory_view(buffer.data(), buffer.size()), 1000, receiver.local_endpoint());
+
+    std::vector<uint8_t> input(64 * 1024);
+    size_t received = 0;
+    while (received < 10) {
+        udp::coalesced_datagrams datagrams = receiver.read_coalesced(memory_view(input.data(), input.size()));
+        ASSERT_EQ(datagrams.source, sender.local_endpoint());
+        ASSERT_EQ(datagrams.segment_size, 1000u);
+        for (size_t i = 0; i < datagrams.count(); ++i, ++received) {
+            ASSERT_EQ(datagrams[i].size(), 1000u);
+            ASSERT_EQ(datagrams[i][0], received);
+            ASSERT_EQ(datagrams[i][999], received);
+        }
+    }
+}
+
+#ifdef __linux__
+TEST(UdpSocket, TruncatedDatagrams) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(ipv4::loopback, 0);
+    auto destination = receiver.local_endpoint();
+
+    std::vector<uint8_t> large(16, 0xAA), small(8, 0xBB);
+    sender.write(large, destination);
+    sender.write(small, destination);
+    sender.write(large, destination);
+
+    udp::datagram_batch batch(2, 8);
+    size_t received = 0;
+    while (received < 2) received += receiver.read_batch(batch);
+    ASSERT_EQ(batch.size(), 2u);
+    ASSERT_EQ(batch[0].size(), 8u);
+    ASSERT_TRUE(batch.truncated(0));
+    ASSERT_EQ(batch[1].size(), 8u);
+    ASSERT_FALSE(batch.truncated(1));
+
+    std::vector<uint8_t> input(4);
+    udp::coalesced_datagrams datagrams = receiver.read_coalesced(memory_view(input.data(), input.size()));
+    ASSERT_EQ(datagrams.data.size(), 4u);
+    ASSERT_TRUE(datagrams.truncated);
+
+    sender.write(small, destination);
+    input.resize(64);
+    datagrams = receiver.read_coalesced(memory_view(input.data(), input.size()));
+    ASSERT_EQ(datagrams.data.size(), 8u);
+    ASSERT_FALSE(datagrams.truncated);
+}
+#endif
+
+TEST(UdpSocket, ReadIntoMemoryView) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(ipv4::loopback, 0);
+    sender.bind(ipv4::loopback, 0);
+
+    std::vector<uint8_t> out_buffer(32, 0xAF);
+    sender.write(out_buffer, receiver.local_endpoint());
+
+    uint8_t in_buffer[64];
+    auto [size, source] = receiver.read(memory_view(in_buffer, sizeof(in_buffer)));
+    ASSERT_EQ(size, out_buffer.size());
+    ASSERT_EQ(source, sender.local_endpoint());
+    ASSERT_EQ(std::vector<uint8_t>(in_buffer, in_buffer + size), out_buffer);
+}
+
+TEST(UdpSocket, ReadIntoByteBuffer) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(ipv4::loopback, 0);
+
+    byte_buffer out_buffer(32, 0xAF), in_buffer;
+    for (size_t i = 0; i < 3; ++i) {
+        sender.write(out_buffer, receiver.local_endpoint());
+        receiver.read(64 * 1024, in_buffer);
+        ASSERT_EQ(in_buffer, out_buffer);
+    }
+}
+
+TEST(UdpSocket, DualStack) {
+    udp::socket server(dual_stack), client4(ip::v4), client6(ip::v6);
+    ASSERT_FALSE(server.option(libwire::ipv6_only));
+    server.set_option(libwire::receive_timeout, 10s);
+    client4.set_option(libwire::receive_timeout, 10s);
+    client6.set_option(libwire::receive_timeout, 10s);
+    server.bind(ipv6::any, 0);
+    uint16_t port = std::get<1>(server.local_endpoint());
+    client4.bind(ipv4::loopback, 0);
+    client6.bind(ipv6::loopback, 0);
+
+    std::vector<uint8_t> out_buffer(16, 0x04), in_buffer;
+    client4.write(out_buffer, {{ipv4::loopback, port}});
+    auto source4 = server.read(64, in_buffer);
+    ASSERT_EQ(std::get<0>(source4).version, ip::v4);
+    ASSERT_EQ(source4, client4.local_endpoint());
+
+    std::fill(out_buffer.begin(), out_buffer.end(), 0x06);
+    client6.write(out_buffer, {{ipv6::loopback, port}});
+    auto source6 = server.read(64, in_buffer);
+    ASSERT_EQ(source6, client6.local_endpoint());
+
+    // Replies to both peers, IPv4 destination is mapped internally.
+    server.write(std::vector<uint8_t>(4, 0x40), source4);
+    udp::datagram_batch batch(1);
+    uint8_t reply6[4] = {0x60, 0x60, 0x60, 0x60};
+    ASSERT_TRUE(batch.push(memory_view(reply6, sizeof(reply6)), source6));
+    ASSERT_EQ(server.write_batch(batch), 1u);
+
+    auto [reply4_buffer, reply4_source] = client4.read(64);
+    ASSERT_EQ(reply4_buffer, std::vector<uint8_t>(4, 0x40));
+    ASSERT_EQ(reply4_source, std::tuple(ipv4::loopback, port));
+    auto [reply6_buffer, reply6_source] = client6.read(64);
+    ASSERT_EQ(reply6_buffer, std::vector<uint8_t>(4, 0x60));
+    ASSERT_EQ(reply6_source, std::tuple(ipv6::loopback, port));
+}
+
+TEST(UdpSocket, DualStackBatchToIPv4) {
+    udp::socket server(dual_stack), client(ip::v4);
+    client.set_option(libwire::receive_timeout, 10s);
+    server.bind(ipv6::any, 0);
+    client.bind(ipv4::loopback, 0);
+
+    udp::datagram_batch batch(4);
+    uint8_t datagram[8] = {};
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(batch.push(memory_view(datagram, sizeof(datagram)), client.local_endpoint()));
+    }
+    ASSERT_EQ(server.write_batch(batch), 4u);
+
+    std::vector<uint8_t> in_buffer;
+    for (size_t i = 0; i < 4; ++i) {
+        auto source = client.read(64, in_buffer);
+        ASSERT_EQ(std::get<1>(source), std::get<1>(server.local_endpoint()));
+    }
+}
+
+TEST(UdpSocket, IPv6Only) {
+    udp::socket sock(ip::v6);
+    sock.set_option(libwire::ipv6_only, true);
+    ASSERT_TRUE(sock.option(libwire::ipv6_only));
+
+    std::error_code ec;
+    sock.write(std::vector<uint8_t>(4), ec, {{ipv4::loopback, 7777}});
+    ASSERT_TRUE(ec);
+}
+
+TEST(UdpSocket, WriteToReadFrom) {
+    udp::socket receiver(ip::v4), sender(ip::v4);
+    receiver.set_option(libwire::receive_timeout, 10s);
+    receiver.bind(endpoint{ipv4::loopback, 0});
+    sender.bind(ipv4::loopback, 0);
+
+    endpoint destination = receiver.local_endpoint();
+    uint8_t out_buffer[16] = {1, 2, 3};
+    ASSERT_EQ(sender.write_to(memory_view(out_buffer, sizeof(out_buffer)), destination), sizeof(out_buffer));
+
+    uint8_t in_buffer[64];
+    endpoint source;
+    ASSERT_EQ(receiver.read_from(memory_view(in_buffer, sizeof(in_buffer)), source), sizeof(out_buffer));
+    ASSERT_EQ(source, endpoint(sender.local_endpoint()));
+
+    // Reply using endpoint as received.
+    sender.set_option(libwire::receive_timeout, 10s);
+    receiver.write_to(memory_view(in_buffer, 3), source);
+    ASSERT_EQ(sender.read_from(memory_view(in_buffer, sizeof(in_buffer)), source), 3u);
+    ASSERT_EQ(source, destination);
+}
+
+TEST(UdpSocket, DualStackReadFrom) {
+    udp::socket server(dual_stack), client(ip::v4);
+    server.set_option(libwire::receive_timeout, 10s);
+    client.set_option(libwire::receive_timeout, 10s);
+    server.bind(ipv6::any, 0);
+    client.bind(ipv4::loopback, 0);
+
+    uint8_t buffer[16] = {};
+    client.write_to(memory_view(buffer, sizeof(buffer)), endpoint{ipv4::loopback, std::get<1>(server.local_endpoint())});
+    endpoint source;
+    server.read_from(memory_view(buffer, sizeof(buffer)), source);
+    ASSERT_EQ(source.version(), ip::v4);
+    ASSERT_EQ(source, endpoint(client.local_endpoint()));
+
+    server.write_to(memory_view(buffer, 4), source);
+    ASSERT_EQ(client.read_from(memory_view(buffer, sizeof(buffer)), source), 4u);
+}